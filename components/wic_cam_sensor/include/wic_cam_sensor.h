@@ -13,10 +13,6 @@ extern "C" {
 #define WIC_CAM_CSI_LANE_BITRATE    (200)
 #define WIC_CAM_CSI_LANE_NUM        (2)
 #define WIC_CAM_CSI_BYTE_SWAP_EN    (true)
-#define WIC_CAM_CSI_FMT_800_600     (1)
-// #define WIC_CAM_CSI_FMT_800_1280    (1)
-// #define WIC_CAM_CSI_FMT_1024_600    (0)
-
 #define WIC_CAM_ISP_ENABLE          (1)
 #if WIC_CAM_ISP_ENABLE
 #define WIC_CAM_ISP_CLK_HZ          (80 * 1000 * 1000)
@@ -27,31 +23,43 @@ extern "C" {
 #define WIC_CAM_ISP_LINE_END_P      (false)
 #endif
 
-#if WIC_CAM_CSI_FMT_800_600
-#define WIC_CAM_CSI_FMT_NAME        "MIPI_2lane_24Minput_RAW8_800x640_50fps"
-#define WIC_CAM_CSI_HRES            (800)
-#define WIC_CAM_CSI_VRES            (640)
-#elif WIC_CAM_CSI_FMT_800_1280
-#define WIC_CAM_CSI_FMT_NAME        "MIPI_2lane_24Minput_RAW8_800x1280_50fps"
-#define WIC_CAM_CSI_HRES            (800)
-#define WIC_CAM_CSI_VRES            (1280)
-#elif WIC_CAM_CSI_FMT_1024_600
-#define WIC_CAM_CSI_FMT_NAME        "MIPI_2lane_24Minput_RAW8_1024x600_30fps"
-#define WIC_CAM_CSI_HRES            (1024)
-#define WIC_CAM_CSI_VRES            (600)
-#endif
+// One buffer being filled by the CSI controller, one holding the latest frame and one held by the reader
+#define WIC_CAM_BUF_NUM             (3)
+
+typedef enum {
+    WIC_CAM_FMT_800_640 = 0,
+    WIC_CAM_FMT_800_1280,
+    WIC_CAM_FMT_1024_600,
+    WIC_CAM_FMT_MAX,
+} wic_cam_fmt_t;
 
-#define WIC_CAM_BUF_NUM             (1)
+#define WIC_CAM_FMT_DEFAULT         WIC_CAM_FMT_800_640
+
+typedef struct {
+    const char *name;
+    uint16_t hres;
+    uint16_t vres;
+} wic_cam_fmt_info_t;
 
 typedef struct {
     void *data;
     size_t all_len;
     size_t recv_len;
-    uint8_t is_free;
+    uint16_t width;
+    uint16_t height;
+    int64_t timestamp_us;
 } wic_cam_img_buf_t;
 
-esp_err_t wic_cam_sensor_init(i2c_master_bus_handle_t i2c_handle);
+// Return NULL for an unknown format
+const wic_cam_fmt_info_t *wic_cam_sensor_get_fmt_info(wic_cam_fmt_t fmt);
+
+esp_err_t wic_cam_sensor_init(i2c_master_bus_handle_t i2c_handle, wic_cam_fmt_t fmt);
 esp_err_t wic_cam_sensor_start(void);
+/**
+ * The camera streams continuously into WIC_CAM_BUF_NUM buffers and only the latest complete frame is kept.
+ * Take that frame, or wait up to timeout ms for the next one if it was already taken.
+ * The buffer stays with the caller until wic_cam_sensor_free_img_buf(), hold at most one at a time.
+ */
 esp_err_t wic_cam_sensor_recv_img_buf(wic_cam_img_buf_t **img_buf, uint32_t timeout);
 void wic_cam_sensor_free_img_buf(wic_cam_img_buf_t *img_buf);
 esp_err_t wic_cam_sensor_stop(void);
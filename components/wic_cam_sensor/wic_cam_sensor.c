@@ -1,9 +1,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdatomic.h>
 #include "freertos/FreeRTOS.h"
-#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "esp_err.h"
 #include "esp_cache.h"
 #include "esp_heap_caps.h"
@@ -21,13 +24,37 @@ static i2c_master_bus_handle_t i2c_bus_handle = NULL;
 static esp_cam_ctlr_handle_t cam_handle = NULL;
 static isp_proc_handle_t isp_proc = NULL;
 static wic_cam_img_buf_t cam_img_buf[WIC_CAM_BUF_NUM] = {0};
-static QueueHandle_t cam_img_queue = NULL;
+static SemaphoreHandle_t cam_frame_sem = NULL;
+
+enum {
+    CAM_IMG_BUF_FREE = 0,
+    CAM_IMG_BUF_FILLING,
+    CAM_IMG_BUF_READY,
+    CAM_IMG_BUF_HELD,
+};
+
+// Buffer states are shared by the CSI ISR and the reader, every transition is a single atomic operation
+static atomic_int cam_img_buf_state[WIC_CAM_BUF_NUM];
+// The latest complete frame, NULL once it has been taken
+static _Atomic(wic_cam_img_buf_t *) cam_latest_img_buf = NULL;
+
+static const wic_cam_fmt_info_t cam_fmt_table[WIC_CAM_FMT_MAX] = {
+    [WIC_CAM_FMT_800_640] = { "MIPI_2lane_24Minput_RAW8_800x640_50fps", 800, 640 },
+    [WIC_CAM_FMT_800_1280] = { "MIPI_2lane_24Minput_RAW8_800x1280_50fps", 800, 1280 },
+    [WIC_CAM_FMT_1024_600] = { "MIPI_2lane_24Minput_RAW8_1024x600_30fps", 1024, 600 },
+};
+
+const wic_cam_fmt_info_t *wic_cam_sensor_get_fmt_info(wic_cam_fmt_t fmt)
+{
+    if ((int)fmt < 0 || fmt >= WIC_CAM_FMT_MAX) return NULL;
+    return &cam_fmt_table[fmt];
+}
 
 static wic_cam_img_buf_t *get_free_cam_img_buf(void)
 {
     for (int i = 0; i < WIC_CAM_BUF_NUM; i++) {
-        if (cam_img_buf[i].is_free) {
-            cam_img_buf[i].is_free = 0;
+        int expected = CAM_IMG_BUF_FREE;
+        if (atomic_compare_exchange_strong(&cam_img_buf_state[i], &expected, CAM_IMG_BUF_FILLING)) {
             return &cam_img_buf[i];
         }
     }
@@ -44,15 +71,22 @@ static wic_cam_img_buf_t *get_cam_img_buf(void *buf_ptr)
     return NULL;
 }
 
+static inline int cam_img_buf_index(const wic_cam_img_buf_t *img_buf)
+{
+    return img_buf - cam_img_buf;
+}
+
 void wic_cam_sensor_free_img_buf(wic_cam_img_buf_t *img_buf)
 {
-    img_buf->is_free = 1;
+    if (img_buf == NULL) return;
+    atomic_store(&cam_img_buf_state[cam_img_buf_index(img_buf)], CAM_IMG_BUF_FREE);
 }
 
 static bool wic_cam_request_new_buffer(esp_cam_ctlr_handle_t handle, esp_cam_ctlr_trans_t *trans, void *user_data)
 {
     wic_cam_img_buf_t *img_buf = get_free_cam_img_buf();
 
+    // Without a free buffer the controller drops the frame into its backup buffer
     if (img_buf != NULL) {
         trans->buffer = img_buf->data;
         trans->buflen = img_buf->all_len;
@@ -65,16 +99,27 @@ static bool wic_cam_request_new_buffer(esp_cam_ctlr_handle_t handle, esp_cam_ctl
 
 static bool wic_cam_finished_trans(esp_cam_ctlr_handle_t handle, esp_cam_ctlr_trans_t *trans, void *user_data)
 {
+    BaseType_t need_yield = pdFALSE;
     wic_cam_img_buf_t *img_buf = get_cam_img_buf(trans->buffer);
     if (img_buf == NULL) return false;
 
     img_buf->recv_len = trans->received_size;
-    xQueueSendFromISR(cam_img_queue, &img_buf, NULL);
-    return false;
+    img_buf->timestamp_us = esp_timer_get_time();
+    atomic_store(&cam_img_buf_state[cam_img_buf_index(img_buf)], CAM_IMG_BUF_READY);
+
+    // Publish the new frame, the one it replaces was never taken and can be filled again
+    wic_cam_img_buf_t *old_buf = atomic_exchange(&cam_latest_img_buf, img_buf);
+    if (old_buf != NULL) {
+        int expected = CAM_IMG_BUF_READY;
+        atomic_compare_exchange_strong(&cam_img_buf_state[cam_img_buf_index(old_buf)], &expected, CAM_IMG_BUF_FREE);
+    }
+    xSemaphoreGiveFromISR(cam_frame_sem, &need_yield);
+    return need_yield == pdTRUE;
 }
 
-esp_err_t wic_cam_sensor_init(i2c_master_bus_handle_t i2c_handle)
+esp_err_t wic_cam_sensor_init(i2c_master_bus_handle_t i2c_handle, wic_cam_fmt_t fmt)
 {
+    const wic_cam_fmt_info_t *fmt_info = wic_cam_sensor_get_fmt_info(fmt);
     int enable_flag = 0;
     esp_err_t ret = ESP_OK;
     esp_sccb_io_handle_t sccb_io_handle = NULL;
@@ -100,8 +145,8 @@ esp_err_t wic_cam_sensor_init(i2c_master_bus_handle_t i2c_handle)
     };
     esp_cam_ctlr_csi_config_t csi_config = {
         .ctlr_id = 0,
-        .h_res = WIC_CAM_CSI_HRES,
-        .v_res = WIC_CAM_CSI_VRES,
+        .h_res = fmt_info ? fmt_info->hres : 0,
+        .v_res = fmt_info ? fmt_info->vres : 0,
         .lane_bit_rate_mbps = WIC_CAM_CSI_LANE_BITRATE,
         .input_data_color_type = CAM_CTLR_COLOR_RAW8,
         .output_data_color_type = CAM_CTLR_COLOR_RGB565,
@@ -116,27 +161,34 @@ esp_err_t wic_cam_sensor_init(i2c_master_bus_handle_t i2c_handle)
         .output_data_color_type = WIC_CAM_ISP_OUTPUT_COLOR,
         .has_line_start_packet = WIC_CAM_ISP_LINE_START_P,
         .has_line_end_packet = WIC_CAM_ISP_LINE_END_P,
-        .h_res = WIC_CAM_CSI_HRES,
-        .v_res = WIC_CAM_CSI_VRES,
+        .h_res = fmt_info ? fmt_info->hres : 0,
+        .v_res = fmt_info ? fmt_info->vres : 0,
     };
     esp_cam_ctlr_evt_cbs_t cbs = {
         .on_get_new_trans = wic_cam_request_new_buffer,
         .on_trans_finished = wic_cam_finished_trans,
     };
     
+    if (fmt_info == NULL) {
+        ESP_LOGE(TAG, "Invalid camera format %d", fmt);
+        return ESP_ERR_INVALID_ARG;
+    }
     if (cam_handle) {
         ESP_LOGE(TAG, "Camera controller already initialized");
         return ESP_ERR_INVALID_STATE;
     }
 
-    cam_img_queue = xQueueCreate(WIC_CAM_BUF_NUM, sizeof(wic_cam_img_buf_t *));
-    if (cam_img_queue == NULL) {
-        ESP_LOGE(TAG, "Failed to create camera image queue");
+    cam_frame_sem = xSemaphoreCreateBinary();
+    if (cam_frame_sem == NULL) {
+        ESP_LOGE(TAG, "Failed to create camera frame semaphore");
         ret = ESP_ERR_NO_MEM;
         goto wic_cam_sensor_init_failed;
     }
+    atomic_store(&cam_latest_img_buf, NULL);
     for (int i = 0; i < WIC_CAM_BUF_NUM; i++) {
-        cam_img_buf[i].all_len = WIC_CAM_CSI_HRES * WIC_CAM_CSI_VRES * 2;
+        cam_img_buf[i].width = fmt_info->hres;
+        cam_img_buf[i].height = fmt_info->vres;
+        cam_img_buf[i].all_len = fmt_info->hres * fmt_info->vres * 2;
         cam_img_buf[i].data = heap_caps_malloc(cam_img_buf[i].all_len, MALLOC_CAP_CACHE_ALIGNED | MALLOC_CAP_SPIRAM);
         if (cam_img_buf[i].data == NULL) {
             ESP_LOGE(TAG, "Failed to allocate memory for camera transaction buffer");
@@ -192,7 +244,7 @@ esp_err_t wic_cam_sensor_init(i2c_master_bus_handle_t i2c_handle)
         goto wic_cam_sensor_init_failed;
     }
     for (int i = 0; i < cam_fmt_array.count; i++) {
-        if (!strcmp(cam_fmt_array.format_array[i].name, WIC_CAM_CSI_FMT_NAME)) {
+        if (!strcmp(cam_fmt_array.format_array[i].name, fmt_info->name)) {
             ret = esp_cam_sensor_set_format(cam, (const esp_cam_sensor_format_t *)&(cam_fmt_array.format_array[i].name));
             if (ret != ESP_OK) {
                 ESP_LOGE(TAG, "Failed to set camera sensor format: %s", esp_err_to_name(ret));
@@ -255,11 +307,11 @@ wic_cam_sensor_init_failed:
         i2c_del_master_bus(i2c_bus_handle);
         i2c_bus_handle = NULL;
     }
-    if (cam_img_queue) {
-        xQueueReset(cam_img_queue);
-        vQueueDelete(cam_img_queue);
-        cam_img_queue = NULL;
+    if (cam_frame_sem) {
+        vSemaphoreDelete(cam_frame_sem);
+        cam_frame_sem = NULL;
     }
+    atomic_store(&cam_latest_img_buf, NULL);
     for (int i = 0; i < WIC_CAM_BUF_NUM; i++) {
         if (cam_img_buf[i].data) {
             free(cam_img_buf[i].data);
@@ -279,8 +331,8 @@ esp_err_t wic_cam_sensor_start(void)
     esp_cam_ctlr_trans_t ctlr_trans = {0};
     
     if (cam_handle == NULL) return ESP_ERR_INVALID_STATE;
-    ctlr_trans.buffer = cam_img_buf[0].data;
-    ctlr_trans.buflen = cam_img_buf[0].all_len;
+    wic_cam_request_new_buffer(cam_handle, &ctlr_trans, NULL);
+    if (ctlr_trans.buffer == NULL) return ESP_ERR_NO_MEM;
 
     ret = esp_cam_ctlr_start(cam_handle);
     if (ret != ESP_OK) {
@@ -299,20 +351,38 @@ esp_err_t wic_cam_sensor_start(void)
 esp_err_t wic_cam_sensor_recv_img_buf(wic_cam_img_buf_t **img_buf, uint32_t timeout)
 {
     if (img_buf == NULL) return ESP_ERR_INVALID_ARG;
-    if (cam_img_queue == NULL) return ESP_ERR_INVALID_STATE;
-    if (xQueueReceive(cam_img_queue, img_buf, pdMS_TO_TICKS(timeout)) == pdTRUE) return ESP_OK;
-    return ESP_ERR_TIMEOUT;
+    if (cam_frame_sem == NULL) return ESP_ERR_INVALID_STATE;
+
+    TickType_t start = xTaskGetTickCount();
+    TickType_t wait = pdMS_TO_TICKS(timeout);
+    while (true) {
+        wic_cam_img_buf_t *latest = atomic_exchange(&cam_latest_img_buf, NULL);
+        if (latest != NULL) {
+            // Only the ISR frees a READY buffer, and only through the latest slot that was just emptied
+            atomic_store(&cam_img_buf_state[cam_img_buf_index(latest)], CAM_IMG_BUF_HELD);
+            // The buffer is filled again and again by DMA, drop whatever the cache still holds from a previous frame
+            esp_cache_msync(latest->data, latest->all_len, ESP_CACHE_MSYNC_FLAG_DIR_M2C);
+            *img_buf = latest;
+            return ESP_OK;
+        }
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= wait || xSemaphoreTake(cam_frame_sem, wait - elapsed) != pdTRUE) {
+            return ESP_ERR_TIMEOUT;
+        }
+    }
 }
 
 esp_err_t wic_cam_sensor_stop(void)
 {
     esp_err_t ret = ESP_OK;
-    wic_cam_img_buf_t *img_buf = NULL;
     if (cam_handle == NULL) return ESP_ERR_INVALID_STATE;
 
     ret = esp_cam_ctlr_stop(cam_handle);
-    while (xQueueReceive(cam_img_queue, &img_buf, 0) == pdTRUE) {
-        if (img_buf) wic_cam_sensor_free_img_buf(img_buf);
+    atomic_store(&cam_latest_img_buf, NULL);
+    for (int i = 0; i < WIC_CAM_BUF_NUM; i++) {
+        if (atomic_load(&cam_img_buf_state[i]) != CAM_IMG_BUF_HELD) {
+            atomic_store(&cam_img_buf_state[i], CAM_IMG_BUF_FREE);
+        }
     }
 
     return ret;
@@ -328,11 +398,11 @@ void wic_cam_sensor_deinit(void)
         i2c_del_master_bus(i2c_bus_handle);
         i2c_bus_handle = NULL;
     }
-    if (cam_img_queue) {
-        xQueueReset(cam_img_queue);
-        vQueueDelete(cam_img_queue);
-        cam_img_queue = NULL;
+    if (cam_frame_sem) {
+        vSemaphoreDelete(cam_frame_sem);
+        cam_frame_sem = NULL;
     }
+    atomic_store(&cam_latest_img_buf, NULL);
     for (int i = 0; i < WIC_CAM_BUF_NUM; i++) {
         if (cam_img_buf[i].data) {
             free(cam_img_buf[i].data);
@@ -0,0 +1,566 @@
+#include "cJSON.h"
+
+#include <cctype>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <strings.h>
+
+namespace {
+
+cJSON* NewItem(int type) {
+    auto item = static_cast<cJSON*>(calloc(1, sizeof(cJSON)));
+    item->type = type;
+    return item;
+}
+
+char* CopyString(const char* string) {
+    return string != nullptr ? strdup(string) : nullptr;
+}
+
+void SetNumber(cJSON* item, double number) {
+    item->valuedouble = number;
+    if (number >= INT_MAX) {
+        item->valueint = INT_MAX;
+    } else if (number <= (double)INT_MIN) {
+        item->valueint = INT_MIN;
+    } else {
+        item->valueint = (int)number;
+    }
+}
+
+struct Parser {
+    const char* p;
+
+    void SkipWhitespace() {
+        while (*p != '\0' && isspace(static_cast<unsigned char>(*p))) {
+            p++;
+        }
+    }
+
+    bool Literal(const char* word) {
+        size_t length = strlen(word);
+        if (strncmp(p, word, length) != 0) {
+            return false;
+        }
+        p += length;
+        return true;
+    }
+
+    static int HexDigit(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    bool Hex4(unsigned& code) {
+        code = 0;
+        for (int i = 0; i < 4; i++) {
+            int digit = HexDigit(p[i]);
+            if (digit < 0) {
+                return false;
+            }
+            code = code * 16 + digit;
+        }
+        p += 4;
+        return true;
+    }
+
+    static void AppendUtf8(std::string& out, unsigned code) {
+        if (code < 0x80) {
+            out += static_cast<char>(code);
+        } else if (code < 0x800) {
+            out += static_cast<char>(0xC0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            out += static_cast<char>(0xE0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (code >> 18));
+            out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    // p is at the opening quote
+    char* String() {
+        std::string out;
+        p++;
+        while (*p != '"') {
+            if (*p == '\0') {
+                return nullptr;
+            }
+            if (*p != '\\') {
+                out += *p++;
+                continue;
+            }
+            p++;
+            switch (*p++) {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                unsigned code;
+                if (!Hex4(code)) {
+                    return nullptr;
+                }
+                if (code >= 0xD800 && code <= 0xDBFF) {
+                    unsigned low;
+                    if (p[0] != '\\' || p[1] != 'u') {
+                        return nullptr;
+                    }
+                    p += 2;
+                    if (!Hex4(low) || low < 0xDC00 || low > 0xDFFF) {
+                        return nullptr;
+                    }
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                }
+                AppendUtf8(out, code);
+                break;
+            }
+            default:
+                return nullptr;
+            }
+        }
+        p++;
+        return strdup(out.c_str());
+    }
+
+    cJSON* Value() {
+        SkipWhitespace();
+        if (Literal("null")) {
+            return NewItem(cJSON_NULL);
+        }
+        if (Literal("false")) {
+            return NewItem(cJSON_False);
+        }
+        if (Literal("true")) {
+            auto item = NewItem(cJSON_True);
+            item->valueint = 1;
+            return item;
+        }
+        if (*p == '"') {
+            char* string = String();
+            if (string == nullptr) {
+                return nullptr;
+            }
+            auto item = NewItem(cJSON_String);
+            item->valuestring = string;
+            return item;
+        }
+        if (*p == '-' || (*p >= '0' && *p <= '9')) {
+            char* end;
+            double number = strtod(p, &end);
+            if (end == p) {
+                return nullptr;
+            }
+            p = end;
+            auto item = NewItem(cJSON_Number);
+            SetNumber(item, number);
+            return item;
+        }
+        if (*p == '[' || *p == '{') {
+            return Container();
+        }
+        return nullptr;
+    }
+
+    cJSON* Container() {
+        bool is_object = *p == '{';
+        char close = is_object ? '}' : ']';
+        auto container = NewItem(is_object ? cJSON_Object : cJSON_Array);
+        p++;
+        SkipWhitespace();
+        if (*p == close) {
+            p++;
+            return container;
+        }
+        cJSON* last = nullptr;
+        while (true) {
+            char* key = nullptr;
+            if (is_object) {
+                SkipWhitespace();
+                if (*p != '"' || (key = String()) == nullptr) {
+                    break;
+                }
+                SkipWhitespace();
+                if (*p++ != ':') {
+                    free(key);
+                    break;
+                }
+            }
+            cJSON* item = Value();
+            if (item == nullptr) {
+                free(key);
+                break;
+            }
+            item->string = key;
+            if (last == nullptr) {
+                container->child = item;
+            } else {
+                last->next = item;
+                item->prev = last;
+            }
+            last = item;
+            container->child->prev = last;
+
+            SkipWhitespace();
+            if (*p == ',') {
+                p++;
+                continue;
+            }
+            if (*p == close) {
+                p++;
+                return container;
+            }
+            break;
+        }
+        cJSON_Delete(container);
+        return nullptr;
+    }
+};
+
+void PrintString(std::string& out, const char* string) {
+    out += '"';
+    for (const char* s = string != nullptr ? string : ""; *s != '\0'; s++) {
+        unsigned char c = *s;
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\b': out += "\\b"; break;
+        case '\f': out += "\\f"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (c < 0x20) {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                out += escaped;
+            } else {
+                out += static_cast<char>(c);
+            }
+        }
+    }
+    out += '"';
+}
+
+void PrintNumber(std::string& out, const cJSON* item) {
+    double d = item->valuedouble;
+    char number[32];
+    if (std::isnan(d) || std::isinf(d)) {
+        snprintf(number, sizeof(number), "null");
+    } else if (d == (double)item->valueint) {
+        snprintf(number, sizeof(number), "%d", item->valueint);
+    } else {
+        // The shortest of 15 or 17 digits that reads back the same
+        snprintf(number, sizeof(number), "%1.15g", d);
+        if (strtod(number, nullptr) != d) {
+            snprintf(number, sizeof(number), "%1.17g", d);
+        }
+    }
+    out += number;
+}
+
+void PrintValue(std::string& out, const cJSON* item, bool format, int depth) {
+    switch (item->type & 0xFF) {
+    case cJSON_NULL: out += "null"; return;
+    case cJSON_False: out += "false"; return;
+    case cJSON_True: out += "true"; return;
+    case cJSON_Number: PrintNumber(out, item); return;
+    case cJSON_String: PrintString(out, item->valuestring); return;
+    case cJSON_Raw: out += item->valuestring != nullptr ? item->valuestring : ""; return;
+    case cJSON_Array:
+    case cJSON_Object: {
+        bool is_object = (item->type & 0xFF) == cJSON_Object;
+        out += is_object ? '{' : '[';
+        if (format && is_object) {
+            out += '\n';
+        }
+        for (const cJSON* child = item->child; child != nullptr; child = child->next) {
+            if (format && is_object) {
+                out.append(depth + 1, '\t');
+            }
+            if (is_object) {
+                PrintString(out, child->string);
+                out += format ? ":\t" : ":";
+            }
+            PrintValue(out, child, format, depth + 1);
+            if (child->next != nullptr) {
+                out += format && !is_object ? ", " : ",";
+            }
+            if (format && is_object) {
+                out += '\n';
+            }
+        }
+        if (format && is_object) {
+            out.append(depth, '\t');
+        }
+        out += is_object ? '}' : ']';
+        return;
+    }
+    default:
+        return;
+    }
+}
+
+char* Print(const cJSON* item, bool format) {
+    if (item == nullptr) {
+        return nullptr;
+    }
+    std::string out;
+    PrintValue(out, item, format, 0);
+    return strdup(out.c_str());
+}
+
+cJSON* FindItem(const cJSON* object, const char* string, bool case_sensitive) {
+    if (object == nullptr || string == nullptr) {
+        return nullptr;
+    }
+    for (cJSON* child = object->child; child != nullptr; child = child->next) {
+        if (child->string != nullptr &&
+            (case_sensitive ? strcmp(child->string, string) : strcasecmp(child->string, string)) == 0) {
+            return child;
+        }
+    }
+    return nullptr;
+}
+
+bool Append(cJSON* container, cJSON* item) {
+    if (container == nullptr || item == nullptr || container == item) {
+        return false;
+    }
+    if (container->child == nullptr) {
+        container->child = item;
+        item->prev = item;
+        item->next = nullptr;
+    } else {
+        cJSON* last = container->child->prev;
+        last->next = item;
+        item->prev = last;
+        item->next = nullptr;
+        container->child->prev = item;
+    }
+    return true;
+}
+
+} // namespace
+
+cJSON* cJSON_Parse(const char* value) {
+    if (value == nullptr) {
+        return nullptr;
+    }
+    Parser parser{value};
+    return parser.Value();
+}
+
+char* cJSON_Print(const cJSON* item) {
+    return Print(item, true);
+}
+
+char* cJSON_PrintUnformatted(const cJSON* item) {
+    return Print(item, false);
+}
+
+void cJSON_Delete(cJSON* item) {
+    while (item != nullptr) {
+        cJSON* next = item->next;
+        cJSON_Delete(item->child);
+        free(item->valuestring);
+        free(item->string);
+        free(item);
+        item = next;
+    }
+}
+
+void cJSON_free(void* object) {
+    free(object);
+}
+
+int cJSON_GetArraySize(const cJSON* array) {
+    int size = 0;
+    for (const cJSON* child = array != nullptr ? array->child : nullptr; child != nullptr; child = child->next) {
+        size++;
+    }
+    return size;
+}
+
+cJSON* cJSON_GetArrayItem(const cJSON* array, int index) {
+    if (array == nullptr || index < 0) {
+        return nullptr;
+    }
+    cJSON* child = array->child;
+    while (child != nullptr && index-- > 0) {
+        child = child->next;
+    }
+    return child;
+}
+
+cJSON* cJSON_GetObjectItem(const cJSON* object, const char* string) {
+    return FindItem(object, string, false);
+}
+
+cJSON* cJSON_GetObjectItemCaseSensitive(const cJSON* object, const char* string) {
+    return FindItem(object, string, true);
+}
+
+cJSON_bool cJSON_HasObjectItem(const cJSON* object, const char* string) {
+    return cJSON_GetObjectItem(object, string) != nullptr;
+}
+
+cJSON_bool cJSON_IsInvalid(const cJSON* item) { return item != nullptr && (item->type & 0xFF) == cJSON_Invalid; }
+cJSON_bool cJSON_IsFalse(const cJSON* item) { return item != nullptr && (item->type & 0xFF) == cJSON_False; }
+cJSON_bool cJSON_IsTrue(const cJSON* item) { return item != nullptr && (item->type & 0xFF) == cJSON_True; }
+cJSON_bool cJSON_IsBool(const cJSON* item) { return item != nullptr && (item->type & (cJSON_True | cJSON_False)) != 0; }
+cJSON_bool cJSON_IsNull(const cJSON* item) { return item != nullptr && (item->type & 0xFF) == cJSON_NULL; }
+cJSON_bool cJSON_IsNumber(const cJSON* item) { return item != nullptr && (item->type & 0xFF) == cJSON_Number; }
+cJSON_bool cJSON_IsString(const cJSON* item) { return item != nullptr && (item->type & 0xFF) == cJSON_String; }
+cJSON_bool cJSON_IsArray(const cJSON* item) { return item != nullptr && (item->type & 0xFF) == cJSON_Array; }
+cJSON_bool cJSON_IsObject(const cJSON* item) { return item != nullptr && (item->type & 0xFF) == cJSON_Object; }
+
+cJSON* cJSON_CreateNull(void) { return NewItem(cJSON_NULL); }
+cJSON* cJSON_CreateFalse(void) { return NewItem(cJSON_False); }
+
+cJSON* cJSON_CreateTrue(void) {
+    auto item = NewItem(cJSON_True);
+    item->valueint = 1;
+    return item;
+}
+
+cJSON* cJSON_CreateBool(cJSON_bool boolean) {
+    return boolean ? cJSON_CreateTrue() : cJSON_CreateFalse();
+}
+
+cJSON* cJSON_CreateNumber(double num) {
+    auto item = NewItem(cJSON_Number);
+    SetNumber(item, num);
+    return item;
+}
+
+cJSON* cJSON_CreateString(const char* string) {
+    auto item = NewItem(cJSON_String);
+    item->valuestring = CopyString(string != nullptr ? string : "");
+    return item;
+}
+
+cJSON* cJSON_CreateArray(void) { return NewItem(cJSON_Array); }
+cJSON* cJSON_CreateObject(void) { return NewItem(cJSON_Object); }
+
+cJSON_bool cJSON_AddItemToArray(cJSON* array, cJSON* item) {
+    return Append(array, item);
+}
+
+cJSON_bool cJSON_AddItemToObject(cJSON* object, const char* string, cJSON* item) {
+    if (object == nullptr || string == nullptr || item == nullptr) {
+        return false;
+    }
+    free(item->string);
+    item->string = CopyString(string);
+    return Append(object, item);
+}
+
+static cJSON* AddToObject(cJSON* object, const char* name, cJSON* item) {
+    if (cJSON_AddItemToObject(object, name, item)) {
+        return item;
+    }
+    cJSON_Delete(item);
+    return nullptr;
+}
+
+cJSON* cJSON_AddNullToObject(cJSON* object, const char* name) {
+    return AddToObject(object, name, cJSON_CreateNull());
+}
+
+cJSON* cJSON_AddBoolToObject(cJSON* object, const char* name, cJSON_bool boolean) {
+    return AddToObject(object, name, cJSON_CreateBool(boolean));
+}
+
+cJSON* cJSON_AddNumberToObject(cJSON* object, const char* name, double number) {
+    return AddToObject(object, name, cJSON_CreateNumber(number));
+}
+
+cJSON* cJSON_AddStringToObject(cJSON* object, const char* name, const char* string) {
+    return AddToObject(object, name, cJSON_CreateString(string));
+}
+
+cJSON* cJSON_AddObjectToObject(cJSON* object, const char* name) {
+    return AddToObject(object, name, cJSON_CreateObject());
+}
+
+cJSON* cJSON_AddArrayToObject(cJSON* object, const char* name) {
+    return AddToObject(object, name, cJSON_CreateArray());
+}
+
+cJSON* cJSON_Duplicate(const cJSON* item, cJSON_bool recurse) {
+    if (item == nullptr) {
+        return nullptr;
+    }
+    auto copy = NewItem(item->type);
+    copy->valueint = item->valueint;
+    copy->valuedouble = item->valuedouble;
+    copy->valuestring = CopyString(item->valuestring);
+    copy->string = CopyString(item->string);
+    if (recurse) {
+        for (const cJSON* child = item->child; child != nullptr; child = child->next) {
+            Append(copy, cJSON_Duplicate(child, true));
+        }
+    }
+    return copy;
+}
+
+cJSON_bool cJSON_Compare(const cJSON* a, const cJSON* b, cJSON_bool case_sensitive) {
+    if (a == nullptr || b == nullptr || (a->type & 0xFF) != (b->type & 0xFF)) {
+        return false;
+    }
+    if (a == b) {
+        return true;
+    }
+    switch (a->type & 0xFF) {
+    case cJSON_False:
+    case cJSON_True:
+    case cJSON_NULL:
+        return true;
+    case cJSON_Number:
+        return fabs(a->valuedouble - b->valuedouble) <= fmax(fabs(a->valuedouble), fabs(b->valuedouble)) * 2.2204460492503131e-16;
+    case cJSON_String:
+    case cJSON_Raw:
+        return a->valuestring != nullptr && b->valuestring != nullptr && strcmp(a->valuestring, b->valuestring) == 0;
+    case cJSON_Array: {
+        const cJSON* x = a->child;
+        const cJSON* y = b->child;
+        for (; x != nullptr && y != nullptr; x = x->next, y = y->next) {
+            if (!cJSON_Compare(x, y, case_sensitive)) {
+                return false;
+            }
+        }
+        return x == y;
+    }
+    case cJSON_Object: {
+        // Same members in any order
+        for (const cJSON* x = a->child; x != nullptr; x = x->next) {
+            if (!cJSON_Compare(x, FindItem(b, x->string, case_sensitive), case_sensitive)) {
+                return false;
+            }
+        }
+        for (const cJSON* y = b->child; y != nullptr; y = y->next) {
+            if (FindItem(a, y->string, case_sensitive) == nullptr) {
+                return false;
+            }
+        }
+        return true;
+    }
+    default:
+        return false;
+    }
+}
@@ -0,0 +1,10 @@
+#ifndef HOST_DRIVER_GPIO_H
+#define HOST_DRIVER_GPIO_H
+
+// Pin numbers only, for the board headers; nothing drives a pin on the host
+typedef enum {
+    GPIO_NUM_NC = -1,
+    GPIO_NUM_0 = 0,
+} gpio_num_t;
+
+#endif // HOST_DRIVER_GPIO_H
@@ -0,0 +1,34 @@
+#ifndef HOST_ESP_APP_DESC_H
+#define HOST_ESP_APP_DESC_H
+
+#include <cstdint>
+
+typedef struct {
+    uint32_t magic_word;
+    uint32_t secure_version;
+    uint32_t reserv1[2];
+    char version[32];
+    char project_name[32];
+    char time[16];
+    char date[16];
+    char idf_ver[32];
+    uint8_t app_elf_sha256[32];
+} esp_app_desc_t;
+
+// The host build has a fixed description, the version is "host"
+inline const esp_app_desc_t* esp_app_get_description(void) {
+    static const esp_app_desc_t desc = {
+        .magic_word = 0xABCD5432,
+        .secure_version = 0,
+        .reserv1 = {},
+        .version = "host",
+        .project_name = "xiaozhi",
+        .time = __TIME__,
+        .date = __DATE__,
+        .idf_ver = "host",
+        .app_elf_sha256 = {},
+    };
+    return &desc;
+}
+
+#endif // HOST_ESP_APP_DESC_H
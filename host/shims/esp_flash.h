@@ -0,0 +1,16 @@
+#ifndef HOST_ESP_FLASH_H
+#define HOST_ESP_FLASH_H
+
+#include <cstdint>
+#include "esp_err.h"
+
+typedef struct esp_flash_t esp_flash_t;
+
+// A 16 MB flash, the size of most boards
+inline esp_err_t esp_flash_get_size(esp_flash_t* chip, uint32_t* out_size) {
+    (void)chip;
+    *out_size = 16 * 1024 * 1024;
+    return ESP_OK;
+}
+
+#endif // HOST_ESP_FLASH_H
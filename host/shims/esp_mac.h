@@ -0,0 +1,24 @@
+#ifndef HOST_ESP_MAC_H
+#define HOST_ESP_MAC_H
+
+#include <cstdint>
+#include "esp_err.h"
+
+typedef enum {
+    ESP_MAC_WIFI_STA,
+    ESP_MAC_WIFI_SOFTAP,
+    ESP_MAC_BT,
+    ESP_MAC_ETH,
+} esp_mac_type_t;
+
+// A locally administered address, the same on every run
+inline esp_err_t esp_read_mac(uint8_t* mac, esp_mac_type_t type) {
+    static const uint8_t host_mac[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+    for (int i = 0; i < 6; i++) {
+        mac[i] = host_mac[i];
+    }
+    mac[5] += type;
+    return ESP_OK;
+}
+
+#endif // HOST_ESP_MAC_H
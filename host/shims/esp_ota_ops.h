@@ -0,0 +1,10 @@
+#ifndef HOST_ESP_OTA_OPS_H
+#define HOST_ESP_OTA_OPS_H
+
+#include "esp_app_desc.h"
+#include "esp_partition.h"
+
+// A factory app partition outside the partition list, the host never updates its firmware
+const esp_partition_t* esp_ota_get_running_partition(void);
+
+#endif // HOST_ESP_OTA_OPS_H
@@ -0,0 +1,135 @@
+#include "esp_partition.h"
+#include "esp_ota_ops.h"
+
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace {
+
+struct HostPartition {
+    esp_partition_t partition;
+    std::vector<uint8_t> data;
+};
+
+std::mutex partition_mutex;
+// Partitions are never removed, so the pointers handed out stay valid
+std::map<std::string, std::unique_ptr<HostPartition>> partitions;
+
+HostPartition* FindPartition(const esp_partition_t* partition) {
+    for (auto& [label, host] : partitions) {
+        if (&host->partition == partition) {
+            return host.get();
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
+void esp_partition_host_set(const char* label, const std::vector<uint8_t>& data) {
+    std::lock_guard<std::mutex> lock(partition_mutex);
+    auto& host = partitions[label];
+    if (host == nullptr) {
+        host = std::make_unique<HostPartition>();
+        host->partition.type = ESP_PARTITION_TYPE_DATA;
+        host->partition.subtype = ESP_PARTITION_SUBTYPE_ANY;
+        strncpy(host->partition.label, label, sizeof(host->partition.label) - 1);
+    }
+    host->data = data;
+    host->partition.size = data.size();
+}
+
+struct esp_partition_iterator_opaque_ {
+    std::vector<const esp_partition_t*> partitions;
+    size_t index = 0;
+};
+
+esp_partition_iterator_t esp_partition_find(esp_partition_type_t type, esp_partition_subtype_t subtype, const char* label) {
+    std::lock_guard<std::mutex> lock(partition_mutex);
+    (void)subtype;
+    auto iterator = new esp_partition_iterator_opaque_();
+    for (auto& [name, host] : partitions) {
+        if ((type == ESP_PARTITION_TYPE_ANY || host->partition.type == type) && (label == nullptr || name == label)) {
+            iterator->partitions.push_back(&host->partition);
+        }
+    }
+    if (iterator->partitions.empty()) {
+        delete iterator;
+        return nullptr;
+    }
+    return iterator;
+}
+
+const esp_partition_t* esp_partition_get(esp_partition_iterator_t iterator) {
+    return iterator->partitions[iterator->index];
+}
+
+esp_partition_iterator_t esp_partition_next(esp_partition_iterator_t iterator) {
+    if (++iterator->index >= iterator->partitions.size()) {
+        delete iterator;
+        return nullptr;
+    }
+    return iterator;
+}
+
+void esp_partition_iterator_release(esp_partition_iterator_t iterator) {
+    delete iterator;
+}
+
+const esp_partition_t* esp_ota_get_running_partition(void) {
+    static const esp_partition_t factory = {
+        .type = ESP_PARTITION_TYPE_APP,
+        .subtype = ESP_PARTITION_SUBTYPE_APP_FACTORY,
+        .address = 0x10000,
+        .size = 0,
+        .label = "factory",
+    };
+    return &factory;
+}
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype, const char* label) {
+    std::lock_guard<std::mutex> lock(partition_mutex);
+    auto it = partitions.find(label != nullptr ? label : "");
+    if (it == partitions.end() || it->second->partition.type != type) {
+        return nullptr;
+    }
+    (void)subtype;
+    return &it->second->partition;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t src_offset, void* dst, size_t size) {
+    std::lock_guard<std::mutex> lock(partition_mutex);
+    auto host = FindPartition(partition);
+    if (host == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (src_offset > host->data.size() || size > host->data.size() - src_offset) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(dst, host->data.data() + src_offset, size);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_mmap(const esp_partition_t* partition, size_t offset, size_t size,
+    esp_partition_mmap_memory_t memory, const void** out_ptr, esp_partition_mmap_handle_t* out_handle) {
+    std::lock_guard<std::mutex> lock(partition_mutex);
+    (void)memory;
+    auto host = FindPartition(partition);
+    if (host == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (offset > host->data.size() || size > host->data.size() - offset) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    static esp_partition_mmap_handle_t next_handle = 1;
+    *out_ptr = host->data.data() + offset;
+    *out_handle = next_handle++;
+    return ESP_OK;
+}
+
+void esp_partition_munmap(esp_partition_mmap_handle_t handle) {
+    (void)handle;
+}
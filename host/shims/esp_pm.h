@@ -0,0 +1,23 @@
+#ifndef HOST_ESP_PM_H
+#define HOST_ESP_PM_H
+
+#include "esp_err.h"
+
+typedef enum {
+    ESP_PM_CPU_FREQ_MAX,
+    ESP_PM_APB_FREQ_MAX,
+    ESP_PM_NO_LIGHT_SLEEP,
+} esp_pm_lock_type_t;
+
+typedef struct esp_pm_lock* esp_pm_lock_handle_t;
+
+// Same as a build without CONFIG_PM_ENABLE
+inline esp_err_t esp_pm_lock_create(esp_pm_lock_type_t, int, const char*, esp_pm_lock_handle_t* out_handle) {
+    *out_handle = nullptr;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+inline esp_err_t esp_pm_lock_delete(esp_pm_lock_handle_t) { return ESP_ERR_NOT_SUPPORTED; }
+inline esp_err_t esp_pm_lock_acquire(esp_pm_lock_handle_t) { return ESP_ERR_NOT_SUPPORTED; }
+inline esp_err_t esp_pm_lock_release(esp_pm_lock_handle_t) { return ESP_ERR_NOT_SUPPORTED; }
+
+#endif // HOST_ESP_PM_H
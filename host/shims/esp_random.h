@@ -0,0 +1,10 @@
+#ifndef HOST_ESP_RANDOM_H
+#define HOST_ESP_RANDOM_H
+
+#include <cstddef>
+#include <cstdint>
+
+uint32_t esp_random(void);
+void esp_fill_random(void* buf, size_t len);
+
+#endif // HOST_ESP_RANDOM_H
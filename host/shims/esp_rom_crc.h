@@ -0,0 +1,9 @@
+#ifndef HOST_ESP_ROM_CRC_H
+#define HOST_ESP_ROM_CRC_H
+
+#include <cstdint>
+
+// Same result as zlib.crc32() for crc == 0, like the ROM function
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t* buf, uint32_t len);
+
+#endif // HOST_ESP_ROM_CRC_H
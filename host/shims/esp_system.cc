@@ -0,0 +1,109 @@
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_random.h"
+#include "nvs.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <mutex>
+#include <random>
+#include <vector>
+
+#include "esp_timer.h"
+
+namespace {
+
+std::atomic<int> log_level = [] {
+    const char* env = getenv("XIAOZHI_HOST_LOG_LEVEL");
+    return env != nullptr ? atoi(env) : static_cast<int>(ESP_LOG_INFO);
+}();
+
+std::mutex shutdown_mutex;
+std::vector<shutdown_handler_t> shutdown_handlers;
+
+} // namespace
+
+const char* esp_err_to_name(esp_err_t code) {
+    switch (code) {
+    case ESP_OK: return "ESP_OK";
+    case ESP_FAIL: return "ESP_FAIL";
+    case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE: return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT: return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_NVS_NOT_FOUND: return "ESP_ERR_NVS_NOT_FOUND";
+    case ESP_ERR_NVS_TYPE_MISMATCH: return "ESP_ERR_NVS_TYPE_MISMATCH";
+    case ESP_ERR_NVS_READ_ONLY: return "ESP_ERR_NVS_READ_ONLY";
+    case ESP_ERR_NVS_INVALID_HANDLE: return "ESP_ERR_NVS_INVALID_HANDLE";
+    case ESP_ERR_NVS_INVALID_LENGTH: return "ESP_ERR_NVS_INVALID_LENGTH";
+    default: return "UNKNOWN ERROR";
+    }
+}
+
+void esp_log_level_set(const char* tag, esp_log_level_t level) {
+    (void)tag;
+    log_level = level;
+}
+
+void esp_log_write(esp_log_level_t level, const char* tag, const char* format, ...) {
+    if (level > log_level) {
+        return;
+    }
+    static const char kLetters[] = "NEWIDV";
+    char line[512];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    // One write per line, so lines from different threads do not interleave
+    fprintf(stderr, "%c (%lld) %s: %s\n", kLetters[level], (long long)(esp_timer_get_time() / 1000), tag, line);
+}
+
+esp_err_t esp_register_shutdown_handler(shutdown_handler_t handle) {
+    std::lock_guard<std::mutex> lock(shutdown_mutex);
+    shutdown_handlers.push_back(handle);
+    return ESP_OK;
+}
+
+esp_err_t esp_unregister_shutdown_handler(shutdown_handler_t handle) {
+    std::lock_guard<std::mutex> lock(shutdown_mutex);
+    auto it = std::find(shutdown_handlers.begin(), shutdown_handlers.end(), handle);
+    if (it == shutdown_handlers.end()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    shutdown_handlers.erase(it);
+    return ESP_OK;
+}
+
+void esp_restart(void) {
+    std::vector<shutdown_handler_t> handlers;
+    {
+        std::lock_guard<std::mutex> lock(shutdown_mutex);
+        handlers = shutdown_handlers;
+    }
+    for (auto it = handlers.rbegin(); it != handlers.rend(); ++it) {
+        (*it)();
+    }
+    fflush(stderr);
+    std::_Exit(0);
+}
+
+uint32_t esp_random(void) {
+    static std::mutex random_mutex;
+    static std::mt19937 generator(std::random_device{}());
+    std::lock_guard<std::mutex> lock(random_mutex);
+    return generator();
+}
+
+void esp_fill_random(void* buf, size_t len) {
+    auto bytes = static_cast<uint8_t*>(buf);
+    for (size_t i = 0; i < len; i++) {
+        bytes[i] = esp_random() & 0xff;
+    }
+}
@@ -0,0 +1,18 @@
+#ifndef HOST_ESP_SYSTEM_H
+#define HOST_ESP_SYSTEM_H
+
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+
+typedef void (*shutdown_handler_t)(void);
+
+esp_err_t esp_register_shutdown_handler(shutdown_handler_t handle);
+esp_err_t esp_unregister_shutdown_handler(shutdown_handler_t handle);
+// Runs the shutdown handlers and exits the process
+[[noreturn]] void esp_restart(void);
+
+// Same fixed values as heap_caps_get_free_size()
+inline uint32_t esp_get_free_heap_size(void) { return heap_caps_get_free_size(MALLOC_CAP_DEFAULT); }
+inline uint32_t esp_get_minimum_free_heap_size(void) { return heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT); }
+
+#endif // HOST_ESP_SYSTEM_H
@@ -0,0 +1,168 @@
+#include "esp_timer.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+struct esp_timer {
+    esp_timer_cb_t callback;
+    void* arg;
+    std::string name;
+    bool skip_unhandled_events;
+    bool active = false;
+    uint64_t period_us = 0;     // 0 for one-shot timers
+    int64_t deadline_us = 0;
+};
+
+namespace {
+
+const auto kClockStart = std::chrono::steady_clock::now();
+
+class TimerDispatcher {
+public:
+    static TimerDispatcher& GetInstance() {
+        // Leaked, the dispatch thread outlives static destructors
+        static TimerDispatcher* instance = new TimerDispatcher();
+        return *instance;
+    }
+
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::set<esp_timer*> timers_;
+    esp_timer* running_ = nullptr;
+    std::thread::id thread_id_;
+
+    void Start(esp_timer* timer, uint64_t timeout_us, uint64_t period_us) {
+        timer->active = true;
+        timer->period_us = period_us;
+        timer->deadline_us = esp_timer_get_time() + timeout_us;
+        condition_.notify_all();
+    }
+
+private:
+    TimerDispatcher() {
+        std::thread thread([this]() { Loop(); });
+        thread_id_ = thread.get_id();
+        thread.detach();
+    }
+
+    esp_timer* NextDue(int64_t now, int64_t& wait_us) {
+        esp_timer* next = nullptr;
+        for (auto timer : timers_) {
+            if (timer->active && (next == nullptr || timer->deadline_us < next->deadline_us)) {
+                next = timer;
+            }
+        }
+        wait_us = next == nullptr ? -1 : next->deadline_us - now;
+        return next;
+    }
+
+    void Loop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            int64_t now = esp_timer_get_time();
+            int64_t wait_us;
+            esp_timer* timer = NextDue(now, wait_us);
+            if (timer == nullptr) {
+                condition_.wait(lock);
+                continue;
+            }
+            if (wait_us > 0) {
+                condition_.wait_for(lock, std::chrono::microseconds(wait_us));
+                continue;
+            }
+
+            if (timer->period_us == 0) {
+                timer->active = false;
+            } else {
+                timer->deadline_us += timer->period_us;
+                if (timer->skip_unhandled_events && timer->deadline_us <= now) {
+                    timer->deadline_us = now + timer->period_us;
+                }
+            }
+            running_ = timer;
+            lock.unlock();
+            timer->callback(timer->arg);
+            lock.lock();
+            running_ = nullptr;
+            condition_.notify_all();
+        }
+    }
+};
+
+} // namespace
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* create_args, esp_timer_handle_t* out_handle) {
+    if (create_args == nullptr || create_args->callback == nullptr || out_handle == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    auto& dispatcher = TimerDispatcher::GetInstance();
+    auto timer = new esp_timer{create_args->callback, create_args->arg,
+        create_args->name != nullptr ? create_args->name : "", create_args->skip_unhandled_events};
+    std::lock_guard<std::mutex> lock(dispatcher.mutex_);
+    dispatcher.timers_.insert(timer);
+    *out_handle = timer;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+    auto& dispatcher = TimerDispatcher::GetInstance();
+    std::lock_guard<std::mutex> lock(dispatcher.mutex_);
+    if (timer->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    dispatcher.Start(timer, timeout_us, 0);
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period) {
+    auto& dispatcher = TimerDispatcher::GetInstance();
+    std::lock_guard<std::mutex> lock(dispatcher.mutex_);
+    if (timer->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    dispatcher.Start(timer, period, period);
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+    auto& dispatcher = TimerDispatcher::GetInstance();
+    std::lock_guard<std::mutex> lock(dispatcher.mutex_);
+    if (!timer->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->active = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer) {
+    if (timer == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    auto& dispatcher = TimerDispatcher::GetInstance();
+    std::unique_lock<std::mutex> lock(dispatcher.mutex_);
+    if (timer->active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    // Wait for a running callback, unless the timer deletes itself from it
+    if (std::this_thread::get_id() != dispatcher.thread_id_) {
+        dispatcher.condition_.wait(lock, [&]() { return dispatcher.running_ != timer; });
+    }
+    dispatcher.timers_.erase(timer);
+    delete timer;
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer) {
+    auto& dispatcher = TimerDispatcher::GetInstance();
+    std::lock_guard<std::mutex> lock(dispatcher.mutex_);
+    return timer->active;
+}
+
+int64_t esp_timer_get_time(void) {
+    auto elapsed = std::chrono::steady_clock::now() - kClockStart;
+    return std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+}
@@ -0,0 +1,37 @@
+#ifndef HOST_FONT_AWESOME_SYMBOLS_H
+#define HOST_FONT_AWESOME_SYMBOLS_H
+
+// The icons main/ uses from xiaozhi-fonts, as readable names instead of the glyph code points
+#define FONT_AWESOME_VOLUME_MUTE          "volume_mute"
+#define FONT_AWESOME_BATTERY_CHARGING     "battery_charging"
+#define FONT_AWESOME_BATTERY_EMPTY        "battery_empty"
+#define FONT_AWESOME_BATTERY_1            "battery_1"
+#define FONT_AWESOME_BATTERY_2            "battery_2"
+#define FONT_AWESOME_BATTERY_3            "battery_3"
+#define FONT_AWESOME_BATTERY_FULL         "battery_full"
+#define FONT_AWESOME_DOWNLOAD             "download"
+#define FONT_AWESOME_WIFI                 "wifi"
+#define FONT_AWESOME_WIFI_OFF             "wifi_off"
+#define FONT_AWESOME_EMOJI_NEUTRAL        "emoji_neutral"
+#define FONT_AWESOME_EMOJI_HAPPY          "emoji_happy"
+#define FONT_AWESOME_EMOJI_LAUGHING       "emoji_laughing"
+#define FONT_AWESOME_EMOJI_FUNNY          "emoji_funny"
+#define FONT_AWESOME_EMOJI_SAD            "emoji_sad"
+#define FONT_AWESOME_EMOJI_ANGRY          "emoji_angry"
+#define FONT_AWESOME_EMOJI_CRYING         "emoji_crying"
+#define FONT_AWESOME_EMOJI_LOVING         "emoji_loving"
+#define FONT_AWESOME_EMOJI_EMBARRASSED    "emoji_embarrassed"
+#define FONT_AWESOME_EMOJI_SURPRISED      "emoji_surprised"
+#define FONT_AWESOME_EMOJI_SHOCKED        "emoji_shocked"
+#define FONT_AWESOME_EMOJI_THINKING       "emoji_thinking"
+#define FONT_AWESOME_EMOJI_WINKING        "emoji_winking"
+#define FONT_AWESOME_EMOJI_COOL           "emoji_cool"
+#define FONT_AWESOME_EMOJI_RELAXED        "emoji_relaxed"
+#define FONT_AWESOME_EMOJI_DELICIOUS      "emoji_delicious"
+#define FONT_AWESOME_EMOJI_KISSY          "emoji_kissy"
+#define FONT_AWESOME_EMOJI_CONFIDENT      "emoji_confident"
+#define FONT_AWESOME_EMOJI_SLEEPY         "emoji_sleepy"
+#define FONT_AWESOME_EMOJI_SILLY          "emoji_silly"
+#define FONT_AWESOME_EMOJI_CONFUSED       "emoji_confused"
+
+#endif // HOST_FONT_AWESOME_SYMBOLS_H
@@ -0,0 +1,252 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include "freertos/semphr.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <pthread.h>
+#include <time.h>
+
+struct HostTask {
+    std::string name;
+    UBaseType_t number = 0;
+    UBaseType_t priority = 0;
+    clockid_t cpu_clock = 0;
+};
+
+namespace {
+
+// Thrown by vTaskDelete(nullptr) to unwind the calling task back to its thread entry
+struct TaskDeleted {};
+
+thread_local HostTask* current_task = nullptr;
+
+// Tasks whose function has not returned yet, for uxTaskGetSystemState()
+std::mutex tasks_mutex;
+std::list<HostTask*> running_tasks;
+UBaseType_t next_task_number = 1;
+
+std::chrono::steady_clock::time_point Deadline(TickType_t ticks) {
+    return std::chrono::steady_clock::now() + std::chrono::milliseconds(pdTICKS_TO_MS(ticks));
+}
+
+} // namespace
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t stack_depth,
+    void* arg, UBaseType_t priority, TaskHandle_t* out_handle, BaseType_t core_id) {
+    (void)core_id;
+    if (stack_depth == 0) {
+        return pdFAIL;
+    }
+    // The handle is leaked on purpose: a FreeRTOS handle may still be compared after the task ended
+    auto task = new HostTask{name != nullptr ? name : ""};
+    task->priority = priority;
+    if (out_handle != nullptr) {
+        *out_handle = task;
+    }
+    std::thread([function, arg, task]() {
+        current_task = task;
+        {
+            std::lock_guard<std::mutex> lock(tasks_mutex);
+            task->number = next_task_number++;
+            pthread_getcpuclockid(pthread_self(), &task->cpu_clock);
+            running_tasks.push_back(task);
+        }
+        try {
+            function(arg);
+        } catch (const TaskDeleted&) {
+        }
+        std::lock_guard<std::mutex> lock(tasks_mutex);
+        running_tasks.remove(task);
+    }).detach();
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char* name, uint32_t stack_depth,
+    void* arg, UBaseType_t priority, TaskHandle_t* out_handle) {
+    return xTaskCreatePinnedToCore(function, name, stack_depth, arg, priority, out_handle, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    if (task == nullptr || task == current_task) {
+        throw TaskDeleted();
+    }
+}
+
+void vTaskDelay(TickType_t ticks) {
+    std::this_thread::sleep_until(Deadline(ticks));
+}
+
+TickType_t xTaskGetTickCount(void) {
+    static const auto start = std::chrono::steady_clock::now();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return pdMS_TO_TICKS(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count());
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    return current_task;
+}
+
+const char* pcTaskGetName(TaskHandle_t task) {
+    if (task == nullptr) {
+        task = current_task;
+    }
+    return task != nullptr ? task->name.c_str() : "main";
+}
+
+void vTaskPrioritySet(TaskHandle_t task, UBaseType_t priority) {
+    std::lock_guard<std::mutex> lock(tasks_mutex);
+    if (task == nullptr) {
+        task = current_task;
+    }
+    if (task != nullptr) {
+        task->priority = priority;
+    }
+}
+
+UBaseType_t uxTaskGetNumberOfTasks(void) {
+    std::lock_guard<std::mutex> lock(tasks_mutex);
+    return running_tasks.size();
+}
+
+UBaseType_t uxTaskGetSystemState(TaskStatus_t* task_status_array, UBaseType_t array_size,
+    configRUN_TIME_COUNTER_TYPE* total_run_time) {
+    std::lock_guard<std::mutex> lock(tasks_mutex);
+    if (running_tasks.size() > array_size) {
+        return 0;
+    }
+    UBaseType_t count = 0;
+    for (auto task : running_tasks) {
+        timespec cpu_time = {};
+        clock_gettime(task->cpu_clock, &cpu_time);
+        auto& status = task_status_array[count++];
+        status = {};
+        status.xHandle = task;
+        status.pcTaskName = task->name.c_str();
+        status.xTaskNumber = task->number;
+        status.eCurrentState = task == current_task ? eRunning : eReady;
+        status.uxCurrentPriority = task->priority;
+        status.uxBasePriority = task->priority;
+        status.ulRunTimeCounter = cpu_time.tv_sec * 1000000 + cpu_time.tv_nsec / 1000;
+        status.xCoreID = tskNO_AFFINITY;
+    }
+    if (total_run_time != nullptr) {
+        static const auto start = std::chrono::steady_clock::now();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        *total_run_time = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    }
+    return count;
+}
+
+TaskHandle_t xTaskGetIdleTaskHandleForCore(BaseType_t core_id) {
+    (void)core_id;
+    return nullptr;
+}
+
+void vTaskList(char* buffer) {
+    std::lock_guard<std::mutex> lock(tasks_mutex);
+    buffer[0] = '\0';
+    for (auto task : running_tasks) {
+        buffer += sprintf(buffer, "%-16s\tR\t%u\t0\t%u\n", task->name.c_str(), task->priority, task->number);
+    }
+}
+
+struct HostEventGroup {
+    std::mutex mutex;
+    std::condition_variable condition;
+    EventBits_t bits = 0;
+};
+
+EventGroupHandle_t xEventGroupCreate(void) {
+    return new HostEventGroup();
+}
+
+void vEventGroupDelete(EventGroupHandle_t group) {
+    delete group;
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits) {
+    std::lock_guard<std::mutex> lock(group->mutex);
+    group->bits |= bits;
+    group->condition.notify_all();
+    return group->bits;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits) {
+    std::lock_guard<std::mutex> lock(group->mutex);
+    EventBits_t previous = group->bits;
+    group->bits &= ~bits;
+    return previous;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group) {
+    std::lock_guard<std::mutex> lock(group->mutex);
+    return group->bits;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clear_on_exit,
+    BaseType_t wait_for_all, TickType_t ticks_to_wait) {
+    std::unique_lock<std::mutex> lock(group->mutex);
+    auto ready = [&]() {
+        return wait_for_all ? (group->bits & bits) == bits : (group->bits & bits) != 0;
+    };
+    if (ticks_to_wait == portMAX_DELAY) {
+        group->condition.wait(lock, ready);
+    } else {
+        group->condition.wait_until(lock, Deadline(ticks_to_wait), ready);
+    }
+    // Like FreeRTOS, the bits are returned as they were before clearing
+    EventBits_t result = group->bits;
+    if (ready() && clear_on_exit) {
+        group->bits &= ~bits;
+    }
+    return result;
+}
+
+struct HostSemaphore {
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool available = false;
+};
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+    return new HostSemaphore();
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    auto semaphore = new HostSemaphore();
+    semaphore->available = true;
+    return semaphore;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore) {
+    delete semaphore;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks_to_wait) {
+    std::unique_lock<std::mutex> lock(semaphore->mutex);
+    auto ready = [semaphore]() { return semaphore->available; };
+    if (ticks_to_wait == portMAX_DELAY) {
+        semaphore->condition.wait(lock, ready);
+    } else if (!semaphore->condition.wait_until(lock, Deadline(ticks_to_wait), ready)) {
+        return pdFALSE;
+    }
+    semaphore->available = false;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    std::lock_guard<std::mutex> lock(semaphore->mutex);
+    if (semaphore->available) {
+        return pdFALSE;
+    }
+    semaphore->available = true;
+    semaphore->condition.notify_one();
+    return pdTRUE;
+}
@@ -0,0 +1,27 @@
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+#include <cstdint>
+#include "sdkconfig.h"
+#include "esp_heap_caps.h"
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint32_t StackType_t;
+typedef uint32_t configRUN_TIME_COUNTER_TYPE;
+
+#define configTICK_RATE_HZ      1000
+#define configMAX_TASK_NAME_LEN 16
+#define portTICK_PERIOD_MS      (1000 / configTICK_RATE_HZ)
+#define portMAX_DELAY           ((TickType_t)0xffffffffUL)
+#define pdMS_TO_TICKS(ms)       ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000))
+#define pdTICKS_TO_MS(ticks)    ((uint32_t)(((uint64_t)(ticks) * 1000) / configTICK_RATE_HZ))
+
+#define pdFALSE                 ((BaseType_t)0)
+#define pdTRUE                  ((BaseType_t)1)
+#define pdFAIL                  pdFALSE
+#define pdPASS                  pdTRUE
+#define tskNO_AFFINITY          0x7fffffff
+
+#endif // HOST_FREERTOS_H
@@ -0,0 +1,59 @@
+#ifndef HOST_FREERTOS_TASK_H
+#define HOST_FREERTOS_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef struct HostTask* TaskHandle_t;
+typedef void (*TaskFunction_t)(void* arg);
+
+/**
+ * Tasks are std::threads. Priorities, core affinity and stack sizes are ignored, the stack size
+ * is only checked to be non zero. vTaskDelete(nullptr) ends the calling task; deleting another
+ * task is not possible on the host, it is detached and keeps running, so objects owning a task
+ * must outlive it.
+ */
+BaseType_t xTaskCreate(TaskFunction_t function, const char* name, uint32_t stack_depth,
+    void* arg, UBaseType_t priority, TaskHandle_t* out_handle);
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t stack_depth,
+    void* arg, UBaseType_t priority, TaskHandle_t* out_handle, BaseType_t core_id);
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+const char* pcTaskGetName(TaskHandle_t task);
+void vTaskPrioritySet(TaskHandle_t task, UBaseType_t priority);
+
+typedef enum {
+    eRunning,
+    eReady,
+    eBlocked,
+    eSuspended,
+    eDeleted,
+    eInvalid,
+} eTaskState;
+
+typedef struct {
+    TaskHandle_t xHandle;
+    const char* pcTaskName;
+    UBaseType_t xTaskNumber;
+    eTaskState eCurrentState;
+    UBaseType_t uxCurrentPriority;
+    UBaseType_t uxBasePriority;
+    configRUN_TIME_COUNTER_TYPE ulRunTimeCounter;
+    StackType_t* pxStackBase;
+    uint32_t usStackHighWaterMark;
+    BaseType_t xCoreID;
+} TaskStatus_t;
+
+/**
+ * Only tasks created with xTaskCreate*() are listed, there are no idle tasks. The run time counter
+ * is the CPU time of the thread in microseconds and the total is the wall time since the first call,
+ * so the load of a task is relative to one core. The stack high water mark is not known and is 0.
+ */
+UBaseType_t uxTaskGetNumberOfTasks(void);
+UBaseType_t uxTaskGetSystemState(TaskStatus_t* task_status_array, UBaseType_t array_size,
+    configRUN_TIME_COUNTER_TYPE* total_run_time);
+TaskHandle_t xTaskGetIdleTaskHandleForCore(BaseType_t core_id);
+void vTaskList(char* buffer);
+
+#endif // HOST_FREERTOS_TASK_H
@@ -0,0 +1,7 @@
+#ifndef HOST_HTTP_H
+#define HOST_HTTP_H
+
+// esp-ml307 network class, only declared: Board hands out pointers, the host board has no network
+class Http;
+
+#endif // HOST_HTTP_H
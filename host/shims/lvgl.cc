@@ -0,0 +1,29 @@
+#include "lvgl.h"
+
+#include <cstring>
+
+lv_font_t* lv_binfont_create_from_buffer(void* buffer, uint32_t size) {
+    // First table: length (including these 8 bytes), "head", u32 version, u16 table count, u16 font size,
+    // u16 ascent, i16 descent
+    const uint8_t* data = static_cast<const uint8_t*>(buffer);
+    if (buffer == nullptr || size < 20 || memcmp(data + 4, "head", 4) != 0) {
+        return nullptr;
+    }
+    uint32_t length;
+    memcpy(&length, data, sizeof(length));
+    if (length < 20 || length > size) {
+        return nullptr;
+    }
+    uint16_t ascent;
+    int16_t descent;
+    memcpy(&ascent, data + 16, sizeof(ascent));
+    memcpy(&descent, data + 18, sizeof(descent));
+    auto font = new lv_font_t();
+    font->line_height = ascent - descent;
+    font->base_line = -descent;
+    return font;
+}
+
+void lv_binfont_destroy(lv_font_t* font) {
+    delete font;
+}
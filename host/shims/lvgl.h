@@ -0,0 +1,69 @@
+#ifndef HOST_LVGL_H
+#define HOST_LVGL_H
+
+#include <cstdint>
+
+/**
+ * The few LVGL types and functions used by the host built sources, not LVGL itself.
+ * lv_binfont_create_from_buffer() only reads the "head" table of an lv_font_conv binary font.
+ * No object or display is ever created, the object functions are there for Display to link.
+ */
+#define LV_USE_FS_MEMFS 1
+#define LV_IMAGE_HEADER_MAGIC 0x19
+
+typedef struct lv_font_t {
+    int32_t line_height;
+    int32_t base_line;
+    const struct lv_font_t* fallback;
+    const void* dsc;
+} lv_font_t;
+
+typedef struct {
+    uint32_t magic: 8;
+    uint32_t cf: 8;
+    uint32_t flags: 16;
+    uint32_t w: 16;
+    uint32_t h: 16;
+    uint32_t stride: 16;
+    uint32_t reserved_2: 16;
+} lv_image_header_t;
+
+typedef struct {
+    lv_image_header_t header;
+    uint32_t data_size;
+    const uint8_t* data;
+    const void* reserved;
+} lv_image_dsc_t;
+
+typedef lv_image_dsc_t lv_img_dsc_t;
+
+#define LV_COLOR_FORMAT_RGB565          0x12
+#define LV_IMAGE_FLAGS_MODIFIABLE       0x0010
+#define LV_IMAGE_FLAGS_ALLOCATED        0x0100
+
+typedef struct lv_obj_t lv_obj_t;
+typedef struct lv_display_t lv_display_t;
+typedef struct lv_event_t lv_event_t;
+typedef void (*lv_event_cb_t)(lv_event_t* e);
+
+typedef enum {
+    LV_OBJ_FLAG_HIDDEN = 1 << 0,
+} lv_obj_flag_t;
+
+typedef enum {
+    LV_EVENT_RENDER_START = 35,
+    LV_EVENT_RENDER_READY = 36,
+} lv_event_code_t;
+
+lv_font_t* lv_binfont_create_from_buffer(void* buffer, uint32_t size);
+void lv_binfont_destroy(lv_font_t* font);
+
+inline void lv_obj_del(lv_obj_t*) {}
+inline void lv_obj_add_flag(lv_obj_t*, lv_obj_flag_t) {}
+inline void lv_obj_clear_flag(lv_obj_t*, lv_obj_flag_t) {}
+inline void lv_label_set_text(lv_obj_t*, const char*) {}
+inline void lv_display_add_event_cb(lv_display_t*, lv_event_cb_t, lv_event_code_t, void*) {}
+inline lv_event_code_t lv_event_get_code(lv_event_t*) { return LV_EVENT_RENDER_READY; }
+inline void* lv_event_get_user_data(lv_event_t*) { return nullptr; }
+
+#endif // HOST_LVGL_H
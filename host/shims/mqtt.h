@@ -0,0 +1,7 @@
+#ifndef HOST_MQTT_H
+#define HOST_MQTT_H
+
+// esp-ml307 network class, only declared: Board hands out pointers, the host board has no network
+class Mqtt;
+
+#endif // HOST_MQTT_H
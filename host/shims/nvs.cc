@@ -0,0 +1,247 @@
+#include "nvs_flash.h"
+
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <variant>
+
+namespace {
+
+using Value = std::variant<int32_t, std::string>;
+
+struct OpenHandle {
+    std::string ns;
+    bool read_write;
+};
+
+std::mutex nvs_mutex;
+std::map<std::string, std::map<std::string, Value>> namespaces;
+std::map<nvs_handle_t, OpenHandle> handles;
+nvs_handle_t next_handle = 1;
+bool fail_writes = false;
+
+OpenHandle* FindHandle(nvs_handle_t handle) {
+    auto it = handles.find(handle);
+    return it == handles.end() ? nullptr : &it->second;
+}
+
+} // namespace
+
+struct nvs_opaque_iterator_t {
+    std::string ns;
+    nvs_type_t type;
+    std::string key;    // Current key, the map may change between calls
+};
+
+esp_err_t nvs_flash_init(void) {
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void) {
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    namespaces.clear();
+    return ESP_OK;
+}
+
+void nvs_host_fail_writes(bool fail) {
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    fail_writes = fail;
+}
+
+esp_err_t nvs_open(const char* name, nvs_open_mode_t open_mode, nvs_handle_t* out_handle) {
+    if (name == nullptr || strlen(name) >= 16) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    if (fail_writes && open_mode == NVS_READWRITE) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+    if (namespaces.find(name) == namespaces.end()) {
+        if (open_mode == NVS_READONLY) {
+            return ESP_ERR_NVS_NOT_FOUND;
+        }
+        namespaces[name];
+    }
+    *out_handle = next_handle++;
+    handles[*out_handle] = OpenHandle{name, open_mode == NVS_READWRITE};
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle) {
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    handles.erase(handle);
+}
+
+template <typename T>
+static esp_err_t GetValue(nvs_handle_t handle, const char* key, const T** out_value) {
+    auto open = FindHandle(handle);
+    if (open == nullptr) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    auto& entries = namespaces[open->ns];
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    *out_value = std::get_if<T>(&it->second);
+    return *out_value == nullptr ? ESP_ERR_NVS_TYPE_MISMATCH : ESP_OK;
+}
+
+static esp_err_t SetValue(nvs_handle_t handle, const char* key, Value&& value) {
+    auto open = FindHandle(handle);
+    if (open == nullptr) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    if (!open->read_write) {
+        return ESP_ERR_NVS_READ_ONLY;
+    }
+    if (key == nullptr || strlen(key) >= NVS_KEY_NAME_MAX_SIZE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    namespaces[open->ns][key] = std::move(value);
+    return ESP_OK;
+}
+
+esp_err_t nvs_get_i32(nvs_handle_t handle, const char* key, int32_t* out_value) {
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    const int32_t* value;
+    esp_err_t ret = GetValue(handle, key, &value);
+    if (ret == ESP_OK) {
+        *out_value = *value;
+    }
+    return ret;
+}
+
+esp_err_t nvs_set_i32(nvs_handle_t handle, const char* key, int32_t value) {
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    return SetValue(handle, key, value);
+}
+
+esp_err_t nvs_get_str(nvs_handle_t handle, const char* key, char* out_value, size_t* length) {
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    const std::string* value;
+    esp_err_t ret = GetValue(handle, key, &value);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    // Like the flash implementation, the length includes the terminating zero
+    size_t required = value->size() + 1;
+    if (out_value == nullptr) {
+        *length = required;
+        return ESP_OK;
+    }
+    if (*length < required) {
+        *length = required;
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    memcpy(out_value, value->c_str(), required);
+    *length = required;
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_str(nvs_handle_t handle, const char* key, const char* value) {
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    return SetValue(handle, key, std::string(value));
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char* key) {
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    auto open = FindHandle(handle);
+    if (open == nullptr) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    if (!open->read_write) {
+        return ESP_ERR_NVS_READ_ONLY;
+    }
+    return namespaces[open->ns].erase(key) > 0 ? ESP_OK : ESP_ERR_NVS_NOT_FOUND;
+}
+
+esp_err_t nvs_erase_all(nvs_handle_t handle) {
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    auto open = FindHandle(handle);
+    if (open == nullptr) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    if (!open->read_write) {
+        return ESP_ERR_NVS_READ_ONLY;
+    }
+    namespaces[open->ns].clear();
+    return ESP_OK;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) {
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    return FindHandle(handle) != nullptr ? ESP_OK : ESP_ERR_NVS_INVALID_HANDLE;
+}
+
+static bool TypeMatches(const Value& value, nvs_type_t type) {
+    return type == NVS_TYPE_ANY ||
+        (type == NVS_TYPE_I32 && std::holds_alternative<int32_t>(value)) ||
+        (type == NVS_TYPE_STR && std::holds_alternative<std::string>(value));
+}
+
+// Moves the iterator to the first matching key after `after`, or the first one when after is null
+static bool Advance(nvs_opaque_iterator_t* iterator, const std::string* after) {
+    auto space = namespaces.find(iterator->ns);
+    if (space == namespaces.end()) {
+        return false;
+    }
+    auto it = after == nullptr ? space->second.begin() : space->second.upper_bound(*after);
+    for (; it != space->second.end(); ++it) {
+        if (TypeMatches(it->second, iterator->type)) {
+            iterator->key = it->first;
+            return true;
+        }
+    }
+    return false;
+}
+
+esp_err_t nvs_entry_find(const char* part_name, const char* namespace_name, nvs_type_t type, nvs_iterator_t* output_iterator) {
+    (void)part_name;
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    auto iterator = new nvs_opaque_iterator_t{namespace_name != nullptr ? namespace_name : "", type, ""};
+    if (!Advance(iterator, nullptr)) {
+        delete iterator;
+        *output_iterator = nullptr;
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    *output_iterator = iterator;
+    return ESP_OK;
+}
+
+esp_err_t nvs_entry_next(nvs_iterator_t* iterator) {
+    if (iterator == nullptr || *iterator == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    std::string current = (*iterator)->key;
+    if (!Advance(*iterator, &current)) {
+        // Same as the flash implementation, the iterator is released at the end
+        delete *iterator;
+        *iterator = nullptr;
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    return ESP_OK;
+}
+
+esp_err_t nvs_entry_info(const nvs_iterator_t iterator, nvs_entry_info_t* out_info) {
+    if (iterator == nullptr || out_info == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    std::lock_guard<std::mutex> lock(nvs_mutex);
+    memset(out_info, 0, sizeof(*out_info));
+    strncpy(out_info->namespace_name, iterator->ns.c_str(), sizeof(out_info->namespace_name) - 1);
+    strncpy(out_info->key, iterator->key.c_str(), sizeof(out_info->key) - 1);
+    out_info->type = NVS_TYPE_ANY;
+    auto& entries = namespaces[iterator->ns];
+    auto it = entries.find(iterator->key);
+    if (it != entries.end()) {
+        out_info->type = std::holds_alternative<int32_t>(it->second) ? NVS_TYPE_I32 : NVS_TYPE_STR;
+    }
+    return ESP_OK;
+}
+
+void nvs_release_iterator(nvs_iterator_t iterator) {
+    delete iterator;
+}
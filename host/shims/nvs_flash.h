@@ -0,0 +1,12 @@
+#ifndef HOST_NVS_FLASH_H
+#define HOST_NVS_FLASH_H
+
+#include "nvs.h"
+
+esp_err_t nvs_flash_init(void);
+// Drops every namespace, a test can start from a blank flash
+esp_err_t nvs_flash_erase(void);
+// Host only: read-write nvs_open() fails while set, to test the error paths
+void nvs_host_fail_writes(bool fail);
+
+#endif // HOST_NVS_FLASH_H
@@ -0,0 +1,50 @@
+#include "opus_encoder.h"
+#include "opus_decoder.h"
+
+#include <cstring>
+
+OpusEncoderWrapper::OpusEncoderWrapper(int sample_rate, int channels, int duration_ms)
+    : sample_rate_(sample_rate), duration_ms_(duration_ms),
+      frame_size_(static_cast<size_t>(sample_rate) * channels * duration_ms / 1000) {
+}
+
+void OpusEncoderWrapper::Encode(std::vector<int16_t>&& pcm, std::function<void(std::vector<uint8_t>&& opus)> handler) {
+    std::vector<std::vector<uint8_t>> packets;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        in_buffer_.insert(in_buffer_.end(), pcm.begin(), pcm.end());
+        size_t used = 0;
+        for (; in_buffer_.size() - used >= frame_size_; used += frame_size_) {
+            auto& packet = packets.emplace_back(frame_size_ * sizeof(int16_t));
+            memcpy(packet.data(), in_buffer_.data() + used, packet.size());
+        }
+        in_buffer_.erase(in_buffer_.begin(), in_buffer_.begin() + used);
+    }
+    // Outside the lock, the handler may reset the encoder
+    for (auto& packet : packets) {
+        handler(std::move(packet));
+    }
+}
+
+bool OpusEncoderWrapper::IsBufferEmpty() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return in_buffer_.empty();
+}
+
+void OpusEncoderWrapper::ResetState() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    in_buffer_.clear();
+}
+
+OpusDecoderWrapper::OpusDecoderWrapper(int sample_rate, int channels, int duration_ms)
+    : sample_rate_(sample_rate), duration_ms_(duration_ms),
+      frame_size_(static_cast<size_t>(sample_rate) * channels * duration_ms / 1000) {
+}
+
+bool OpusDecoderWrapper::Decode(std::vector<uint8_t>&& opus, std::vector<int16_t>& pcm) {
+    pcm.assign(frame_size_, 0);
+    if (opus.size() == frame_size_ * sizeof(int16_t)) {
+        memcpy(pcm.data(), opus.data(), opus.size());
+    }
+    return true;
+}
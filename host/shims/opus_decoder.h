@@ -0,0 +1,29 @@
+#ifndef HOST_OPUS_DECODER_H
+#define HOST_OPUS_DECODER_H
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/**
+ * Decodes the PCM packets of the host OpusEncoderWrapper. Anything else, such as the real Opus
+ * frames of the embedded sounds, decodes to one frame of silence, so playback keeps its timing.
+ */
+class OpusDecoderWrapper {
+public:
+    OpusDecoderWrapper(int sample_rate, int channels, int duration_ms = 60);
+    ~OpusDecoderWrapper() = default;
+
+    inline int sample_rate() const { return sample_rate_; }
+    inline int duration_ms() const { return duration_ms_; }
+
+    bool Decode(std::vector<uint8_t>&& opus, std::vector<int16_t>& pcm);
+    void ResetState() {}
+
+private:
+    int sample_rate_;
+    int duration_ms_;
+    size_t frame_size_;
+};
+
+#endif // HOST_OPUS_DECODER_H
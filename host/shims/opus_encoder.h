@@ -0,0 +1,36 @@
+#ifndef HOST_OPUS_ENCODER_H
+#define HOST_OPUS_ENCODER_H
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+/**
+ * Stand-in for the esp-opus-encoder wrapper with the same interface and framing: input is buffered
+ * and one packet is produced per complete frame. A packet is the frame's PCM, little-endian, so
+ * tests can compare what the device sent with what the microphone captured.
+ */
+class OpusEncoderWrapper {
+public:
+    OpusEncoderWrapper(int sample_rate, int channels, int duration_ms = 60);
+    ~OpusEncoderWrapper() = default;
+
+    inline int sample_rate() const { return sample_rate_; }
+    inline int duration_ms() const { return duration_ms_; }
+
+    void SetDtx(bool enable) { (void)enable; }
+    void SetComplexity(int complexity) { (void)complexity; }
+    void Encode(std::vector<int16_t>&& pcm, std::function<void(std::vector<uint8_t>&& opus)> handler);
+    bool IsBufferEmpty() const;
+    void ResetState();
+
+private:
+    mutable std::mutex mutex_;
+    int sample_rate_;
+    int duration_ms_;
+    size_t frame_size_;
+    std::vector<int16_t> in_buffer_;
+};
+
+#endif // HOST_OPUS_ENCODER_H
@@ -0,0 +1,30 @@
+#include "opus_resampler.h"
+
+void OpusResampler::Configure(int input_sample_rate, int output_sample_rate) {
+    input_sample_rate_ = input_sample_rate;
+    output_sample_rate_ = output_sample_rate;
+    last_sample_ = 0;
+}
+
+int OpusResampler::GetOutputSamples(int input_samples) const {
+    if (input_sample_rate_ <= 0) {
+        return input_samples;
+    }
+    return static_cast<int>(static_cast<int64_t>(input_samples) * output_sample_rate_ / input_sample_rate_);
+}
+
+void OpusResampler::Process(const int16_t* input, int input_samples, int16_t* output) {
+    int output_samples = GetOutputSamples(input_samples);
+    for (int i = 0; i < output_samples; i++) {
+        // Position in input samples, Q16, interpolated between input[k - 1] and input[k]
+        int64_t position = (static_cast<int64_t>(i) * input_sample_rate_ << 16) / output_sample_rate_;
+        int k = static_cast<int>(position >> 16);
+        int32_t fraction = static_cast<int32_t>(position & 0xffff);
+        int32_t a = k == 0 ? last_sample_ : input[k - 1];
+        int32_t b = input[k];
+        output[i] = static_cast<int16_t>(a + (((b - a) * fraction) >> 16));
+    }
+    if (input_samples > 0) {
+        last_sample_ = input[input_samples - 1];
+    }
+}
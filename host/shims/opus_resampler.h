@@ -0,0 +1,26 @@
+#ifndef HOST_OPUS_RESAMPLER_H
+#define HOST_OPUS_RESAMPLER_H
+
+#include <cstdint>
+
+/**
+ * Stand-in for the esp-opus-encoder resampler with the same interface. It interpolates linearly,
+ * carrying the last sample over to the next block, which is enough for timing and level tests
+ * but not for judging audio quality.
+ */
+class OpusResampler {
+public:
+    void Configure(int input_sample_rate, int output_sample_rate);
+    void Process(const int16_t* input, int input_samples, int16_t* output);
+    int GetOutputSamples(int input_samples) const;
+
+    int input_sample_rate() const { return input_sample_rate_; }
+    int output_sample_rate() const { return output_sample_rate_; }
+
+private:
+    int input_sample_rate_ = 0;
+    int output_sample_rate_ = 0;
+    int16_t last_sample_ = 0;
+};
+
+#endif // HOST_OPUS_RESAMPLER_H
@@ -0,0 +1,13 @@
+#ifndef HOST_SDKCONFIG_H
+#define HOST_SDKCONFIG_H
+
+/**
+ * The configuration the host build compiles main/ with: MCP, no AFE, no wake word, no audio
+ * debugger or trace. Options that are not set are left undefined, as in a generated sdkconfig.h.
+ */
+#define CONFIG_IDF_TARGET "linux"
+#define CONFIG_FREERTOS_NUMBER_OF_CORES 2
+#define CONFIG_IOT_PROTOCOL_MCP 1
+#define CONFIG_LANGUAGE_ZH_CN 1
+
+#endif // HOST_SDKCONFIG_H
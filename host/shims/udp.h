@@ -0,0 +1,7 @@
+#ifndef HOST_UDP_H
+#define HOST_UDP_H
+
+// esp-ml307 network class, only declared: Board hands out pointers, the host board has no network
+class Udp;
+
+#endif // HOST_UDP_H
@@ -0,0 +1,7 @@
+#ifndef HOST_WEB_SOCKET_H
+#define HOST_WEB_SOCKET_H
+
+// esp-ml307 network class, only declared: Board hands out pointers, the host board has no network
+class WebSocket;
+
+#endif // HOST_WEB_SOCKET_H
@@ -0,0 +1,93 @@
+#include "loopback_protocol.h"
+
+#include <esp_log.h>
+
+#define TAG "LoopbackProtocol"
+
+LoopbackProtocol::LoopbackProtocol() {
+    session_id_ = "loopback";
+}
+
+bool LoopbackProtocol::Start() {
+    return true;
+}
+
+bool LoopbackProtocol::OpenAudioChannel() {
+    error_occurred_ = false;
+    last_incoming_time_ = std::chrono::steady_clock::now();
+    audio_channel_opened_ = true;
+    ESP_LOGI(TAG, "Audio channel opened");
+    if (on_audio_channel_opened_ != nullptr) {
+        on_audio_channel_opened_();
+    }
+    return true;
+}
+
+void LoopbackProtocol::CloseAudioChannel() {
+    if (!audio_channel_opened_.exchange(false)) {
+        return;
+    }
+    ESP_LOGI(TAG, "Audio channel closed");
+    if (on_audio_channel_closed_ != nullptr) {
+        on_audio_channel_closed_();
+    }
+}
+
+bool LoopbackProtocol::IsAudioChannelOpened() const {
+    return audio_channel_opened_ && !error_occurred_;
+}
+
+bool LoopbackProtocol::SendAudio(const AudioStreamPacket& packet) {
+    if (!audio_channel_opened_) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    sent_audio_.push_back(packet);
+    return true;
+}
+
+bool LoopbackProtocol::SendText(const std::string& text) {
+    if (!audio_channel_opened_) {
+        ESP_LOGW(TAG, "Channel closed, dropped: %s", text.c_str());
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    sent_texts_.push_back(text);
+    return true;
+}
+
+void LoopbackProtocol::InjectJson(const std::string& json) {
+    cJSON* root = cJSON_Parse(json.c_str());
+    if (root == nullptr) {
+        ESP_LOGE(TAG, "Failed to parse json message %s", json.c_str());
+        return;
+    }
+    last_incoming_time_ = std::chrono::steady_clock::now();
+    if (on_incoming_json_ != nullptr) {
+        on_incoming_json_(root);
+    }
+    cJSON_Delete(root);
+}
+
+void LoopbackProtocol::InjectAudio(AudioStreamPacket&& packet) {
+    last_incoming_time_ = std::chrono::steady_clock::now();
+    if (on_incoming_audio_ != nullptr) {
+        on_incoming_audio_(std::move(packet));
+    }
+}
+
+std::vector<std::string> LoopbackProtocol::GetSentTexts() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sent_texts_;
+}
+
+std::vector<AudioStreamPacket> LoopbackProtocol::GetSentAudio() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sent_audio_;
+}
+
+void LoopbackProtocol::ClearSent() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sent_texts_.clear();
+    sent_audio_.clear();
+}
@@ -0,0 +1,39 @@
+#ifndef _LOOPBACK_PROTOCOL_H_
+#define _LOOPBACK_PROTOCOL_H_
+
+#include "protocol.h"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// A protocol without a server: what the device sends is recorded, and a test plays the server
+// by injecting JSON and audio the way a WebSocket or MQTT receive task would.
+class LoopbackProtocol : public Protocol {
+public:
+    LoopbackProtocol();
+
+    bool Start() override;
+    bool OpenAudioChannel() override;
+    void CloseAudioChannel() override;
+    bool IsAudioChannelOpened() const override;
+    bool SendAudio(const AudioStreamPacket& packet) override;
+
+    // Server side
+    void InjectJson(const std::string& json);
+    void InjectAudio(AudioStreamPacket&& packet);
+    std::vector<std::string> GetSentTexts();
+    std::vector<AudioStreamPacket> GetSentAudio();
+    void ClearSent();
+
+private:
+    std::mutex mutex_;
+    std::atomic<bool> audio_channel_opened_ = false;
+    std::vector<std::string> sent_texts_;
+    std::vector<AudioStreamPacket> sent_audio_;
+
+    bool SendText(const std::string& text) override;
+};
+
+#endif // _LOOPBACK_PROTOCOL_H_
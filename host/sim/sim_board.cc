@@ -0,0 +1,104 @@
+#include "sim_board.h"
+
+#include <esp_log.h>
+
+#define TAG "SimBoard"
+
+void SimDisplay::SetStatus(const char* status) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    status_ = status;
+}
+
+void SimDisplay::ShowNotification(const char* notification, int duration_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    notifications_.push_back(notification);
+}
+
+void SimDisplay::SetEmotion(const char* emotion) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    emotion_ = emotion;
+}
+
+void SimDisplay::SetChatMessage(const char* role, const char* content) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (content != nullptr && content[0] != '\0') {
+        chat_messages_.emplace_back(role, content);
+    }
+}
+
+void SimDisplay::SetIcon(const char* icon) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    emotion_ = icon;
+}
+
+std::string SimDisplay::status() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return status_;
+}
+
+std::string SimDisplay::emotion() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return emotion_;
+}
+
+std::vector<std::pair<std::string, std::string>> SimDisplay::chat_messages() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return chat_messages_;
+}
+
+std::vector<std::string> SimDisplay::notifications() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return notifications_;
+}
+
+SimBoard::SimBoard() {
+    ESP_LOGI(TAG, "Input %d Hz, output %d Hz", codec_.input_sample_rate(), codec_.output_sample_rate());
+}
+
+std::string SimBoard::GetBoardType() {
+    return "host";
+}
+
+AudioCodec* SimBoard::GetAudioCodec() {
+    return &codec_;
+}
+
+Display* SimBoard::GetDisplay() {
+    return &display_;
+}
+
+Http* SimBoard::CreateHttp() {
+    return nullptr;
+}
+
+WebSocket* SimBoard::CreateWebSocket() {
+    return nullptr;
+}
+
+Mqtt* SimBoard::CreateMqtt() {
+    return nullptr;
+}
+
+Udp* SimBoard::CreateUdp() {
+    return nullptr;
+}
+
+void SimBoard::StartNetwork() {
+}
+
+const char* SimBoard::GetNetworkStateIcon() {
+    return nullptr;
+}
+
+void SimBoard::SetPowerSaveMode(bool enabled) {
+}
+
+std::string SimBoard::GetBoardJson() {
+    return R"({"type":"host","name":")" BOARD_NAME R"("})";
+}
+
+std::string SimBoard::GetDeviceStatusJson() {
+    return R"({"audio_speaker":{"volume":)" + std::to_string(codec_.output_volume()) + R"(}})";
+}
+
+DECLARE_BOARD(SimBoard);
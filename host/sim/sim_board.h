@@ -0,0 +1,66 @@
+#ifndef _SIM_BOARD_H_
+#define _SIM_BOARD_H_
+
+#include "board.h"
+#include "display.h"
+#include "wav_audio_codec.h"
+
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Records what the application shows instead of drawing it
+class SimDisplay : public Display {
+public:
+    void SetStatus(const char* status) override;
+    void ShowNotification(const char* notification, int duration_ms = 3000) override;
+    void SetEmotion(const char* emotion) override;
+    void SetChatMessage(const char* role, const char* content) override;
+    void SetIcon(const char* icon) override;
+
+    std::string status();
+    std::string emotion();
+    // (role, content) in the order shown, empty contents (a cleared message) are left out
+    std::vector<std::pair<std::string, std::string>> chat_messages();
+    std::vector<std::string> notifications();
+
+private:
+    std::mutex mutex_;
+    std::string status_;
+    std::string emotion_;
+    std::vector<std::pair<std::string, std::string>> chat_messages_;
+    std::vector<std::string> notifications_;
+
+    bool Lock(int timeout_ms = 0) override { return true; }
+    void Unlock() override {}
+};
+
+// The board of the host build: a WAV codec, a recording display, and no network (the protocol is
+// given to Application::Start() directly)
+class SimBoard : public Board {
+public:
+    SimBoard();
+
+    std::string GetBoardType() override;
+    AudioCodec* GetAudioCodec() override;
+    Display* GetDisplay() override;
+    Http* CreateHttp() override;
+    WebSocket* CreateWebSocket() override;
+    Mqtt* CreateMqtt() override;
+    Udp* CreateUdp() override;
+    void StartNetwork() override;
+    const char* GetNetworkStateIcon() override;
+    void SetPowerSaveMode(bool enabled) override;
+    std::string GetBoardJson() override;
+    std::string GetDeviceStatusJson() override;
+
+    WavAudioCodec& codec() { return codec_; }
+    SimDisplay& display() { return display_; }
+
+private:
+    WavAudioCodec codec_;
+    SimDisplay display_;
+};
+
+#endif // _SIM_BOARD_H_
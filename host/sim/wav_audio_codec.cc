@@ -0,0 +1,118 @@
+#include "wav_audio_codec.h"
+
+#include <esp_log.h>
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+#define TAG "WavAudioCodec"
+
+WavAudioCodec::WavAudioCodec(int input_sample_rate, int output_sample_rate) {
+    duplex_ = true;
+    input_sample_rate_ = input_sample_rate;
+    output_sample_rate_ = output_sample_rate;
+}
+
+void WavAudioCodec::QueueInput(const std::vector<int16_t>& pcm) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    input_.insert(input_.end(), pcm.begin(), pcm.end());
+}
+
+bool WavAudioCodec::QueueInputWav(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (data.size() < 12 || data.compare(0, 4, "RIFF") != 0 || data.compare(8, 4, "WAVE") != 0) {
+        ESP_LOGE(TAG, "Not a WAV file: %s", path.c_str());
+        return false;
+    }
+    bool format_ok = false;
+    for (size_t pos = 12; pos + 8 <= data.size();) {
+        uint32_t size;
+        memcpy(&size, &data[pos + 4], 4);
+        if (size > data.size() - pos - 8) {
+            break;
+        }
+        if (data.compare(pos, 4, "fmt ") == 0 && size >= 16) {
+            uint16_t format, channels, bits;
+            uint32_t rate;
+            memcpy(&format, &data[pos + 8], 2);
+            memcpy(&channels, &data[pos + 10], 2);
+            memcpy(&rate, &data[pos + 12], 4);
+            memcpy(&bits, &data[pos + 22], 2);
+            format_ok = format == 1 && channels == 1 && bits == 16 && (int)rate == input_sample_rate_;
+        } else if (data.compare(pos, 4, "data") == 0 && format_ok) {
+            std::vector<int16_t> pcm(size / 2);
+            memcpy(pcm.data(), &data[pos + 8], pcm.size() * 2);
+            QueueInput(pcm);
+            return true;
+        }
+        pos += 8 + size + (size & 1);
+    }
+    ESP_LOGE(TAG, "Expected 16-bit mono PCM at %d Hz: %s", input_sample_rate_, path.c_str());
+    return false;
+}
+
+bool WavAudioCodec::InputPending() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !input_.empty();
+}
+
+std::vector<int16_t> WavAudioCodec::GetOutput() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return output_;
+}
+
+void WavAudioCodec::ClearOutput() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    output_.clear();
+}
+
+bool WavAudioCodec::SaveOutputWav(const std::string& path) {
+    auto pcm = GetOutput();
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    auto put32 = [&file](uint32_t value) { file.write(reinterpret_cast<const char*>(&value), 4); };
+    auto put16 = [&file](uint16_t value) { file.write(reinterpret_cast<const char*>(&value), 2); };
+    uint32_t data_size = pcm.size() * 2;
+    file.write("RIFF", 4);
+    put32(36 + data_size);
+    file.write("WAVEfmt ", 8);
+    put32(16);
+    put16(1);
+    put16(1);
+    put32(output_sample_rate_);
+    put32(output_sample_rate_ * 2);
+    put16(2);
+    put16(16);
+    file.write("data", 4);
+    put32(data_size);
+    file.write(reinterpret_cast<const char*>(pcm.data()), data_size);
+    return file.good();
+}
+
+int WavAudioCodec::Read(int16_t* dest, int samples) {
+    // Block like the I2S DMA does, one buffer per buffer duration
+    auto now = std::chrono::steady_clock::now();
+    if (next_read_time_ < now - std::chrono::milliseconds(100)) {
+        next_read_time_ = now;
+    }
+    next_read_time_ += std::chrono::microseconds(1000000LL * samples / input_sample_rate_);
+    std::this_thread::sleep_until(next_read_time_);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    int queued = std::min<int>(samples, input_.size());
+    std::copy(input_.begin(), input_.begin() + queued, dest);
+    input_.erase(input_.begin(), input_.begin() + queued);
+    std::fill(dest + queued, dest + samples, 0);
+    return samples;
+}
+
+int WavAudioCodec::Write(const int16_t* data, int samples) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    output_.insert(output_.end(), data, data + samples);
+    return samples;
+}
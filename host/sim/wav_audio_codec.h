@@ -0,0 +1,37 @@
+#ifndef _WAV_AUDIO_CODEC_H
+#define _WAV_AUDIO_CODEC_H
+
+#include "audio_codec.h"
+
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// The microphone plays queued PCM (or WAV files) and then silence, at the pace of a real I2S channel.
+// The speaker records everything written, so a test can compare it with what the server sent.
+class WavAudioCodec : public AudioCodec {
+public:
+    WavAudioCodec(int input_sample_rate = 16000, int output_sample_rate = 24000);
+
+    void QueueInput(const std::vector<int16_t>& pcm);
+    // 16-bit mono WAV at the input sample rate, false if the file is anything else
+    bool QueueInputWav(const std::string& path);
+    bool InputPending();
+
+    std::vector<int16_t> GetOutput();
+    void ClearOutput();
+    bool SaveOutputWav(const std::string& path);
+
+private:
+    std::mutex mutex_;
+    std::deque<int16_t> input_;
+    std::vector<int16_t> output_;
+    std::chrono::steady_clock::time_point next_read_time_;
+
+    virtual int Read(int16_t* dest, int samples) override;
+    virtual int Write(const int16_t* data, int samples) override;
+};
+
+#endif // _WAV_AUDIO_CODEC_H
@@ -0,0 +1,206 @@
+#include "afsk_demod.h"
+#include "test_common.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace audio_wifi_config;
+
+// Same frame as scripts/acoustic_wifi_send.py: preamble, start, text, checksum, end, MSB first
+static std::vector<uint8_t> FrameBits(const std::string& text) {
+    std::vector<uint8_t> bytes = {0x33, 0x33, 0x33, 0x33, 0x01, 0x02};
+    bytes.insert(bytes.end(), text.begin(), text.end());
+    bytes.push_back(AudioDataBuffer::CalculateChecksum(text));
+    bytes.push_back(0x03);
+    bytes.push_back(0x04);
+    std::vector<uint8_t> bits;
+    for (uint8_t byte : bytes) {
+        for (int i = 7; i >= 0; i--) {
+            bits.push_back((byte >> i) & 1);
+        }
+    }
+    return bits;
+}
+
+// Continuous phase (M)FSK at 16 kHz between 200 ms of silence, with uniform noise
+static std::vector<int16_t> Modulate(const std::vector<uint8_t>& bits, const AfskConfig& config,
+                                     double amplitude, int noise) {
+    const double sample_rate = kInputSampleRate;
+    size_t bits_per_symbol = config.tone_count == 4 ? 2 : 1;
+    std::vector<double> signal(kInputSampleRate / 5, 0.0);
+    double phase = 0;
+    double position = signal.size();
+    for (size_t i = 0; i < bits.size(); i += bits_per_symbol) {
+        size_t symbol = 0;
+        for (size_t b = 0; b < bits_per_symbol; b++) {
+            symbol = (symbol << 1) | bits[i + b];
+        }
+        double step = 2 * M_PI * config.tones[symbol] / sample_rate;
+        position += sample_rate / config.baud;
+        while (signal.size() < static_cast<size_t>(std::lround(position))) {
+            signal.push_back(amplitude * sin(phase));
+            phase += step;
+        }
+    }
+    signal.resize(signal.size() + kInputSampleRate / 5, 0.0);
+
+    std::vector<int16_t> samples(signal.size());
+    srand(1);
+    for (size_t i = 0; i < signal.size(); i++) {
+        int n = noise > 0 ? rand() % (2 * noise + 1) - noise : 0;
+        samples[i] = static_cast<int16_t>(std::lround(signal[i]) + n);
+    }
+    return samples;
+}
+
+// Runs the samples through the demodulator in 30 ms chunks, as the provisioning task does
+static std::vector<std::string> Receive(const std::vector<int16_t>& samples, const AfskConfig& config) {
+    const size_t kChunkSamples = 480;
+    AfskDemodulator demodulator(config, kInputSampleRate);
+    AudioDataBuffer buffer;
+    std::vector<std::string> received;
+    uint8_t bits[64];
+    for (size_t pos = 0; pos < samples.size(); pos += kChunkSamples) {
+        size_t count = std::min(kChunkSamples, samples.size() - pos);
+        size_t bit_count = demodulator.Process(&samples[pos], count, bits, sizeof(bits));
+        for (size_t i = 0; i < bit_count; i++) {
+            if (buffer.ProcessBit(bits[i]) && buffer.decoded_text.has_value()) {
+                received.push_back(*buffer.decoded_text);
+                buffer.decoded_text.reset();
+            }
+        }
+    }
+    return received;
+}
+
+static AfskConfig MfskConfig() {
+    AfskConfig config;
+    config.baud = kMfskBaud;
+    config.tone_count = kMaxTones;
+    for (size_t i = 0; i < kMaxTones; i++) {
+        config.tones[i] = kMfskFrequencies[i];
+    }
+    return config;
+}
+
+static double Rms(const std::vector<int16_t>& samples, size_t skip) {
+    double sum = 0;
+    for (size_t i = skip; i < samples.size(); i++) {
+        sum += static_cast<double>(samples[i]) * samples[i];
+    }
+    return sqrt(sum / (samples.size() - skip));
+}
+
+// 16 kHz 16-bit mono PCM, empty if the file is anything else
+static std::vector<int16_t> LoadWav(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (data.size() < 12 || data.compare(0, 4, "RIFF") != 0 || data.compare(8, 4, "WAVE") != 0) {
+        return {};
+    }
+    bool format_ok = false;
+    for (size_t pos = 12; pos + 8 <= data.size();) {
+        uint32_t size;
+        memcpy(&size, &data[pos + 4], 4);
+        if (size > data.size() - pos - 8) {
+            return {};
+        }
+        if (data.compare(pos, 4, "fmt ") == 0 && size >= 16) {
+            uint16_t format, channels, bits;
+            uint32_t rate;
+            memcpy(&format, &data[pos + 8], 2);
+            memcpy(&channels, &data[pos + 10], 2);
+            memcpy(&rate, &data[pos + 12], 4);
+            memcpy(&bits, &data[pos + 22], 2);
+            format_ok = format == 1 && channels == 1 && rate == kInputSampleRate && bits == 16;
+        } else if (data.compare(pos, 4, "data") == 0 && format_ok) {
+            std::vector<int16_t> samples(size / 2);
+            memcpy(samples.data(), &data[pos + 8], samples.size() * 2);
+            return samples;
+        }
+        pos += 8 + size + (size & 1);
+    }
+    return {};
+}
+
+static std::vector<int16_t> Decimate(double frequency, size_t input_samples) {
+    Decimator decimator(kInputSampleRate, kAudioSampleRate);
+    std::vector<int16_t> input(input_samples);
+    for (size_t i = 0; i < input.size(); i++) {
+        input[i] = static_cast<int16_t>(std::lround(10000 * sin(2 * M_PI * frequency * i / kInputSampleRate)));
+    }
+    std::vector<int16_t> output(input_samples);
+    size_t produced = decimator.Process(input.data(), input.size(), output.data(), output.size());
+    output.resize(produced);
+    return output;
+}
+
+int main() {
+    // 16 kHz -> 6.4 kHz is 2/5, every 5 inputs give exactly 2 outputs
+    auto pass = Decimate(1000, 16000);
+    CHECK_EQ(pass.size(), size_t(6400));
+    double pass_rms = Rms(pass, 64);
+    CHECK(pass_rms > 10000 / sqrt(2.0) * 0.9 && pass_rms < 10000 / sqrt(2.0) * 1.1);
+    // Above the output Nyquist frequency, would alias onto 1400 Hz without the filter
+    auto stop = Decimate(5000, 16000);
+    CHECK(Rms(stop, 64) < pass_rms / 10);
+
+    // MaxInput() never lets the output overrun
+    Decimator decimator(kInputSampleRate, kAudioSampleRate);
+    std::vector<int16_t> input(1000, 1000);
+    int16_t output[17];
+    size_t max_input = decimator.MaxInput(17);
+    CHECK(decimator.Process(input.data(), max_input, output, 17) <= 17);
+
+    const std::string text = "my-ssid\npassw0rd!";
+    AfskConfig fsk;
+    CHECK_EQ(AfskDemodulator(fsk).bits_per_symbol(), size_t(1));
+    CHECK_EQ(AfskDemodulator(MfskConfig()).bits_per_symbol(), size_t(2));
+
+    for (const auto& config : {fsk, MfskConfig()}) {
+        auto bits = FrameBits(text);
+        // Clean and noisy (SNR around 15 dB) transmissions
+        for (int noise : {0, 2000}) {
+            auto received = Receive(Modulate(bits, config, 8000, noise), config);
+            CHECK_EQ(received.size(), size_t(1));
+            CHECK(received[0] == text);
+        }
+        // Noise alone never passes for a frame
+        CHECK(Receive(Modulate({}, config, 0, 2000), config).empty());
+    }
+
+    // Simulated microphone captures from host/tests/data/afsk/make_captures.py: speaker and microphone
+    // band limits, room reverberation, noise, and a sender clock 1% off in the offset files
+    for (auto [name, config] : {std::pair{"fsk100_room", fsk}, std::pair{"fsk100_offset", fsk},
+                                std::pair{"mfsk400_room", MfskConfig()}, std::pair{"mfsk400_offset", MfskConfig()}}) {
+        auto samples = LoadWav(std::string(AFSK_TEST_DATA_DIR "/") + name + ".wav");
+        CHECK(!samples.empty());
+        auto received = Receive(samples, config);
+        CHECK_EQ(received.size(), size_t(1));
+        CHECK(!received.empty() && received[0] == "xiaozhi\n12345678");
+        // The other mode never decodes a frame out of it
+        CHECK(Receive(samples, config.tone_count == 4 ? fsk : MfskConfig()).empty());
+    }
+
+    // A flipped bit inside the text fails the checksum
+    auto bits = FrameBits(text);
+    bits[6 * 8 + 3] ^= 1;
+    CHECK(Receive(Modulate(bits, fsk, 8000, 0), fsk).empty());
+
+    // Bits fed directly, without the modem
+    AudioDataBuffer buffer;
+    int decoded = 0;
+    for (uint8_t bit : FrameBits("a\nb")) {
+        decoded += buffer.ProcessBit(bit);
+    }
+    CHECK_EQ(decoded, 1);
+    CHECK(buffer.decoded_text.has_value() && *buffer.decoded_text == "a\nb");
+
+    printf("afsk_demod_test passed\n");
+    return 0;
+}
@@ -0,0 +1,138 @@
+#include "asset_pack.h"
+#include "test_common.h"
+
+#include <esp_rom_crc.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+struct TestAsset {
+    std::string name;
+    uint8_t type;
+    std::string data;
+    uint16_t width = 0;
+    uint16_t height = 0;
+};
+
+// Same layout as scripts/asset_tools/pack_assets.py, the assets must be sorted by name
+static std::vector<uint8_t> Pack(const std::vector<TestAsset>& assets, size_t align = 16) {
+    auto align_up = [align](size_t value) { return (value + align - 1) / align * align; };
+    size_t index_end = sizeof(AssetPackHeader) + assets.size() * sizeof(AssetPackEntry);
+    std::vector<uint8_t> image(align_up(index_end), 0);
+    std::vector<AssetPackEntry> entries(assets.size());
+    for (size_t i = 0; i < assets.size(); i++) {
+        auto& entry = entries[i];
+        memset(&entry, 0, sizeof(entry));
+        strncpy(entry.name, assets[i].name.c_str(), ASSET_PACK_NAME_LEN - 1);
+        entry.offset = image.size();
+        entry.size = assets[i].data.size();
+        entry.type = assets[i].type;
+        entry.width = assets[i].width;
+        entry.height = assets[i].height;
+        image.insert(image.end(), assets[i].data.begin(), assets[i].data.end());
+        image.resize(align_up(image.size()), 0);
+    }
+    memcpy(image.data() + sizeof(AssetPackHeader), entries.data(), entries.size() * sizeof(AssetPackEntry));
+
+    AssetPackHeader header = {};
+    header.magic = ASSET_PACK_MAGIC;
+    header.version = ASSET_PACK_VERSION;
+    header.entry_count = assets.size();
+    header.total_size = image.size();
+    header.index_crc = esp_rom_crc32_le(0, image.data() + sizeof(header), index_end - sizeof(header));
+    header.data_crc = esp_rom_crc32_le(0, image.data() + index_end, image.size() - index_end);
+    memcpy(image.data(), &header, sizeof(header));
+    return image;
+}
+
+// Start of an lv_font_conv binary font, up to the descent field of the "head" table
+static std::string FontHead(uint16_t ascent, int16_t descent) {
+    std::string data(48, '\0');
+    uint32_t length = data.size();
+    uint16_t tables = 1;
+    uint16_t font_size = ascent - descent;
+    memcpy(&data[0], &length, 4);
+    memcpy(&data[4], "head", 4);
+    memcpy(&data[12], &tables, 2);
+    memcpy(&data[14], &font_size, 2);
+    memcpy(&data[16], &ascent, 2);
+    memcpy(&data[18], &descent, 2);
+    return data;
+}
+
+int main() {
+    // The CRC the packer gets from zlib.crc32()
+    CHECK_EQ(esp_rom_crc32_le(0, (const uint8_t*)"123456789", 9), 0xCBF43926u);
+
+    auto& pack = AssetPack::GetInstance();
+    std::vector<TestAsset> assets = {
+        {"bad_font.bin", kAssetTypeFont, "not a font"},
+        {"logo.png", kAssetTypeImage, std::string(100, 'p'), 64, 32},
+        {"success.p3", kAssetTypeSound, "p3 data"},
+        {"text_font.bin", kAssetTypeFont, FontHead(20, -4)},
+    };
+    auto image = Pack(assets);
+
+    // No partition, or not a pack
+    CHECK(!pack.Load());
+    esp_partition_host_set(ASSET_PACK_PARTITION, std::vector<uint8_t>(4096, 0xff));
+    CHECK(!pack.Load());
+
+    // A corrupted entry table
+    auto corrupted = image;
+    corrupted[sizeof(AssetPackHeader) + 1] ^= 1;
+    esp_partition_host_set(ASSET_PACK_PARTITION, corrupted);
+    CHECK(!pack.Load());
+
+    // An entry pointing past the end, with a valid CRC
+    auto out_of_range = image;
+    AssetPackHeader header;
+    memcpy(&header, out_of_range.data(), sizeof(header));
+    AssetPackEntry entry;
+    memcpy(&entry, out_of_range.data() + sizeof(header), sizeof(entry));
+    entry.size = header.total_size;
+    memcpy(out_of_range.data() + sizeof(header), &entry, sizeof(entry));
+    header.index_crc = esp_rom_crc32_le(0, out_of_range.data() + sizeof(header), assets.size() * sizeof(entry));
+    memcpy(out_of_range.data(), &header, sizeof(header));
+    esp_partition_host_set(ASSET_PACK_PARTITION, out_of_range);
+    CHECK(!pack.Load());
+
+    // Larger than the partition
+    esp_partition_host_set(ASSET_PACK_PARTITION, std::vector<uint8_t>(image.begin(), image.end() - 16));
+    CHECK(!pack.Load());
+    CHECK(!pack.loaded());
+
+    esp_partition_host_set(ASSET_PACK_PARTITION, image);
+    CHECK(pack.Load());
+    CHECK(pack.loaded());
+
+    CHECK(pack.Find("success.p3") != nullptr);
+    CHECK(pack.Find("missing") == nullptr);
+    CHECK(pack.Find("") == nullptr);
+    CHECK_EQ(pack.GetSound("success.p3", "embedded"), std::string_view("p3 data"));
+    CHECK_EQ(pack.GetSound("missing.p3", "embedded"), std::string_view("embedded"));
+    // Not a sound
+    CHECK_EQ(pack.GetSound("logo.png", "embedded"), std::string_view("embedded"));
+
+    lv_img_dsc_t logo;
+    CHECK(pack.GetImage("logo.png", logo));
+    CHECK_EQ(logo.header.magic, uint32_t(LV_IMAGE_HEADER_MAGIC));
+    CHECK_EQ(logo.header.w, 64u);
+    CHECK_EQ(logo.header.h, 32u);
+    CHECK_EQ(logo.data_size, 100u);
+    CHECK_EQ(logo.data[0], uint8_t('p'));
+    CHECK(!pack.GetImage("success.p3", logo));
+
+    // The font LcdDisplay takes as its text font, created once
+    auto font = pack.GetFont("text_font.bin");
+    CHECK(font != nullptr);
+    CHECK_EQ(font->line_height, 24);
+    CHECK(pack.GetFont("text_font.bin") == font);
+    CHECK(pack.GetFont("bad_font.bin") == nullptr);
+    CHECK(pack.GetFont("success.p3") == nullptr);
+    CHECK(pack.GetFont("missing.bin") == nullptr);
+
+    printf("asset_pack_test passed\n");
+    return 0;
+}
@@ -0,0 +1,26 @@
+#include "background_task.h"
+#include "test_common.h"
+
+#include <vector>
+
+int main() {
+    // Never destroyed, a host task cannot be deleted from outside
+    auto task = new BackgroundTask(4096);
+
+    std::mutex mutex;
+    std::vector<int> order;
+    for (int i = 0; i < 200; i++) {
+        CHECK(task->Schedule([&mutex, &order, i]() {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(i);
+        }));
+    }
+    task->WaitForCompletion();
+    CHECK_EQ(order.size(), 200u);
+    for (int i = 0; i < 200; i++) {
+        CHECK_EQ(order[i], i);
+    }
+
+    printf("background_task_test passed\n");
+    return 0;
+}
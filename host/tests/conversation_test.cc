@@ -0,0 +1,181 @@
+#include "application.h"
+#include "loopback_protocol.h"
+#include "sim_board.h"
+#include "assets/lang_config.h"
+#include "test_common.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+// A scripted conversation against the real Application and McpServer: the test plays the server
+// through the loopback protocol and the user through the WAV codec.
+
+static bool WaitFor(const std::function<bool()>& condition, int timeout_ms = 5000) {
+    for (int elapsed = 0; elapsed < timeout_ms; elapsed += 10) {
+        if (condition()) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return condition();
+}
+
+static std::vector<int16_t> Tone(double frequency, int sample_rate, size_t samples) {
+    std::vector<int16_t> pcm(samples);
+    for (size_t i = 0; i < samples; i++) {
+        pcm[i] = static_cast<int16_t>(std::lround(8000 * sin(2 * M_PI * frequency * i / sample_rate)));
+    }
+    return pcm;
+}
+
+static void WriteWav(const std::string& path, const std::vector<int16_t>& pcm, uint32_t sample_rate) {
+    std::ofstream file(path, std::ios::binary);
+    auto put32 = [&file](uint32_t value) { file.write(reinterpret_cast<const char*>(&value), 4); };
+    auto put16 = [&file](uint16_t value) { file.write(reinterpret_cast<const char*>(&value), 2); };
+    uint32_t data_size = pcm.size() * 2;
+    file.write("RIFF", 4);
+    put32(36 + data_size);
+    file.write("WAVEfmt ", 8);
+    put32(16);
+    put16(1);
+    put16(1);
+    put32(sample_rate);
+    put32(sample_rate * 2);
+    put16(2);
+    put16(16);
+    file.write("data", 4);
+    put32(data_size);
+    file.write(reinterpret_cast<const char*>(pcm.data()), data_size);
+}
+
+// The shimmed encoder sends every 60 ms frame as raw PCM
+static std::vector<int16_t> UplinkPcm(LoopbackProtocol* protocol) {
+    std::vector<int16_t> pcm;
+    for (auto& packet : protocol->GetSentAudio()) {
+        size_t offset = pcm.size();
+        pcm.resize(offset + packet.payload.size() / 2);
+        memcpy(&pcm[offset], packet.payload.data(), packet.payload.size() / 2 * 2);
+    }
+    return pcm;
+}
+
+static bool Sent(LoopbackProtocol* protocol, const std::vector<std::string>& parts) {
+    for (auto& text : protocol->GetSentTexts()) {
+        bool all = true;
+        for (auto& part : parts) {
+            all = all && text.find(part) != std::string::npos;
+        }
+        if (all) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool Shown(SimDisplay& display, const std::string& role, const std::string& content) {
+    for (auto& [r, c] : display.chat_messages()) {
+        if (r == role && c == content) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int main() {
+    auto& app = Application::GetInstance();
+    auto& board = static_cast<SimBoard&>(Board::GetInstance());
+    auto& codec = board.codec();
+    auto& display = board.display();
+
+    // Start() never returns, it runs the main loop in its own task as on the device
+    auto protocol = new LoopbackProtocol();
+    xTaskCreate([](void* arg) {
+        Application::GetInstance().Start(std::unique_ptr<Protocol>(static_cast<LoopbackProtocol*>(arg)));
+    }, "main", 4096 * 2, protocol, 1, nullptr);
+
+    CHECK(WaitFor([&]() { return app.GetDeviceState() == kDeviceStateIdle; }));
+    CHECK(WaitFor([&]() { return !display.notifications().empty(); }));
+    CHECK_EQ(display.notifications()[0], std::string(Lang::Strings::VERSION) + "host");
+    CHECK(WaitFor([&]() { return display.status() == Lang::Strings::STANDBY; }));
+    // The success sound is played, its opus packets decode to silence with the host codec
+    CHECK(WaitFor([&]() { return codec.GetOutput().size() > 0; }));
+
+    // The user speaks: one second of a 440 Hz tone from a WAV file, then silence
+    auto speech = Tone(440, 16000, 16 * 960);
+    auto wav_path = (std::filesystem::temp_directory_path() / "conversation_test_input.wav").string();
+    WriteWav(wav_path, speech, 16000);
+    CHECK(codec.QueueInputWav(wav_path));
+    std::filesystem::remove(wav_path);
+
+    app.ToggleChatState();
+    CHECK(WaitFor([&]() { return app.GetDeviceState() == kDeviceStateListening; }));
+    CHECK(protocol->IsAudioChannelOpened());
+    CHECK(WaitFor([&]() { return Sent(protocol, {"\"type\":\"listen\"", "\"state\":\"start\"", "\"mode\":\"auto\""}); }));
+    CHECK(WaitFor([&]() { return display.status() == Lang::Strings::LISTENING; }));
+
+    // Uplink audio is the microphone input, sample exact
+    CHECK(WaitFor([&]() { return UplinkPcm(protocol).size() >= speech.size(); }));
+    auto uplink = UplinkPcm(protocol);
+    CHECK(std::equal(speech.begin(), speech.end(), uplink.begin()));
+    for (auto& packet : protocol->GetSentAudio()) {
+        CHECK_EQ(packet.payload.size(), size_t(960 * 2));
+    }
+
+    // The server recognizes it and answers
+    protocol->InjectJson(R"({"type":"stt","text":"今天天气怎么样"})");
+    CHECK(WaitFor([&]() { return Shown(display, "user", "今天天气怎么样"); }));
+    protocol->InjectJson(R"({"type":"llm","emotion":"happy"})");
+    protocol->InjectJson(R"({"type":"tts","state":"start"})");
+    CHECK(WaitFor([&]() { return app.GetDeviceState() == kDeviceStateSpeaking; }));
+    CHECK(WaitFor([&]() { return display.emotion() == "happy"; }));
+    CHECK(WaitFor([&]() { return display.status() == Lang::Strings::SPEAKING; }));
+    protocol->InjectJson(R"({"type":"tts","state":"sentence_start","text":"今天是晴天"})");
+    CHECK(WaitFor([&]() { return Shown(display, "assistant", "今天是晴天"); }));
+
+    // Speech from the server reaches the speaker unchanged, it is at the codec sample rate
+    codec.ClearOutput();
+    auto reply = Tone(1000, 24000, 3 * 1440);
+    for (size_t pos = 0; pos < reply.size(); pos += 1440) {
+        AudioStreamPacket packet;
+        packet.sample_rate = 24000;
+        packet.frame_duration = 60;
+        packet.payload.resize(1440 * 2);
+        memcpy(packet.payload.data(), &reply[pos], 1440 * 2);
+        protocol->InjectAudio(std::move(packet));
+    }
+    CHECK(WaitFor([&]() { return codec.GetOutput().size() >= reply.size(); }));
+    auto played = codec.GetOutput();
+    CHECK(std::equal(reply.begin(), reply.end(), played.begin()));
+
+    // In auto mode the device listens again after the answer
+    protocol->ClearSent();
+    protocol->InjectJson(R"({"type":"tts","state":"stop"})");
+    CHECK(WaitFor([&]() { return app.GetDeviceState() == kDeviceStateListening; }));
+    CHECK(WaitFor([&]() { return Sent(protocol, {"\"type\":\"listen\"", "\"state\":\"start\""}); }));
+
+    // The server calls an MCP tool, the result and then the changed device status are sent back
+    protocol->ClearSent();
+    protocol->InjectJson(R"({"type":"mcp","payload":{"jsonrpc":"2.0","id":7,"method":"tools/call",)"
+                         R"("params":{"name":"self.audio_speaker.set_volume","arguments":{"volume":42}}}})");
+    CHECK(WaitFor([&]() { return codec.output_volume() == 42; }));
+    CHECK(WaitFor([&]() { return Sent(protocol, {"\"type\":\"mcp\"", "\"id\":7", "\"result\""}); }));
+    CHECK(WaitFor([&]() {
+        return Sent(protocol, {"notifications/device_status", "\"volume\":42"});
+    }));
+
+    // The user ends the conversation
+    app.ToggleChatState();
+    CHECK(WaitFor([&]() { return app.GetDeviceState() == kDeviceStateIdle; }));
+    CHECK(!protocol->IsAudioChannelOpened());
+    CHECK(WaitFor([&]() { return display.status() == Lang::Strings::STANDBY; }));
+
+    printf("conversation_test passed\n");
+    // The application tasks never end, leave without running the static destructors under them
+    fflush(stdout);
+    std::quick_exit(0);
+}
@@ -0,0 +1,128 @@
+import os
+import sys
+import math
+import wave
+import random
+import struct
+
+
+'''
+  Simulated microphone captures of scripts/acoustic_wifi_send.py, decoded by host/tests/afsk_demod_test.cc.
+  They are not recordings: the 48 kHz sender output goes through a model of a phone speaker, a room
+  and the device microphone, and is written at the 16 kHz the device reads.
+
+    python host/tests/data/afsk/make_captures.py
+
+  Re-run after changing the frame format, the output is deterministic.
+
+  Both modes stop decoding reliably when the direct to reverberant ratio drops below about 6 dB,
+  that is the phone more than about half a meter away in a normal room.
+'''
+
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), "..", "..", "..", "..", "scripts"))
+from acoustic_wifi_send import MODES, frame_bits, modulate  # noqa: E402
+
+SSID = "xiaozhi"
+PASSWORD = "12345678"
+SEND_RATE = 48000
+CAPTURE_RATE = 16000
+
+CAPTURES = {
+    # name: (mode, playback clock error, reverberation time in s, direct to reverberant ratio in dB, SNR in dB)
+    # A phone speaker about 30 cm from the device, in a furnished room
+    "fsk100_room": ("fsk100", 0.0, 0.4, 10, 20),
+    "mfsk400_room": ("mfsk400", 0.0, 0.4, 10, 20),
+    # Sender clock 1% fast or slow: every tone and the symbol rate are off by 1%
+    "fsk100_offset": ("fsk100", 0.01, 0.2, 10, 25),
+    "mfsk400_offset": ("mfsk400", -0.01, 0.2, 10, 25),
+}
+
+
+def resample(samples, ratio):
+    # Linear interpolation, ratio is output samples per input sample
+    output = []
+    position = 0.0
+    while position < len(samples) - 1:
+        i = int(position)
+        frac = position - i
+        output.append(samples[i] * (1 - frac) + samples[i + 1] * frac)
+        position += 1 / ratio
+    return output
+
+
+def biquad(samples, b, a):
+    x1 = x2 = y1 = y2 = 0.0
+    output = []
+    for x in samples:
+        y = b[0] * x + b[1] * x1 + b[2] * x2 - a[1] * y1 - a[2] * y2
+        x2, x1, y2, y1 = x1, x, y1, y
+        output.append(y)
+    return output
+
+
+def band_pass(samples, low, high, rate):
+    # RBJ 2nd order high pass at low and low pass at high, Q = 0.707
+    def coefficients(frequency, high_pass):
+        w = 2 * math.pi * frequency / rate
+        alpha = math.sin(w) / (2 * 0.7071)
+        cos_w = math.cos(w)
+        if high_pass:
+            b = [(1 + cos_w) / 2, -(1 + cos_w), (1 + cos_w) / 2]
+        else:
+            b = [(1 - cos_w) / 2, 1 - cos_w, (1 - cos_w) / 2]
+        a0 = 1 + alpha
+        return [v / a0 for v in b], [1, -2 * cos_w / a0, (1 - alpha) / a0]
+    return biquad(biquad(samples, *coefficients(low, True)), *coefficients(high, False))
+
+
+def reverberate(samples, rt60, drr, rate, rng):
+    # Direct path plus sparse reflections decaying by 60 dB over rt60, their total energy drr dB
+    # below the direct path. The closer the phone, the higher the direct to reverberant ratio
+    taps = []
+    for _ in range(int(rt60 * 400)):
+        delay = rng.uniform(0.002, rt60)
+        taps.append((int(delay * rate), rng.choice((-1, 1)) * 10 ** (-3 * delay / rt60)))
+    scale = math.sqrt(10 ** (-drr / 10) / sum(gain * gain for _, gain in taps))
+    taps = [(0, 1.0)] + [(delay, gain * scale) for delay, gain in taps]
+    output = [0.0] * (len(samples) + int(rt60 * rate))
+    for delay, gain in taps:
+        for i, x in enumerate(samples):
+            output[i + delay] += gain * x
+    return output
+
+
+def capture(mode, clock_error, rt60, drr, snr, seed):
+    rng = random.Random(seed)
+    baud, tones = MODES[mode]
+    silence = [0] * (SEND_RATE // 5)
+    frame = modulate(frame_bits(SSID, PASSWORD), baud, tones, SEND_RATE, 16000)
+    # A fast sender clock plays the file in less time, the same as reading it at a lower rate
+    ratio = CAPTURE_RATE / SEND_RATE / (1 + clock_error)
+    signal = resample(silence + frame + silence, ratio)
+    signal = band_pass(signal, 400, 3400, CAPTURE_RATE)
+    signal = reverberate(signal, rt60, drr, CAPTURE_RATE, rng)
+    # SNR over the frame, not the whole file with its silence
+    start = int(len(silence) * ratio)
+    active = signal[start:start + int(len(frame) * ratio)]
+    noise = math.sqrt(sum(x * x for x in active) / len(active) / 10 ** (snr / 10))
+    peak = max(abs(x) for x in signal)
+    gain = 12000 / peak
+    return [max(-32768, min(32767, round(gain * (x + rng.gauss(0, noise))))) for x in signal]
+
+
+def main():
+    directory = os.path.dirname(os.path.abspath(__file__))
+    for index, (name, (mode, clock_error, rt60, drr, snr)) in enumerate(CAPTURES.items()):
+        samples = capture(mode, clock_error, rt60, drr, snr, index + 1)
+        path = os.path.join(directory, f"{name}.wav")
+        with wave.open(path, "wb") as f:
+            f.setnchannels(1)
+            f.setsampwidth(2)
+            f.setframerate(CAPTURE_RATE)
+            f.writeframes(struct.pack(f"<{len(samples)}h", *samples))
+        print(f"{path}: {len(samples) / CAPTURE_RATE:.2f} s")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,101 @@
+#include "main_message_queue.h"
+#include "test_common.h"
+
+#include <string>
+
+// Records the dispatch order, callbacks are named by the letter they append
+static std::string Dispatch(MainMessageQueue& queue, std::string& order) {
+    order.clear();
+    queue.DispatchAll([&order](MainMessage& message) {
+        if (message.type == kMainMessageCallback) {
+            message.callback();
+        } else if (message.type == kMainMessageChat) {
+            order += "[" + message.text + "]";
+        } else {
+            order += "(" + message.text + ")";
+        }
+    });
+    return order;
+}
+
+static void TestArrivalOrder() {
+    MainMessageQueue queue;
+    std::string order;
+    queue.Push([&order]() { order += "A"; }, kMessagePriorityNormal);
+    queue.PushChatMessage("assistant", "hello");
+    queue.Push([&order]() { order += "B"; }, kMessagePriorityHigh);
+    queue.PushEmotion("happy");
+    queue.Push([&order]() { order += "C"; }, kMessagePriorityNormal);
+    // B is a state change and overtakes the pending chat message, the rest is in arrival order
+    CHECK_EQ(Dispatch(queue, order), std::string("AB[hello](happy)C"));
+    CHECK_EQ(Dispatch(queue, order), std::string(""));
+}
+
+static void TestChatCoalescing() {
+    MainMessageQueue queue;
+    std::string order;
+    queue.PushChatMessage("assistant", "one");
+    queue.PushChatMessage("assistant", "two");
+    queue.PushChatMessage("user", "question");
+    queue.PushEmotion("sad");
+    queue.PushEmotion("happy");
+    CHECK_EQ(Dispatch(queue, order), std::string("[two][question](happy)"));
+    auto stats = queue.TakeStats();
+    CHECK_EQ(stats.dispatched, 3u);
+}
+
+static void TestPushDuringDispatch() {
+    MainMessageQueue queue;
+    std::string order;
+    queue.Push([&]() {
+        order += "A";
+        queue.Push([&order]() { order += "n"; }, kMessagePriorityNormal);
+        queue.Push([&order]() { order += "h"; }, kMessagePriorityHigh);
+    }, kMessagePriorityNormal);
+    queue.Push([&order]() { order += "B"; }, kMessagePriorityNormal);
+    // The high priority message runs in the same dispatch, after the older B
+    CHECK_EQ(Dispatch(queue, order), std::string("ABh"));
+    CHECK_EQ(Dispatch(queue, order), std::string("n"));
+}
+
+static void TestStateBeforeUi() {
+    MainMessageQueue queue;
+    std::string order;
+    queue.PushEmotion("happy");
+    queue.PushChatMessage("assistant", "hello");
+    queue.Push([&order]() { order += "A"; }, kMessagePriorityNormal);
+    queue.Push([&order]() { order += "H"; }, kMessagePriorityHigh);
+    // The state change skips the UI updates but not the older callback
+    CHECK_EQ(Dispatch(queue, order), std::string("AH(happy)[hello]"));
+
+    // A state change that sets its own emotion drops the stale one
+    queue.PushEmotion("happy");
+    queue.PushChatMessage("assistant", "bye");
+    queue.Push([&queue, &order]() {
+        order += "S";
+        queue.DiscardEmotion();
+    }, kMessagePriorityHigh);
+    CHECK_EQ(Dispatch(queue, order), std::string("S[bye]"));
+}
+
+static void TestOverflow() {
+    MainMessageQueue queue;
+    std::string order;
+    std::string expected;
+    for (int i = 0; i < MAIN_MESSAGE_NORMAL_CAPACITY * 2; i++) {
+        char letter = 'a' + i % 26;
+        expected += letter;
+        queue.Push([&order, letter]() { order += letter; }, kMessagePriorityNormal);
+    }
+    CHECK_EQ(Dispatch(queue, order), expected);
+}
+
+int main() {
+    TestArrivalOrder();
+    TestChatCoalescing();
+    TestPushDuringDispatch();
+    TestStateBeforeUi();
+    TestOverflow();
+    printf("main_message_queue_test passed\n");
+    return 0;
+}
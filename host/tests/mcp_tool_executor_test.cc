@@ -0,0 +1,105 @@
+#include "mcp_tool_executor.h"
+#include "test_common.h"
+
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Replies by id, the executor replies from its workers and the timeout timer
+static std::mutex replies_mutex;
+static std::map<int, std::string> replies;
+
+static void Reply(int id, const std::string& text) {
+    std::lock_guard<std::mutex> lock(replies_mutex);
+    replies[id] = text;
+}
+
+static std::string WaitReply(int id) {
+    for (int i = 0; i < 500; i++) {
+        {
+            std::lock_guard<std::mutex> lock(replies_mutex);
+            auto it = replies.find(id);
+            if (it != replies.end()) {
+                return it->second;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return "<no reply>";
+}
+
+static size_t ThreadCount() {
+    size_t count = 0;
+    for (auto& entry : std::filesystem::directory_iterator("/proc/self/task")) {
+        (void)entry;
+        count++;
+    }
+    return count;
+}
+
+int main() {
+    // Workers cannot be deleted on the host, so the executor lives until exit
+    auto executor = new McpToolExecutor(
+        [](int id, const std::string& result) { Reply(id, "result:" + result); },
+        [](int id, const std::string& message) { Reply(id, "error:" + message); });
+
+    // No worker before the first call
+    size_t idle_threads = ThreadCount();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK_EQ(ThreadCount(), idle_threads);
+
+    auto task_name = []() { return std::string(pcTaskGetName(xTaskGetCurrentTaskHandle())); };
+    CHECK(executor->Submit(1, "small", MCP_TOOL_SMALL_STACK_SIZE, 1000, task_name));
+    CHECK(WaitReply(1).rfind("result:tool_call_s", 0) == 0);
+    CHECK_EQ(ThreadCount(), idle_threads + MCP_TOOL_SMALL_WORKERS);
+
+    // The large class starts on its own first call
+    CHECK(executor->Submit(2, "large", MCP_TOOL_LARGE_STACK_SIZE, 1000, task_name));
+    CHECK_EQ(WaitReply(2), std::string("result:tool_call_l0"));
+    CHECK_EQ(ThreadCount(), idle_threads + MCP_TOOL_SMALL_WORKERS + MCP_TOOL_LARGE_WORKERS);
+
+    // No worker has a stack this large, the call is refused rather than overflowing one
+    CHECK(!executor->Submit(6, "huge", MCP_TOOL_LARGE_STACK_SIZE + 1, 1000, task_name));
+
+    // Exceptions become error replies
+    CHECK(executor->Submit(3, "throws", 0, 1000, []() -> std::string { throw std::runtime_error("bad"); }));
+    CHECK_EQ(WaitReply(3), std::string("error:bad"));
+
+    // A slow call times out once, its late result is dropped
+    CHECK(executor->Submit(4, "slow", 0, 100, []() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(800));
+        return std::string("late");
+    }));
+    CHECK(WaitReply(4).rfind("error:Tool call timed out", 0) == 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+    CHECK(WaitReply(4).rfind("error:Tool call timed out", 0) == 0);
+
+    // Calls sharing an id run in submission order, even with a free worker
+    std::string order;
+    std::mutex order_mutex;
+    auto append = [&order, &order_mutex](char c, int sleep_ms) {
+        return [&order, &order_mutex, c, sleep_ms]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(sleep_ms));
+            std::lock_guard<std::mutex> lock(order_mutex);
+            order += c;
+            return std::string(1, c);
+        };
+    };
+    CHECK(executor->Submit(5, "a", 0, 5000, append('a', 200)));
+    CHECK(executor->Submit(5, "b", 0, 5000, append('b', 0)));
+    std::this_thread::sleep_for(std::chrono::milliseconds(600));
+    {
+        std::lock_guard<std::mutex> lock(order_mutex);
+        CHECK_EQ(order, std::string("ab"));
+    }
+
+    auto metrics = executor->GetMetrics();
+    CHECK_EQ(metrics.submitted, 6u);
+    CHECK_EQ(metrics.timed_out, 1u);
+    CHECK_EQ(metrics.rejected, 1u);
+
+    printf("mcp_tool_executor_test passed\n");
+    return 0;
+}
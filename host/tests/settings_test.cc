@@ -0,0 +1,87 @@
+#include "settings.h"
+#include "test_common.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+
+static bool StoredInt(const char* ns, const char* key, int32_t& value) {
+    nvs_handle_t handle;
+    if (nvs_open(ns, NVS_READONLY, &handle) != ESP_OK) {
+        return false;
+    }
+    bool found = nvs_get_i32(handle, key, &value) == ESP_OK;
+    nvs_close(handle);
+    return found;
+}
+
+int main() {
+    nvs_flash_init();
+
+    // Values already in flash are loaded on first use
+    nvs_handle_t handle;
+    CHECK_EQ(nvs_open("wifi", NVS_READWRITE, &handle), ESP_OK);
+    CHECK_EQ(nvs_set_str(handle, "ssid", "home"), ESP_OK);
+    nvs_close(handle);
+    {
+        Settings settings("wifi");
+        CHECK_EQ(settings.GetString("ssid"), std::string("home"));
+        CHECK_EQ(settings.GetInt("missing", 7), 7);
+    }
+
+    // Writes stay in RAM until the debounced commit
+    int32_t value = 0;
+    {
+        Settings settings("audio", true);
+        settings.SetInt("volume", 10);
+        settings.SetInt("volume", 20);
+        CHECK_EQ(settings.GetInt("volume"), 20);
+        CHECK(!StoredInt("audio", "volume", value));
+    }
+    int64_t start = esp_timer_get_time();
+    while (!StoredInt("audio", "volume", value) && esp_timer_get_time() - start < 3000000) {
+        vTaskDelay(pdMS_TO_TICKS(20));
+    }
+    CHECK_EQ(value, 20);
+    CHECK(esp_timer_get_time() - start >= 500000);
+
+    // Flush commits right away, erases included
+    {
+        Settings settings("audio", true);
+        settings.EraseKey("volume");
+        settings.SetString("codec", "opus");
+    }
+    Settings::Flush();
+    CHECK(!StoredInt("audio", "volume", value));
+    {
+        Settings settings("audio");
+        CHECK_EQ(settings.GetString("codec"), std::string("opus"));
+        CHECK_EQ(settings.GetInt("volume", -1), -1);
+    }
+
+    // A commit that cannot open the namespace keeps the writes pending
+    nvs_host_fail_writes(true);
+    {
+        Settings settings("audio", true);
+        settings.SetInt("volume", 30);
+        settings.EraseKey("codec");
+    }
+    Settings::Flush();
+    CHECK(!StoredInt("audio", "volume", value));
+    nvs_host_fail_writes(false);
+    {
+        // A newer write to the same key wins over the requeued one
+        Settings settings("audio", true);
+        settings.SetInt("volume", 40);
+    }
+    Settings::Flush();
+    CHECK(StoredInt("audio", "volume", value));
+    CHECK_EQ(value, 40);
+    CHECK_EQ(nvs_open("audio", NVS_READONLY, &handle), ESP_OK);
+    size_t length = 0;
+    CHECK_EQ(nvs_get_str(handle, "codec", nullptr, &length), ESP_ERR_NVS_NOT_FOUND);
+    nvs_close(handle);
+
+    printf("settings_test passed\n");
+    return 0;
+}
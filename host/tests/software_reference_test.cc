@@ -0,0 +1,58 @@
+#include "software_reference.h"
+#include "test_common.h"
+
+#include <cstdlib>
+#include <vector>
+
+// Noise bursts with a random envelope every 20 ms, so the envelopes correlate at one lag only
+static std::vector<int16_t> MakeSignal(size_t samples) {
+    std::vector<int16_t> signal(samples);
+    srand(1);
+    int amplitude = 0;
+    for (size_t i = 0; i < samples; i++) {
+        if (i % 320 == 0) {
+            amplitude = (rand() % 2) ? 500 + rand() % 6000 : 0;
+        }
+        signal[i] = amplitude > 0 ? rand() % (2 * amplitude) - amplitude : 0;
+    }
+    return signal;
+}
+
+int main() {
+    const int kSampleRate = 16000;
+    const int kChunk = 160;
+    const int kEchoDelay = 800;     // 50 ms from the speaker to the microphone
+    const int kBlock = kSampleRate * SOFTWARE_REFERENCE_BLOCK_MS / 1000;
+    auto signal = MakeSignal(kSampleRate * 4);
+
+    SoftwareReference reference(kSampleRate, kSampleRate);
+    // Two chunks queued ahead, as the I2S DMA does, so the placement does not depend on timing
+    reference.OnOutput(&signal[0], kChunk);
+    reference.OnOutput(&signal[kChunk], kChunk);
+
+    std::vector<int16_t> mic(kChunk);
+    std::vector<int16_t> output(kChunk * 2);
+    bool aligned = false;
+    for (size_t pos = 0; pos + 3 * kChunk <= signal.size(); pos += kChunk) {
+        reference.OnOutput(&signal[pos + 2 * kChunk], kChunk);
+        for (int i = 0; i < kChunk; i++) {
+            int64_t source = static_cast<int64_t>(pos) + i - kEchoDelay;
+            mic[i] = source >= 0 ? signal[source] / 2 : 0;
+        }
+        reference.OnInput(mic.data(), kChunk, output.data());
+
+        for (int i = 0; i < kChunk; i++) {
+            CHECK_EQ(output[i * 2], mic[i]);
+        }
+        // Once estimated, the reference leads the echo by at most two envelope blocks
+        int delay = reference.delay_samples();
+        if (delay > 0) {
+            CHECK(delay <= kEchoDelay && delay >= kEchoDelay - 2 * kBlock);
+            aligned = true;
+        }
+    }
+    CHECK(aligned);
+
+    printf("software_reference_test passed, delay %d samples\n", reference.delay_samples());
+    return 0;
+}
@@ -0,0 +1,24 @@
+#ifndef HOST_TEST_COMMON_H
+#define HOST_TEST_COMMON_H
+
+#include <cstdio>
+#include <cstdlib>
+
+// Minimal checks, a failed one prints the location and fails the ctest run
+#define CHECK(condition) do {                                                       \
+        if (!(condition)) {                                                         \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+            exit(1);                                                                \
+        }                                                                           \
+    } while (0)
+
+#define CHECK_EQ(a, b) do {                                                         \
+        auto a_ = (a);                                                              \
+        auto b_ = (b);                                                              \
+        if (!(a_ == b_)) {                                                          \
+            fprintf(stderr, "%s:%d: CHECK_EQ failed: %s != %s\n", __FILE__, __LINE__, #a, #b); \
+            exit(1);                                                                \
+        }                                                                           \
+    } while (0)
+
+#endif // HOST_TEST_COMMON_H
@@ -2,15 +2,17 @@
 #include "board.h"
 #include "display.h"
 #include "system_info.h"
-#include "ml307_ssl_transport.h"
+#include "system_profiler.h"
 #include "audio_codec.h"
-#include "mqtt_protocol.h"
-#include "websocket_protocol.h"
-#include "font_awesome_symbols.h"
-#include "iot/thing_manager.h"
 #include "assets/lang_config.h"
+#include "asset_pack.h"
 #include "mcp_server.h"
 #include "audio_debugger.h"
+#include "audio_trace.h"
+
+#if CONFIG_IOT_PROTOCOL_XIAOZHI
+#include "iot/thing_manager.h"
+#endif
 
 #if CONFIG_USE_AUDIO_PROCESSOR
 #include "afe_audio_processor.h"
@@ -27,13 +29,24 @@
 #endif
 
 #include <cstring>
+#include <algorithm>
 #include <esp_log.h>
 #include <cJSON.h>
-#include <driver/gpio.h>
+#include <esp_app_desc.h>
+#include <esp_system.h>
 #include <arpa/inet.h>
+#include <sys/time.h>
 
 #define TAG "Application"
 
+// State changes within this window are sent together
+#define STATE_NOTIFY_WINDOW_MS 200
+// Minimum interval between two state notifications
+#define STATE_NOTIFY_MIN_INTERVAL_MS 1000
+// Signal strength has no change events, nor has the battery on boards without PowerTelemetry.
+// Both drift slowly, so the icons are refreshed this often
+#define STATUS_POLL_INTERVAL_MS 60000
+
 
 static const char* const STATE_STRINGS[] = {
     "unknown",
@@ -87,6 +100,46 @@ Application::Application() {
         .skip_unhandled_events = true
     };
     esp_timer_create(&clock_timer_args, &clock_timer_handle_);
+
+    esp_timer_create_args_t status_timer_args = {
+        .callback = [](void* arg) {
+            Application* app = (Application*)arg;
+            app->OnStatusTimer();
+        },
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "status_timer",
+        .skip_unhandled_events = true
+    };
+    esp_timer_create(&status_timer_args, &status_timer_handle_);
+
+    // Status bar updates run in the timer task, reading the battery or the 4G modem must not block the main loop
+    esp_timer_create_args_t status_bar_notify_timer_args = {
+        .callback = [](void* arg) {
+            Application* app = (Application*)arg;
+            auto items = app->status_bar_pending_.exchange(0);
+            Board::GetInstance().GetDisplay()->UpdateStatusBar(items);
+        },
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "status_bar_notify_timer",
+        .skip_unhandled_events = true
+    };
+    esp_timer_create(&status_bar_notify_timer_args, &status_bar_notify_timer_);
+
+    esp_timer_create_args_t state_notify_timer_args = {
+        .callback = [](void* arg) {
+            Application* app = (Application*)arg;
+            app->Schedule([app]() {
+                app->SendStateChanges();
+            });
+        },
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "state_notify_timer",
+        .skip_unhandled_events = true
+    };
+    esp_timer_create(&state_notify_timer_args, &state_notify_timer_);
 }
 
 Application::~Application() {
@@ -94,150 +147,24 @@ Application::~Application() {
         esp_timer_stop(clock_timer_handle_);
         esp_timer_delete(clock_timer_handle_);
     }
+    if (status_timer_handle_ != nullptr) {
+        esp_timer_stop(status_timer_handle_);
+        esp_timer_delete(status_timer_handle_);
+    }
+    if (status_bar_notify_timer_ != nullptr) {
+        esp_timer_stop(status_bar_notify_timer_);
+        esp_timer_delete(status_bar_notify_timer_);
+    }
+    if (state_notify_timer_ != nullptr) {
+        esp_timer_stop(state_notify_timer_);
+        esp_timer_delete(state_notify_timer_);
+    }
     if (background_task_ != nullptr) {
         delete background_task_;
     }
     vEventGroupDelete(event_group_);
 }
 
-void Application::CheckNewVersion(Ota& ota) {
-    const int MAX_RETRY = 10;
-    int retry_count = 0;
-    int retry_delay = 10; // 初始重试延迟为10秒
-
-    while (true) {
-        SetDeviceState(kDeviceStateActivating);
-        auto display = Board::GetInstance().GetDisplay();
-        display->SetStatus(Lang::Strings::CHECKING_NEW_VERSION);
-
-        if (!ota.CheckVersion()) {
-            retry_count++;
-            if (retry_count >= MAX_RETRY) {
-                ESP_LOGE(TAG, "Too many retries, exit version check");
-                return;
-            }
-
-            char buffer[128];
-            snprintf(buffer, sizeof(buffer), Lang::Strings::CHECK_NEW_VERSION_FAILED, retry_delay, ota.GetCheckVersionUrl().c_str());
-            Alert(Lang::Strings::ERROR, buffer, "sad", Lang::Sounds::P3_EXCLAMATION);
-
-            ESP_LOGW(TAG, "Check new version failed, retry in %d seconds (%d/%d)", retry_delay, retry_count, MAX_RETRY);
-            for (int i = 0; i < retry_delay; i++) {
-                vTaskDelay(pdMS_TO_TICKS(1000));
-                if (device_state_ == kDeviceStateIdle) {
-                    break;
-                }
-            }
-            retry_delay *= 2; // 每次重试后延迟时间翻倍
-            continue;
-        }
-        retry_count = 0;
-        retry_delay = 10; // 重置重试延迟时间
-
-        if (ota.HasNewVersion()) {
-            Alert(Lang::Strings::OTA_UPGRADE, Lang::Strings::UPGRADING, "happy", Lang::Sounds::P3_UPGRADE);
-
-            vTaskDelay(pdMS_TO_TICKS(3000));
-
-            SetDeviceState(kDeviceStateUpgrading);
-            
-            display->SetIcon(FONT_AWESOME_DOWNLOAD);
-            std::string message = std::string(Lang::Strings::NEW_VERSION) + ota.GetFirmwareVersion();
-            display->SetChatMessage("system", message.c_str());
-
-            auto& board = Board::GetInstance();
-            board.SetPowerSaveMode(false);
-            wake_word_->StopDetection();
-            // 预先关闭音频输出，避免升级过程有音频操作
-            auto codec = board.GetAudioCodec();
-            codec->EnableInput(false);
-            codec->EnableOutput(false);
-            {
-                std::lock_guard<std::mutex> lock(mutex_);
-                audio_decode_queue_.clear();
-            }
-            background_task_->WaitForCompletion();
-            delete background_task_;
-            background_task_ = nullptr;
-            vTaskDelay(pdMS_TO_TICKS(1000));
-
-            ota.StartUpgrade([display](int progress, size_t speed) {
-                char buffer[64];
-                snprintf(buffer, sizeof(buffer), "%d%% %uKB/s", progress, speed / 1024);
-                display->SetChatMessage("system", buffer);
-            });
-
-            // If upgrade success, the device will reboot and never reach here
-            display->SetStatus(Lang::Strings::UPGRADE_FAILED);
-            ESP_LOGI(TAG, "Firmware upgrade failed...");
-            vTaskDelay(pdMS_TO_TICKS(3000));
-            Reboot();
-            return;
-        }
-
-        // No new version, mark the current version as valid
-        ota.MarkCurrentVersionValid();
-        if (!ota.HasActivationCode() && !ota.HasActivationChallenge()) {
-            xEventGroupSetBits(event_group_, CHECK_NEW_VERSION_DONE_EVENT);
-            // Exit the loop if done checking new version
-            break;
-        }
-
-        display->SetStatus(Lang::Strings::ACTIVATION);
-        // Activation code is shown to the user and waiting for the user to input
-        if (ota.HasActivationCode()) {
-            ShowActivationCode(ota.GetActivationCode(), ota.GetActivationMessage());
-        }
-
-        // This will block the loop until the activation is done or timeout
-        for (int i = 0; i < 10; ++i) {
-            ESP_LOGI(TAG, "Activating... %d/%d", i + 1, 10);
-            esp_err_t err = ota.Activate();
-            if (err == ESP_OK) {
-                xEventGroupSetBits(event_group_, CHECK_NEW_VERSION_DONE_EVENT);
-                break;
-            } else if (err == ESP_ERR_TIMEOUT) {
-                vTaskDelay(pdMS_TO_TICKS(3000));
-            } else {
-                vTaskDelay(pdMS_TO_TICKS(10000));
-            }
-            if (device_state_ == kDeviceStateIdle) {
-                break;
-            }
-        }
-    }
-}
-
-void Application::ShowActivationCode(const std::string& code, const std::string& message) {
-    struct digit_sound {
-        char digit;
-        const std::string_view& sound;
-    };
-    static const std::array<digit_sound, 10> digit_sounds{{
-        digit_sound{'0', Lang::Sounds::P3_0},
-        digit_sound{'1', Lang::Sounds::P3_1}, 
-        digit_sound{'2', Lang::Sounds::P3_2},
-        digit_sound{'3', Lang::Sounds::P3_3},
-        digit_sound{'4', Lang::Sounds::P3_4},
-        digit_sound{'5', Lang::Sounds::P3_5},
-        digit_sound{'6', Lang::Sounds::P3_6},
-        digit_sound{'7', Lang::Sounds::P3_7},
-        digit_sound{'8', Lang::Sounds::P3_8},
-        digit_sound{'9', Lang::Sounds::P3_9}
-    }};
-
-    // This sentence uses 9KB of SRAM, so we need to wait for it to finish
-    Alert(Lang::Strings::ACTIVATION, message.c_str(), "happy", Lang::Sounds::P3_ACTIVATION);
-
-    for (const auto& digit : code) {
-        auto it = std::find_if(digit_sounds.begin(), digit_sounds.end(),
-            [digit](const digit_sound& ds) { return ds.digit == digit; });
-        if (it != digit_sounds.end()) {
-            PlaySound(it->sound);
-        }
-    }
-}
-
 void Application::Alert(const char* status, const char* message, const char* emotion, const std::string_view& sound) {
     ESP_LOGW(TAG, "Alert %s: %s [%s]", status, message, emotion);
     auto display = Board::GetInstance().GetDisplay();
@@ -259,6 +186,20 @@ void Application::DismissAlert() {
     }
 }
 
+// 资源分区中有同名音效时使用分区中的版本，更新音效不需要重新编译固件
+static std::string_view ResolveSound(const std::string_view& sound) {
+    auto& asset_pack = AssetPack::GetInstance();
+    if (!asset_pack.loaded()) {
+        return sound;
+    }
+    for (auto& named : Lang::Sounds::ALL) {
+        if (named.sound.data() == sound.data()) {
+            return asset_pack.GetSound(named.name, sound);
+        }
+    }
+    return sound;
+}
+
 void Application::PlaySound(const std::string_view& sound) {
     // Wait for the previous sound to finish
     {
@@ -269,15 +210,17 @@ void Application::PlaySound(const std::string_view& sound) {
     }
     background_task_->WaitForCompletion();
 
-    const char* data = sound.data();
-    size_t size = sound.size();
+    auto resolved = ResolveSound(sound);
+    const char* data = resolved.data();
+    size_t size = resolved.size();
     for (const char* p = data; p < data + size; ) {
         auto p3 = (BinaryProtocol3*)p;
         p += sizeof(BinaryProtocol3);
 
         auto payload_size = ntohs(p3->payload_size);
         AudioStreamPacket packet;
-        packet.sample_rate = 16000;
+        // 保留字节记录采样率 (kHz)，与 codec 输出采样率一致的音效不需要重采样
+        packet.sample_rate = p3->reserved != 0 ? p3->reserved * 1000 : 16000;
         packet.frame_duration = 60;
         packet.payload.resize(payload_size);
         memcpy(packet.payload.data(), p3->payload, payload_size);
@@ -399,12 +342,19 @@ void Application::StopListening() {
     });
 }
 
-void Application::Start() {
+void Application::Start(std::unique_ptr<Protocol> protocol) {
+    InitializeDevice();
+    Board::GetInstance().GetDisplay()->SetStatus(Lang::Strings::LOADING_PROTOCOL);
+    bool protocol_started = StartProtocol(std::move(protocol));
+    Run(protocol_started, esp_app_get_description()->version);
+}
+
+void Application::InitializeDevice() {
     auto& board = Board::GetInstance();
     SetDeviceState(kDeviceStateStarting);
 
-    /* Setup the display */
-    auto display = board.GetDisplay();
+    /* Map the asset partition, embedded assets are used if there is none */
+    AssetPack::GetInstance().Load();
 
     /* Setup the audio codec */
     auto codec = board.GetAudioCodec();
@@ -444,36 +394,39 @@ void Application::Start() {
     }, "audio_loop", 4096 * 2, this, 8, &audio_loop_task_handle_);
 #endif
 
-    /* Start the clock timer to update the status bar */
-    esp_timer_start_periodic(clock_timer_handle_, 1000000);
+    /* Poll the battery and network icons, the clock timer is started once the time is known */
+    esp_timer_start_periodic(status_timer_handle_, STATUS_POLL_INTERVAL_MS * 1000);
+
+    /* Keep a rolling history of task CPU usage, heap and main loop stats for field diagnostics */
+    SystemProfiler::GetInstance().SetMainLoopStatsSource([this]() {
+        return main_messages_.TakeStats();
+    });
+    SystemProfiler::GetInstance().Start();
 
     /* Wait for the network to be ready */
     board.StartNetwork();
 
     // Update the status bar immediately to show the network state
-    display->UpdateStatusBar(true);
+    NotifyStatusBarChanged(kStatusBarAll);
 
-    // Check for new firmware version or get the MQTT broker address
-    Ota ota;
-    CheckNewVersion(ota);
+#if CONFIG_USE_BOOT_BENCHMARK
+    board.GetDisplay()->RunTextBenchmark();
+#endif
+}
 
-    // Initialize the protocol
-    display->SetStatus(Lang::Strings::LOADING_PROTOCOL);
+bool Application::StartProtocol(std::unique_ptr<Protocol> protocol) {
+    auto& board = Board::GetInstance();
+    auto codec = board.GetAudioCodec();
 
     // Add MCP common tools before initializing the protocol
 #if CONFIG_IOT_PROTOCOL_MCP
     McpServer::GetInstance().AddCommonTools();
+#if CONFIG_USE_BOOT_BENCHMARK
+    McpServer::GetInstance().RunBenchmark();
+#endif
 #endif
 
-    if (ota.HasMqttConfig()) {
-        protocol_ = std::make_unique<MqttProtocol>();
-    } else if (ota.HasWebsocketConfig()) {
-        protocol_ = std::make_unique<WebsocketProtocol>();
-    } else {
-        ESP_LOGW(TAG, "No protocol specified in the OTA config, using MQTT");
-        protocol_ = std::make_unique<MqttProtocol>();
-    }
-
+    protocol_ = std::move(protocol);
     protocol_->OnNetworkError([this](const std::string& message) {
         SetDeviceState(kDeviceStateIdle);
         Alert(Lang::Strings::ERROR, message.c_str(), "sad", Lang::Sounds::P3_EXCLAMATION);
@@ -481,6 +434,8 @@ void Application::Start() {
     protocol_->OnIncomingAudio([this](AudioStreamPacket&& packet) {
         std::lock_guard<std::mutex> lock(mutex_);
         if (device_state_ == kDeviceStateSpeaking && audio_decode_queue_.size() < MAX_AUDIO_PACKETS_IN_QUEUE) {
+            packet.frame_id = AUDIO_TRACE_NEW_FRAME();
+            AUDIO_TRACE(kAudioTraceReceive, packet.frame_id);
             audio_decode_queue_.emplace_back(std::move(packet));
         }
     });
@@ -502,13 +457,17 @@ void Application::Start() {
     });
     protocol_->OnAudioChannelClosed([this, &board]() {
         board.SetPowerSaveMode(true);
+#if CONFIG_IOT_PROTOCOL_MCP
+        McpServer::GetInstance().CancelToolCalls();
+        McpServer::GetInstance().ResetDeviceStatus();
+#endif
         Schedule([this]() {
             auto display = Board::GetInstance().GetDisplay();
             display->SetChatMessage("system", "");
             SetDeviceState(kDeviceStateIdle);
         });
     });
-    protocol_->OnIncomingJson([this, display](const cJSON* root) {
+    protocol_->OnIncomingJson([this](const cJSON* root) {
         // Parse JSON data
         auto type = cJSON_GetObjectItem(root, "type");
         if (strcmp(type->valuestring, "tts") == 0) {
@@ -519,7 +478,7 @@ void Application::Start() {
                     if (device_state_ == kDeviceStateIdle || device_state_ == kDeviceStateListening) {
                         SetDeviceState(kDeviceStateSpeaking);
                     }
-                });
+                }, kMessagePriorityHigh);
             } else if (strcmp(state->valuestring, "stop") == 0) {
                 Schedule([this]() {
                     background_task_->WaitForCompletion();
@@ -530,30 +489,24 @@ void Application::Start() {
                             SetDeviceState(kDeviceStateListening);
                         }
                     }
-                });
+                }, kMessagePriorityHigh);
             } else if (strcmp(state->valuestring, "sentence_start") == 0) {
                 auto text = cJSON_GetObjectItem(root, "text");
                 if (cJSON_IsString(text)) {
                     ESP_LOGI(TAG, "<< %s", text->valuestring);
-                    Schedule([this, display, message = std::string(text->valuestring)]() {
-                        display->SetChatMessage("assistant", message.c_str());
-                    });
+                    ScheduleChatMessage("assistant", text->valuestring);
                 }
             }
         } else if (strcmp(type->valuestring, "stt") == 0) {
             auto text = cJSON_GetObjectItem(root, "text");
             if (cJSON_IsString(text)) {
                 ESP_LOGI(TAG, ">> %s", text->valuestring);
-                Schedule([this, display, message = std::string(text->valuestring)]() {
-                    display->SetChatMessage("user", message.c_str());
-                });
+                ScheduleChatMessage("user", text->valuestring);
             }
         } else if (strcmp(type->valuestring, "llm") == 0) {
             auto emotion = cJSON_GetObjectItem(root, "emotion");
             if (cJSON_IsString(emotion)) {
-                Schedule([this, display, emotion_str = std::string(emotion->valuestring)]() {
-                    display->SetEmotion(emotion_str.c_str());
-                });
+                ScheduleEmotion(emotion->valuestring);
             }
 #if CONFIG_IOT_PROTOCOL_MCP
         } else if (strcmp(type->valuestring, "mcp") == 0) {
@@ -604,6 +557,8 @@ void Application::Start() {
     audio_debugger_ = std::make_unique<AudioDebugger>();
     audio_processor_->Initialize(codec);
     audio_processor_->OnOutput([this](std::vector<int16_t>&& data) {
+        uint32_t frame_id = AUDIO_TRACE_FETCH_FRAME();
+        AUDIO_TRACE(kAudioTraceProcessorOutput, frame_id);
         {
             std::lock_guard<std::mutex> lock(mutex_);
             if (audio_send_queue_.size() >= MAX_AUDIO_PACKETS_IN_QUEUE) {
@@ -611,10 +566,14 @@ void Application::Start() {
                 return;
             }
         }
-        background_task_->Schedule([this, data = std::move(data)]() mutable {
-            opus_encoder_->Encode(std::move(data), [this](std::vector<uint8_t>&& opus) {
+        background_task_->Schedule([this, frame_id, data = std::move(data)]() mutable {
+            AUDIO_TRACE(kAudioTraceEncodeStart, frame_id);
+            // The encoder buffers partial frames, a packet carries the id of the block that completed it
+            opus_encoder_->Encode(std::move(data), [this, frame_id](std::vector<uint8_t>&& opus) {
+                AUDIO_TRACE(kAudioTraceEncodeEnd, frame_id);
                 AudioStreamPacket packet;
                 packet.payload = std::move(opus);
+                packet.frame_id = frame_id;
 #ifdef CONFIG_USE_SERVER_AEC
                 {
                     std::lock_guard<std::mutex> lock(timestamp_mutex_);
@@ -698,14 +657,18 @@ void Application::Start() {
         });
     });
     wake_word_->StartDetection();
+    return protocol_started;
+}
 
-    // Wait for the new version check to finish
-    xEventGroupWaitBits(event_group_, CHECK_NEW_VERSION_DONE_EVENT, pdTRUE, pdFALSE, portMAX_DELAY);
+void Application::Run(bool protocol_started, const std::string& version) {
     SetDeviceState(kDeviceStateIdle);
 
-    has_server_time_ = ota.HasServerTime();
+    if (has_server_time_) {
+        StartClockTimer();
+    }
     if (protocol_started) {
-        std::string message = std::string(Lang::Strings::VERSION) + ota.GetCurrentVersion();
+        auto display = Board::GetInstance().GetDisplay();
+        std::string message = std::string(Lang::Strings::VERSION) + version;
         display->ShowNotification(message.c_str());
         display->SetChatMessage("system", "");
         // Play the success sound to indicate the device is ready
@@ -720,39 +683,76 @@ void Application::Start() {
     MainEventLoop();
 }
 
+// Fires at every minute boundary once the server time is known
 void Application::OnClockTimer() {
-    clock_ticks_++;
+    Schedule([this]() {
+        UpdateClock();
+    });
+    StartClockTimer();
+}
 
-    auto display = Board::GetInstance().GetDisplay();
-    display->UpdateStatusBar();
+void Application::StartClockTimer() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    int64_t delay_us = (60 - tv.tv_sec % 60) * 1000000LL - tv.tv_usec;
+    esp_timer_stop(clock_timer_handle_);
+    esp_timer_start_once(clock_timer_handle_, delay_us);
+}
 
-    // Print the debug info every 10 seconds
-    if (clock_ticks_ % 10 == 0) {
-        // SystemInfo::PrintTaskCpuUsage(pdMS_TO_TICKS(1000));
-        // SystemInfo::PrintTaskList();
-        SystemInfo::PrintHeapStats();
+void Application::UpdateClock() {
+    // Set status to clock "HH:MM" if the device is idle, only when the minute changes
+    if (!has_server_time_ || device_state_ != kDeviceStateIdle) {
+        return;
+    }
+    time_t now = time(NULL);
+    struct tm tm;
+    localtime_r(&now, &tm);
+    int minute = tm.tm_hour * 60 + tm.tm_min;
+    if (minute == clock_minute_) {
+        return;
+    }
+    clock_minute_ = minute;
+    char time_str[64];
+    strftime(time_str, sizeof(time_str), "%H:%M  ", &tm);
+    Board::GetInstance().GetDisplay()->SetStatus(time_str);
+}
 
-        // If we have synchronized server time, set the status to clock "HH:MM" if the device is idle
-        if (has_server_time_) {
-            if (device_state_ == kDeviceStateIdle) {
-                Schedule([this]() {
-                    // Set status to clock "HH:MM"
-                    time_t now = time(NULL);
-                    char time_str[64];
-                    strftime(time_str, sizeof(time_str), "%H:%M  ", localtime(&now));
-                    Board::GetInstance().GetDisplay()->SetStatus(time_str);
-                });
-            }
-        }
+// Heap and main loop stats are sampled by SystemProfiler, see self.system.get_profile
+void Application::OnStatusTimer() {
+    uint32_t polled = (kStatusBarBattery | kStatusBarNetwork) & ~Board::GetInstance().GetStatusBarEvents();
+    if (polled != 0) {
+        NotifyStatusBarChanged(polled);
+    }
+
+    // Show the clock again after the idle status text, the clock timer only fires when the minute changes
+    if (has_server_time_ && device_state_ == kDeviceStateIdle) {
+        Schedule([this]() {
+            UpdateClock();
+        });
     }
 }
 
-// Add a async task to MainLoop
-void Application::Schedule(std::function<void()> callback) {
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        main_tasks_.push_back(std::move(callback));
+void Application::NotifyStatusBarChanged(uint32_t items) {
+    if (status_bar_pending_.fetch_or(items) != 0) {
+        // Already scheduled, the pending update reads these items too
+        return;
     }
+    esp_timer_start_once(status_bar_notify_timer_, 0);
+}
+
+// Add a async task to MainLoop
+void Application::Schedule(std::function<void()> callback, MessagePriority priority) {
+    main_messages_.Push(std::move(callback), priority);
+    xEventGroupSetBits(event_group_, SCHEDULE_EVENT);
+}
+
+void Application::ScheduleChatMessage(const char* role, const char* content) {
+    main_messages_.PushChatMessage(role, content);
+    xEventGroupSetBits(event_group_, SCHEDULE_EVENT);
+}
+
+void Application::ScheduleEmotion(const char* emotion) {
+    main_messages_.PushEmotion(emotion);
     xEventGroupSetBits(event_group_, SCHEDULE_EVENT);
 }
 
@@ -771,6 +771,7 @@ void Application::MainEventLoop() {
             auto packets = std::move(audio_send_queue_);
             lock.unlock();
             for (auto& packet : packets) {
+                AUDIO_TRACE(kAudioTraceSend, packet.frame_id);
                 if (!protocol_->SendAudio(packet)) {
                     break;
                 }
@@ -778,12 +779,20 @@ void Application::MainEventLoop() {
         }
 
         if (bits & SCHEDULE_EVENT) {
-            std::unique_lock<std::mutex> lock(mutex_);
-            auto tasks = std::move(main_tasks_);
-            lock.unlock();
-            for (auto& task : tasks) {
-                task();
-            }
+            main_messages_.DispatchAll([this](MainMessage& message) {
+                auto display = Board::GetInstance().GetDisplay();
+                switch (message.type) {
+                    case kMainMessageCallback:
+                        message.callback();
+                        break;
+                    case kMainMessageChat:
+                        display->SetChatMessage(message.role, message.text.c_str());
+                        break;
+                    case kMainMessageEmotion:
+                        display->SetEmotion(message.text.c_str());
+                        break;
+                }
+            });
         }
     }
 }
@@ -835,6 +844,7 @@ void Application::OnAudioOutput() {
             return;
         }
 
+        AUDIO_TRACE(kAudioTraceDecodeStart, packet.frame_id);
         std::vector<int16_t> pcm;
         if (!opus_decoder_->Decode(std::move(packet.payload), pcm)) {
             return;
@@ -846,7 +856,10 @@ void Application::OnAudioOutput() {
             output_resampler_.Process(pcm.data(), pcm.size(), resampled.data());
             pcm = std::move(resampled);
         }
+        output_analyzer_.Process(pcm.data(), pcm.size(), codec->output_sample_rate());
+        AUDIO_TRACE(kAudioTraceDecodeEnd, packet.frame_id);
         codec->OutputData(pcm);
+        AUDIO_TRACE(kAudioTraceOutput, packet.frame_id);
 #ifdef CONFIG_USE_SERVER_AEC
         std::lock_guard<std::mutex> lock(timestamp_mutex_);
         timestamp_queue_.push_back(packet.timestamp);
@@ -896,6 +909,7 @@ void Application::OnAudioInput() {
         int samples = audio_processor_->GetFeedSize();
         if (samples > 0) {
             if (ReadAudio(data, 16000, samples)) {
+                AUDIO_TRACE(kAudioTraceMicRead, AUDIO_TRACE_FEED_FRAME());
                 audio_processor_->Feed(data);
                 return;
             }
@@ -944,6 +958,9 @@ bool Application::ReadAudio(std::vector<int16_t>& data, int sample_rate, int sam
         }
     }
     
+    // 只分析麦克风通道，参考通道是播放的回采信号
+    input_analyzer_.Process(data.data(), data.size(), sample_rate, codec->input_channels());
+
     // 音频调试：发送原始音频数据
     if (audio_debugger_) {
         audio_debugger_->Feed(data);
@@ -968,8 +985,8 @@ void Application::SetDeviceState(DeviceState state) {
         return;
     }
     
-    clock_ticks_ = 0;
-    auto previous_state = device_state_;
+    clock_minute_ = -1;
+    DeviceState previous_state = device_state_;
     device_state_ = state;
     ESP_LOGI(TAG, "STATE: %s", STATE_STRINGS[device_state_]);
     // The state is changed, wait for all background tasks to finish
@@ -979,23 +996,31 @@ void Application::SetDeviceState(DeviceState state) {
     auto display = board.GetDisplay();
     auto led = board.GetLed();
     led->OnStateChanged();
+    // The network icon is only refreshed in some states, see Display::UpdateStatusBar()
+    NotifyStatusBarChanged(kStatusBarNetwork);
     switch (state) {
         case kDeviceStateUnknown:
         case kDeviceStateIdle:
             display->SetStatus(Lang::Strings::STANDBY);
             display->SetEmotion("neutral");
+            // An emotion still pending belongs to the previous turn
+            main_messages_.DiscardEmotion();
             audio_processor_->Stop();
             wake_word_->StartDetection();
+            // The pipeline is quiet now, print the trace of the last session
+            AUDIO_TRACE_DUMP();
             break;
         case kDeviceStateConnecting:
             display->SetStatus(Lang::Strings::CONNECTING);
             display->SetEmotion("neutral");
+            main_messages_.DiscardEmotion();
             display->SetChatMessage("system", "");
             timestamp_queue_.clear();
             break;
         case kDeviceStateListening:
             display->SetStatus(Lang::Strings::LISTENING);
             display->SetEmotion("neutral");
+            main_messages_.DiscardEmotion();
             // Update the IoT states before sending the start listening command
 #if CONFIG_IOT_PROTOCOL_XIAOZHI
             UpdateIotStates();
@@ -1006,7 +1031,10 @@ void Application::SetDeviceState(DeviceState state) {
                 // Send the start listening command
                 protocol_->SendStartListening(listening_mode_);
                 if (previous_state == kDeviceStateSpeaking) {
-                    audio_decode_queue_.clear();
+                    {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        audio_decode_queue_.clear();
+                    }
                     audio_decode_cv_.notify_all();
                     // FIXME: Wait for the speaker to empty the buffer
                     vTaskDelay(pdMS_TO_TICKS(120));
@@ -1071,6 +1099,31 @@ void Application::UpdateIotStates() {
 #endif
 }
 
+void Application::NotifyStateChanged() {
+    if (state_notify_pending_.exchange(true)) {
+        // Already scheduled, the pending notification reads the latest values
+        return;
+    }
+    int64_t since_last_ms = (esp_timer_get_time() - last_state_notify_us_) / 1000;
+    int64_t delay_ms = std::max<int64_t>(STATE_NOTIFY_WINDOW_MS, STATE_NOTIFY_MIN_INTERVAL_MS - since_last_ms);
+    esp_timer_start_once(state_notify_timer_, delay_ms * 1000);
+}
+
+void Application::SendStateChanges() {
+    // Clear the flag first, changes made while sending schedule the next notification
+    state_notify_pending_ = false;
+    if (!protocol_ || !protocol_->IsAudioChannelOpened()) {
+        // Values are compared against the last sent ones, the next session picks up the changes
+        return;
+    }
+    last_state_notify_us_ = esp_timer_get_time();
+#if CONFIG_IOT_PROTOCOL_XIAOZHI
+    UpdateIotStates();
+#elif CONFIG_IOT_PROTOCOL_MCP
+    McpServer::GetInstance().NotifyDeviceStatus();
+#endif
+}
+
 void Application::Reboot() {
     ESP_LOGI(TAG, "Rebooting...");
     esp_restart();
@@ -11,6 +11,7 @@
 #include <list>
 #include <vector>
 #include <condition_variable>
+#include <atomic>
 #include <memory>
 
 #include <opus_encoder.h>
@@ -18,11 +19,12 @@
 #include <opus_resampler.h>
 
 #include "protocol.h"
-#include "ota.h"
 #include "background_task.h"
+#include "main_message_queue.h"
 #include "audio_processor.h"
 #include "wake_word.h"
 #include "audio_debugger.h"
+#include "audio_analyzer.h"
 
 #define SCHEDULE_EVENT (1 << 0)
 #define SEND_AUDIO_EVENT (1 << 1)
@@ -52,6 +54,8 @@ enum DeviceState {
 #define MAX_AUDIO_PACKETS_IN_QUEUE (2400 / OPUS_FRAME_DURATION_MS)
 #define AUDIO_TESTING_MAX_DURATION_MS 10000
 
+class Ota;
+
 class Application {
 public:
     static Application& GetInstance() {
@@ -62,10 +66,19 @@ public:
     Application(const Application&) = delete;
     Application& operator=(const Application&) = delete;
 
+    // Checks the firmware version, then connects with the protocol from the OTA config. Never returns
     void Start();
+    // Same without the firmware check, on the given protocol. Never returns
+    void Start(std::unique_ptr<Protocol> protocol);
     DeviceState GetDeviceState() const { return device_state_; }
     bool IsVoiceDetected() const { return voice_detected_; }
-    void Schedule(std::function<void()> callback);
+    // Lock-free loudness snapshots of the microphone and the playback stream
+    AudioLevels GetInputLevels() const { return input_analyzer_.GetLevels(); }
+    AudioLevels GetOutputLevels() const { return output_analyzer_.GetLevels(); }
+    void Schedule(std::function<void()> callback, MessagePriority priority = kMessagePriorityNormal);
+    // UI updates that are coalesced in the main loop, only the latest pending one is drawn
+    void ScheduleChatMessage(const char* role, const char* content);
+    void ScheduleEmotion(const char* emotion);
     void SetDeviceState(DeviceState state);
     void Alert(const char* status, const char* message, const char* emotion = "", const std::string_view& sound = "");
     void DismissAlert();
@@ -74,6 +87,10 @@ public:
     void StartListening();
     void StopListening();
     void UpdateIotStates();
+    // Coalesce state changes (volume, brightness, IoT properties) into one rate limited delta
+    void NotifyStateChanged();
+    // Redraw the given StatusBarItem bits in the esp_timer task, callable from any task, repeated notifications are merged
+    void NotifyStatusBarChanged(uint32_t items);
     void Reboot();
     void WakeWordInvoke(const std::string& wake_word);
     void PlaySound(const std::string_view& sound);
@@ -91,20 +108,28 @@ private:
     std::unique_ptr<WakeWord> wake_word_;
     std::unique_ptr<AudioProcessor> audio_processor_;
     std::unique_ptr<AudioDebugger> audio_debugger_;
+    AudioAnalyzer input_analyzer_;
+    AudioAnalyzer output_analyzer_;
     std::mutex mutex_;
-    std::list<std::function<void()>> main_tasks_;
+    MainMessageQueue main_messages_;
     std::unique_ptr<Protocol> protocol_;
     EventGroupHandle_t event_group_ = nullptr;
     esp_timer_handle_t clock_timer_handle_ = nullptr;
-    volatile DeviceState device_state_ = kDeviceStateUnknown;
+    esp_timer_handle_t status_timer_handle_ = nullptr;
+    esp_timer_handle_t status_bar_notify_timer_ = nullptr;
+    std::atomic<uint32_t> status_bar_pending_ = 0;
+    esp_timer_handle_t state_notify_timer_ = nullptr;
+    std::atomic<bool> state_notify_pending_ = false;
+    std::atomic<int64_t> last_state_notify_us_ = 0;
+    std::atomic<DeviceState> device_state_ = kDeviceStateUnknown;
     ListeningMode listening_mode_ = kListeningModeAutoStop;
     AecMode aec_mode_ = kAecOff;
 
     bool has_server_time_ = false;
-    bool aborted_ = false;
-    bool voice_detected_ = false;
-    bool busy_decoding_audio_ = false;
-    int clock_ticks_ = 0;
+    std::atomic<bool> aborted_ = false;
+    std::atomic<bool> voice_detected_ = false;
+    std::atomic<bool> busy_decoding_audio_ = false;
+    int clock_minute_ = -1;
     TaskHandle_t check_new_version_task_handle_ = nullptr;
 
     // Audio encode / decode
@@ -127,6 +152,9 @@ private:
     OpusResampler reference_resampler_;
     OpusResampler output_resampler_;
 
+    void InitializeDevice();
+    bool StartProtocol(std::unique_ptr<Protocol> protocol);
+    void Run(bool protocol_started, const std::string& version);
     void MainEventLoop();
     void OnAudioInput();
     void OnAudioOutput();
@@ -135,6 +163,10 @@ private:
     void CheckNewVersion(Ota& ota);
     void ShowActivationCode(const std::string& code, const std::string& message);
     void OnClockTimer();
+    void OnStatusTimer();
+    void StartClockTimer();
+    void UpdateClock();
+    void SendStateChanges();
     void SetListeningMode(ListeningMode mode);
     void AudioLoop();
     void EnterAudioTestingMode();
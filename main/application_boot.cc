@@ -0,0 +1,184 @@
+/*
+ * Device boot: firmware check, activation and the protocol chosen by the OTA server.
+ * Kept out of application.cc, which has no network dependency and also builds on the host.
+ */
+
+#include "application.h"
+#include "board.h"
+#include "display.h"
+#include "ota.h"
+#include "mqtt_protocol.h"
+#include "websocket_protocol.h"
+#include "font_awesome_symbols.h"
+#include "assets/lang_config.h"
+
+#include <array>
+#include <algorithm>
+#include <esp_log.h>
+
+#define TAG "Application"
+
+void Application::Start() {
+    auto display = Board::GetInstance().GetDisplay();
+    InitializeDevice();
+
+    // Check for new firmware version or get the MQTT broker address
+    Ota ota;
+    CheckNewVersion(ota);
+
+    // Initialize the protocol
+    display->SetStatus(Lang::Strings::LOADING_PROTOCOL);
+
+    std::unique_ptr<Protocol> protocol;
+    if (ota.HasMqttConfig()) {
+        protocol = std::make_unique<MqttProtocol>();
+    } else if (ota.HasWebsocketConfig()) {
+        protocol = std::make_unique<WebsocketProtocol>();
+    } else {
+        ESP_LOGW(TAG, "No protocol specified in the OTA config, using MQTT");
+        protocol = std::make_unique<MqttProtocol>();
+    }
+    bool protocol_started = StartProtocol(std::move(protocol));
+
+    // Wait for the new version check to finish
+    xEventGroupWaitBits(event_group_, CHECK_NEW_VERSION_DONE_EVENT, pdTRUE, pdFALSE, portMAX_DELAY);
+    has_server_time_ = ota.HasServerTime();
+    Run(protocol_started, ota.GetCurrentVersion());
+}
+
+void Application::CheckNewVersion(Ota& ota) {
+    const int MAX_RETRY = 10;
+    int retry_count = 0;
+    int retry_delay = 10; // 初始重试延迟为10秒
+
+    while (true) {
+        SetDeviceState(kDeviceStateActivating);
+        auto display = Board::GetInstance().GetDisplay();
+        display->SetStatus(Lang::Strings::CHECKING_NEW_VERSION);
+
+        if (!ota.CheckVersion()) {
+            retry_count++;
+            if (retry_count >= MAX_RETRY) {
+                ESP_LOGE(TAG, "Too many retries, exit version check");
+                return;
+            }
+
+            char buffer[128];
+            snprintf(buffer, sizeof(buffer), Lang::Strings::CHECK_NEW_VERSION_FAILED, retry_delay, ota.GetCheckVersionUrl().c_str());
+            Alert(Lang::Strings::ERROR, buffer, "sad", Lang::Sounds::P3_EXCLAMATION);
+
+            ESP_LOGW(TAG, "Check new version failed, retry in %d seconds (%d/%d)", retry_delay, retry_count, MAX_RETRY);
+            for (int i = 0; i < retry_delay; i++) {
+                vTaskDelay(pdMS_TO_TICKS(1000));
+                if (device_state_ == kDeviceStateIdle) {
+                    break;
+                }
+            }
+            retry_delay *= 2; // 每次重试后延迟时间翻倍
+            continue;
+        }
+        retry_count = 0;
+        retry_delay = 10; // 重置重试延迟时间
+
+        if (ota.HasNewVersion()) {
+            Alert(Lang::Strings::OTA_UPGRADE, Lang::Strings::UPGRADING, "happy", Lang::Sounds::P3_UPGRADE);
+
+            vTaskDelay(pdMS_TO_TICKS(3000));
+
+            SetDeviceState(kDeviceStateUpgrading);
+            
+            display->SetIcon(FONT_AWESOME_DOWNLOAD);
+            std::string message = std::string(Lang::Strings::NEW_VERSION) + ota.GetFirmwareVersion();
+            display->SetChatMessage("system", message.c_str());
+
+            auto& board = Board::GetInstance();
+            board.SetPowerSaveMode(false);
+            wake_word_->StopDetection();
+            // 预先关闭音频输出，避免升级过程有音频操作
+            auto codec = board.GetAudioCodec();
+            codec->EnableInput(false);
+            codec->EnableOutput(false);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                audio_decode_queue_.clear();
+            }
+            background_task_->WaitForCompletion();
+            delete background_task_;
+            background_task_ = nullptr;
+            vTaskDelay(pdMS_TO_TICKS(1000));
+
+            ota.StartUpgrade([display](int progress, size_t speed) {
+                char buffer[64];
+                snprintf(buffer, sizeof(buffer), "%d%% %uKB/s", progress, speed / 1024);
+                display->SetChatMessage("system", buffer);
+            });
+
+            // If upgrade success, the device will reboot and never reach here
+            display->SetStatus(Lang::Strings::UPGRADE_FAILED);
+            ESP_LOGI(TAG, "Firmware upgrade failed...");
+            vTaskDelay(pdMS_TO_TICKS(3000));
+            Reboot();
+            return;
+        }
+
+        // No new version, mark the current version as valid
+        ota.MarkCurrentVersionValid();
+        if (!ota.HasActivationCode() && !ota.HasActivationChallenge()) {
+            xEventGroupSetBits(event_group_, CHECK_NEW_VERSION_DONE_EVENT);
+            // Exit the loop if done checking new version
+            break;
+        }
+
+        display->SetStatus(Lang::Strings::ACTIVATION);
+        // Activation code is shown to the user and waiting for the user to input
+        if (ota.HasActivationCode()) {
+            ShowActivationCode(ota.GetActivationCode(), ota.GetActivationMessage());
+        }
+
+        // This will block the loop until the activation is done or timeout
+        for (int i = 0; i < 10; ++i) {
+            ESP_LOGI(TAG, "Activating... %d/%d", i + 1, 10);
+            esp_err_t err = ota.Activate();
+            if (err == ESP_OK) {
+                xEventGroupSetBits(event_group_, CHECK_NEW_VERSION_DONE_EVENT);
+                break;
+            } else if (err == ESP_ERR_TIMEOUT) {
+                vTaskDelay(pdMS_TO_TICKS(3000));
+            } else {
+                vTaskDelay(pdMS_TO_TICKS(10000));
+            }
+            if (device_state_ == kDeviceStateIdle) {
+                break;
+            }
+        }
+    }
+}
+void Application::ShowActivationCode(const std::string& code, const std::string& message) {
+    struct digit_sound {
+        char digit;
+        const std::string_view& sound;
+    };
+    static const std::array<digit_sound, 10> digit_sounds{{
+        digit_sound{'0', Lang::Sounds::P3_0},
+        digit_sound{'1', Lang::Sounds::P3_1}, 
+        digit_sound{'2', Lang::Sounds::P3_2},
+        digit_sound{'3', Lang::Sounds::P3_3},
+        digit_sound{'4', Lang::Sounds::P3_4},
+        digit_sound{'5', Lang::Sounds::P3_5},
+        digit_sound{'6', Lang::Sounds::P3_6},
+        digit_sound{'7', Lang::Sounds::P3_7},
+        digit_sound{'8', Lang::Sounds::P3_8},
+        digit_sound{'9', Lang::Sounds::P3_9}
+    }};
+
+    // This sentence uses 9KB of SRAM, so we need to wait for it to finish
+    Alert(Lang::Strings::ACTIVATION, message.c_str(), "happy", Lang::Sounds::P3_ACTIVATION);
+
+    for (const auto& digit : code) {
+        auto it = std::find_if(digit_sounds.begin(), digit_sounds.end(),
+            [digit](const digit_sound& ds) { return ds.digit == digit; });
+        if (it != digit_sounds.end()) {
+            PlaySound(it->sound);
+        }
+    }
+}
\ No newline at end of file
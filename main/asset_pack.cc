@@ -0,0 +1,150 @@
+#include "asset_pack.h"
+
+#include <esp_log.h>
+#include <esp_rom_crc.h>
+
+#include <cstring>
+
+#define TAG "AssetPack"
+
+AssetPack::~AssetPack() {
+    for (auto& [name, font] : fonts_) {
+        if (font != nullptr) {
+            lv_binfont_destroy(font);
+        }
+    }
+    if (base_ != nullptr) {
+        esp_partition_munmap(mmap_handle_);
+    }
+}
+
+bool AssetPack::Load(const char* partition_label) {
+    if (base_ != nullptr) {
+        return true;
+    }
+
+    auto partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, partition_label);
+    if (partition == nullptr) {
+        ESP_LOGI(TAG, "No %s partition, using embedded assets", partition_label);
+        return false;
+    }
+
+    AssetPackHeader header;
+    esp_err_t err = esp_partition_read(partition, 0, &header, sizeof(header));
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to read header: %s", esp_err_to_name(err));
+        return false;
+    }
+    if (header.magic != ASSET_PACK_MAGIC) {
+        ESP_LOGI(TAG, "No asset pack in %s partition", partition_label);
+        return false;
+    }
+    size_t index_end = sizeof(header) + header.entry_count * sizeof(AssetPackEntry);
+    if (header.version != ASSET_PACK_VERSION || header.total_size > partition->size || header.total_size < index_end) {
+        ESP_LOGE(TAG, "Unsupported asset pack, version %u, size %lu", header.version, (unsigned long)header.total_size);
+        return false;
+    }
+
+    // Only the MMU is set up here, flash pages are read when an asset is touched
+    const void* base = nullptr;
+    err = esp_partition_mmap(partition, 0, header.total_size, ESP_PARTITION_MMAP_DATA, &base, &mmap_handle_);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to map %s partition: %s", partition_label, esp_err_to_name(err));
+        return false;
+    }
+
+    auto entries = (const AssetPackEntry*)((const uint8_t*)base + sizeof(header));
+    if (esp_rom_crc32_le(0, (const uint8_t*)entries, index_end - sizeof(header)) != header.index_crc) {
+        ESP_LOGE(TAG, "Asset pack index is corrupted");
+        esp_partition_munmap(mmap_handle_);
+        return false;
+    }
+    for (size_t i = 0; i < header.entry_count; i++) {
+        auto& entry = entries[i];
+        if (entry.name[ASSET_PACK_NAME_LEN - 1] != '\0' || entry.offset < index_end ||
+            entry.offset > header.total_size || entry.size > header.total_size - entry.offset) {
+            ESP_LOGE(TAG, "Invalid asset entry %zu", i);
+            esp_partition_munmap(mmap_handle_);
+            return false;
+        }
+    }
+
+    base_ = (const uint8_t*)base;
+    entries_ = entries;
+    entry_count_ = header.entry_count;
+    ESP_LOGI(TAG, "Mapped %zu assets, %lu bytes", entry_count_, (unsigned long)header.total_size);
+    return true;
+}
+
+const AssetPackEntry* AssetPack::Find(const char* name) const {
+    size_t low = 0;
+    size_t high = entry_count_;
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        int cmp = strcmp(entries_[mid].name, name);
+        if (cmp == 0) {
+            return &entries_[mid];
+        }
+        if (cmp < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return nullptr;
+}
+
+bool AssetPack::GetData(const char* name, std::string_view& data) const {
+    auto entry = Find(name);
+    if (entry == nullptr) {
+        return false;
+    }
+    data = std::string_view((const char*)base_ + entry->offset, entry->size);
+    return true;
+}
+
+std::string_view AssetPack::GetSound(const char* name, std::string_view fallback) const {
+    auto entry = Find(name);
+    if (entry == nullptr || entry->type != kAssetTypeSound) {
+        return fallback;
+    }
+    return std::string_view((const char*)base_ + entry->offset, entry->size);
+}
+
+bool AssetPack::GetImage(const char* name, lv_img_dsc_t& image) const {
+    auto entry = Find(name);
+    if (entry == nullptr || entry->type != kAssetTypeImage) {
+        return false;
+    }
+    memset(&image, 0, sizeof(image));
+    image.header.magic = LV_IMAGE_HEADER_MAGIC;
+    image.header.cf = entry->color_format;
+    image.header.w = entry->width;
+    image.header.h = entry->height;
+    image.data_size = entry->size;
+    image.data = base_ + entry->offset;
+    return true;
+}
+
+lv_font_t* AssetPack::GetFont(const char* name) {
+    std::lock_guard<std::mutex> lock(font_mutex_);
+    auto it = fonts_.find(name);
+    if (it != fonts_.end()) {
+        return it->second;
+    }
+
+    lv_font_t* font = nullptr;
+    auto entry = Find(name);
+    if (entry != nullptr && entry->type == kAssetTypeFont) {
+#if LV_USE_FS_MEMFS
+        font = lv_binfont_create_from_buffer((void*)(base_ + entry->offset), entry->size);
+        if (font == nullptr) {
+            ESP_LOGE(TAG, "Failed to load font %s", name);
+        }
+#else
+        ESP_LOGW(TAG, "Font %s needs LV_USE_FS_MEMFS", name);
+#endif
+    }
+    fonts_[name] = font;
+    return font;
+}
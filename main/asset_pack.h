@@ -0,0 +1,94 @@
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#include <esp_partition.h>
+#include <lvgl.h>
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#define ASSET_PACK_PARTITION "assets"
+#define ASSET_PACK_MAGIC 0x50415a58     // "XZAP"
+#define ASSET_PACK_VERSION 1
+#define ASSET_PACK_NAME_LEN 32
+
+enum AssetType : uint8_t {
+    kAssetTypeBlob = 0,
+    kAssetTypeSound = 1,    // P3 stream
+    kAssetTypeFont = 2,     // LVGL binary font (lv_font_conv --format bin)
+    kAssetTypeImage = 3,
+};
+
+// Layout shared with scripts/asset_tools/pack_assets.py, all fields little endian
+struct AssetPackHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t entry_count;
+    uint32_t total_size;        // From the start of the header to the end of the last asset
+    uint32_t index_crc;         // CRC32 of the entry table
+    uint32_t data_crc;          // CRC32 of everything after the entry table, checked by the tools only
+    uint32_t reserved[3];
+};
+
+// Entries are sorted by name
+struct AssetPackEntry {
+    char name[ASSET_PACK_NAME_LEN];     // NUL terminated
+    uint32_t offset;                    // From the start of the header, aligned by the packer
+    uint32_t size;
+    uint8_t type;
+    uint8_t color_format;               // lv_color_format_t of an image, LV_COLOR_FORMAT_RAW if it is encoded
+    uint16_t reserved;
+    uint16_t width;
+    uint16_t height;
+};
+
+static_assert(sizeof(AssetPackHeader) == 32, "AssetPackHeader must match the packer");
+static_assert(sizeof(AssetPackEntry) == 48, "AssetPackEntry must match the packer");
+
+/**
+ * Sounds, fonts and images packed into their own data partition, so they can be flashed or
+ * updated without rebuilding the firmware.
+ *
+ * Load() only checks the header and the entry table, the pack is memory mapped and the flash
+ * behind an asset is read when it is first touched. Lookups are a binary search by name and
+ * return views into the mapping, which stays valid until the device restarts.
+ */
+class AssetPack {
+public:
+    static AssetPack& GetInstance() {
+        static AssetPack instance;
+        return instance;
+    }
+    // Delete copy constructor and assignment operator
+    AssetPack(const AssetPack&) = delete;
+    AssetPack& operator=(const AssetPack&) = delete;
+
+    // False if there is no valid pack, callers fall back to the embedded assets then
+    bool Load(const char* partition_label = ASSET_PACK_PARTITION);
+    bool loaded() const { return base_ != nullptr; }
+
+    const AssetPackEntry* Find(const char* name) const;
+    bool GetData(const char* name, std::string_view& data) const;
+    // The sound in the pack, or fallback if it is not there
+    std::string_view GetSound(const char* name, std::string_view fallback = {}) const;
+    // The pixels are not copied, image.data points into the mapping
+    bool GetImage(const char* name, lv_img_dsc_t& image) const;
+    // Created on first use and kept, nullptr if missing or LVGL has no memory file system
+    lv_font_t* GetFont(const char* name);
+
+private:
+    AssetPack() = default;
+    ~AssetPack();
+
+    esp_partition_mmap_handle_t mmap_handle_ = 0;
+    const uint8_t* base_ = nullptr;
+    const AssetPackEntry* entries_ = nullptr;
+    size_t entry_count_ = 0;
+
+    std::mutex font_mutex_;
+    std::map<std::string, lv_font_t*> fonts_;
+};
+
+#endif // ASSET_PACK_H
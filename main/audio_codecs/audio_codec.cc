@@ -1,6 +1,8 @@
 #include "audio_codec.h"
 #include "board.h"
 #include "settings.h"
+#include "application.h"
+#include "display.h"
 
 #include <esp_log.h>
 #include <cstring>
@@ -16,9 +18,23 @@ AudioCodec::~AudioCodec() {
 
 void AudioCodec::OutputData(std::vector<int16_t>& data) {
     Write(data.data(), data.size());
+    if (software_reference_) {
+        software_reference_->OnOutput(data.data(), data.size());
+    }
 }
 
 bool AudioCodec::InputData(std::vector<int16_t>& data) {
+    if (software_reference_) {
+        // Stays within the capacity reserved in EnableSoftwareReference(), no allocation per read
+        mic_buffer_.resize(data.size() / 2);
+        int samples = Read(mic_buffer_.data(), mic_buffer_.size());
+        if (samples <= 0) {
+            return false;
+        }
+        software_reference_->OnInput(mic_buffer_.data(), samples, data.data());
+        return true;
+    }
+
     int samples = Read(data.data(), data.size());
     if (samples > 0) {
         return true;
@@ -26,11 +42,19 @@ bool AudioCodec::InputData(std::vector<int16_t>& data) {
     return false;
 }
 
+void AudioCodec::EnableSoftwareReference() {
+    software_reference_ = std::make_unique<SoftwareReference>(input_sample_rate_, output_sample_rate_);
+    // 100 ms, more than any feed or wake word chunk
+    mic_buffer_.reserve(input_sample_rate_ / 10);
+    input_reference_ = true;
+    input_channels_ = 2;
+}
+
 void AudioCodec::Start() {
     Settings settings("audio", false);
     output_volume_ = settings.GetInt("output_volume", output_volume_);
     if (output_volume_ <= 0) {
-        ESP_LOGW(TAG, "Output volume value (%d) is too small, setting to default (10)", output_volume_);
+        ESP_LOGW(TAG, "Output volume value (%d) is too small, setting to default (10)", output_volume_.load());
         output_volume_ = 10;
     }
 
@@ -44,10 +68,13 @@ void AudioCodec::Start() {
 
 void AudioCodec::SetOutputVolume(int volume) {
     output_volume_ = volume;
-    ESP_LOGI(TAG, "Set output volume to %d", output_volume_);
+    ESP_LOGI(TAG, "Set output volume to %d", output_volume_.load());
     
     Settings settings("audio", true);
     settings.SetInt("output_volume", output_volume_);
+    auto& app = Application::GetInstance();
+    app.NotifyStateChanged();
+    app.NotifyStatusBarChanged(kStatusBarMute);
 }
 
 void AudioCodec::EnableInput(bool enable) {
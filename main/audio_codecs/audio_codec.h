@@ -8,8 +8,11 @@
 #include <vector>
 #include <string>
 #include <functional>
+#include <memory>
+#include <atomic>
 
 #include "board.h"
+#include "software_reference.h"
 
 #define AUDIO_CODEC_DMA_DESC_NUM 6
 #define AUDIO_CODEC_DMA_FRAME_NUM 240
@@ -50,7 +53,13 @@ protected:
     int output_sample_rate_ = 0;
     int input_channels_ = 1;
     int output_channels_ = 1;
-    int output_volume_ = 70;
+    std::atomic<int> output_volume_ = 70;
+    std::unique_ptr<SoftwareReference> software_reference_;
+    std::vector<int16_t> mic_buffer_;   // Mono capture before the reference is interleaved
+
+    // For codecs without a loopback channel, call before Start() once the sample rates are known.
+    // The input becomes two channels, the microphone and the played PCM as the reference.
+    void EnableSoftwareReference();
 
     virtual int Read(int16_t* dest, int samples) = 0;
     virtual int Write(const int16_t* data, int samples) = 0;
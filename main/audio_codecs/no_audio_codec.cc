@@ -15,6 +15,14 @@ NoAudioCodec::~NoAudioCodec() {
     }
 }
 
+void NoAudioCodec::Start() {
+#if CONFIG_USE_SOFTWARE_AEC_REFERENCE
+    // There is no loopback on the I2S bus, use the PCM written to the speaker as the reference
+    EnableSoftwareReference();
+#endif
+    AudioCodec::Start();
+}
+
 NoAudioCodecDuplex::NoAudioCodecDuplex(int input_sample_rate, int output_sample_rate, gpio_num_t bclk, gpio_num_t ws, gpio_num_t dout, gpio_num_t din) {
     duplex_ = true;
     input_sample_rate_ = input_sample_rate;
@@ -13,6 +13,7 @@ private:
 
 public:
     virtual ~NoAudioCodec();
+    virtual void Start() override;
 };
 
 class NoAudioCodecDuplex : public NoAudioCodec {
@@ -0,0 +1,161 @@
+#include "software_reference.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#define TAG "SoftwareReference"
+
+// Below this mean amplitude the speaker is considered silent and no estimate is made
+#define MIN_REFERENCE_LEVEL 100
+// Normalized correlation needed to trust an estimate, talking over the playback lowers it
+#define MIN_CORRELATION 0.5f
+
+SoftwareReference::SoftwareReference(int input_sample_rate, int output_sample_rate)
+    : input_sample_rate_(input_sample_rate), output_sample_rate_(output_sample_rate) {
+    if (output_sample_rate_ != input_sample_rate_) {
+        resampler_.Configure(output_sample_rate_, input_sample_rate_);
+    }
+
+    // About one second, more than the playback queue plus the longest delay searched
+    int ring_size = 1;
+    while (ring_size < input_sample_rate_) {
+        ring_size <<= 1;
+    }
+    ring_.resize(ring_size, 0);
+    ring_mask_ = ring_size - 1;
+
+    block_samples_ = input_sample_rate_ * SOFTWARE_REFERENCE_BLOCK_MS / 1000;
+    ESP_LOGI(TAG, "Software reference enabled, %d Hz -> %d Hz", output_sample_rate_, input_sample_rate_);
+}
+
+void SoftwareReference::OnOutput(const int16_t* data, int samples) {
+    if (output_sample_rate_ != input_sample_rate_) {
+        resampled_.resize(resampler_.GetOutputSamples(samples));
+        resampler_.Process(data, samples, resampled_.data());
+        data = resampled_.data();
+        samples = resampled_.size();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    // The write returned once the data fit in the DMA queue, so it starts playing after what is
+    // already queued, or right now if the output was idle
+    int64_t now_pos = capture_pos_;
+    if (capture_time_us_ != 0) {
+        now_pos += (esp_timer_get_time() - capture_time_us_) * input_sample_rate_ / 1000000;
+    }
+    int64_t start = std::max(play_end_pos_, now_pos);
+    int64_t ring_size = ring_mask_ + 1;
+    if (start - now_pos > ring_size / 2) {
+        ESP_LOGW(TAG, "Reference is %lld samples ahead, resetting", (long long)(start - now_pos));
+        start = now_pos;
+    }
+
+    // Clear the silence between the previous output and this one
+    for (int64_t pos = std::max(play_end_pos_, start - ring_size); pos < start; pos++) {
+        ring_[pos & ring_mask_] = 0;
+    }
+    int skip = std::max<int64_t>(0, samples - ring_size);
+    for (int i = skip; i < samples; i++) {
+        ring_[(start + i) & ring_mask_] = data[i];
+    }
+    play_end_pos_ = start + samples;
+}
+
+int16_t SoftwareReference::ReferenceAt(int64_t pos) const {
+    if (pos < 0 || pos >= play_end_pos_ || pos < play_end_pos_ - (ring_mask_ + 1)) {
+        return 0;
+    }
+    return ring_[pos & ring_mask_];
+}
+
+void SoftwareReference::OnInput(const int16_t* mic, int samples, int16_t* output) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (int i = 0; i < samples; i++) {
+        int64_t pos = capture_pos_ + i;
+        output[i * 2] = mic[i];
+        output[i * 2 + 1] = ReferenceAt(pos - delay_);
+
+        // Envelopes are taken without the estimated delay, the estimator searches it
+        mic_sum_ += std::abs(mic[i]);
+        ref_sum_ += std::abs(ReferenceAt(pos));
+        if (++block_fill_ == block_samples_) {
+            mic_env_[env_index_] = mic_sum_ / block_samples_;
+            ref_env_[env_index_] = ref_sum_ / block_samples_;
+            env_index_ = (env_index_ + 1) % SOFTWARE_REFERENCE_HISTORY_BLOCKS;
+            block_fill_ = 0;
+            mic_sum_ = 0;
+            ref_sum_ = 0;
+            if (++env_count_ == SOFTWARE_REFERENCE_HISTORY_BLOCKS) {
+                env_count_ = 0;
+                EstimateDelay();
+            }
+        }
+    }
+    capture_pos_ += samples;
+    capture_time_us_ = esp_timer_get_time();
+}
+
+void SoftwareReference::EstimateDelay() {
+    const int history = SOFTWARE_REFERENCE_HISTORY_BLOCKS;
+    const int max_lag = SOFTWARE_REFERENCE_MAX_LAG_BLOCKS;
+    // Oldest block first
+    auto mic_at = [this](int t) { return (float)mic_env_[(env_index_ + t) % history]; };
+    auto ref_at = [this](int t) { return (float)ref_env_[(env_index_ + t) % history]; };
+
+    float mic_mean = 0, ref_mean = 0;
+    for (int t = 0; t < history; t++) {
+        ref_mean += ref_at(t);
+    }
+    ref_mean /= history;
+    if (ref_mean < MIN_REFERENCE_LEVEL) {
+        return;
+    }
+    for (int t = max_lag; t < history; t++) {
+        mic_mean += mic_at(t);
+    }
+    mic_mean /= history - max_lag;
+
+    float mic_energy = 0;
+    for (int t = max_lag; t < history; t++) {
+        float x = mic_at(t) - mic_mean;
+        mic_energy += x * x;
+    }
+    if (mic_energy <= 0) {
+        return;
+    }
+
+    // The echo in the microphone follows the reference, so only positive lags are searched
+    float best = 0;
+    int best_lag = -1;
+    for (int lag = 0; lag <= max_lag; lag++) {
+        float cross = 0, ref_energy = 0;
+        for (int t = max_lag; t < history; t++) {
+            float x = mic_at(t) - mic_mean;
+            float y = ref_at(t - lag) - ref_mean;
+            cross += x * y;
+            ref_energy += y * y;
+        }
+        if (ref_energy <= 0) {
+            continue;
+        }
+        float correlation = cross / sqrtf(mic_energy * ref_energy);
+        if (correlation > best) {
+            best = correlation;
+            best_lag = lag;
+        }
+    }
+    if (best_lag < 0 || best < MIN_CORRELATION) {
+        return;
+    }
+
+    // Keep the reference one block early, the AEC filter covers the rest but cannot look ahead
+    int delay = std::max(0, best_lag - 1) * block_samples_;
+    if (std::abs(delay - delay_) > block_samples_) {
+        ESP_LOGI(TAG, "Echo delay %d -> %d samples (correlation %.2f)", delay_, delay, best);
+        delay_ = delay;
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef SOFTWARE_REFERENCE_H
+#define SOFTWARE_REFERENCE_H
+
+#include <opus_resampler.h>
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Envelope block of the delay estimator, 4 ms
+#define SOFTWARE_REFERENCE_BLOCK_MS 4
+// Envelope history used for one estimate, ~1 s
+#define SOFTWARE_REFERENCE_HISTORY_BLOCKS 256
+// Longest echo delay searched, on top of the playback queue, 256 ms
+#define SOFTWARE_REFERENCE_MAX_LAG_BLOCKS 64
+
+/**
+ * Echo reference for codecs without a hardware loopback channel.
+ *
+ * The PCM written to the speaker is resampled to the input rate and placed on the capture
+ * timeline, at the capture position where it is expected to start playing (after the samples
+ * already queued in the I2S DMA). The remaining acoustic and ADC delay is estimated by
+ * correlating 4 ms energy envelopes of the microphone and the reference once per second of
+ * playback, which costs a few tens of thousands of multiply-adds per estimate.
+ *
+ * The reference is returned interleaved with the microphone as the R channel of the AFE.
+ */
+class SoftwareReference {
+public:
+    SoftwareReference(int input_sample_rate, int output_sample_rate);
+
+    // Called with the mono PCM after it has been written to the output
+    void OnOutput(const int16_t* data, int samples);
+    // Interleave the captured mono samples with the aligned reference, output holds 2 * samples
+    void OnInput(const int16_t* mic, int samples, int16_t* output);
+
+    int delay_samples() const { return delay_; }
+
+private:
+    std::mutex mutex_;
+    int input_sample_rate_;
+    int output_sample_rate_;
+    OpusResampler resampler_;
+    std::vector<int16_t> resampled_;
+
+    // Reference samples indexed by capture position
+    std::vector<int16_t> ring_;
+    int64_t ring_mask_;
+    int64_t capture_pos_ = 0;
+    int64_t capture_time_us_ = 0;
+    int64_t play_end_pos_ = 0;
+    int delay_ = 0;
+
+    // Delay estimation
+    int block_samples_;
+    int block_fill_ = 0;
+    int32_t mic_sum_ = 0;
+    int32_t ref_sum_ = 0;
+    uint16_t mic_env_[SOFTWARE_REFERENCE_HISTORY_BLOCKS] = {};
+    uint16_t ref_env_[SOFTWARE_REFERENCE_HISTORY_BLOCKS] = {};
+    int env_index_ = 0;
+    int env_count_ = 0;
+
+    int16_t ReferenceAt(int64_t pos) const;
+    void EstimateDelay();
+};
+
+#endif // SOFTWARE_REFERENCE_H
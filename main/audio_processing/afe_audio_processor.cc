@@ -87,6 +87,7 @@ void AfeAudioProcessor::Feed(const std::vector<int16_t>& data) {
 }
 
 void AfeAudioProcessor::Start() {
+    cpu_lock_.Acquire();
     xEventGroupSetBits(event_group_, PROCESSOR_RUNNING);
 }
 
@@ -95,6 +96,7 @@ void AfeAudioProcessor::Stop() {
     if (afe_data_ != nullptr) {
         afe_iface_->reset_buffer(afe_data_);
     }
+    cpu_lock_.Release();
 }
 
 bool AfeAudioProcessor::IsRunning() {
@@ -12,6 +12,7 @@
 
 #include "audio_processor.h"
 #include "audio_codec.h"
+#include "cpu_frequency_lock.h"
 
 class AfeAudioProcessor : public AudioProcessor {
 public:
@@ -36,6 +37,8 @@ private:
     std::function<void(bool speaking)> vad_state_change_callback_;
     AudioCodec* codec_ = nullptr;
     bool is_speaking_ = false;
+    // AEC, NS and VAD are sized for the max frequency, DFS must not lower it while processing
+    CpuFrequencyLock cpu_lock_{"audio_processor"};
 
     void AudioProcessorTask();
 };
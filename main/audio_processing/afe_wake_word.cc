@@ -82,6 +82,7 @@ void AfeWakeWord::OnWakeWordDetected(std::function<void(const std::string& wake_
 }
 
 void AfeWakeWord::StartDetection() {
+    cpu_lock_.Acquire();
     xEventGroupSetBits(event_group_, DETECTION_RUNNING_EVENT);
 }
 
@@ -90,6 +91,7 @@ void AfeWakeWord::StopDetection() {
     if (afe_data_ != nullptr) {
         afe_iface_->reset_buffer(afe_data_);
     }
+    cpu_lock_.Release();
 }
 
 bool AfeWakeWord::IsDetectionRunning() {
@@ -17,6 +17,7 @@
 
 #include "audio_codec.h"
 #include "wake_word.h"
+#include "cpu_frequency_lock.h"
 
 class AfeWakeWord : public WakeWord {
 public:
@@ -43,6 +44,8 @@ private:
     std::function<void(const std::string& wake_word)> wake_word_detected_callback_;
     AudioCodec* codec_ = nullptr;
     std::string last_detected_wake_word_;
+    // WakeNet and the AFE are sized for the max frequency, DFS must not lower it while detecting
+    CpuFrequencyLock cpu_lock_{"wake_word"};
 
     TaskHandle_t wake_word_encode_task_ = nullptr;
     StaticTask_t wake_word_encode_task_buffer_;
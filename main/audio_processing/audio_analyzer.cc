@@ -0,0 +1,116 @@
+#include "audio_analyzer.h"
+
+#include <esp_timer.h>
+#include <algorithm>
+#include <cmath>
+
+// Analysis rate after decimation, high enough for the 3 kHz band
+#define AUDIO_ANALYZER_TARGET_RATE 8000
+// Max samples analyzed per block after decimation (32 ms at 8 kHz)
+#define AUDIO_ANALYZER_WINDOW 256
+// Level drop per processed block, so peaks stay visible at low frame rates
+#define AUDIO_ANALYZER_RELEASE 12
+#define AUDIO_ANALYZER_FLOOR_DB -60.0f
+// Levels read as zero when the stream has not been fed for this long
+#define AUDIO_ANALYZER_STALE_MS 200
+
+static const int kBandFrequencies[AUDIO_ANALYZER_BAND_COUNT] = { 250, 1000, 3000 };
+
+static uint8_t ToLevel(float amplitude) {
+    if (amplitude < 1.0f) {
+        return 0;
+    }
+    float db = 20.0f * log10f(amplitude / 32768.0f);
+    int level = (int)((db - AUDIO_ANALYZER_FLOOR_DB) * 255.0f / -AUDIO_ANALYZER_FLOOR_DB);
+    return std::clamp(level, 0, 255);
+}
+
+static uint32_t Pack(const AudioLevels& levels) {
+    uint32_t value = levels.rms;
+    for (int i = 0; i < AUDIO_ANALYZER_BAND_COUNT; i++) {
+        value |= (uint32_t)levels.bands[i] << (8 * (i + 1));
+    }
+    return value;
+}
+
+static AudioLevels Unpack(uint32_t value) {
+    AudioLevels levels;
+    levels.rms = value & 0xFF;
+    for (int i = 0; i < AUDIO_ANALYZER_BAND_COUNT; i++) {
+        levels.bands[i] = (value >> (8 * (i + 1))) & 0xFF;
+    }
+    return levels;
+}
+
+static uint8_t Release(uint8_t current, uint8_t previous) {
+    return std::max<int>(current, previous - AUDIO_ANALYZER_RELEASE);
+}
+
+AudioAnalyzer::AudioAnalyzer() {
+}
+
+void AudioAnalyzer::Configure(int sample_rate) {
+    sample_rate_ = sample_rate;
+    decimation_ = std::max(1, sample_rate / AUDIO_ANALYZER_TARGET_RATE);
+    float rate = (float)sample_rate / decimation_;
+    for (int i = 0; i < AUDIO_ANALYZER_BAND_COUNT; i++) {
+        float w = 2.0f * (float)M_PI * kBandFrequencies[i] / rate;
+        coefficients_[i] = lroundf(2.0f * cosf(w) * 16384.0f);
+    }
+}
+
+void AudioAnalyzer::Process(const int16_t* samples, size_t count, int sample_rate, int channels) {
+    if (samples == nullptr || sample_rate <= 0 || channels <= 0) {
+        return;
+    }
+    if (sample_rate != sample_rate_) {
+        Configure(sample_rate);
+    }
+
+    size_t stride = decimation_ * channels;
+    size_t total = count / stride;
+    size_t n = std::min<size_t>(total, AUDIO_ANALYZER_WINDOW);
+    if (n == 0) {
+        return;
+    }
+    // Analyze the most recent samples only, the cost per block is bounded
+    const int16_t* p = samples + (total - n) * stride;
+
+    int64_t energy = 0;
+    int32_t s1[AUDIO_ANALYZER_BAND_COUNT] = {};
+    int32_t s2[AUDIO_ANALYZER_BAND_COUNT] = {};
+    for (size_t k = 0; k < n; k++, p += stride) {
+        int32_t x = *p;
+        energy += x * x;
+        for (int b = 0; b < AUDIO_ANALYZER_BAND_COUNT; b++) {
+            int32_t s = x + (int32_t)(((int64_t)coefficients_[b] * s1[b]) >> 14) - s2[b];
+            s2[b] = s1[b];
+            s1[b] = s;
+        }
+    }
+
+    AudioLevels current;
+    current.rms = ToLevel(sqrtf((float)(energy / (int64_t)n)));
+    for (int b = 0; b < AUDIO_ANALYZER_BAND_COUNT; b++) {
+        int64_t power = (int64_t)s1[b] * s1[b] + (int64_t)s2[b] * s2[b]
+            - ((((int64_t)coefficients_[b] * s1[b]) >> 14) * s2[b]);
+        // |X(k)| = A * N / 2 for a tone of amplitude A
+        current.bands[b] = ToLevel(sqrtf((float)std::max<int64_t>(power, 0)) * 2.0f / n);
+    }
+
+    AudioLevels previous = Unpack(levels_.load(std::memory_order_relaxed));
+    current.rms = Release(current.rms, previous.rms);
+    for (int b = 0; b < AUDIO_ANALYZER_BAND_COUNT; b++) {
+        current.bands[b] = Release(current.bands[b], previous.bands[b]);
+    }
+    levels_.store(Pack(current), std::memory_order_release);
+    updated_ms_.store(esp_timer_get_time() / 1000, std::memory_order_release);
+}
+
+AudioLevels AudioAnalyzer::GetLevels() const {
+    uint32_t now_ms = esp_timer_get_time() / 1000;
+    if (now_ms - updated_ms_.load(std::memory_order_acquire) > AUDIO_ANALYZER_STALE_MS) {
+        return AudioLevels();
+    }
+    return Unpack(levels_.load(std::memory_order_acquire));
+}
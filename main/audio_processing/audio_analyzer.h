@@ -0,0 +1,43 @@
+#ifndef AUDIO_ANALYZER_H
+#define AUDIO_ANALYZER_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+#define AUDIO_ANALYZER_BAND_COUNT 3
+
+// Levels are 0 ~ 255, mapped from -60 dBFS ~ 0 dBFS
+struct AudioLevels {
+    uint8_t rms = 0;
+    uint8_t bands[AUDIO_ANALYZER_BAND_COUNT] = {};  // ~250 Hz, ~1 kHz, ~3 kHz
+};
+
+/**
+ * Cheap loudness analysis for LED and display effects.
+ *
+ * Process() runs inline on the audio path: the input is decimated to ~8 kHz and at most
+ * AUDIO_ANALYZER_WINDOW samples of each block are analyzed (the most recent ones), using
+ * integer RMS and fixed-point Goertzel filters. The result is packed into one 32-bit atomic,
+ * so GetLevels() never blocks or tears and can be polled at any frame rate. Levels read as
+ * zero once the stream has not been fed for a while.
+ */
+class AudioAnalyzer {
+public:
+    AudioAnalyzer();
+
+    // channels > 1 means interleaved data, only the first channel is analyzed
+    void Process(const int16_t* samples, size_t count, int sample_rate, int channels = 1);
+    AudioLevels GetLevels() const;
+
+private:
+    std::atomic<uint32_t> levels_ = 0;
+    std::atomic<uint32_t> updated_ms_ = 0;
+    int sample_rate_ = 0;
+    int decimation_ = 1;
+    int32_t coefficients_[AUDIO_ANALYZER_BAND_COUNT] = {};  // 2 * cos(w) in Q14
+
+    void Configure(int sample_rate);
+};
+
+#endif // AUDIO_ANALYZER_H
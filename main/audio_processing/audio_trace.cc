@@ -0,0 +1,95 @@
+#include "audio_trace.h"
+
+#if CONFIG_USE_AUDIO_TRACE
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_cpu.h>
+#include <atomic>
+#include <deque>
+#include <mutex>
+
+#define TAG "AudioTrace"
+
+// A fed frame older than this was dropped by a processor reset, the AFE itself buffers far less
+#define AUDIO_TRACE_PENDING_MAX_AGE_US 500000
+
+struct AudioTraceEvent {
+    uint32_t time_us;
+    uint32_t frame_and_stage;   // Frame id in the upper 24 bits
+};
+
+// Each core appends to its own ring, so recording never contends with the other core
+struct AudioTraceBuffer {
+    std::atomic<uint32_t> head;
+    uint32_t dumped;
+    AudioTraceEvent events[CONFIG_AUDIO_TRACE_EVENTS_PER_CORE];
+};
+
+static AudioTraceBuffer buffers[CONFIG_FREERTOS_NUMBER_OF_CORES];
+static std::atomic<uint32_t> next_frame_id(1);
+
+struct AudioTracePendingFrame {
+    uint32_t frame_id;
+    int64_t time_us;
+};
+
+// Frames fed to the audio processor and not yet output, in feed order
+static std::mutex pending_mutex;
+static std::deque<AudioTracePendingFrame> pending_frames;
+
+uint32_t AudioTrace::NewFrame() {
+    return next_frame_id.fetch_add(1, std::memory_order_relaxed) & 0xFFFFFF;
+}
+
+uint32_t AudioTrace::FeedFrame() {
+    uint32_t frame_id = NewFrame();
+    std::lock_guard<std::mutex> lock(pending_mutex);
+    pending_frames.push_back({frame_id, esp_timer_get_time()});
+    return frame_id;
+}
+
+uint32_t AudioTrace::FetchFrame() {
+    int64_t now = esp_timer_get_time();
+    std::lock_guard<std::mutex> lock(pending_mutex);
+    while (!pending_frames.empty()) {
+        auto frame = pending_frames.front();
+        pending_frames.pop_front();
+        if (now - frame.time_us <= AUDIO_TRACE_PENDING_MAX_AGE_US) {
+            return frame.frame_id;
+        }
+    }
+    return NewFrame();
+}
+
+void AudioTrace::Record(AudioTraceStage stage, uint32_t frame_id) {
+    // A task switch between the two lines only puts the event in the other ring, the slot is still claimed atomically
+    auto& buffer = buffers[esp_cpu_get_core_id()];
+    uint32_t index = buffer.head.fetch_add(1, std::memory_order_relaxed);
+    auto& event = buffer.events[index % CONFIG_AUDIO_TRACE_EVENTS_PER_CORE];
+    event.time_us = (uint32_t)esp_timer_get_time();
+    event.frame_and_stage = (frame_id << 8) | stage;
+}
+
+void AudioTrace::Dump() {
+    int64_t now = esp_timer_get_time();
+    for (int core = 0; core < CONFIG_FREERTOS_NUMBER_OF_CORES; core++) {
+        auto& buffer = buffers[core];
+        uint32_t head = buffer.head.load(std::memory_order_acquire);
+        uint32_t count = head - buffer.dumped;
+        if (count > CONFIG_AUDIO_TRACE_EVENTS_PER_CORE) {
+            ESP_LOGW(TAG, "core %d: %lu events overwritten", core, (unsigned long)(count - CONFIG_AUDIO_TRACE_EVENTS_PER_CORE));
+            count = CONFIG_AUDIO_TRACE_EVENTS_PER_CORE;
+        }
+        // Format: core stage frame time_us
+        for (uint32_t i = head - count; i != head; i++) {
+            auto& event = buffer.events[i % CONFIG_AUDIO_TRACE_EVENTS_PER_CORE];
+            // Extend the 32 bit timestamp, it wraps every 71 minutes
+            int64_t time_us = now - (uint32_t)((uint32_t)now - event.time_us);
+            ESP_LOGI(TAG, "%d %lu %lu %lld", core, (unsigned long)(event.frame_and_stage & 0xFF),
+                (unsigned long)(event.frame_and_stage >> 8), time_us);
+        }
+        buffer.dumped = head;
+    }
+}
+
+#endif // CONFIG_USE_AUDIO_TRACE
@@ -0,0 +1,61 @@
+#ifndef AUDIO_TRACE_H
+#define AUDIO_TRACE_H
+
+#include <sdkconfig.h>
+#include <cstdint>
+
+/*
+ * Latency tracepoints of the voice pipeline.
+ *
+ * Uplink:   mic read -> processor output -> opus encode -> audio_send_queue_ -> SendAudio
+ * Downlink: incoming packet -> audio_decode_queue_ -> opus decode -> codec OutputData
+ *
+ * Every frame gets an id when it enters the pipeline, all stages of the frame record the same id.
+ * The audio processor outputs one chunk per chunk fed, so the ids of the fed chunks are queued and
+ * taken in order by the outputs; ids left over from before a processor reset are dropped by age.
+ * With CONFIG_USE_AUDIO_TRACE disabled the macros compile to nothing.
+ * Use scripts/audio_trace.py to turn a dump into a Chrome / Perfetto trace.
+ */
+enum AudioTraceStage : uint8_t {
+    kAudioTraceMicRead,
+    kAudioTraceProcessorOutput,
+    kAudioTraceEncodeStart,
+    kAudioTraceEncodeEnd,
+    kAudioTraceSend,
+    kAudioTraceReceive,
+    kAudioTraceDecodeStart,
+    kAudioTraceDecodeEnd,
+    kAudioTraceOutput,
+};
+
+#if CONFIG_USE_AUDIO_TRACE
+
+class AudioTrace {
+public:
+    static uint32_t NewFrame();
+    // A new frame whose id is queued for the next processor output
+    static uint32_t FeedFrame();
+    // The id of the oldest fed frame, or a new one if none is pending
+    static uint32_t FetchFrame();
+    static void Record(AudioTraceStage stage, uint32_t frame_id);
+    // Print the events recorded since the last dump
+    static void Dump();
+};
+
+#define AUDIO_TRACE_NEW_FRAME() AudioTrace::NewFrame()
+#define AUDIO_TRACE_FEED_FRAME() AudioTrace::FeedFrame()
+#define AUDIO_TRACE_FETCH_FRAME() AudioTrace::FetchFrame()
+#define AUDIO_TRACE(stage, frame_id) AudioTrace::Record(stage, frame_id)
+#define AUDIO_TRACE_DUMP() AudioTrace::Dump()
+
+#else
+
+#define AUDIO_TRACE_NEW_FRAME() 0
+#define AUDIO_TRACE_FEED_FRAME() 0
+#define AUDIO_TRACE_FETCH_FRAME() 0
+#define AUDIO_TRACE(stage, frame_id) ((void)(frame_id))
+#define AUDIO_TRACE_DUMP() do {} while (0)
+
+#endif // CONFIG_USE_AUDIO_TRACE
+
+#endif // AUDIO_TRACE_H
@@ -51,11 +51,13 @@ void EspWakeWord::OnWakeWordDetected(std::function<void(const std::string& wake_
 }
 
 void EspWakeWord::StartDetection() {
+    cpu_lock_.Acquire();
     xEventGroupSetBits(event_group_, DETECTION_RUNNING_EVENT);
 }
 
 void EspWakeWord::StopDetection() {
     xEventGroupClearBits(event_group_, DETECTION_RUNNING_EVENT);
+    cpu_lock_.Release();
 }
 
 bool EspWakeWord::IsDetectionRunning() {
@@ -18,6 +18,7 @@
 
 #include "audio_codec.h"
 #include "wake_word.h"
+#include "cpu_frequency_lock.h"
 
 class EspWakeWord : public WakeWord {
 public:
@@ -44,6 +45,8 @@ private:
 
     std::function<void(const std::string& wake_word)> wake_word_detected_callback_;
     std::string last_detected_wake_word_;
+    // WakeNet runs in Feed(), DFS must not lower the frequency while detecting
+    CpuFrequencyLock cpu_lock_{"wake_word"};
 };
 
 #endif
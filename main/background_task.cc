@@ -10,12 +10,20 @@ BackgroundTask::BackgroundTask(uint32_t stack_size) {
         BackgroundTask* task = (BackgroundTask*)arg;
         task->BackgroundTaskLoop();
     }, "background_task", stack_size, this, 2, &background_task_handle_);
+
+    auto ret = esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "background_task", &pm_lock_);
+    if (ret != ESP_OK && ret != ESP_ERR_NOT_SUPPORTED) {
+        ESP_LOGE(TAG, "Failed to create PM lock: %s", esp_err_to_name(ret));
+    }
 }
 
 BackgroundTask::~BackgroundTask() {
     if (background_task_handle_ != nullptr) {
         vTaskDelete(background_task_handle_);
     }
+    if (pm_lock_ != nullptr) {
+        esp_pm_lock_delete(pm_lock_);
+    }
 }
 
 bool BackgroundTask::Schedule(std::function<void()> callback) {
@@ -31,8 +39,14 @@ bool BackgroundTask::Schedule(std::function<void()> callback) {
         }
     }
     active_tasks_++;
+    if (pm_lock_ != nullptr) {
+        esp_pm_lock_acquire(pm_lock_);
+    }
     background_tasks_.emplace_back([this, cb = std::move(callback)]() {
         cb();
+        if (pm_lock_ != nullptr) {
+            esp_pm_lock_release(pm_lock_);
+        }
         {
             std::lock_guard<std::mutex> lock(mutex_);
             active_tasks_--;
@@ -3,6 +3,8 @@
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
+#include <esp_pm.h>
+#include <functional>
 #include <mutex>
 #include <list>
 #include <condition_variable>
@@ -21,6 +23,8 @@ private:
     std::list<std::function<void()>> background_tasks_;
     std::condition_variable condition_variable_;
     TaskHandle_t background_task_handle_ = nullptr;
+    // Held while work is pending, opus encoding and decoding must not run at a DFS lowered frequency
+    esp_pm_lock_handle_t pm_lock_ = nullptr;
     int active_tasks_ = 0;
     int waiting_for_completion_ = 0;
 
@@ -1,5 +1,8 @@
 #include "afsk_demod.h"
 #include <cstring>
+#include <cmath>
+#include <array>
+#include <numeric>
 #include <algorithm>
 #include "esp_log.h"
 
@@ -11,98 +14,10 @@ namespace audio_wifi_config
 {
     static const char *kLogTag = "AUDIO_WIFI_CONFIG";
 
-    void ReceiveWifiCredentialsFromAudio(Application *app,
-                                       WifiConfigurationAp *wifi_ap)
-    {
-        const int kInputSampleRate = 16000;                                    // Input sampling rate
-        const float kDownsampleStep = static_cast<float>(kInputSampleRate) / static_cast<float>(kAudioSampleRate); // Downsampling step
-        std::vector<int16_t> audio_data;
-        AudioSignalProcessor signal_processor(kAudioSampleRate, kMarkFrequency, kSpaceFrequency, kBitRate, kWindowSize);
-        AudioDataBuffer data_buffer;
-
-        while (true)
-        {
-            // 检查Application状态，只有在WiFi配置模式下才处理音频
-            if (app->GetDeviceState() != kDeviceStateWifiConfiguring) {
-                // 不在WiFi配置状态，休眠100ms后再检查
-                vTaskDelay(pdMS_TO_TICKS(100));
-                continue;
-            }
-            
-            if (!app->ReadAudio(audio_data, 16000, 480)) { // 16kHz, 480 samples corresponds to 30ms data
-                // 读取音频失败，短暂延迟后重试
-                ESP_LOGI(kLogTag, "Failed to read audio data, retrying.");
-                vTaskDelay(pdMS_TO_TICKS(10));
-                continue;
-            }
-            
-            // Downsample the audio data
-            std::vector<float> downsampled_data;
-            size_t last_index = 0;
-
-            if (kDownsampleStep > 1.0f)
-            {
-                downsampled_data.reserve(audio_data.size() / static_cast<size_t>(kDownsampleStep));
-                for (size_t i = 0; i < audio_data.size(); ++i)
-                {
-                    size_t sample_index = static_cast<size_t>(i / kDownsampleStep);
-                    if ((sample_index + 1) > last_index)
-                    {
-                        downsampled_data.push_back(static_cast<float>(audio_data[i]));
-                        last_index = sample_index + 1;
-                    }
-                }
-            }
-            else
-            {
-                downsampled_data.reserve(audio_data.size());
-                for (int16_t sample : audio_data)
-                {
-                    downsampled_data.push_back(static_cast<float>(sample));
-                }
-            }
-            
-            // Process audio samples to get probability data
-            auto probabilities = signal_processor.ProcessAudioSamples(downsampled_data);
-            
-            // Feed probability data to the data buffer
-            if (data_buffer.ProcessProbabilityData(probabilities, 0.5f))
-            {
-                // If complete data was received, extract WiFi credentials
-                if (data_buffer.decoded_text.has_value())
-                {
-                    ESP_LOGI(kLogTag, "Received text data: %s", data_buffer.decoded_text->c_str());
-                    
-                    // Split SSID and password by newline character
-                    std::string wifi_ssid, wifi_password;
-                    size_t newline_position = data_buffer.decoded_text->find('\n');
-                    if (newline_position != std::string::npos)
-                    {
-                        wifi_ssid = data_buffer.decoded_text->substr(0, newline_position);
-                        wifi_password = data_buffer.decoded_text->substr(newline_position + 1);
-                        ESP_LOGI(kLogTag, "WiFi SSID: %s, Password: %s", wifi_ssid.c_str(), wifi_password.c_str());
-                    }
-                    else
-                    {
-                        ESP_LOGE(kLogTag, "Invalid data format, no newline character found");
-                        continue;
-                    }
-                    
-                    if (wifi_ap->ConnectToWifi(wifi_ssid, wifi_password))
-                    {
-                        wifi_ap->Save(wifi_ssid, wifi_password);  // Save WiFi credentials
-                        esp_restart();                            // Restart device to apply new WiFi configuration
-                    }
-                    else
-                    {
-                        ESP_LOGE(kLogTag, "Failed to connect to WiFi with received credentials");
-                    }
-                    data_buffer.decoded_text.reset();  // Clear processed data
-                }
-            }
-            vTaskDelay(pdMS_TO_TICKS(1));  // 1ms delay
-        }
-    }
+    // Tones quieter than this amplitude are ignored by the symbol timing loop
+    static const int kMinToneAmplitude = 64;
+    // Symbol timing correction per observed transition, 1/4 of the error
+    static const int kTimingGainShift = 2;
 
     // Default start and end transmission identifiers
     // \x01\x02 = 00000001 00000010
@@ -113,151 +28,234 @@ namespace audio_wifi_config
     const std::vector<uint8_t> kDefaultEndTransmissionPattern = {
         0, 0, 0, 0, 0, 0, 1, 1, 0, 0, 0, 0, 0, 1, 0, 0};
 
-    // FrequencyDetector implementation
-    FrequencyDetector::FrequencyDetector(float frequency, size_t window_size)
-        : frequency_(frequency), window_size_(window_size)
-    {
-        frequency_bin_ = std::floor(frequency_ * static_cast<float>(window_size_));
-        angular_frequency_ = 2.0f * M_PI * frequency_;
-        cos_coefficient_ = std::cos(angular_frequency_);
-        sin_coefficient_ = std::sin(angular_frequency_);
-        filter_coefficient_ = 2.0f * cos_coefficient_;
-
-        // Initialize state buffer
-        state_buffer_.push_back(0.0f);
-        state_buffer_.push_back(0.0f);
-    }
-
-    void FrequencyDetector::Reset()
+    // One period of sin() in Q14, indexed by the top 8 bits of a 32-bit phase accumulator
+    static const std::array<int16_t, 256> &SineTable()
     {
-        state_buffer_.clear();
-        state_buffer_.push_back(0.0f);
-        state_buffer_.push_back(0.0f);
+        static const std::array<int16_t, 256> table = []() {
+            std::array<int16_t, 256> t;
+            for (int i = 0; i < 256; i++)
+            {
+                t[i] = static_cast<int16_t>(lroundf(16384.0f * sinf(2.0f * static_cast<float>(M_PI) * i / 256.0f)));
+            }
+            return t;
+        }();
+        return table;
     }
 
-    void FrequencyDetector::ProcessSample(float sample)
+    // Decimator implementation
+    Decimator::Decimator(size_t input_rate, size_t output_rate)
     {
-        if (state_buffer_.size() < 2)
+        size_t divisor = std::gcd(input_rate, output_rate);
+        up_ = output_rate / divisor;
+        down_ = input_rate / divisor;
+        if (up_ > kDecimatorMaxPhases)
         {
-            return;
+            ESP_LOGE(kLogTag, "Unsupported resampling ratio %zu/%zu", up_, down_);
+            up_ = kDecimatorMaxPhases;
         }
 
-        float s_minus_2 = state_buffer_.front();  // S[-2]
-        state_buffer_.pop_front();
-        float s_minus_1 = state_buffer_.front();  // S[-1]
-        state_buffer_.pop_front();
+        // Windowed-sinc low pass at the upsampled rate, cut off below the output Nyquist frequency
+        const size_t taps = up_ * kDecimatorTapsPerPhase;
+        const float cutoff = 0.45f * std::min(input_rate, output_rate) / static_cast<float>(input_rate * up_);
+        float h[kDecimatorMaxPhases * kDecimatorTapsPerPhase];
+        float sum = 0.0f;
+        for (size_t k = 0; k < taps; k++)
+        {
+            float x = static_cast<float>(k) - (taps - 1) / 2.0f;
+            float sinc = (x == 0.0f) ? 1.0f : sinf(2.0f * M_PI * cutoff * x) / (2.0f * M_PI * cutoff * x);
+            float window = 0.54f - 0.46f * cosf(2.0f * M_PI * k / (taps - 1));
+            h[k] = sinc * window;
+            sum += h[k];
+        }
+        // Unity DC gain after zero stuffing, split into polyphase branches
+        for (size_t k = 0; k < taps; k++)
+        {
+            size_t phase = k % up_;
+            size_t tap = k / up_;
+            coefficients_[phase * kDecimatorTapsPerPhase + tap] = static_cast<int16_t>(lroundf(h[k] * up_ / sum * 32767.0f));
+        }
+    }
 
-        float s_current = sample + filter_coefficient_ * s_minus_1 - s_minus_2;
+    size_t Decimator::Process(const int16_t *input, size_t count, int16_t *output, size_t max_output)
+    {
+        size_t produced = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            history_index_ = (history_index_ == 0) ? kDecimatorTapsPerPhase - 1 : history_index_ - 1;
+            history_[history_index_] = input[i];
+            history_[history_index_ + kDecimatorTapsPerPhase] = input[i];
 
-        state_buffer_.push_back(s_minus_1);  // Put S[-1] back
-        state_buffer_.push_back(s_current);  // Add new S[0]
+            while (phase_ < up_)
+            {
+                const int16_t *coefficients = &coefficients_[phase_ * kDecimatorTapsPerPhase];
+                const int16_t *window = &history_[history_index_];
+                int32_t acc = 0;
+                for (size_t j = 0; j < kDecimatorTapsPerPhase; j++)
+                {
+                    acc += coefficients[j] * window[j];
+                }
+                if (produced < max_output)
+                {
+                    output[produced++] = static_cast<int16_t>(std::clamp<int32_t>(acc >> 15, INT16_MIN, INT16_MAX));
+                }
+                phase_ += down_;
+            }
+            phase_ -= up_;
+        }
+        return produced;
     }
 
-    float FrequencyDetector::GetAmplitude() const
+    // AfskDemodulator implementation
+    AfskDemodulator::AfskDemodulator(const AfskConfig &config, size_t input_rate)
+        : config_(config), decimator_(input_rate, config.sample_rate)
     {
-        if (state_buffer_.size() < 2)
+        if (config_.sample_rate % config_.baud != 0)
         {
-            return 0.0f;
+            ESP_LOGW(kLogTag, "Sample rate %zu is not divisible by baud %zu", config_.sample_rate, config_.baud);
+        }
+        symbol_samples_ = std::clamp<size_t>(config_.sample_rate / config_.baud, 1, kMaxSymbolSamples);
+        config_.tone_count = std::clamp<size_t>(config_.tone_count, 2, kMaxTones);
+        bits_per_symbol_ = 0;
+        while ((2u << bits_per_symbol_) <= config_.tone_count)
+        {
+            bits_per_symbol_++;
+        }
+        for (size_t t = 0; t < config_.tone_count; t++)
+        {
+            phase_steps_[t] = static_cast<uint32_t>(static_cast<uint64_t>(config_.tones[t]) * (1ull << 32) / config_.sample_rate);
         }
-
-        float s_minus_1 = state_buffer_[1];                      // S[-1]
-        float s_minus_2 = state_buffer_[0];                      // S[-2]
-        float real_part = cos_coefficient_ * s_minus_1 - s_minus_2;  // Real part
-        float imaginary_part = sin_coefficient_ * s_minus_1;         // Imaginary part
-
-        return std::sqrt(real_part * real_part + imaginary_part * imaginary_part) / 
-               (static_cast<float>(window_size_) / 2.0f);
     }
 
-    // AudioSignalProcessor implementation
-    AudioSignalProcessor::AudioSignalProcessor(size_t sample_rate, size_t mark_frequency, size_t space_frequency,
-                                             size_t bit_rate, size_t window_size)
-        : input_buffer_size_(window_size), output_sample_count_(0)
+    int AfskDemodulator::ProcessSample(int16_t sample, int &confidence)
     {
-        if (sample_rate % bit_rate != 0)
+        const auto &sine = SineTable();
+        int64_t energies[kMaxTones];
+        for (size_t t = 0; t < config_.tone_count; t++)
         {
-            // On ESP32 we can continue execution, but log the error
-            ESP_LOGW(kLogTag, "Sample rate %zu is not divisible by bit rate %zu", sample_rate, bit_rate);
+            uint8_t index = phases_[t] >> 24;
+            phases_[t] += phase_steps_[t];
+            int16_t i_product = (sample * sine[(index + 64) & 0xFF]) >> 14;
+            int16_t q_product = (sample * sine[index]) >> 14;
+            // Sliding window: add the newest product, drop the one leaving the window
+            sums_[t][0] += i_product - products_[t][0][ring_index_];
+            sums_[t][1] += q_product - products_[t][1][ring_index_];
+            products_[t][0][ring_index_] = i_product;
+            products_[t][1][ring_index_] = q_product;
+            energies[t] = static_cast<int64_t>(sums_[t][0]) * sums_[t][0] + static_cast<int64_t>(sums_[t][1]) * sums_[t][1];
+        }
+        ring_index_ = (ring_index_ + 1 == symbol_samples_) ? 0 : ring_index_ + 1;
+        if (filled_ < symbol_samples_)
+        {
+            filled_++;
+            return -1;
         }
 
-        float normalized_mark_freq = static_cast<float>(mark_frequency) / static_cast<float>(sample_rate);
-        float normalized_space_freq = static_cast<float>(space_frequency) / static_cast<float>(sample_rate);
+        int best = 0;
+        for (size_t t = 1; t < config_.tone_count; t++)
+        {
+            if (energies[t] > energies[best])
+            {
+                best = t;
+            }
+        }
+        int64_t second = 0;
+        for (size_t t = 0; t < config_.tone_count; t++)
+        {
+            if (static_cast<int>(t) != best)
+            {
+                second = std::max(second, energies[t]);
+            }
+        }
+
+        // A tone of amplitude A gives a correlation of A * N / 2
+        const int64_t min_magnitude = kMinToneAmplitude * static_cast<int64_t>(symbol_samples_) / 2;
+        bool has_signal = energies[best] > min_magnitude * min_magnitude;
 
-        mark_detector_ = std::make_unique<FrequencyDetector>(normalized_mark_freq, window_size);
-        space_detector_ = std::make_unique<FrequencyDetector>(normalized_space_freq, window_size);
+        const int32_t period = static_cast<int32_t>(symbol_samples_) << 8;
+        symbol_phase_ += 1 << 8;
+        if (has_signal)
+        {
+            if (last_symbol_ >= 0 && best != last_symbol_)
+            {
+                // Decision changed at the window end: we should be half a symbol from the boundary
+                int32_t error = symbol_phase_ - period / 2;
+                symbol_phase_ -= error >> kTimingGainShift;
+            }
+            last_symbol_ = best;
+        }
 
-        samples_per_bit_ = sample_rate / bit_rate;  // Number of samples per bit
+        if (symbol_phase_ < period)
+        {
+            return -1;
+        }
+        symbol_phase_ -= period;
+        // Soft decision: 0 when the two strongest tones are equal, 255 for a clean tone
+        int64_t total = energies[best] + second;
+        confidence = total > 0 ? static_cast<int>((energies[best] - second) * 255 / total) : 0;
+        return best;
     }
 
-    std::vector<float> AudioSignalProcessor::ProcessAudioSamples(const std::vector<float> &samples)
+    size_t AfskDemodulator::Process(const int16_t *samples, size_t count, uint8_t *bits, size_t max_bits)
     {
-        std::vector<float> result;
-
-        for (float sample : samples)
+        size_t bit_count = 0;
+        const size_t block_size = sizeof(block_) / sizeof(block_[0]);
+        // Input per pass, so the decimated output always fits in block_
+        const size_t max_input = std::max<size_t>(1, decimator_.MaxInput(block_size));
+        while (count > 0)
         {
-            if (input_buffer_.size() < input_buffer_size_)
-            {
-                input_buffer_.push_back(sample);  // Just add, don't process yet
-            }
-            else
-            {
-                // Input buffer is full, process the data
-                input_buffer_.pop_front();   // Remove oldest sample
-                input_buffer_.push_back(sample);  // Add new sample
-                output_sample_count_++;
+            size_t input = std::min(count, max_input);
+            size_t decimated = decimator_.Process(samples, input, block_, block_size);
+            samples += input;
+            count -= input;
 
-                if (output_sample_count_ >= samples_per_bit_)
+            for (size_t i = 0; i < decimated; i++)
+            {
+                int confidence = 0;
+                int symbol = ProcessSample(block_[i], confidence);
+                if (symbol < 0)
                 {
-                    // Process all samples in the window using Goertzel algorithm
-                    for (float window_sample : input_buffer_)
+                    continue;
+                }
+                for (int b = bits_per_symbol_ - 1; b >= 0; b--)
+                {
+                    if (bit_count < max_bits)
                     {
-                        mark_detector_->ProcessSample(window_sample);
-                        space_detector_->ProcessSample(window_sample);
+                        bits[bit_count++] = (symbol >> b) & 1;
                     }
-
-                    float mark_amplitude = mark_detector_->GetAmplitude();   // Mark amplitude
-                    float space_amplitude = space_detector_->GetAmplitude(); // Space amplitude
-
-                    // Avoid division by zero
-                    float mark_probability = mark_amplitude / 
-                                           (space_amplitude + mark_amplitude + std::numeric_limits<float>::epsilon());
-                    result.push_back(mark_probability);
-
-                    // Reset detector windows
-                    mark_detector_->Reset();
-                    space_detector_->Reset();
-                    output_sample_count_ = 0;  // Reset output counter
                 }
             }
         }
-
-        return result;
+        return bit_count;
     }
 
     // AudioDataBuffer implementation
-    AudioDataBuffer::AudioDataBuffer()
-        : current_state_(DataReceptionState::kInactive),
-          start_of_transmission_(kDefaultStartTransmissionPattern),
-          end_of_transmission_(kDefaultEndTransmissionPattern),
-          enable_checksum_validation_(true)
+    static uint32_t PackIdentifier(const std::vector<uint8_t> &bits)
     {
-        identifier_buffer_size_ = std::max(start_of_transmission_.size(), end_of_transmission_.size());
-        max_bit_buffer_size_ = 776;  // Preset bit buffer size, 776 bits = (32 + 1 + 63 + 1) * 8 = 776
+        uint32_t value = 0;
+        for (uint8_t bit : bits)
+        {
+            value = (value << 1) | (bit & 1);
+        }
+        return value;
+    }
 
-        bit_buffer_.reserve(max_bit_buffer_size_);
+    AudioDataBuffer::AudioDataBuffer()
+        : AudioDataBuffer(776 / 8, kDefaultStartTransmissionPattern, kDefaultEndTransmissionPattern, true)
+    {
+        // Preset bit buffer size, 776 bits = (32 + 1 + 63 + 1) * 8 = 776
     }
 
     AudioDataBuffer::AudioDataBuffer(size_t max_byte_size, const std::vector<uint8_t> &start_identifier,
                                    const std::vector<uint8_t> &end_identifier, bool enable_checksum)
         : current_state_(DataReceptionState::kInactive),
-          start_of_transmission_(start_identifier),
-          end_of_transmission_(end_identifier),
+          start_identifier_(PackIdentifier(start_identifier)),
+          end_identifier_(PackIdentifier(end_identifier)),
+          start_identifier_size_(std::min<size_t>(start_identifier.size(), 32)),
+          end_identifier_size_(std::min<size_t>(end_identifier.size(), 32)),
           enable_checksum_validation_(enable_checksum)
     {
-        identifier_buffer_size_ = std::max(start_of_transmission_.size(), end_of_transmission_.size());
         max_bit_buffer_size_ = max_byte_size * 8;  // Bit buffer size in bytes
-
-        bit_buffer_.reserve(max_bit_buffer_size_);
+        byte_buffer_.resize(max_byte_size + 1);
     }
 
     uint8_t AudioDataBuffer::CalculateChecksum(const std::string &text)
@@ -272,140 +270,124 @@ namespace audio_wifi_config
 
     void AudioDataBuffer::ClearBuffers()
     {
-        identifier_buffer_.clear();
-        bit_buffer_.clear();
+        identifier_bits_ = 0;
+        identifier_count_ = 0;
+        bit_count_ = 0;
+        std::fill(byte_buffer_.begin(), byte_buffer_.end(), 0);
     }
 
-    bool AudioDataBuffer::ProcessProbabilityData(const std::vector<float> &probabilities, float threshold)
+    bool AudioDataBuffer::MatchIdentifier(uint32_t identifier, size_t size) const
     {
-        for (float probability : probabilities)
+        if (identifier_count_ < size)
         {
-            uint8_t bit = (probability > threshold) ? 1 : 0;
+            return false;
+        }
+        uint32_t mask = (size >= 32) ? UINT32_MAX : ((1u << size) - 1);
+        return (identifier_bits_ & mask) == identifier;
+    }
 
-            if (identifier_buffer_.size() >= identifier_buffer_size_)
+    bool AudioDataBuffer::ProcessBit(uint8_t bit)
+    {
+        identifier_bits_ = (identifier_bits_ << 1) | (bit & 1);
+        identifier_count_ = std::min<size_t>(identifier_count_ + 1, 32);
+
+        // Process received bit based on state machine
+        switch (current_state_)
+        {
+        case DataReceptionState::kInactive:
+            if (identifier_count_ >= start_identifier_size_)
             {
-                identifier_buffer_.pop_front();  // Maintain buffer size
+                current_state_ = DataReceptionState::kWaiting;  // Enter waiting state
+                ESP_LOGI(kLogTag, "Entering Waiting state");
             }
-            identifier_buffer_.push_back(bit);
+            break;
 
-            // Process received bit based on state machine
-            switch (current_state_)
+        case DataReceptionState::kWaiting:
+            if (MatchIdentifier(start_identifier_, start_identifier_size_))
             {
-            case DataReceptionState::kInactive:
-                if (identifier_buffer_.size() >= start_of_transmission_.size())
-                {
-                    current_state_ = DataReceptionState::kWaiting;  // Enter waiting state
-                    ESP_LOGI(kLogTag, "Entering Waiting state");
-                }
-                break;
+                ClearBuffers();                                // Clear buffers
+                current_state_ = DataReceptionState::kReceiving;  // Enter receiving state
+                ESP_LOGI(kLogTag, "Entering Receiving state");
+            }
+            break;
 
-            case DataReceptionState::kWaiting:
-                // Waiting state, possibly waiting for transmission end
-                if (identifier_buffer_.size() >= start_of_transmission_.size())
+        case DataReceptionState::kReceiving:
+            if (bit_count_ >= byte_buffer_.size() * 8)
+            {
+                ClearBuffers();
+                ESP_LOGW(kLogTag, "Buffer overflow, clearing buffer");
+                current_state_ = DataReceptionState::kInactive;
+                break;
+            }
+            byte_buffer_[bit_count_ / 8] |= (bit & 1) << (7 - bit_count_ % 8);
+            bit_count_++;
+            if (identifier_count_ >= end_identifier_size_)
+            {
+                if (MatchIdentifier(end_identifier_, end_identifier_size_))
                 {
-                    std::vector<uint8_t> identifier_snapshot(identifier_buffer_.begin(), identifier_buffer_.end());
-                    if (identifier_snapshot == start_of_transmission_)
-                    {
-                        ClearBuffers();                                // Clear buffers
-                        current_state_ = DataReceptionState::kReceiving;  // Enter receiving state
-                        ESP_LOGI(kLogTag, "Entering Receiving state");
-                    }
+                    current_state_ = DataReceptionState::kInactive;  // Enter inactive state
+                    return OnEndOfTransmission();
                 }
-                break;
-
-            case DataReceptionState::kReceiving:
-                bit_buffer_.push_back(bit);
-                if (identifier_buffer_.size() >= end_of_transmission_.size())
+                else if (bit_count_ >= max_bit_buffer_size_)
                 {
-                    std::vector<uint8_t> identifier_snapshot(identifier_buffer_.begin(), identifier_buffer_.end());
-                    if (identifier_snapshot == end_of_transmission_)
-                    {
-                        current_state_ = DataReceptionState::kInactive;  // Enter inactive state
-
-                        // Convert bits to bytes
-                        std::vector<uint8_t> bytes = ConvertBitsToBytes(bit_buffer_);
-
-                        uint8_t received_checksum = 0;
-                        size_t minimum_length = 0;
-
-                        if (enable_checksum_validation_)
-                        {
-                            // If checksum is required, last byte is checksum
-                            minimum_length = 1 + start_of_transmission_.size() / 8;
-                            if (bytes.size() >= minimum_length)
-                            {
-                                received_checksum = bytes[bytes.size() - start_of_transmission_.size() / 8 - 1];
-                            }
-                        }
-                        else
-                        {
-                            minimum_length = start_of_transmission_.size() / 8;
-                        }
-
-                        if (bytes.size() < minimum_length)
-                        {
-                            ClearBuffers();
-                            ESP_LOGW(kLogTag, "Data too short, clearing buffer");
-                            return false;  // Data too short, return failure
-                        }
-
-                        // Extract text data (remove trailing identifier part)
-                        std::vector<uint8_t> text_bytes(
-                            bytes.begin(), bytes.begin() + bytes.size() - minimum_length);
-
-                        std::string result(text_bytes.begin(), text_bytes.end());
-
-                        // Validate checksum if required
-                        if (enable_checksum_validation_)
-                        {
-                            uint8_t calculated_checksum = CalculateChecksum(result);
-                            if (calculated_checksum != received_checksum)
-                            {
-                                // Checksum mismatch
-                                ESP_LOGW(kLogTag, "Checksum mismatch: expected %d, got %d", 
-                                        received_checksum, calculated_checksum);
-                                ClearBuffers();
-                                return false;
-                            }
-                        }
-
-                        ClearBuffers();
-                        decoded_text = result;
-                        return true;  // Return success
-                    }
-                    else if (bit_buffer_.size() >= max_bit_buffer_size_)
-                    {
-                        // If not end identifier and bit buffer is full, reset
-                        ClearBuffers();
-                        ESP_LOGW(kLogTag, "Buffer overflow, clearing buffer");
-                        current_state_ = DataReceptionState::kInactive;  // Reset state machine
-                    }
+                    // If not end identifier and bit buffer is full, reset
+                    ClearBuffers();
+                    ESP_LOGW(kLogTag, "Buffer overflow, clearing buffer");
+                    current_state_ = DataReceptionState::kInactive;  // Reset state machine
                 }
-                break;
             }
+            break;
         }
 
         return false;
     }
 
-    std::vector<uint8_t> AudioDataBuffer::ConvertBitsToBytes(const std::vector<uint8_t> &bits) const
+    bool AudioDataBuffer::OnEndOfTransmission()
     {
-        std::vector<uint8_t> bytes;
+        size_t byte_count = bit_count_ / 8;
+        uint8_t received_checksum = 0;
+        size_t minimum_length = 0;
+
+        if (enable_checksum_validation_)
+        {
+            // If checksum is required, last byte is checksum
+            minimum_length = 1 + start_identifier_size_ / 8;
+            if (byte_count >= minimum_length)
+            {
+                received_checksum = byte_buffer_[byte_count - start_identifier_size_ / 8 - 1];
+            }
+        }
+        else
+        {
+            minimum_length = start_identifier_size_ / 8;
+        }
+
+        if (byte_count < minimum_length)
+        {
+            ClearBuffers();
+            ESP_LOGW(kLogTag, "Data too short, clearing buffer");
+            return false;  // Data too short, return failure
+        }
 
-        // Ensure number of bits is a multiple of 8
-        size_t complete_bytes_count = bits.size() / 8;
-        bytes.reserve(complete_bytes_count);
+        // Extract text data (remove trailing identifier part)
+        std::string result(byte_buffer_.begin(), byte_buffer_.begin() + byte_count - minimum_length);
 
-        for (size_t i = 0; i < complete_bytes_count; ++i)
+        // Validate checksum if required
+        if (enable_checksum_validation_)
         {
-            uint8_t byte_value = 0;
-            for (size_t j = 0; j < 8; ++j)
+            uint8_t calculated_checksum = CalculateChecksum(result);
+            if (calculated_checksum != received_checksum)
             {
-                byte_value |= bits[i * 8 + j] << (7 - j);
+                // Checksum mismatch
+                ESP_LOGW(kLogTag, "Checksum mismatch: expected %d, got %d",
+                        received_checksum, calculated_checksum);
+                ClearBuffers();
+                return false;
             }
-            bytes.push_back(byte_value);
         }
 
-        return bytes;
+        ClearBuffers();
+        decoded_text = result;
+        return true;  // Return success
     }
-}
\ No newline at end of file
+}
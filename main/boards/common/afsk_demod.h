@@ -1,100 +1,113 @@
 #pragma once
 
 #include <vector>
-#include <deque>
 #include <string>
 #include <memory>
 #include <optional>
-#include <cmath>
-#include "wifi_configuration_ap.h"
-#include "application.h"
+#include <cstdint>
+
+class Application;
+class WifiConfigurationAp;
 
 // Audio signal processing constants for WiFi configuration via audio
+const size_t kInputSampleRate = 16000;
 const size_t kAudioSampleRate = 6400;
 const size_t kMarkFrequency = 1800;
 const size_t kSpaceFrequency = 1500;
 const size_t kBitRate = 100;
-const size_t kWindowSize = 64;
+// 4-FSK mode, 2 bits per symbol, scripts/acoustic_wifi_send.py sends both modes
+const size_t kMfskBaud = 200;
+const size_t kMfskFrequencies[] = {1400, 1600, 1800, 2000};
 
 namespace audio_wifi_config
 {
-    // Main function to receive WiFi credentials through audio signal
+    // Main function to receive WiFi credentials through audio signal, in afsk_provisioning.cc
     void ReceiveWifiCredentialsFromAudio(Application *app, WifiConfigurationAp *wifi_ap);
 
+    const size_t kMaxTones = 4;             // Up to 2 bits per symbol
+    const size_t kMaxSymbolSamples = 64;    // Longest symbol at the demodulator rate
+    const size_t kDecimatorTapsPerPhase = 16;
+    const size_t kDecimatorMaxPhases = 4;
+
+    /**
+     * Modulation parameters, the sender must use the same values.
+     * tones[i] is sent for symbol value i, so the classic FSK has tones = { space, mark }.
+     * Tones should be spaced at least one baud apart to stay orthogonal over a symbol.
+     */
+    struct AfskConfig
+    {
+        size_t sample_rate = kAudioSampleRate;
+        size_t baud = kBitRate;
+        size_t tone_count = 2;
+        size_t tones[kMaxTones] = {kSpaceFrequency, kMarkFrequency};
+    };
+
     /**
-     * Goertzel algorithm implementation for single frequency detection
-     * Used to detect specific audio frequencies in the AFSK demodulation process
+     * Rational resampler (L/M polyphase FIR), used to decimate the 16 kHz microphone stream
+     * to the demodulator rate with a proper anti-aliasing filter. Integer only after construction.
      */
-    class FrequencyDetector
+    class Decimator
     {
     private:
-        float frequency_;              // Target frequency (normalized, i.e., f / fs)
-        size_t window_size_;           // Window size for analysis
-        float frequency_bin_;          // Frequency bin
-        float angular_frequency_;      // Angular frequency
-        float cos_coefficient_;        // cos(w)
-        float sin_coefficient_;        // sin(w)
-        float filter_coefficient_;     // 2 * cos(w)
-        std::deque<float> state_buffer_;  // Circular buffer for storing S[-1] and S[-2]
+        size_t up_;                     // L
+        size_t down_;                   // M
+        size_t phase_ = 0;              // Position of the next output, in 1/L input samples
+        size_t history_index_ = 0;
+        int16_t coefficients_[kDecimatorMaxPhases * kDecimatorTapsPerPhase] = {};  // Q15, scaled by L
+        int16_t history_[kDecimatorTapsPerPhase * 2] = {};  // Mirrored, so a window is always contiguous
 
     public:
-        /**
-         * Constructor
-         * @param frequency Normalized frequency (f / fs)
-         * @param window_size Window size for analysis
-         */
-        FrequencyDetector(float frequency, size_t window_size);
+        Decimator(size_t input_rate, size_t output_rate);
 
-        /**
-         * Reset the detector state
-         */
-        void Reset();
+        // Largest input block whose output is guaranteed to fit in max_output samples
+        size_t MaxInput(size_t max_output) const { return (max_output - 1) * down_ / up_; }
 
         /**
-         * Process one audio sample
-         * @param sample Input audio sample
+         * Resample a block of samples
+         * @return Number of samples written to output
          */
-        void ProcessSample(float sample);
-
-        /**
-         * Calculate current amplitude
-         * @return Amplitude value
-         */
-        float GetAmplitude() const;
+        size_t Process(const int16_t *input, size_t count, int16_t *output, size_t max_output);
     };
 
     /**
-     * Audio signal processor for Mark/Space frequency pair detection
-     * Processes audio signals to extract digital data using AFSK demodulation
+     * Streaming non-coherent (M)FSK demodulator.
+     *
+     * Each tone is correlated over a sliding window of one symbol: the mixed I/Q products are kept
+     * in ring buffers, so every sample adds the newest product and drops the oldest one (exact
+     * integer sums, no drift). Symbol timing is recovered by a PLL driven by the transitions of the
+     * soft decision: a transition seen at the window end means the window straddles two symbols,
+     * which should happen half a symbol away from the sampling instant.
      */
-    class AudioSignalProcessor
+    class AfskDemodulator
     {
     private:
-        std::deque<float> input_buffer_;             // Input sample buffer
-        size_t input_buffer_size_;                   // Input buffer size = window size
-        size_t output_sample_count_;                 // Output sample counter
-        size_t samples_per_bit_;                     // Samples per bit threshold
-        std::unique_ptr<FrequencyDetector> mark_detector_;   // Mark frequency detector
-        std::unique_ptr<FrequencyDetector> space_detector_;  // Space frequency detector
+        AfskConfig config_;
+        Decimator decimator_;
+        size_t symbol_samples_;
+        size_t bits_per_symbol_;
+        uint32_t phase_steps_[kMaxTones];
+        uint32_t phases_[kMaxTones] = {};
+        int16_t products_[kMaxTones][2][kMaxSymbolSamples] = {};  // I/Q ring buffers
+        int32_t sums_[kMaxTones][2] = {};
+        size_t ring_index_ = 0;
+        size_t filled_ = 0;
+        int32_t symbol_phase_ = 0;      // Q8 samples since the last symbol boundary
+        int last_symbol_ = -1;
+        int16_t block_[kMaxSymbolSamples * 4];
+
+        int ProcessSample(int16_t sample, int &confidence);
 
     public:
-        /**
-         * Constructor
-         * @param sample_rate Audio sampling rate
-         * @param mark_frequency Mark frequency for digital '1'
-         * @param space_frequency Space frequency for digital '0'
-         * @param bit_rate Data transmission bit rate
-         * @param window_size Analysis window size
-         */
-        AudioSignalProcessor(size_t sample_rate, size_t mark_frequency, size_t space_frequency,
-                           size_t bit_rate, size_t window_size);
+        explicit AfskDemodulator(const AfskConfig &config = AfskConfig(), size_t input_rate = kInputSampleRate);
+
+        size_t bits_per_symbol() const { return bits_per_symbol_; }
 
         /**
-         * Process input audio samples
-         * @param samples Input audio sample vector
-         * @return Vector of Mark probability values (0.0 to 1.0)
+         * Demodulate a block of input samples
+         * @param bits Output bits, MSB of each symbol first
+         * @return Number of bits written
          */
-        std::vector<float> ProcessAudioSamples(const std::vector<float> &samples);
+        size_t Process(const int16_t *samples, size_t count, uint8_t *bits, size_t max_bits);
     };
 
     /**
@@ -109,18 +122,21 @@ namespace audio_wifi_config
 
     /**
      * Data buffer for managing audio-to-digital data conversion
-     * Handles the complete process from audio signal to decoded text data
+     * Handles the complete process from demodulated bits to decoded text data
      */
     class AudioDataBuffer
     {
     private:
         DataReceptionState current_state_;       // Current reception state
-        std::deque<uint8_t> identifier_buffer_;  // Buffer for start/end identifier detection
-        size_t identifier_buffer_size_;          // Identifier buffer size
-        std::vector<uint8_t> bit_buffer_;        // Buffer for storing bit stream
+        uint32_t identifier_bits_ = 0;           // Shift register of the most recent bits
+        size_t identifier_count_ = 0;            // Valid bits in the shift register
+        uint32_t start_identifier_;              // Start-of-transmission identifier
+        uint32_t end_identifier_;                // End-of-transmission identifier
+        size_t start_identifier_size_;
+        size_t end_identifier_size_;
+        std::vector<uint8_t> byte_buffer_;       // Received bits, packed MSB first
+        size_t bit_count_ = 0;
         size_t max_bit_buffer_size_;             // Maximum bit buffer size
-        const std::vector<uint8_t> start_of_transmission_;  // Start-of-transmission identifier
-        const std::vector<uint8_t> end_of_transmission_;    // End-of-transmission identifier
         bool enable_checksum_validation_;       // Whether to validate checksum
 
     public:
@@ -134,20 +150,18 @@ namespace audio_wifi_config
         /**
          * Constructor with custom parameters
          * @param max_byte_size Expected maximum data size in bytes
-         * @param start_identifier Start-of-transmission identifier
-         * @param end_identifier End-of-transmission identifier
+         * @param start_identifier Start-of-transmission identifier (at most 32 bits)
+         * @param end_identifier End-of-transmission identifier (at most 32 bits)
          * @param enable_checksum Whether to enable checksum validation
          */
         AudioDataBuffer(size_t max_byte_size, const std::vector<uint8_t> &start_identifier,
                       const std::vector<uint8_t> &end_identifier, bool enable_checksum = false);
 
         /**
-         * Process probability data and attempt to decode
-         * @param probabilities Vector of Mark probabilities
-         * @param threshold Decision threshold for bit detection
+         * Feed one demodulated bit
          * @return true if complete data was successfully received and decoded
          */
-        bool ProcessProbabilityData(const std::vector<float> &probabilities, float threshold = 0.5f);
+        bool ProcessBit(uint8_t bit);
 
         /**
          * Calculate checksum for ASCII text
@@ -157,12 +171,8 @@ namespace audio_wifi_config
         static uint8_t CalculateChecksum(const std::string &text);
 
     private:
-        /**
-         * Convert bit vector to byte vector
-         * @param bits Input bit vector
-         * @return Converted byte vector
-         */
-        std::vector<uint8_t> ConvertBitsToBytes(const std::vector<uint8_t> &bits) const;
+        bool MatchIdentifier(uint32_t identifier, size_t size) const;
+        bool OnEndOfTransmission();
 
         /**
          * Clear all buffers and reset state
@@ -173,4 +183,4 @@ namespace audio_wifi_config
     // Default start and end transmission identifiers
     extern const std::vector<uint8_t> kDefaultStartTransmissionPattern;
     extern const std::vector<uint8_t> kDefaultEndTransmissionPattern;
-}
\ No newline at end of file
+}
@@ -0,0 +1,95 @@
+#include "afsk_demod.h"
+#include "application.h"
+#include "wifi_configuration_ap.h"
+
+#include <algorithm>
+#include <iterator>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_log.h>
+#include <esp_system.h>
+
+namespace audio_wifi_config
+{
+    static const char *kLogTag = "AUDIO_WIFI_CONFIG";
+
+    static AfskConfig GetProvisioningConfig()
+    {
+        AfskConfig config;
+#if CONFIG_ACOUSTIC_WIFI_PROVISIONING_MFSK_400
+        // 4-FSK at 200 baud, 2 bits per symbol
+        config.baud = kMfskBaud;
+        config.tone_count = kMaxTones;
+        std::copy(std::begin(kMfskFrequencies), std::end(kMfskFrequencies), config.tones);
+#endif
+        return config;
+    }
+
+    void ReceiveWifiCredentialsFromAudio(Application *app,
+                                       WifiConfigurationAp *wifi_ap)
+    {
+        const size_t kChunkSamples = 480;  // 16kHz, 480 samples corresponds to 30ms data
+        std::vector<int16_t> audio_data;
+        uint8_t bits[64];
+        auto demodulator = std::make_unique<AfskDemodulator>(GetProvisioningConfig(), kInputSampleRate);
+        AudioDataBuffer data_buffer;
+
+        while (true)
+        {
+            // 检查Application状态，只有在WiFi配置模式下才处理音频
+            if (app->GetDeviceState() != kDeviceStateWifiConfiguring) {
+                // 不在WiFi配置状态，休眠100ms后再检查
+                vTaskDelay(pdMS_TO_TICKS(100));
+                continue;
+            }
+
+            if (!app->ReadAudio(audio_data, kInputSampleRate, kChunkSamples)) {
+                // 读取音频失败，短暂延迟后重试
+                ESP_LOGI(kLogTag, "Failed to read audio data, retrying.");
+                vTaskDelay(pdMS_TO_TICKS(10));
+                continue;
+            }
+
+            // Decimate and demodulate in place, no allocation per chunk
+            size_t bit_count = demodulator->Process(audio_data.data(), audio_data.size(), bits, sizeof(bits));
+            for (size_t i = 0; i < bit_count; i++)
+            {
+                if (!data_buffer.ProcessBit(bits[i]) || !data_buffer.decoded_text.has_value())
+                {
+                    continue;
+                }
+
+                // If complete data was received, extract WiFi credentials
+                ESP_LOGI(kLogTag, "Received text data: %s", data_buffer.decoded_text->c_str());
+
+                // Split SSID and password by newline character
+                std::string wifi_ssid, wifi_password;
+                size_t newline_position = data_buffer.decoded_text->find('\n');
+                if (newline_position != std::string::npos)
+                {
+                    wifi_ssid = data_buffer.decoded_text->substr(0, newline_position);
+                    wifi_password = data_buffer.decoded_text->substr(newline_position + 1);
+                    ESP_LOGI(kLogTag, "WiFi SSID: %s, Password: %s", wifi_ssid.c_str(), wifi_password.c_str());
+                }
+                else
+                {
+                    ESP_LOGE(kLogTag, "Invalid data format, no newline character found");
+                    data_buffer.decoded_text.reset();
+                    continue;
+                }
+
+                if (wifi_ap->ConnectToWifi(wifi_ssid, wifi_password))
+                {
+                    wifi_ap->Save(wifi_ssid, wifi_password);  // Save WiFi credentials
+                    esp_restart();                            // Restart device to apply new WiFi configuration
+                }
+                else
+                {
+                    ESP_LOGE(kLogTag, "Failed to connect to WiFi with received credentials");
+                }
+                data_buffer.decoded_text.reset();  // Clear processed data
+            }
+            vTaskDelay(pdMS_TO_TICKS(1));  // 1ms delay
+        }
+    }
+}
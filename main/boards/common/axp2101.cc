@@ -7,6 +7,9 @@
 #define TAG "Axp2101"
 
 Axp2101::Axp2101(i2c_master_bus_handle_t i2c_bus, uint8_t addr) : I2cDevice(i2c_bus, addr) {
+    // Telemetry only, yield the bus to codec and touch traffic
+    priority_ = kI2cPriorityLow;
+    merge_reads_ = true;
 }
 
 int Axp2101::GetBatteryCurrentDirection() {
@@ -39,3 +42,31 @@ void Axp2101::PowerOff() {
     value = value | 0x01;
     WriteReg(0x10, value);
 }
+
+void Axp2101::ReadTelemetryAsync(PowerTelemetry::SampleDone done) {
+    bool queued = ReadRegsAsync(0x01, 1, [this, done](esp_err_t err, const uint8_t* status, size_t length) {
+        if (err != ESP_OK) {
+            done(false, PowerReading());
+            return;
+        }
+        PowerReading reading;
+        int direction = (status[0] & 0b01100000) >> 5;
+        reading.charging = direction == 1;
+        reading.discharging = direction == 2;
+        reading.charge_done = (status[0] & 0b00000111) == 0b00000100;
+        // 0xA4 battery percentage, 0xA5 temperature
+        bool queued = ReadRegsAsync(0xA4, 2, [done, reading](esp_err_t err, const uint8_t* data, size_t length) mutable {
+            if (err == ESP_OK) {
+                reading.level = data[0];
+                reading.temperature = data[1];
+            }
+            done(err == ESP_OK, reading);
+        });
+        if (!queued) {
+            done(false, reading);
+        }
+    });
+    if (!queued) {
+        done(false, PowerReading());
+    }
+}
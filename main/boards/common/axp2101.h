@@ -2,6 +2,7 @@
 #define __AXP2101_H__
 
 #include "i2c_device.h"
+#include "power_telemetry.h"
 
 class Axp2101 : public I2cDevice {
 public:
@@ -12,6 +13,8 @@ public:
     int GetBatteryLevel();
     float GetTemperature();
     void PowerOff();
+    // Reads the status and the fuel gauge on the bus worker
+    void ReadTelemetryAsync(PowerTelemetry::SampleDone done);
 
 private:
     int GetBatteryCurrentDirection();
@@ -1,5 +1,6 @@
 #include "backlight.h"
 #include "settings.h"
+#include "application.h"
 
 #include <esp_log.h>
 #include <driver/ledc.h>
@@ -78,6 +79,8 @@ void Backlight::OnTransitionTimer() {
 
     if (brightness_ == target_brightness_) {
         esp_timer_stop(transition_timer_);
+        // Report the final value only, not every step of the transition
+        Application::GetInstance().NotifyStateChanged();
     }
 }
 
@@ -48,6 +48,10 @@ bool Board::GetBatteryLevel(int &level, bool& charging, bool& discharging) {
     return false;
 }
 
+uint32_t Board::GetStatusBarEvents() {
+    return 0;
+}
+
 bool Board::GetTemperature(float& esp32temp){
     return false;
 }
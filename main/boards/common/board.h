@@ -50,6 +50,8 @@ public:
     virtual void StartNetwork() = 0;
     virtual const char* GetNetworkStateIcon() = 0;
     virtual bool GetBatteryLevel(int &level, bool& charging, bool& discharging);
+    // Status bar items (kStatusBar*) the board notifies itself on change, the others are polled
+    virtual uint32_t GetStatusBarEvents();
     virtual std::string GetJson();
     virtual void SetPowerSaveMode(bool enabled) = 0;
     virtual std::string GetBoardJson() = 0;
@@ -3,26 +3,15 @@
 
 #include <esp_camera.h>
 #include <lvgl.h>
-#include <thread>
 #include <memory>
 
-#include <freertos/FreeRTOS.h>
-#include <freertos/queue.h>
-
 #include "camera.h"
-
-struct JpegChunk {
-    uint8_t* data;
-    size_t len;
-};
+#include "explain_uploader.h"
 
 class Esp32Camera : public Camera {
 private:
     camera_fb_t* fb_ = nullptr;
-    lv_img_dsc_t preview_image_;
-    std::string explain_url_;
-    std::string explain_token_;
-    std::thread encoder_thread_;
+    ExplainUploader uploader_;
 
 public:
     Esp32Camera(const camera_config_t& config);
@@ -0,0 +1,499 @@
+#include "explain_uploader.h"
+#include "board.h"
+#include "system_info.h"
+
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <img_converters.h>
+#include <cJSON.h>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <algorithm>
+#include <vector>
+
+#define TAG "ExplainUploader"
+
+#define MULTIPART_BOUNDARY "----ESP32_CAMERA_BOUNDARY"
+
+// 8 x 2KB 的分块池，编码速度超过上传速度时编码线程会阻塞等待
+static constexpr size_t kChunkSize = 2048;
+static constexpr int kChunkCount = 8;
+static constexpr int kMaxAttempts = 3;
+static constexpr int kMinQuality = 20;
+// 后半段写入短于此时间时认为请求体都进了发送缓冲区，斜率不可信
+static constexpr int64_t kMinSlopeUs = 20 * 1000;
+
+// 上行速度分档：速度越低，分辨率与质量越低
+struct EncodingTier {
+    float min_bytes_per_second;
+    int scale;
+    int quality;
+};
+
+static const EncodingTier kEncodingTiers[] = {
+    { 64 * 1024, 1, 80 },
+    { 24 * 1024, 1, 60 },
+    {  8 * 1024, 2, 50 },
+    {         0, 2, 35 },
+};
+
+struct JpegChunk {
+    uint8_t* data;
+    size_t len;
+};
+
+struct JpegStream {
+    QueueHandle_t free_queue;
+    QueueHandle_t ready_queue;
+    std::atomic<bool>* abort;
+    JpegChunk chunk;
+    size_t total;
+};
+
+// 编码器回调：把 JPEG 数据拷贝进分块池，写满一块就交给上传线程
+static size_t OnJpegData(void* arg, size_t index, const void* data, size_t len) {
+    auto stream = (JpegStream*)arg;
+    auto src = (const uint8_t*)data;
+    size_t remaining = len;
+    while (remaining > 0 && !stream->abort->load()) {
+        size_t n = std::min(remaining, kChunkSize - stream->chunk.len);
+        memcpy(stream->chunk.data + stream->chunk.len, src, n);
+        stream->chunk.len += n;
+        src += n;
+        remaining -= n;
+        if (stream->chunk.len == kChunkSize) {
+            xQueueSend(stream->ready_queue, &stream->chunk, portMAX_DELAY);
+            xQueueReceive(stream->free_queue, &stream->chunk, portMAX_DELAY);
+            stream->chunk.len = 0;
+        }
+    }
+    stream->total += len;
+    return len;
+}
+
+// 每次写入返回时的累计字节数与时间，用于估计上行速度
+struct WriteSample {
+    int64_t time_us;
+    size_t bytes;
+    int64_t idle_us;
+};
+
+// 一次 multipart 请求，记录每次写入返回的时间和等待编码器的时间
+struct MultipartRequest {
+    std::unique_ptr<Http> http;
+    int64_t start_time = 0;
+    int64_t idle_us = 0;
+    size_t bytes = 0;
+    bool failed = false;
+    std::vector<WriteSample> samples;
+
+    void Write(const void* data, size_t len) {
+        if (failed) {
+            return;
+        }
+        if (http->Write((const char*)data, len) < 0) {
+            ESP_LOGE(TAG, "Failed to write %u bytes after %u bytes", len, bytes);
+            failed = true;
+        }
+        bytes += len;
+        samples.push_back({ esp_timer_get_time(), bytes, idle_us });
+    }
+};
+
+static std::unique_ptr<Http> OpenRequest(const std::string& url, const std::string& token) {
+    auto http = std::unique_ptr<Http>(Board::GetInstance().CreateHttp());
+    http->SetHeader("Device-Id", SystemInfo::GetMacAddress().c_str());
+    http->SetHeader("Client-Id", Board::GetInstance().GetUuid().c_str());
+    if (!token.empty()) {
+        http->SetHeader("Authorization", "Bearer " + token);
+    }
+    http->SetHeader("Content-Type", "multipart/form-data; boundary=" MULTIPART_BOUNDARY);
+    http->SetHeader("Transfer-Encoding", "chunked");
+    if (!http->Open("POST", url)) {
+        ESP_LOGE(TAG, "Failed to connect to explain URL");
+        return nullptr;
+    }
+    return http;
+}
+
+ExplainUploader::ExplainUploader() {
+}
+
+ExplainUploader::~ExplainUploader() {
+    if (free_queue_ != nullptr) {
+        vQueueDelete(free_queue_);
+    }
+    if (ready_queue_ != nullptr) {
+        vQueueDelete(ready_queue_);
+    }
+    if (pool_ != nullptr) {
+        heap_caps_free(pool_);
+    }
+}
+
+void ExplainUploader::SetExplainUrl(const std::string& url, const std::string& token) {
+    explain_url_ = url;
+    explain_token_ = token;
+}
+
+bool ExplainUploader::AllocatePool() {
+    if (pool_ == nullptr) {
+        pool_ = (uint8_t*)heap_caps_malloc(kChunkSize * kChunkCount, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (pool_ == nullptr) {
+            pool_ = (uint8_t*)heap_caps_malloc(kChunkSize * kChunkCount, MALLOC_CAP_8BIT);
+        }
+        if (pool_ == nullptr) {
+            ESP_LOGE(TAG, "Failed to allocate JPEG chunk pool");
+            return false;
+        }
+    }
+    if (free_queue_ == nullptr) {
+        free_queue_ = xQueueCreate(kChunkCount, sizeof(JpegChunk));
+    }
+    if (ready_queue_ == nullptr) {
+        // 额外一项用于结束标记
+        ready_queue_ = xQueueCreate(kChunkCount + 1, sizeof(JpegChunk));
+    }
+    if (free_queue_ == nullptr || ready_queue_ == nullptr) {
+        ESP_LOGE(TAG, "Failed to create JPEG queues");
+        return false;
+    }
+    return true;
+}
+
+void ExplainUploader::ChooseEncoding(int& scale, int& quality) const {
+    if (uplink_bytes_per_second_ <= 0) {
+        // 尚未测量过上行速度，使用全分辨率
+        scale = 1;
+        quality = 80;
+        return;
+    }
+    for (auto& tier : kEncodingTiers) {
+        if (uplink_bytes_per_second_ >= tier.min_bytes_per_second) {
+            scale = tier.scale;
+            quality = tier.quality;
+            return;
+        }
+    }
+}
+
+/**
+ * 写入只在 TCP 发送缓冲区满时阻塞，阻塞时间只反映了缓冲区之外的数据，直接用它会高估速度。
+ * 缓冲区填满后，写入返回的速度就是网络发出数据的速度，所以取请求体后半段写入的斜率，
+ * 缓冲区大小在差值中抵消。后半段太快（整个请求体都进了缓冲区）时无法测量，
+ * 改用从第一个字节到收到响应的时间，其中包含服务器处理时间，结果偏低但不会选到过大的图像。
+ */
+void ExplainUploader::UpdateUplinkSpeed(const std::vector<WriteSample>& samples, int64_t response_time) {
+    if (samples.size() < 2) {
+        return;
+    }
+    const auto& first = samples.front();
+    const auto& last = samples.back();
+    auto mid = std::find_if(samples.begin(), samples.end(), [&last](const WriteSample& sample) {
+        return sample.bytes >= last.bytes / 2;
+    });
+    int64_t busy_us = (last.time_us - mid->time_us) - (last.idle_us - mid->idle_us);
+    float speed;
+    if (busy_us >= kMinSlopeUs) {
+        speed = (last.bytes - mid->bytes) * 1000000.0f / busy_us;
+    } else {
+        int64_t elapsed_us = response_time - first.time_us - (last.idle_us - first.idle_us);
+        if (elapsed_us <= 0) {
+            return;
+        }
+        speed = last.bytes * 1000000.0f / elapsed_us;
+    }
+    if (uplink_bytes_per_second_ <= 0) {
+        uplink_bytes_per_second_ = speed;
+    } else {
+        uplink_bytes_per_second_ = uplink_bytes_per_second_ * 0.5f + speed * 0.5f;
+    }
+    ESP_LOGI(TAG, "Uplink speed: %.1f KB/s (%s), estimated: %.1f KB/s", speed / 1024,
+        busy_us >= kMinSlopeUs ? "write slope" : "until response", uplink_bytes_per_second_ / 1024);
+}
+
+std::string ExplainUploader::MultipartHeader(const std::string& question) {
+    std::string header;
+    // 第一块：question字段
+    header += "--" MULTIPART_BOUNDARY "\r\n";
+    header += "Content-Disposition: form-data; name=\"question\"\r\n";
+    header += "\r\n";
+    header += question + "\r\n";
+    // 第二块：文件字段头部
+    header += "--" MULTIPART_BOUNDARY "\r\n";
+    header += "Content-Disposition: form-data; name=\"file\"; filename=\"camera.jpg\"\r\n";
+    header += "Content-Type: image/jpeg\r\n";
+    header += "\r\n";
+    return header;
+}
+
+std::string ExplainUploader::MultipartFooter() {
+    return "\r\n--" MULTIPART_BOUNDARY "--\r\n";
+}
+
+// 缩小 RGB565 图像，保持原有字节序
+static void DownscaleFrame(const uint16_t* src, int src_width, uint16_t* dst, int dst_width, int dst_height, int factor) {
+    for (int y = 0; y < dst_height; y++) {
+        const uint16_t* row = src + (size_t)y * factor * src_width;
+        uint16_t* out = dst + (size_t)y * dst_width;
+        for (int x = 0; x < dst_width; x++) {
+            out[x] = row[x * factor];
+        }
+    }
+}
+
+std::string ExplainUploader::Explain(const uint8_t* frame, size_t len, int width, int height, pixformat_t format, const std::string& question) {
+    if (!configured()) {
+        return "{\"success\": false, \"message\": \"Image explain URL or token is not set\"}";
+    }
+    if (format == PIXFORMAT_JPEG) {
+        return ExplainJpeg(frame, len, width, height, 0, 0, question);
+    }
+    if (!AllocatePool()) {
+        return "{\"success\": false, \"message\": \"Failed to allocate JPEG buffer\"}";
+    }
+
+    int scale = 1;
+    int quality = 80;
+    ChooseEncoding(scale, quality);
+
+    // 上行速度较低时先缩小图像，减少需要上传的数据量
+    uint16_t* scaled_frame = nullptr;
+    if (scale > 1 && format == PIXFORMAT_RGB565) {
+        int scaled_width = width / scale;
+        int scaled_height = height / scale;
+        size_t scaled_len = (size_t)scaled_width * scaled_height * 2;
+        scaled_frame = (uint16_t*)heap_caps_malloc(scaled_len, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (scaled_frame != nullptr) {
+            DownscaleFrame((const uint16_t*)frame, width, scaled_frame, scaled_width, scaled_height, scale);
+            frame = (const uint8_t*)scaled_frame;
+            len = scaled_len;
+            width = scaled_width;
+            height = scaled_height;
+        } else {
+            ESP_LOGW(TAG, "Failed to allocate scaled frame, upload full resolution");
+        }
+    }
+
+    Timings timings;
+    timings.width = width;
+    timings.height = height;
+    std::string response;
+    AttemptResult result = kAttemptRetry;
+    for (int attempt = 0; attempt < kMaxAttempts && result == kAttemptRetry; attempt++) {
+        if (attempt > 0) {
+            // 原始帧仍然保留，降低一级质量后重新编码上传
+            quality = std::max(quality - 20, kMinQuality);
+            ESP_LOGW(TAG, "Retry explain upload (%d/%d), quality=%d", attempt + 1, kMaxAttempts, quality);
+            vTaskDelay(pdMS_TO_TICKS(500 * attempt));
+        }
+        timings.attempts = attempt + 1;
+        timings.quality = quality;
+        result = StreamOnce(frame, len, width, height, format, quality, question, timings, response);
+    }
+
+    if (scaled_frame != nullptr) {
+        heap_caps_free(scaled_frame);
+    }
+    return MakeResult(response, result == kAttemptOk, timings);
+}
+
+ExplainUploader::AttemptResult ExplainUploader::StreamOnce(const uint8_t* frame, size_t len, int width, int height, pixformat_t format,
+    int quality, const std::string& question, Timings& timings, std::string& response) {
+    MultipartRequest request;
+    request.http = OpenRequest(explain_url_, explain_token_);
+    if (!request.http) {
+        response = "Failed to connect to explain URL";
+        return kAttemptRetry;
+    }
+    request.start_time = esp_timer_get_time();
+    auto header = MultipartHeader(question);
+    request.Write(header.data(), header.size());
+
+    // 重置分块池
+    xQueueReset(free_queue_);
+    xQueueReset(ready_queue_);
+    for (int i = 0; i < kChunkCount; i++) {
+        JpegChunk chunk = { pool_ + i * kChunkSize, 0 };
+        xQueueSend(free_queue_, &chunk, 0);
+    }
+    abort_encoding_ = false;
+
+    JpegStream stream = {
+        .free_queue = free_queue_,
+        .ready_queue = ready_queue_,
+        .abort = &abort_encoding_,
+        .chunk = { nullptr, 0 },
+        .total = 0,
+    };
+    bool encoded = false;
+    std::thread encoder_thread([&]() {
+        int64_t start_time = esp_timer_get_time();
+        xQueueReceive(stream.free_queue, &stream.chunk, portMAX_DELAY);
+        encoded = fmt2jpg_cb((uint8_t*)frame, len, width, height, format, quality, OnJpegData, &stream);
+        if (stream.chunk.len > 0 && !abort_encoding_) {
+            xQueueSend(stream.ready_queue, &stream.chunk, portMAX_DELAY);
+        } else {
+            xQueueSend(stream.free_queue, &stream.chunk, portMAX_DELAY);
+        }
+        timings.encode_us = esp_timer_get_time() - start_time;
+        // 结束标记
+        JpegChunk end = { nullptr, 0 };
+        xQueueSend(stream.ready_queue, &end, portMAX_DELAY);
+    });
+
+    // 第三块：JPEG数据，写入失败后继续回收分块直到编码结束
+    while (true) {
+        JpegChunk chunk;
+        // 等待编码器的时间不算作上传时间
+        int64_t wait_start = esp_timer_get_time();
+        xQueueReceive(ready_queue_, &chunk, portMAX_DELAY);
+        request.idle_us += esp_timer_get_time() - wait_start;
+        if (chunk.data == nullptr) {
+            break;
+        }
+        request.Write(chunk.data, chunk.len);
+        if (request.failed) {
+            abort_encoding_ = true;
+        }
+        xQueueSend(free_queue_, &chunk, portMAX_DELAY);
+    }
+    encoder_thread.join();
+    timings.jpeg_size = stream.total;
+
+    if (!encoded) {
+        ESP_LOGE(TAG, "Failed to encode JPEG");
+        response = "Failed to encode JPEG";
+        return kAttemptFailed;
+    }
+    if (request.failed) {
+        response = "Upload interrupted";
+        return kAttemptRetry;
+    }
+
+    // 第四块：multipart尾部
+    auto footer = MultipartFooter();
+    request.Write(footer.data(), footer.size());
+    // 结束块
+    request.Write("", 0);
+    timings.upload_us = esp_timer_get_time() - request.start_time;
+    if (request.failed) {
+        response = "Upload interrupted";
+        return kAttemptRetry;
+    }
+
+    int64_t wait_start = esp_timer_get_time();
+    int status_code = request.http->GetStatusCode();
+    int64_t response_time = esp_timer_get_time();
+    timings.server_us = response_time - wait_start;
+    if (status_code != 200) {
+        ESP_LOGE(TAG, "Failed to upload photo, status code: %d, jpeg_size: %u", status_code, stream.total);
+        response = "Failed to upload photo, status code: " + std::to_string(status_code);
+        // 只有连接问题和服务器错误才值得重试
+        return (status_code <= 0 || status_code >= 500) ? kAttemptRetry : kAttemptFailed;
+    }
+
+    response = request.http->ReadAll();
+    request.http->Close();
+    UpdateUplinkSpeed(request.samples, response_time);
+    return kAttemptOk;
+}
+
+std::string ExplainUploader::ExplainJpeg(const uint8_t* jpeg, size_t len, int width, int height, int quality, int64_t encode_us, const std::string& question) {
+    if (!configured()) {
+        return "{\"success\": false, \"message\": \"Image explain URL or token is not set\"}";
+    }
+
+    Timings timings;
+    timings.encode_us = encode_us;
+    timings.jpeg_size = len;
+    timings.width = width;
+    timings.height = height;
+    timings.quality = quality;
+    std::string response;
+    AttemptResult result = kAttemptRetry;
+    for (int attempt = 0; attempt < kMaxAttempts && result == kAttemptRetry; attempt++) {
+        if (attempt > 0) {
+            // JPEG 数据仍在内存中，直接重新上传
+            ESP_LOGW(TAG, "Retry explain upload (%d/%d)", attempt + 1, kMaxAttempts);
+            vTaskDelay(pdMS_TO_TICKS(500 * attempt));
+        }
+        timings.attempts = attempt + 1;
+        result = UploadOnce(jpeg, len, question, timings, response);
+    }
+    return MakeResult(response, result == kAttemptOk, timings);
+}
+
+ExplainUploader::AttemptResult ExplainUploader::UploadOnce(const uint8_t* jpeg, size_t len, const std::string& question, Timings& timings, std::string& response) {
+    MultipartRequest request;
+    request.http = OpenRequest(explain_url_, explain_token_);
+    if (!request.http) {
+        response = "Failed to connect to explain URL";
+        return kAttemptRetry;
+    }
+    request.start_time = esp_timer_get_time();
+    auto header = MultipartHeader(question);
+    request.Write(header.data(), header.size());
+    for (size_t offset = 0; offset < len && !request.failed; offset += kChunkSize) {
+        request.Write(jpeg + offset, std::min(kChunkSize, len - offset));
+    }
+    auto footer = MultipartFooter();
+    request.Write(footer.data(), footer.size());
+    request.Write("", 0);
+    timings.upload_us = esp_timer_get_time() - request.start_time;
+    if (request.failed) {
+        response = "Upload interrupted";
+        return kAttemptRetry;
+    }
+
+    int64_t wait_start = esp_timer_get_time();
+    int status_code = request.http->GetStatusCode();
+    int64_t response_time = esp_timer_get_time();
+    timings.server_us = response_time - wait_start;
+    if (status_code != 200) {
+        ESP_LOGE(TAG, "Failed to upload photo, status code: %d, jpeg_size: %u", status_code, len);
+        response = "Failed to upload photo, status code: " + std::to_string(status_code);
+        return (status_code <= 0 || status_code >= 500) ? kAttemptRetry : kAttemptFailed;
+    }
+
+    response = request.http->ReadAll();
+    request.http->Close();
+    UpdateUplinkSpeed(request.samples, response_time);
+    return kAttemptOk;
+}
+
+std::string ExplainUploader::MakeResult(const std::string& response, bool success, const Timings& timings) {
+    ESP_LOGI(TAG, "Explain %s: %dx%d q=%d, jpeg=%u bytes, attempts=%d, encode=%lldms, upload=%lldms, server=%lldms",
+        success ? "done" : "failed", timings.width, timings.height, timings.quality, timings.jpeg_size, timings.attempts,
+        timings.encode_us / 1000, timings.upload_us / 1000, timings.server_us / 1000);
+
+    // 服务器返回 JSON 对象时直接附加耗时信息，否则包装成 JSON 对象
+    cJSON* root = success ? cJSON_Parse(response.c_str()) : nullptr;
+    if (!cJSON_IsObject(root)) {
+        cJSON_Delete(root);
+        root = cJSON_CreateObject();
+        cJSON_AddBoolToObject(root, "success", success);
+        cJSON_AddStringToObject(root, success ? "result" : "message", response.c_str());
+    }
+
+    cJSON* json_timings = cJSON_CreateObject();
+    cJSON_AddNumberToObject(json_timings, "encode_ms", timings.encode_us / 1000);
+    cJSON_AddNumberToObject(json_timings, "upload_ms", timings.upload_us / 1000);
+    cJSON_AddNumberToObject(json_timings, "server_ms", timings.server_us / 1000);
+    cJSON_AddNumberToObject(json_timings, "attempts", timings.attempts);
+    cJSON_AddNumberToObject(json_timings, "jpeg_size", timings.jpeg_size);
+    cJSON_AddNumberToObject(json_timings, "width", timings.width);
+    cJSON_AddNumberToObject(json_timings, "height", timings.height);
+    if (timings.quality > 0) {
+        cJSON_AddNumberToObject(json_timings, "quality", timings.quality);
+    }
+    cJSON_AddItemToObject(root, "timings", json_timings);
+
+    auto json_str = cJSON_PrintUnformatted(root);
+    std::string result(json_str);
+    cJSON_free(json_str);
+    cJSON_Delete(root);
+    return result;
+}
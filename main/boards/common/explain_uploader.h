@@ -0,0 +1,75 @@
+#ifndef EXPLAIN_UPLOADER_H
+#define EXPLAIN_UPLOADER_H
+
+#include <esp_camera.h>
+#include <string>
+#include <atomic>
+#include <vector>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
+struct WriteSample;
+
+/**
+ * 将摄像头图像以 multipart/form-data 流式上传到 Explain 服务器
+ *
+ * - JPEG 数据写入固定大小的分块池，池满时编码线程阻塞等待，内存占用固定
+ * - 根据之前上传测得的上行速度（请求体写入的斜率）选择分辨率与 JPEG 质量
+ * - 上传失败时从仍保留的原始帧重新编码并重试，每次重试降低一级质量
+ * - 返回结果中附带编码、上传、服务器处理耗时
+ */
+class ExplainUploader {
+public:
+    struct Timings {
+        int64_t encode_us = 0;      // 编码耗时（流式上传时与上传重叠）
+        int64_t upload_us = 0;      // 从开始写请求体到写完的时间
+        int64_t server_us = 0;      // 请求体写完到收到响应状态的时间，包含发送缓冲区中还未发出的数据
+        int attempts = 0;
+        size_t jpeg_size = 0;
+        int width = 0;
+        int height = 0;
+        int quality = 0;
+    };
+
+    ExplainUploader();
+    ~ExplainUploader();
+
+    void SetExplainUrl(const std::string& url, const std::string& token);
+    bool configured() const { return !explain_url_.empty(); }
+
+    // 编码原始帧并流式上传，frame 在调用期间必须保持有效
+    std::string Explain(const uint8_t* frame, size_t len, int width, int height, pixformat_t format, const std::string& question);
+    // 上传已编码的 JPEG（例如硬件编码器的输出）
+    std::string ExplainJpeg(const uint8_t* jpeg, size_t len, int width, int height, int quality, int64_t encode_us, const std::string& question);
+
+    // 根据上行速度选择缩小倍数和 JPEG 质量
+    void ChooseEncoding(int& scale, int& quality) const;
+
+private:
+    enum AttemptResult {
+        kAttemptOk,
+        kAttemptRetry,
+        kAttemptFailed,
+    };
+
+    std::string explain_url_;
+    std::string explain_token_;
+    uint8_t* pool_ = nullptr;
+    QueueHandle_t free_queue_ = nullptr;
+    QueueHandle_t ready_queue_ = nullptr;
+    std::atomic<bool> abort_encoding_ = false;
+    // 上行速度估计值（字节/秒），0 表示尚未测量
+    float uplink_bytes_per_second_ = 0;
+
+    bool AllocatePool();
+    AttemptResult StreamOnce(const uint8_t* frame, size_t len, int width, int height, pixformat_t format,
+        int quality, const std::string& question, Timings& timings, std::string& response);
+    AttemptResult UploadOnce(const uint8_t* jpeg, size_t len, const std::string& question, Timings& timings, std::string& response);
+    void UpdateUplinkSpeed(const std::vector<WriteSample>& samples, int64_t response_time);
+    std::string MakeResult(const std::string& response, bool success, const Timings& timings);
+    static std::string MultipartHeader(const std::string& question);
+    static std::string MultipartFooter();
+};
+
+#endif // EXPLAIN_UPLOADER_H
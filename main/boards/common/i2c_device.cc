@@ -1,11 +1,167 @@
 #include "i2c_device.h"
 
 #include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <list>
+#include <map>
+#include <mutex>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <condition_variable>
 
 #define TAG "I2cDevice"
 
+#define I2C_BUS_MAX_QUEUED 32
+
+struct I2cTransaction {
+    I2cDevice* device;
+    bool write;
+    uint8_t reg;
+    uint8_t value;
+    size_t length;
+    int64_t queued_us;
+    I2cDevice::ReadCallback read_callback;
+    I2cDevice::WriteCallback write_callback;
+};
+
+/**
+ * One per bus. Async transactions are queued by priority and executed by a worker task that is
+ * created on the first async call; synchronous calls go straight to the driver, whose bus lock
+ * already keeps them atomic with respect to the worker.
+ */
+class I2cBusScheduler {
+public:
+    static I2cBusScheduler* GetInstance(i2c_master_bus_handle_t bus) {
+        static std::mutex registry_mutex;
+        static std::map<i2c_master_bus_handle_t, I2cBusScheduler*> registry;
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        auto& scheduler = registry[bus];
+        if (scheduler == nullptr) {
+            scheduler = new I2cBusScheduler();
+        }
+        return scheduler;
+    }
+
+    std::mutex mutex_;
+
+    bool Submit(I2cTransaction&& transaction) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t queued = 0;
+        for (auto& queue : queues_) {
+            queued += queue.size();
+        }
+        if (queued >= I2C_BUS_MAX_QUEUED) {
+            return false;
+        }
+        if (worker_ == nullptr) {
+            xTaskCreate([](void* arg) {
+                static_cast<I2cBusScheduler*>(arg)->WorkerLoop();
+            }, "i2c_bus", 4096, this, 3, &worker_);
+        }
+        queues_[transaction.device->priority_].push_back(std::move(transaction));
+        condition_variable_.notify_one();
+        return true;
+    }
+
+private:
+    std::list<I2cTransaction> queues_[kI2cPriorityCount];
+    std::condition_variable condition_variable_;
+    TaskHandle_t worker_ = nullptr;
+
+    // Take the next transaction, and the queued reads that continue it on the same device
+    std::vector<I2cTransaction> TakeBatch() {
+        std::vector<I2cTransaction> batch;
+        for (auto& queue : queues_) {
+            if (queue.empty()) {
+                continue;
+            }
+            batch.push_back(std::move(queue.front()));
+            queue.pop_front();
+            auto device = batch.front().device;
+            if (batch.front().write || !device->merge_reads_) {
+                return batch;
+            }
+            size_t end = batch.front().reg + batch.front().length;
+            size_t total = batch.front().length;
+            bool found = true;
+            while (found) {
+                found = false;
+                for (auto it = queue.begin(); it != queue.end(); ++it) {
+                    // A later read must not overtake a write to the same device queued before it
+                    if (it->write && it->device->addr_ == device->addr_) {
+                        break;
+                    }
+                    if (it->device == device && !it->write && it->reg == end
+                        && total + it->length <= I2C_DEVICE_MAX_MERGED_READ) {
+                        end += it->length;
+                        total += it->length;
+                        batch.push_back(std::move(*it));
+                        queue.erase(it);
+                        found = true;
+                        break;
+                    }
+                }
+            }
+            return batch;
+        }
+        return batch;
+    }
+
+    void WorkerLoop() {
+        uint8_t buffer[I2C_DEVICE_MAX_MERGED_READ];
+        while (true) {
+            std::vector<I2cTransaction> batch;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                condition_variable_.wait(lock, [this, &batch]() {
+                    batch = TakeBatch();
+                    return !batch.empty();
+                });
+            }
 
-I2cDevice::I2cDevice(i2c_master_bus_handle_t i2c_bus, uint8_t addr) {
+            auto& first = batch.front();
+            auto device = first.device;
+            esp_err_t err;
+            uint8_t* data = buffer;
+            std::vector<uint8_t> large;
+            if (first.write) {
+                err = device->Transmit(first.reg, first.value);
+            } else {
+                size_t total = 0;
+                for (auto& transaction : batch) {
+                    total += transaction.length;
+                }
+                if (total > sizeof(buffer)) {
+                    // A single read larger than the merge buffer
+                    large.resize(total);
+                    data = large.data();
+                }
+                err = device->TransmitReceive(first.reg, data, total);
+            }
+            // The first transaction of the batch is the oldest, its latency covers the others
+            device->RecordTransaction(err, esp_timer_get_time() - first.queued_us, batch.size() - 1);
+
+            size_t offset = 0;
+            for (auto& transaction : batch) {
+                if (transaction.write) {
+                    if (transaction.write_callback) {
+                        transaction.write_callback(err);
+                    }
+                } else {
+                    transaction.read_callback(err, data + offset, transaction.length);
+                    offset += transaction.length;
+                }
+            }
+        }
+    }
+};
+
+
+I2cDevice::I2cDevice(i2c_master_bus_handle_t i2c_bus, uint8_t addr) : addr_(addr) {
     i2c_device_config_t i2c_device_cfg = {
         .dev_addr_length = I2C_ADDR_BIT_LEN_7,
         .device_address = addr,
@@ -17,19 +173,96 @@ I2cDevice::I2cDevice(i2c_master_bus_handle_t i2c_bus, uint8_t addr) {
     };
     ESP_ERROR_CHECK(i2c_master_bus_add_device(i2c_bus, &i2c_device_cfg, &i2c_device_));
     assert(i2c_device_ != NULL);
+    scheduler_ = I2cBusScheduler::GetInstance(i2c_bus);
 }
 
-void I2cDevice::WriteReg(uint8_t reg, uint8_t value) {
+void I2cDevice::RecordTransaction(esp_err_t err, int64_t latency_us, uint32_t merged) {
+    uint32_t errors;
+    {
+        std::lock_guard<std::mutex> lock(scheduler_->mutex_);
+        stats_.transactions++;
+        stats_.merged += merged;
+        stats_.total_latency_us += latency_us;
+        stats_.max_latency_us = std::max(stats_.max_latency_us, latency_us);
+        if (err == ESP_OK) {
+            return;
+        }
+        errors = ++stats_.errors;
+    }
+    // Log the first errors and then every 100th, a missing device must not flood the log
+    if (errors <= 3 || errors % 100 == 0) {
+        ESP_LOGE(TAG, "Device 0x%02x: %s (%lu errors)", addr_, esp_err_to_name(err), (unsigned long)errors);
+    }
+}
+
+I2cDeviceStats I2cDevice::GetStats() {
+    std::lock_guard<std::mutex> lock(scheduler_->mutex_);
+    return stats_;
+}
+
+esp_err_t I2cDevice::Transmit(uint8_t reg, uint8_t value) {
     uint8_t buffer[2] = {reg, value};
-    ESP_ERROR_CHECK(i2c_master_transmit(i2c_device_, buffer, 2, 100));
+    return i2c_master_transmit(i2c_device_, buffer, 2, I2C_DEVICE_TIMEOUT_MS);
+}
+
+esp_err_t I2cDevice::TransmitReceive(uint8_t reg, uint8_t* buffer, size_t length) {
+    esp_err_t err = i2c_master_transmit_receive(i2c_device_, &reg, 1, buffer, length, I2C_DEVICE_TIMEOUT_MS);
+    if (err != ESP_OK) {
+        memset(buffer, 0, length);
+    }
+    return err;
+}
+
+esp_err_t I2cDevice::TryWriteReg(uint8_t reg, uint8_t value) {
+    int64_t start_us = esp_timer_get_time();
+    esp_err_t err = Transmit(reg, value);
+    RecordTransaction(err, esp_timer_get_time() - start_us);
+    return err;
+}
+
+esp_err_t I2cDevice::TryReadRegs(uint8_t reg, uint8_t* buffer, size_t length) {
+    int64_t start_us = esp_timer_get_time();
+    esp_err_t err = TransmitReceive(reg, buffer, length);
+    RecordTransaction(err, esp_timer_get_time() - start_us);
+    return err;
+}
+
+void I2cDevice::WriteReg(uint8_t reg, uint8_t value) {
+    TryWriteReg(reg, value);
 }
 
 uint8_t I2cDevice::ReadReg(uint8_t reg) {
     uint8_t buffer[1];
-    ESP_ERROR_CHECK(i2c_master_transmit_receive(i2c_device_, &reg, 1, buffer, 1, 100));
+    TryReadRegs(reg, buffer, 1);
     return buffer[0];
 }
 
 void I2cDevice::ReadRegs(uint8_t reg, uint8_t* buffer, size_t length) {
-    ESP_ERROR_CHECK(i2c_master_transmit_receive(i2c_device_, &reg, 1, buffer, length, 100));
-}
\ No newline at end of file
+    TryReadRegs(reg, buffer, length);
+}
+
+bool I2cDevice::WriteRegAsync(uint8_t reg, uint8_t value, WriteCallback callback) {
+    return scheduler_->Submit(I2cTransaction{
+        .device = this,
+        .write = true,
+        .reg = reg,
+        .value = value,
+        .length = 0,
+        .queued_us = esp_timer_get_time(),
+        .read_callback = nullptr,
+        .write_callback = std::move(callback),
+    });
+}
+
+bool I2cDevice::ReadRegsAsync(uint8_t reg, size_t length, ReadCallback callback) {
+    return scheduler_->Submit(I2cTransaction{
+        .device = this,
+        .write = false,
+        .reg = reg,
+        .value = 0,
+        .length = length,
+        .queued_us = esp_timer_get_time(),
+        .read_callback = std::move(callback),
+        .write_callback = nullptr,
+    });
+}
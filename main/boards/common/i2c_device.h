@@ -3,16 +3,66 @@
 
 #include <driver/i2c_master.h>
 
+#include <functional>
+
+#define I2C_DEVICE_TIMEOUT_MS 100
+// Longest merged read, consecutive async reads of one device are combined up to this size
+#define I2C_DEVICE_MAX_MERGED_READ 32
+
+enum I2cPriority {
+    kI2cPriorityHigh,       // Codec, touch, anything a user is waiting for
+    kI2cPriorityNormal,
+    kI2cPriorityLow,        // Battery and charger telemetry
+    kI2cPriorityCount,
+};
+
+struct I2cDeviceStats {
+    uint32_t transactions = 0;
+    uint32_t errors = 0;
+    uint32_t merged = 0;            // Async reads served by a merged transaction
+    int64_t total_latency_us = 0;   // Per bus transaction, queue wait of the oldest async request plus transfer
+    int64_t max_latency_us = 0;
+};
+
+class I2cBusScheduler;
+
 class I2cDevice {
 public:
     I2cDevice(i2c_master_bus_handle_t i2c_bus, uint8_t addr);
 
+    using ReadCallback = std::function<void(esp_err_t err, const uint8_t* data, size_t length)>;
+    using WriteCallback = std::function<void(esp_err_t err)>;
+
+    I2cDeviceStats GetStats();
+
 protected:
     i2c_master_dev_handle_t i2c_device_;
+    uint8_t addr_;
+    // Priority of the async calls of this device, and whether its registers auto increment so reads can be merged
+    I2cPriority priority_ = kI2cPriorityNormal;
+    bool merge_reads_ = false;
 
+    // Errors are logged and counted instead of aborting, reads return zeros on error
     void WriteReg(uint8_t reg, uint8_t value);
     uint8_t ReadReg(uint8_t reg);
     void ReadRegs(uint8_t reg, uint8_t* buffer, size_t length);
+    esp_err_t TryWriteReg(uint8_t reg, uint8_t value);
+    esp_err_t TryReadRegs(uint8_t reg, uint8_t* buffer, size_t length);
+
+    // Queued on the bus worker, callbacks run in the worker task. Returns false if the bus queue is full
+    bool WriteRegAsync(uint8_t reg, uint8_t value, WriteCallback callback = nullptr);
+    bool ReadRegsAsync(uint8_t reg, size_t length, ReadCallback callback);
+
+private:
+    I2cBusScheduler* scheduler_;
+    I2cDeviceStats stats_;
+
+    // Bus transfers without the bookkeeping, the worker records a batch as one transaction
+    esp_err_t Transmit(uint8_t reg, uint8_t value);
+    esp_err_t TransmitReceive(uint8_t reg, uint8_t* buffer, size_t length);
+    void RecordTransaction(esp_err_t err, int64_t latency_us, uint32_t merged = 0);
+
+    friend class I2cBusScheduler;
 };
 
 #endif // I2C_DEVICE_H
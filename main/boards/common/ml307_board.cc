@@ -1,6 +1,7 @@
 #include "ml307_board.h"
 
 #include "application.h"
+#include "system_profiler.h"
 #include "display.h"
 #include "font_awesome_symbols.h"
 #include "assets/lang_config.h"
@@ -33,6 +34,8 @@ void Ml307Board::StartNetwork() {
     // If low power, the material ready event will be triggered by the modem because of a reset
     modem_.OnMaterialReady([this, &application]() {
         ESP_LOGI(TAG, "ML307 material ready");
+        // The modem was reset, the network is gone until it registers again
+        application.NotifyStatusBarChanged(kStatusBarNetwork);
         application.Schedule([this, &application]() {
             application.SetDeviceState(kDeviceStateIdle);
             WaitForNetworkReady();
@@ -72,6 +75,7 @@ void Ml307Board::WaitForNetworkReady() {
 
     // Enable sleep mode
     modem_.SetSleepMode(true, 30);
+    application.NotifyStatusBarChanged(kStatusBarNetwork);
 }
 
 Http* Ml307Board::CreateHttp() {
@@ -149,6 +153,11 @@ std::string Ml307Board::GetDeviceStatusJson() {
      *         "type": "cellular",
      *         "carrier": "CHINA MOBILE",
      *         "csq": 10
+     *     },
+     *     "system": {
+     *         "cpu_load": [35, 12],
+     *         "free_internal_heap": 81920,
+     *         "largest_internal_block": 40960
      *     }
      * }
      */
@@ -204,6 +213,12 @@ std::string Ml307Board::GetDeviceStatusJson() {
     }
     cJSON_AddItemToObject(root, "network", network);
 
+    // System load, see self.system.get_profile for the details
+    auto system = SystemProfiler::GetInstance().GetSummaryJson();
+    if (system) {
+        cJSON_AddItemToObject(root, "system", system);
+    }
+
     auto json_str = cJSON_PrintUnformatted(root);
     std::string json(json_str);
     cJSON_free(json_str);
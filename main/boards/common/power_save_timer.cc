@@ -1,10 +1,14 @@
 #include "power_save_timer.h"
 #include "application.h"
+#include "settings.h"
+#include "system_profiler.h"
 
 #include <esp_log.h>
 
 #define TAG "PowerSaveTimer"
 
+static const char* const POWER_LEVEL_NAMES[] = { "active", "idle", "sleep" };
+
 
 PowerSaveTimer::PowerSaveTimer(int cpu_max_freq, int seconds_to_sleep, int seconds_to_shutdown)
     : cpu_max_freq_(cpu_max_freq), seconds_to_sleep_(seconds_to_sleep), seconds_to_shutdown_(seconds_to_shutdown) {
@@ -19,9 +23,14 @@ PowerSaveTimer::PowerSaveTimer(int cpu_max_freq, int seconds_to_sleep, int secon
         .skip_unhandled_events = true,
     };
     ESP_ERROR_CHECK(esp_timer_create(&timer_args, &power_save_timer_));
+    level_since_us_ = esp_timer_get_time();
+    SystemProfiler::GetInstance().SetPowerSource([this]() {
+        return GetResidencyJson();
+    });
 }
 
 PowerSaveTimer::~PowerSaveTimer() {
+    SystemProfiler::GetInstance().SetPowerSource(nullptr);
     esp_timer_stop(power_save_timer_);
     esp_timer_delete(power_save_timer_);
 }
@@ -52,52 +61,143 @@ void PowerSaveTimer::OnShutdownRequest(std::function<void()> callback) {
     on_shutdown_request_ = callback;
 }
 
-void PowerSaveTimer::PowerSaveCheck() {
-    auto& app = Application::GetInstance();
-    if (!in_sleep_mode_ && !app.CanEnterSleepMode()) {
-        ticks_ = 0;
+void PowerSaveTimer::SetCurrentEstimates(int active_ma, int idle_ma, int sleep_ma) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    current_ma_[kPowerLevelActive] = active_ma;
+    current_ma_[kPowerLevelIdle] = idle_ma;
+    current_ma_[kPowerLevelSleep] = sleep_ma;
+}
+
+void PowerSaveTimer::SetLevel(PowerLevel level) {
+    if (level == level_) {
         return;
     }
+    int64_t now = esp_timer_get_time();
+    residency_us_[level_] += now - level_since_us_;
+    level_since_us_ = now;
+    level_ = level;
 
-    ticks_++;
-    if (seconds_to_sleep_ != -1 && ticks_ >= seconds_to_sleep_) {
+    if (cpu_max_freq_ == -1) {
+        return;
+    }
+    esp_pm_config_t pm_config = {
+        .max_freq_mhz = cpu_max_freq_,
+        .min_freq_mhz = cpu_max_freq_,
+        .light_sleep_enable = false,
+    };
+    if (level == kPowerLevelIdle) {
+        // The wake word, AFE, opus and LVGL rendering hold CPU max locks, the rest may run slower
+        pm_config.min_freq_mhz = cpu_max_freq_ > 160 ? 160 : 80;
+    } else if (level == kPowerLevelSleep) {
+        pm_config.min_freq_mhz = 40;
+        pm_config.light_sleep_enable = true;
+    }
+    esp_err_t ret = esp_pm_configure(&pm_config);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to configure %s level: %s", POWER_LEVEL_NAMES[level], esp_err_to_name(ret));
+    }
+}
+
+int64_t PowerSaveTimer::GetResidency(int64_t residency_us[kPowerLevelCount], int& average_ma) {
+    int64_t total_us = 0;
+    int64_t charge = 0;     // mA * us
+    for (int i = 0; i < kPowerLevelCount; i++) {
+        residency_us[i] = residency_us_[i];
+        if (i == level_) {
+            residency_us[i] += esp_timer_get_time() - level_since_us_;
+        }
+        total_us += residency_us[i];
+        charge += residency_us[i] * current_ma_[i];
+    }
+    average_ma = total_us > 0 ? (int)(charge / total_us) : 0;
+    return total_us;
+}
+
+void PowerSaveTimer::PrintResidency() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int64_t residency_us[kPowerLevelCount];
+    int average_ma;
+    int64_t total_us = GetResidency(residency_us, average_ma);
+    if (total_us == 0) {
+        return;
+    }
+    ESP_LOGI(TAG, "Residency: active %d%% idle %d%% sleep %d%%, average ~%d mA",
+        (int)(residency_us[kPowerLevelActive] * 100 / total_us),
+        (int)(residency_us[kPowerLevelIdle] * 100 / total_us),
+        (int)(residency_us[kPowerLevelSleep] * 100 / total_us),
+        average_ma);
+}
+
+cJSON* PowerSaveTimer::GetResidencyJson() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int64_t residency_us[kPowerLevelCount];
+    int average_ma;
+    GetResidency(residency_us, average_ma);
+    auto json = cJSON_CreateObject();
+    cJSON_AddStringToObject(json, "level", POWER_LEVEL_NAMES[level_]);
+    auto seconds = cJSON_CreateObject();
+    for (int i = 0; i < kPowerLevelCount; i++) {
+        cJSON_AddNumberToObject(seconds, POWER_LEVEL_NAMES[i], residency_us[i] / 1000000);
+    }
+    cJSON_AddItemToObject(json, "residency_s", seconds);
+    cJSON_AddNumberToObject(json, "average_ma", average_ma);
+    return json;
+}
+
+void PowerSaveTimer::PowerSaveCheck() {
+    bool can_sleep = Application::GetInstance().CanEnterSleepMode();
+    bool enter_sleep = false;
+    bool shutdown = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!in_sleep_mode_ && !can_sleep) {
+            ticks_ = 0;
+            SetLevel(kPowerLevelActive);
+            return;
+        }
+
+        ticks_++;
         if (!in_sleep_mode_) {
+            SetLevel(kPowerLevelIdle);
+        }
+        if (seconds_to_sleep_ != -1 && ticks_ >= seconds_to_sleep_ && !in_sleep_mode_) {
             in_sleep_mode_ = true;
-            if (on_enter_sleep_mode_) {
-                on_enter_sleep_mode_();
-            }
+            enter_sleep = true;
+        }
+        shutdown = seconds_to_shutdown_ != -1 && ticks_ >= seconds_to_shutdown_;
+    }
 
-            if (cpu_max_freq_ != -1) {
-                esp_pm_config_t pm_config = {
-                    .max_freq_mhz = cpu_max_freq_,
-                    .min_freq_mhz = 40,
-                    .light_sleep_enable = true,
-                };
-                esp_pm_configure(&pm_config);
+    if (enter_sleep) {
+        if (on_enter_sleep_mode_) {
+            on_enter_sleep_mode_();
+        }
+        {
+            // Unless woken up during the callback
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (in_sleep_mode_) {
+                SetLevel(kPowerLevelSleep);
             }
         }
+        PrintResidency();
     }
-    if (seconds_to_shutdown_ != -1 && ticks_ >= seconds_to_shutdown_ && on_shutdown_request_) {
+    if (shutdown && on_shutdown_request_) {
+        // The callbacks cut the power or enter deep sleep, pending settings would be lost
+        Settings::Flush();
         on_shutdown_request_();
     }
 }
 
 void PowerSaveTimer::WakeUp() {
-    ticks_ = 0;
-    if (in_sleep_mode_) {
+    bool was_sleeping;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ticks_ = 0;
+        was_sleeping = in_sleep_mode_;
         in_sleep_mode_ = false;
-
-        if (cpu_max_freq_ != -1) {
-            esp_pm_config_t pm_config = {
-                .max_freq_mhz = cpu_max_freq_,
-                .min_freq_mhz = cpu_max_freq_,
-                .light_sleep_enable = false,
-            };
-            esp_pm_configure(&pm_config);
-        }
-
-        if (on_exit_sleep_mode_) {
-            on_exit_sleep_mode_();
-        }
+        // Also from idle: the work that woke us up must not run at the lowered DFS frequency
+        SetLevel(kPowerLevelActive);
+    }
+    if (was_sleeping && on_exit_sleep_mode_) {
+        on_exit_sleep_mode_();
     }
 }
@@ -1,9 +1,24 @@
 #pragma once
 
 #include <functional>
+#include <mutex>
+#include <atomic>
 
 #include <esp_timer.h>
 #include <esp_pm.h>
+#include <cJSON.h>
+
+// Rough current draw of each level, used for the average current in the residency log and profile
+#define POWER_SAVE_ACTIVE_CURRENT_MA 110
+#define POWER_SAVE_IDLE_CURRENT_MA 70
+#define POWER_SAVE_SLEEP_CURRENT_MA 25
+
+enum PowerLevel {
+    kPowerLevelActive,  // Audio channel open, CPU locked at the max frequency
+    kPowerLevelIdle,    // DFS may lower the clock, the wake word, AFE and rendering hold CPU max locks
+    kPowerLevelSleep,   // No activity for a while, light sleep allowed
+    kPowerLevelCount,
+};
 
 class PowerSaveTimer {
 public:
@@ -16,17 +31,36 @@ public:
     void OnShutdownRequest(std::function<void()> callback);
     void WakeUp();
 
+    // Override the default current estimates with measured values of the board
+    void SetCurrentEstimates(int active_ma, int idle_ma, int sleep_ma);
+    PowerLevel level() const { return level_.load(std::memory_order_relaxed); }
+    void PrintResidency();
+    // Level, time per level and the estimated average current, added to self.system.get_profile
+    cJSON* GetResidencyJson();
+
 private:
     void PowerSaveCheck();
+    // Called with mutex_ held
+    void SetLevel(PowerLevel level);
+    // Called with mutex_ held, returns the total time and the average current in mA
+    int64_t GetResidency(int64_t residency_us[kPowerLevelCount], int& average_ma);
 
     esp_timer_handle_t power_save_timer_ = nullptr;
     bool enabled_ = false;
+    // WakeUp() comes from input tasks while the check runs in the timer task. The lock guards the
+    // sleep state, the level and its residency, callbacks are invoked without it
+    std::mutex mutex_;
     bool in_sleep_mode_ = false;
     int ticks_ = 0;
     int cpu_max_freq_;
     int seconds_to_sleep_;
     int seconds_to_shutdown_;
 
+    std::atomic<PowerLevel> level_ = kPowerLevelActive;
+    int64_t level_since_us_ = 0;
+    int64_t residency_us_[kPowerLevelCount] = {};
+    int current_ma_[kPowerLevelCount] = { POWER_SAVE_ACTIVE_CURRENT_MA, POWER_SAVE_IDLE_CURRENT_MA, POWER_SAVE_SLEEP_CURRENT_MA };
+
     std::function<void()> on_enter_sleep_mode_;
     std::function<void()> on_exit_sleep_mode_;
     std::function<void()> on_shutdown_request_;
@@ -0,0 +1,131 @@
+#include "power_telemetry.h"
+
+#include <esp_log.h>
+#include <cmath>
+#include <algorithm>
+
+#define TAG "PowerTelemetry"
+
+#define LEVEL_FILTER_ALPHA 0.3f
+#define SETTLING_SAMPLES 3
+#define LOW_BATTERY_HYSTERESIS 5
+
+PowerTelemetry::PowerTelemetry(Sampler sampler) : sampler_(sampler) {
+    esp_timer_create_args_t timer_args = {
+        .callback = [](void* arg) {
+            static_cast<PowerTelemetry*>(arg)->Sample();
+        },
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "power_telemetry",
+        .skip_unhandled_events = true,
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &timer_));
+}
+
+PowerTelemetry::~PowerTelemetry() {
+    if (timer_ != nullptr) {
+        esp_timer_stop(timer_);
+        esp_timer_delete(timer_);
+    }
+}
+
+void PowerTelemetry::Start() {
+    settling_samples_ = SETTLING_SAMPLES;
+    Sample();
+}
+
+void PowerTelemetry::OnEvent(EventCallback callback) {
+    on_event_ = callback;
+}
+
+bool PowerTelemetry::GetSnapshot(PowerSnapshot& snapshot) const {
+    uint32_t sequence;
+    do {
+        sequence = sequence_.load(std::memory_order_acquire);
+        snapshot = snapshot_;
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((sequence & 1) != 0 || sequence != sequence_.load(std::memory_order_relaxed));
+    return snapshot.updated_us != 0;
+}
+
+void PowerTelemetry::Sample() {
+    sampler_([this](bool ok, const PowerReading& reading) {
+        OnSample(ok, reading);
+    });
+}
+
+void PowerTelemetry::OnSample(bool ok, const PowerReading& reading) {
+    if (!ok) {
+        // Keep the last snapshot, a failing bus is already logged by the device
+        uint64_t interval_ms = snapshot_.updated_us == 0 ? POWER_TELEMETRY_FAST_INTERVAL_MS : POWER_TELEMETRY_SLOW_INTERVAL_MS;
+        esp_timer_start_once(timer_, interval_ms * 1000);
+        return;
+    }
+
+    PowerSnapshot last = snapshot_;
+    bool first = last.updated_us == 0;
+    bool flow_changed = !first && (reading.charging != last.charging || reading.discharging != last.discharging);
+    if (flow_changed) {
+        settling_samples_ = SETTLING_SAMPLES;
+    }
+
+    int raw_level = std::clamp(reading.level, 0, 100);
+    if (filtered_level_ < 0) {
+        filtered_level_ = raw_level;
+    } else {
+        float level = filtered_level_ + LEVEL_FILTER_ALPHA * (raw_level - filtered_level_);
+        // Like a coulomb counter, the level only follows the current: down when discharging, up when charging
+        if (reading.discharging) {
+            level = std::min(level, filtered_level_);
+        } else if (reading.charging) {
+            level = std::max(level, filtered_level_);
+        }
+        filtered_level_ = level;
+    }
+
+    PowerSnapshot snapshot;
+    snapshot.level = reading.charge_done ? 100 : (int)std::lround(filtered_level_);
+    snapshot.charging = reading.charging;
+    snapshot.discharging = reading.discharging;
+    snapshot.charge_done = reading.charge_done;
+    snapshot.voltage_mv = reading.voltage_mv;
+    snapshot.temperature = reading.temperature;
+    snapshot.raw_level = raw_level;
+    snapshot.updated_us = esp_timer_get_time();
+    if (last.low_battery) {
+        snapshot.low_battery = reading.discharging && snapshot.level < POWER_TELEMETRY_LOW_BATTERY_LEVEL + LOW_BATTERY_HYSTERESIS;
+    } else {
+        snapshot.low_battery = reading.discharging && snapshot.level <= POWER_TELEMETRY_LOW_BATTERY_LEVEL;
+    }
+
+    sequence_.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    snapshot_ = snapshot;
+    sequence_.fetch_add(1, std::memory_order_release);
+
+    if (first) {
+        ESP_LOGI(TAG, "Battery %d%%, charging %d, discharging %d", snapshot.level, snapshot.charging, snapshot.discharging);
+    }
+    if (on_event_) {
+        if (first || snapshot.charging != last.charging) {
+            on_event_(kPowerEventChargingChanged, snapshot);
+        }
+        if (first || snapshot.discharging != last.discharging) {
+            on_event_(kPowerEventDischargingChanged, snapshot);
+        }
+        if (snapshot.low_battery != last.low_battery) {
+            on_event_(kPowerEventLowBatteryChanged, snapshot);
+        }
+        if (!first && snapshot.level != last.level) {
+            on_event_(kPowerEventLevelChanged, snapshot);
+        }
+    }
+
+    if (settling_samples_ > 0) {
+        settling_samples_--;
+    }
+    bool fast = settling_samples_ > 0 || snapshot.charging || snapshot.low_battery;
+    uint64_t interval_ms = fast ? POWER_TELEMETRY_FAST_INTERVAL_MS : POWER_TELEMETRY_SLOW_INTERVAL_MS;
+    esp_timer_start_once(timer_, interval_ms * 1000);
+}
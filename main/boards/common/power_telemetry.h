@@ -0,0 +1,84 @@
+#ifndef POWER_TELEMETRY_H
+#define POWER_TELEMETRY_H
+
+#include <esp_timer.h>
+
+#include <atomic>
+#include <functional>
+
+#define POWER_TELEMETRY_FAST_INTERVAL_MS 2000
+#define POWER_TELEMETRY_SLOW_INTERVAL_MS 15000
+#define POWER_TELEMETRY_LOW_BATTERY_LEVEL 20
+
+// One raw reading of a PMIC, charger or battery ADC
+struct PowerReading {
+    int level = 0;              // 0-100
+    bool charging = false;
+    bool discharging = false;
+    bool charge_done = false;
+    int voltage_mv = 0;         // 0 if the source does not measure it
+    float temperature = 0;
+};
+
+// Filtered state, published after each sample
+struct PowerSnapshot {
+    int level = 0;
+    bool charging = false;
+    bool discharging = false;
+    bool charge_done = false;
+    bool low_battery = false;
+    int voltage_mv = 0;
+    float temperature = 0;
+    int raw_level = 0;
+    int64_t updated_us = 0;
+};
+
+enum PowerEvent {
+    kPowerEventChargingChanged,
+    kPowerEventDischargingChanged,
+    kPowerEventLowBatteryChanged,
+    kPowerEventLevelChanged,        // The filtered level, in whole percent
+};
+
+/**
+ * Samples the battery in the background and caches the result, so the status bar and other readers
+ * never touch the bus.
+ *
+ * The sampler is asynchronous: it may hand the reading to the I2C bus worker and report it later.
+ * It samples fast while the state is settling, charging or close to empty, and slowly otherwise.
+ * The level is an EMA of the readings that only moves in the direction of the current flow, so
+ * the icon does not flicker between two steps.
+ */
+class PowerTelemetry {
+public:
+    using SampleDone = std::function<void(bool ok, const PowerReading& reading)>;
+    using Sampler = std::function<void(SampleDone done)>;
+    using EventCallback = std::function<void(PowerEvent event, const PowerSnapshot& snapshot)>;
+
+    PowerTelemetry(Sampler sampler);
+    ~PowerTelemetry();
+
+    void Start();
+    // Lock free, returns false until the first sample is in
+    bool GetSnapshot(PowerSnapshot& snapshot) const;
+    // Called in the sampling context, which may be the I2C bus worker with a 4 KB stack,
+    // keep it short and hand anything heavier to Application::Schedule()
+    void OnEvent(EventCallback callback);
+
+private:
+    Sampler sampler_;
+    EventCallback on_event_;
+    esp_timer_handle_t timer_ = nullptr;
+
+    // Seqlock, the sampler is the only writer
+    std::atomic<uint32_t> sequence_{0};
+    PowerSnapshot snapshot_;
+
+    float filtered_level_ = -1;
+    int settling_samples_ = 0;
+
+    void Sample();
+    void OnSample(bool ok, const PowerReading& reading);
+};
+
+#endif // POWER_TELEMETRY_H
@@ -0,0 +1,278 @@
+#include "servo_motion.h"
+
+#include <esp_log.h>
+
+#include <cmath>
+#include <climits>
+#include <cstring>
+#include <algorithm>
+
+#define TAG "ServoMotion"
+
+#define KEEP_POSITION INT32_MIN
+
+// Q15 tables with one extra entry for the interpolation, built once
+static uint16_t min_jerk_table[257];
+static int16_t sine_table[257];
+static bool tables_ready = false;
+
+static void BuildTables() {
+    if (tables_ready) {
+        return;
+    }
+    for (int i = 0; i <= 256; i++) {
+        double t = i / 256.0;
+        // Minimum jerk: 10t^3 - 15t^4 + 6t^5
+        double s = t * t * t * (10 - 15 * t + 6 * t * t);
+        min_jerk_table[i] = (uint16_t)std::lround(s * 32768);
+        sine_table[i] = (int16_t)std::lround(std::sin(2 * M_PI * t) * 32767);
+    }
+    tables_ready = true;
+}
+
+// fraction: 0-65536, returns 0-32768
+static inline int32_t MinJerk(uint32_t fraction) {
+    if (fraction >= 65536) {
+        return 32768;
+    }
+    uint32_t index = fraction >> 8;
+    int32_t frac = fraction & 0xFF;
+    int32_t a = min_jerk_table[index];
+    int32_t b = min_jerk_table[index + 1];
+    return a + (((b - a) * frac) >> 8);
+}
+
+// phase: 2^32 is a full turn, returns -32767-32767
+static inline int32_t Sine(uint32_t phase) {
+    uint32_t index = phase >> 24;
+    int32_t frac = (phase >> 16) & 0xFF;
+    int32_t a = sine_table[index];
+    int32_t b = sine_table[index + 1];
+    return a + (((b - a) * frac) >> 8);
+}
+
+static inline uint32_t Fraction(int64_t t_us, int64_t duration_us) {
+    if (duration_us <= 0 || t_us >= duration_us) {
+        return 65536;
+    }
+    return (uint32_t)((t_us << 16) / duration_us);
+}
+
+ServoMotion::ServoMotion(int servo_count, WriteCallback write)
+    : servo_count_(std::min(servo_count, SERVO_MOTION_MAX_SERVOS)), write_(write) {
+    BuildTables();
+    for (int i = 0; i < SERVO_MOTION_MAX_SERVOS; i++) {
+        position_[i] = 90 << 8;
+        start_position_[i] = position_[i];
+        written_[i] = 90;
+    }
+
+    esp_timer_create_args_t timer_args = {
+        .callback = [](void* arg) {
+            static_cast<ServoMotion*>(arg)->OnTick();
+        },
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "servo_motion",
+        .skip_unhandled_events = true,
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &timer_));
+}
+
+ServoMotion::~ServoMotion() {
+    if (timer_ != nullptr) {
+        esp_timer_stop(timer_);
+        esp_timer_delete(timer_);
+    }
+}
+
+bool ServoMotion::Push(const Segment& segment) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (queue_count_ == SERVO_MOTION_QUEUE_SIZE) {
+        ESP_LOGW(TAG, "Motion queue is full");
+        return false;
+    }
+    queue_[(queue_head_ + queue_count_) % SERVO_MOTION_QUEUE_SIZE] = segment;
+    queue_count_++;
+    if (!timer_running_) {
+        last_tick_us_ = 0;
+        ESP_ERROR_CHECK(esp_timer_start_periodic(timer_, SERVO_MOTION_TICK_MS * 1000));
+        timer_running_ = true;
+    }
+    return true;
+}
+
+bool ServoMotion::QueueMove(const int target[], int duration_ms) {
+    Segment segment;
+    segment.type = kSegmentMove;
+    segment.duration_us = std::max(duration_ms, 0) * 1000LL;
+    segment.period_us = 0;
+    for (int i = 0; i < servo_count_; i++) {
+        segment.target[i] = target[i] < 0 ? KEEP_POSITION : std::min(target[i], 180) << 8;
+    }
+    return Push(segment);
+}
+
+bool ServoMotion::QueueOscillation(const int amplitude[], const int offset[], const double phase[], int period_ms, float cycles) {
+    int64_t duration_us = (int64_t)(period_ms * 1000LL * cycles);
+    if (period_ms <= 0 || duration_us <= 0) {
+        return true;
+    }
+    Segment segment;
+    segment.type = kSegmentOscillation;
+    segment.duration_us = duration_us;
+    segment.period_us = period_ms * 1000;
+    for (int i = 0; i < servo_count_; i++) {
+        segment.target[i] = offset[i] << 8;
+        segment.amplitude[i] = amplitude[i] << 8;
+        double turns = phase[i] / (2 * M_PI);
+        turns -= std::floor(turns);
+        segment.phase[i] = (uint32_t)(uint64_t)(turns * 4294967296.0);
+    }
+    return Push(segment);
+}
+
+bool ServoMotion::QueueHold(int duration_ms) {
+    Segment segment;
+    segment.type = kSegmentHold;
+    segment.duration_us = std::max(duration_ms, 0) * 1000LL;
+    segment.period_us = 0;
+    return Push(segment);
+}
+
+void ServoMotion::Cancel() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_count_ = 0;
+        running_ = false;
+        epoch_++;
+    }
+    idle_cv_.notify_all();
+}
+
+uint32_t ServoMotion::epoch() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return epoch_;
+}
+
+bool ServoMotion::WaitIdle(uint32_t epoch, int timeout_ms) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto done = [this, epoch]() {
+        return epoch_ != epoch || (!running_ && queue_count_ == 0);
+    };
+    if (timeout_ms < 0) {
+        idle_cv_.wait(lock, done);
+    } else {
+        idle_cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms), done);
+    }
+    return epoch_ == epoch && !running_ && queue_count_ == 0;
+}
+
+bool ServoMotion::IsIdle() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !running_ && queue_count_ == 0;
+}
+
+int ServoMotion::GetPosition(int servo) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return (position_[servo] + 128) >> 8;
+}
+
+ServoMotionStats ServoMotion::TakeStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto stats = stats_;
+    stats_ = ServoMotionStats();
+    return stats;
+}
+
+void ServoMotion::Evaluate(const Segment& segment, int64_t t_us) {
+    switch (segment.type) {
+    case kSegmentMove: {
+        int32_t s = MinJerk(Fraction(t_us, segment.duration_us));
+        for (int i = 0; i < servo_count_; i++) {
+            if (segment.target[i] != KEEP_POSITION) {
+                int32_t start = start_position_[i];
+                position_[i] = start + (int32_t)(((int64_t)(segment.target[i] - start) * s) >> 15);
+            }
+        }
+        break;
+    }
+    case kSegmentOscillation: {
+        uint32_t advance = (uint32_t)(((uint64_t)(t_us % segment.period_us) << 32) / segment.period_us);
+        int64_t blend_us = std::min<int64_t>(SERVO_MOTION_BLEND_MS * 1000, segment.duration_us / 2);
+        int32_t weight = t_us < blend_us ? MinJerk(Fraction(t_us, blend_us)) : 32768;
+        for (int i = 0; i < servo_count_; i++) {
+            int32_t value = segment.target[i] + ((segment.amplitude[i] * Sine(segment.phase[i] + advance)) >> 15);
+            int32_t start = start_position_[i];
+            position_[i] = start + (int32_t)(((int64_t)(value - start) * weight) >> 15);
+        }
+        break;
+    }
+    case kSegmentHold:
+        break;
+    }
+}
+
+void ServoMotion::OnTick() {
+    int64_t now = esp_timer_get_time();
+    int positions[SERVO_MOTION_MAX_SERVOS];
+    bool became_idle = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (last_tick_us_ != 0) {
+            int64_t jitter_us = std::abs(now - last_tick_us_ - SERVO_MOTION_TICK_MS * 1000);
+            stats_.ticks++;
+            stats_.total_jitter_us += jitter_us;
+            stats_.max_jitter_us = std::max(stats_.max_jitter_us, jitter_us);
+        }
+        last_tick_us_ = now;
+
+        bool chained = false;
+        while (queue_count_ > 0) {
+            auto& segment = queue_[queue_head_];
+            if (!running_) {
+                running_ = true;
+                // A segment queued behind another starts exactly where the previous one ended
+                if (!chained) {
+                    segment_start_us_ = now;
+                }
+                memcpy(start_position_, position_, sizeof(position_));
+            }
+            int64_t t_us = now - segment_start_us_;
+            if (t_us < segment.duration_us) {
+                Evaluate(segment, t_us);
+                break;
+            }
+            Evaluate(segment, segment.duration_us);
+            segment_start_us_ += segment.duration_us;
+            queue_head_ = (queue_head_ + 1) % SERVO_MOTION_QUEUE_SIZE;
+            queue_count_--;
+            running_ = false;
+            chained = true;
+            became_idle = queue_count_ == 0;
+        }
+
+        if (queue_count_ == 0 && timer_running_) {
+            esp_timer_stop(timer_);
+            timer_running_ = false;
+        }
+        for (int i = 0; i < servo_count_; i++) {
+            positions[i] = (position_[i] + 128) >> 8;
+        }
+    }
+
+    for (int i = 0; i < servo_count_; i++) {
+        if (positions[i] != written_[i]) {
+            written_[i] = positions[i];
+            write_(i, positions[i]);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.max_run_us = std::max(stats_.max_run_us, esp_timer_get_time() - now);
+    }
+    if (became_idle) {
+        idle_cv_.notify_all();
+    }
+}
@@ -0,0 +1,97 @@
+#ifndef SERVO_MOTION_H
+#define SERVO_MOTION_H
+
+#include <esp_timer.h>
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+
+#define SERVO_MOTION_MAX_SERVOS 8
+#define SERVO_MOTION_QUEUE_SIZE 16
+// One update per 50 Hz servo PWM frame, a faster update would never reach the servo
+#define SERVO_MOTION_TICK_MS 20
+// Cross fade from the current pose into an oscillation
+#define SERVO_MOTION_BLEND_MS 120
+
+struct ServoMotionStats {
+    uint32_t ticks = 0;
+    int64_t total_jitter_us = 0;    // Deviation of the tick interval from SERVO_MOTION_TICK_MS
+    int64_t max_jitter_us = 0;
+    int64_t max_run_us = 0;
+};
+
+/**
+ * Drives a group of servos from a periodic esp_timer.
+ *
+ * Motions are queued without blocking and played back to back: moves follow a min-jerk profile,
+ * oscillations are sine waves. Both are evaluated in fixed point from tables built once, the timer
+ * callback does no floating point and never waits. Positions are in degrees, 0-180.
+ */
+class ServoMotion {
+public:
+    // Called from the timer task with the new position of a servo
+    using WriteCallback = std::function<void(int servo, int position)>;
+
+    ServoMotion(int servo_count, WriteCallback write);
+    ~ServoMotion();
+
+    // Return false if the queue is full. A negative target keeps the servo where it is
+    bool QueueMove(const int target[], int duration_ms);
+    // position = offset + amplitude * sin(2 * pi * t / period + phase)
+    bool QueueOscillation(const int amplitude[], const int offset[], const double phase[], int period_ms, float cycles);
+    bool QueueHold(int duration_ms);
+
+    // Drop the running and queued motions, the servos stay where they are
+    void Cancel();
+    // Changes on every Cancel
+    uint32_t epoch();
+    // Wait until the queue is drained; false if the epoch changed or on timeout
+    bool WaitIdle(uint32_t epoch, int timeout_ms = -1);
+    bool IsIdle();
+    int GetPosition(int servo);
+    ServoMotionStats TakeStats();
+
+private:
+    enum SegmentType {
+        kSegmentMove,
+        kSegmentOscillation,
+        kSegmentHold,
+    };
+
+    struct Segment {
+        SegmentType type;
+        int64_t duration_us;
+        uint32_t period_us;
+        int32_t target[SERVO_MOTION_MAX_SERVOS];       // 1/256 degree, move target or oscillation offset
+        int32_t amplitude[SERVO_MOTION_MAX_SERVOS];    // 1/256 degree
+        uint32_t phase[SERVO_MOTION_MAX_SERVOS];       // 2^32 is a full turn
+    };
+
+    int servo_count_;
+    WriteCallback write_;
+    esp_timer_handle_t timer_ = nullptr;
+    bool timer_running_ = false;
+
+    std::mutex mutex_;
+    std::condition_variable idle_cv_;
+    Segment queue_[SERVO_MOTION_QUEUE_SIZE];
+    size_t queue_head_ = 0;
+    size_t queue_count_ = 0;
+    bool running_ = false;
+    int64_t segment_start_us_ = 0;
+    uint32_t epoch_ = 0;
+
+    int32_t position_[SERVO_MOTION_MAX_SERVOS];         // 1/256 degree
+    int32_t start_position_[SERVO_MOTION_MAX_SERVOS];
+    int written_[SERVO_MOTION_MAX_SERVOS];
+
+    int64_t last_tick_us_ = 0;
+    ServoMotionStats stats_;
+
+    bool Push(const Segment& segment);
+    void OnTick();
+    void Evaluate(const Segment& segment, int64_t t_us);
+};
+
+#endif // SERVO_MOTION_H
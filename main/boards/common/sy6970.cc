@@ -7,6 +7,9 @@
 #define TAG "Sy6970"
 
 Sy6970::Sy6970(i2c_master_bus_handle_t i2c_bus, uint8_t addr) : I2cDevice(i2c_bus, addr) {
+    // Telemetry only, yield the bus to codec and touch traffic
+    priority_ = kI2cPriorityLow;
+    merge_reads_ = true;
 }
 
 int Sy6970::GetChangingStatus() {
@@ -25,8 +28,7 @@ bool Sy6970::IsChargingDone() {
     return GetChangingStatus() == 3;
 }
 
-int Sy6970::GetBatteryVoltage() {
-    uint8_t value = ReadReg(0x0E);
+static int BatteryVoltageFromReg(uint8_t value) {
     value &= 0x7F;
     if (value == 0) {
         return 0;
@@ -34,8 +36,7 @@ int Sy6970::GetBatteryVoltage() {
     return value * 20 + 2304;
 }
 
-int Sy6970::GetChargeTargetVoltage() {
-    uint8_t value = ReadReg(0x06);
+static int ChargeTargetVoltageFromReg(uint8_t value) {
     value = (value & 0xFC) >> 2;
     if (value > 0x30) {
         return 4608;
@@ -43,12 +44,18 @@ int Sy6970::GetChargeTargetVoltage() {
     return value * 16 + 3840;
 }
 
-int Sy6970::GetBatteryLevel() {
+int Sy6970::GetBatteryVoltage() {
+    return BatteryVoltageFromReg(ReadReg(0x0E));
+}
+
+int Sy6970::GetChargeTargetVoltage() {
+    return ChargeTargetVoltageFromReg(ReadReg(0x06));
+}
+
+static int BatteryLevelFromVoltage(int battery_voltage, int charge_voltage_limit) {
     int level = 0;
     // 电池所能掉电的最低电压
     int battery_minimum_voltage = 3200;
-    int battery_voltage = GetBatteryVoltage();
-    int charge_voltage_limit = GetChargeTargetVoltage();
     // ESP_LOGI(TAG, "battery_voltage: %d, charge_voltage_limit: %d", battery_voltage, charge_voltage_limit);
     if (battery_voltage > battery_minimum_voltage && charge_voltage_limit > battery_minimum_voltage) {
         level = (((float) battery_voltage - (float) battery_minimum_voltage) / ((float) charge_voltage_limit - (float) battery_minimum_voltage)) * 100.0;
@@ -60,6 +67,30 @@ int Sy6970::GetBatteryLevel() {
     return level;
 }
 
+int Sy6970::GetBatteryLevel() {
+    return BatteryLevelFromVoltage(GetBatteryVoltage(), GetChargeTargetVoltage());
+}
+
 void Sy6970::PowerOff() {
     WriteReg(0x09, 0B01100100);
 }
+
+void Sy6970::ReadTelemetryAsync(PowerTelemetry::SampleDone done) {
+    // 0x06 charge target voltage ... 0x0B status ... 0x0E battery voltage
+    bool queued = ReadRegsAsync(0x06, 9, [done](esp_err_t err, const uint8_t* data, size_t length) {
+        PowerReading reading;
+        if (err == ESP_OK) {
+            uint8_t status = data[0x0B - 0x06];
+            int changing_status = (status >> 3) & 0x03;
+            reading.charging = changing_status != 0;
+            reading.charge_done = changing_status == 3;
+            reading.discharging = !reading.charging && (status & 0x04) != 0;
+            reading.voltage_mv = BatteryVoltageFromReg(data[0x0E - 0x06]);
+            reading.level = BatteryLevelFromVoltage(reading.voltage_mv, ChargeTargetVoltageFromReg(data[0]));
+        }
+        done(err == ESP_OK, reading);
+    });
+    if (!queued) {
+        done(false, PowerReading());
+    }
+}
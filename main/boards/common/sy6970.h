@@ -2,6 +2,7 @@
 #define __SY6970_H__
 
 #include "i2c_device.h"
+#include "power_telemetry.h"
 
 class Sy6970 : public I2cDevice {
 public:
@@ -11,6 +12,8 @@ public:
     bool IsChargingDone();
     int GetBatteryLevel();
     void PowerOff();
+    // Reads the charge target, status and battery voltage registers in one transfer on the bus worker
+    void ReadTelemetryAsync(PowerTelemetry::SampleDone done);
 
 private:
     int GetChangingStatus();
@@ -3,16 +3,23 @@
 #include "display.h"
 #include "board.h"
 #include "system_info.h"
+#include "preview_image.h"
 #include "esp_ldo_regulator.h"
 
 #include <esp_log.h>
 #include <esp_heap_caps.h>
-#include <img_converters.h>
+#include <esp_timer.h>
 #include <cstring>
+#include <algorithm>
 
 #define TAG "WicCamera"
 
-WicCamera::WicCamera(i2c_master_bus_handle_t i2c_handle) {
+#if SOC_PPA_SUPPORTED
+#define PPA_SCALE_STEP  16  // PPA 缩放精度为 1/16
+#endif
+
+WicCamera::WicCamera(i2c_master_bus_handle_t i2c_handle, wic_cam_fmt_t format, int preview_rotation)
+    : preview_rotation_(preview_rotation) {
     esp_err_t err = ESP_OK;
 
     //mipi ldo
@@ -28,7 +35,7 @@ WicCamera::WicCamera(i2c_master_bus_handle_t i2c_handle) {
     }
 
     // camera init
-    err = wic_cam_sensor_init(i2c_handle);
+    err = wic_cam_sensor_init(i2c_handle, format);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Camera init failed with error 0x%x", err);
         return;
@@ -39,79 +46,186 @@ WicCamera::WicCamera(i2c_master_bus_handle_t i2c_handle) {
         return;
     }
 
-    // 初始化预览图片的内存
-    memset(&preview_image_, 0, sizeof(preview_image_));
-    preview_image_.header.magic = LV_IMAGE_HEADER_MAGIC;
-    preview_image_.header.cf = LV_COLOR_FORMAT_RGB565;
-    preview_image_.header.flags = LV_IMAGE_FLAGS_ALLOCATED | LV_IMAGE_FLAGS_MODIFIABLE;
-    preview_image_.header.w = WIC_CAM_CSI_HRES;
-    preview_image_.header.h = WIC_CAM_CSI_VRES;
+#if SOC_JPEG_CODEC_SUPPORTED
+    // 使用硬件 JPEG 编码器，失败时回退到软件编码
+    jpeg_encode_engine_cfg_t encode_engine_cfg = {
+        .intr_priority = 0,
+        .timeout_ms = 100,
+    };
+    err = jpeg_new_encoder_engine(&encode_engine_cfg, &jpeg_encoder_);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to create hardware JPEG encoder, fallback to software: %s", esp_err_to_name(err));
+        jpeg_encoder_ = nullptr;
+    }
+#endif
 
-    preview_image_.header.stride = preview_image_.header.w * 2;
-    preview_image_.data_size = preview_image_.header.w * preview_image_.header.h * 2;
-    preview_image_.data = (uint8_t*)heap_caps_malloc(preview_image_.data_size, MALLOC_CAP_SPIRAM);
-    if (preview_image_.data == nullptr) {
-        ESP_LOGE(TAG, "Failed to allocate memory for preview image");
-        return;
+#if SOC_PPA_SUPPORTED
+    // 预览图的缩放、旋转和字节序交换交给 PPA，失败时回退到软件缩放
+    ppa_client_config_t ppa_config = {
+        .oper_type = PPA_OPERATION_SRM,
+        .max_pending_trans_num = 1,
+    };
+    err = ppa_register_client(&ppa_config, &ppa_srm_);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to register PPA client, fallback to software preview: %s", esp_err_to_name(err));
+        ppa_srm_ = nullptr;
     }
+#endif
 }
 
 WicCamera::~WicCamera() {
-    if (preview_image_.data) {
-        heap_caps_free((void*)preview_image_.data);
-        preview_image_.data = nullptr;
+#if SOC_PPA_SUPPORTED
+    if (ppa_srm_ != nullptr) {
+        ppa_unregister_client(ppa_srm_);
+        ppa_srm_ = nullptr;
+    }
+#endif
+#if SOC_JPEG_CODEC_SUPPORTED
+    if (jpeg_encoder_ != nullptr) {
+        jpeg_del_encoder_engine(jpeg_encoder_);
+        jpeg_encoder_ = nullptr;
     }
+#endif
     wic_cam_sensor_deinit();
 }
 
 void WicCamera::SetExplainUrl(const std::string& url, const std::string& token) {
-    explain_url_ = url;
-    explain_token_ = token;
+    uploader_.SetExplainUrl(url, token);
     ESP_LOGI(TAG, "url: %s, token: %s.", url.c_str(), token.c_str());
 }
 
 bool WicCamera::Capture() {
-    int fb_num = 3;
-    esp_err_t err = ESP_OK;
-
-    if (encoder_thread_.joinable()) {
-        encoder_thread_.join();
+    // 摄像头持续输出到多个缓冲区，直接取最新的一帧，不再丢弃旧帧等待新输出
+    if (fb_) {
+        wic_cam_sensor_free_img_buf(fb_);
+        fb_ = nullptr;
     }
-
-    while (fb_num > 0) {
-        if (fb_) wic_cam_sensor_free_img_buf(fb_);
-        err = wic_cam_sensor_recv_img_buf(&fb_, 1000);
-        if (err != ESP_OK) {
-            ESP_LOGE(TAG, "Camera capture failed, err = %s.", esp_err_to_name(err));
-            return false;
-        }
-        fb_num--;
+    int64_t start_time = esp_timer_get_time();
+    esp_err_t err = wic_cam_sensor_recv_img_buf(&fb_, 1000);
+    if (err != ESP_OK) {
+        fb_ = nullptr;
+        ESP_LOGE(TAG, "Camera capture failed, err = %s.", esp_err_to_name(err));
+        return false;
     }
+    ESP_LOGI(TAG, "Captured %dx%d in %lld us, frame age %lld us", fb_->width, fb_->height,
+        esp_timer_get_time() - start_time, start_time - fb_->timestamp_us);
 
-    // 如果预览图片 buffer 为空，则跳过预览
-    // 但仍返回 true，因为此时图像可以上传至服务器
-    if (preview_image_.data_size == 0) {
-        ESP_LOGW(TAG, "Skip preview because of unsupported frame size");
-        return true;
-    }
-    if (preview_image_.data == nullptr) {
-        ESP_LOGE(TAG, "Preview image data is not initialized");
-        return true;
-    }
-    // 显示预览图片
+    // 显示预览图片，交换字节序的同时缩小到屏幕尺寸，图片由 display 持有
     auto display = Board::GetInstance().GetDisplay();
     if (display != nullptr) {
-        auto src = (uint16_t*)fb_->data;
-        auto dst = (uint16_t*)preview_image_.data;
-        size_t pixel_count = fb_->recv_len / 2;
-        for (size_t i = 0; i < pixel_count; i++) {
-            // 交换每个16位字内的字节
-            dst[i] = __builtin_bswap16(src[i]);
+        start_time = esp_timer_get_time();
+        lv_img_dsc_t* image = nullptr;
+#if SOC_PPA_SUPPORTED
+        if (ppa_srm_ != nullptr) {
+            image = CreatePreviewImageWithPpa(display->width(), display->height());
         }
-        display->SetPreviewImage(&preview_image_);
+#endif
+        if (image == nullptr) {
+            image = CreatePreviewImage((const uint16_t*)fb_->data, fb_->width, fb_->height, display->width(), display->height());
+        }
+        if (image == nullptr) {
+            return true;
+        }
+        ESP_LOGI(TAG, "Preview %dx%d -> %dx%d in %lld us", fb_->width, fb_->height,
+            (int)image->header.w, (int)image->header.h, esp_timer_get_time() - start_time);
+        display->TakePreviewImage(image);
     }
     return true;
 }
+
+#if SOC_PPA_SUPPORTED
+/**
+ * @brief 使用 PPA 的 SRM 引擎一次完成缩放、旋转和 RGB565 字节序交换
+ *
+ * 摄像头输出的是大端 RGB565，LVGL 和硬件 JPEG 编码器都需要小端。
+ * 输出缓冲区按 cache line 对齐，由调用者释放，失败时返回 nullptr。
+ */
+void* WicCamera::TransformWithPpa(int scale_steps, ppa_srm_rotation_angle_t rotation, int width, int height, size_t& buffer_size) {
+    // PPA 输出缓冲区需要按 cache line 对齐
+    buffer_size = ((size_t)width * height * 2 + 63) & ~63;
+    auto data = heap_caps_aligned_alloc(64, buffer_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_DMA);
+    if (data == nullptr) {
+        return nullptr;
+    }
+
+    float scale = (float)scale_steps / PPA_SCALE_STEP;
+    ppa_srm_oper_config_t srm_config = {};
+    srm_config.in.buffer = fb_->data;
+    srm_config.in.pic_w = fb_->width;
+    srm_config.in.pic_h = fb_->height;
+    srm_config.in.block_w = fb_->width;
+    srm_config.in.block_h = fb_->height;
+    srm_config.in.srm_cm = PPA_SRM_COLOR_MODE_RGB565;
+    srm_config.out.buffer = data;
+    srm_config.out.buffer_size = buffer_size;
+    srm_config.out.pic_w = width;
+    srm_config.out.pic_h = height;
+    srm_config.out.srm_cm = PPA_SRM_COLOR_MODE_RGB565;
+    srm_config.rotation_angle = rotation;
+    srm_config.scale_x = scale;
+    srm_config.scale_y = scale;
+    srm_config.byte_swap = true;
+    srm_config.mode = PPA_TRANS_MODE_BLOCKING;
+    esp_err_t err = ppa_do_scale_rotate_mirror(ppa_srm_, &srm_config);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "PPA transform failed: %s", esp_err_to_name(err));
+        heap_caps_free(data);
+        return nullptr;
+    }
+    return data;
+}
+
+/**
+ * @brief 使用 PPA 生成预览图，缩放比例按 PPA 的 1/16 精度向下取整
+ *
+ * 失败时返回 nullptr，调用者回退到软件缩放。
+ */
+lv_img_dsc_t* WicCamera::CreatePreviewImageWithPpa(int max_width, int max_height) {
+    ppa_srm_rotation_angle_t rotation;
+    switch (preview_rotation_) {
+    case 90: rotation = PPA_SRM_ROTATION_ANGLE_90; break;
+    case 180: rotation = PPA_SRM_ROTATION_ANGLE_180; break;
+    case 270: rotation = PPA_SRM_ROTATION_ANGLE_270; break;
+    default: rotation = PPA_SRM_ROTATION_ANGLE_0; break;
+    }
+    bool swap_sides = rotation == PPA_SRM_ROTATION_ANGLE_90 || rotation == PPA_SRM_ROTATION_ANGLE_270;
+    int rotated_width = swap_sides ? fb_->height : fb_->width;
+    int rotated_height = swap_sides ? fb_->width : fb_->height;
+
+    int scale_steps = std::min(max_width * PPA_SCALE_STEP / rotated_width, max_height * PPA_SCALE_STEP / rotated_height);
+    scale_steps = std::min(scale_steps, PPA_SCALE_STEP);
+    if (scale_steps <= 0) {
+        return nullptr;
+    }
+    int width = fb_->width * scale_steps / PPA_SCALE_STEP;
+    int height = fb_->height * scale_steps / PPA_SCALE_STEP;
+    if (swap_sides) {
+        std::swap(width, height);
+    }
+
+    auto image = (lv_img_dsc_t*)heap_caps_calloc(1, sizeof(lv_img_dsc_t), MALLOC_CAP_8BIT);
+    if (image == nullptr) {
+        return nullptr;
+    }
+    size_t buffer_size;
+    auto data = TransformWithPpa(scale_steps, rotation, width, height, buffer_size);
+    if (data == nullptr) {
+        heap_caps_free(image);
+        return nullptr;
+    }
+
+    image->header.magic = LV_IMAGE_HEADER_MAGIC;
+    image->header.cf = LV_COLOR_FORMAT_RGB565;
+    image->header.flags = LV_IMAGE_FLAGS_ALLOCATED | LV_IMAGE_FLAGS_MODIFIABLE;
+    image->header.w = width;
+    image->header.h = height;
+    image->header.stride = width * 2;
+    image->data_size = width * height * 2;
+    image->data = (const uint8_t*)data;
+    return image;
+}
+#endif
+
 bool WicCamera::SetHMirror(bool enabled) {
 
     return false;
@@ -130,134 +244,98 @@ bool WicCamera::SetVFlip(bool enabled) {
  * 问题对图像进行AI分析并返回结果。
  * 
  * 实现特点：
- * - 使用独立线程编码JPEG，与主线程分离
- * - 采用分块传输编码(chunked transfer encoding)优化内存使用
- * - 通过队列机制实现编码线程和发送线程的数据同步
+ * - 由 ExplainUploader 边编码边上传，JPEG 数据写入固定大小的分块池
+ * - 根据上行速度选择分辨率与 JPEG 质量，上传失败时重新编码并重试
+ * - 返回结果中附带编码、上传、服务器处理耗时 (timings 字段)
  * - 支持设备ID、客户端ID和认证令牌的HTTP头部配置
  * 
  * @param question 要向AI提出的关于图像的问题，将作为表单字段发送
  * @return std::string 服务器返回的JSON格式响应字符串
  *         成功时包含AI分析结果，失败时包含错误信息
- *         格式示例：{"success": true, "result": "分析结果"}
- *                  {"success": false, "message": "错误信息"}
+ *         格式示例：{"success": true, "result": "分析结果", "timings": {...}}
+ *                  {"success": false, "message": "错误信息", "timings": {...}}
  * 
  * @note 调用此函数前必须先调用SetExplainUrl()设置服务器URL
- * @note 函数会等待之前的编码线程完成后再开始新的处理
  * @warning 如果摄像头缓冲区为空或网络连接失败，将返回错误信息
  */
 std::string WicCamera::Explain(const std::string& question) {
-    if (explain_url_.empty()) {
-        return "{\"success\": false, \"message\": \"Image explain URL or token is not set\"}";
-    }
-
-    // 创建局部的 JPEG 队列, 40 entries is about to store 512 * 40 = 20480 bytes of JPEG data
-    QueueHandle_t jpeg_queue = xQueueCreate(40, sizeof(JpegChunk));
-    if (jpeg_queue == nullptr) {
-        ESP_LOGE(TAG, "Failed to create JPEG queue");
-        return "{\"success\": false, \"message\": \"Failed to create JPEG queue\"}";
-    }
-
-    // We spawn a thread to encode the image to JPEG
-    encoder_thread_ = std::thread([this, jpeg_queue]() {
-        fmt2jpg_cb((uint8_t *)fb_->data, fb_->recv_len, WIC_CAM_CSI_HRES, WIC_CAM_CSI_VRES, PIXFORMAT_RGB565, 8, [](void* arg, size_t index, const void* data, size_t len) -> unsigned int {
-            auto jpeg_queue = (QueueHandle_t)arg;
-            JpegChunk chunk = {
-                .data = (uint8_t*)heap_caps_aligned_alloc(16, len, MALLOC_CAP_SPIRAM),
-                .len = len
-            };
-            memcpy(chunk.data, data, len);
-            xQueueSend(jpeg_queue, &chunk, portMAX_DELAY);
-            return len;
-        }, jpeg_queue);
-    });
-
-    auto http = Board::GetInstance().CreateHttp();
-    // 构造multipart/form-data请求体
-    std::string boundary = "----ESP32_CAMERA_BOUNDARY";
-
-    // 配置HTTP客户端，使用分块传输编码
-    http->SetHeader("Device-Id", SystemInfo::GetMacAddress().c_str());
-    http->SetHeader("Client-Id", Board::GetInstance().GetUuid().c_str());
-    if (!explain_token_.empty()) {
-        http->SetHeader("Authorization", "Bearer " + explain_token_);
+    if (fb_ == nullptr) {
+        return "{\"success\": false, \"message\": \"No image captured\"}";
     }
-    http->SetHeader("Content-Type", "multipart/form-data; boundary=" + boundary);
-    http->SetHeader("Transfer-Encoding", "chunked");
-    if (!http->Open("POST", explain_url_)) {
-        ESP_LOGE(TAG, "Failed to connect to explain URL");
-        // Clear the queue
-        encoder_thread_.join();
-        JpegChunk chunk;
-        while (xQueueReceive(jpeg_queue, &chunk, portMAX_DELAY) == pdPASS) {
-            if (chunk.data != nullptr) {
-                heap_caps_free(chunk.data);
-            } else {
-                break;
-            }
+#if SOC_JPEG_CODEC_SUPPORTED
+    if (jpeg_encoder_ != nullptr && uploader_.configured()) {
+        std::string result;
+        if (ExplainWithHardwareJpeg(question, result)) {
+            return result;
         }
-        vQueueDelete(jpeg_queue);
-        return "{\"success\": false, \"message\": \"Failed to connect to explain URL\"}";
-    }
-    
-    {
-        // 第一块：question字段
-        std::string question_field;
-        question_field += "--" + boundary + "\r\n";
-        question_field += "Content-Disposition: form-data; name=\"question\"\r\n";
-        question_field += "\r\n";
-        question_field += question + "\r\n";
-        http->Write(question_field.c_str(), question_field.size());
-    }
-    {
-        // 第二块：文件字段头部
-        std::string file_header;
-        file_header += "--" + boundary + "\r\n";
-        file_header += "Content-Disposition: form-data; name=\"file\"; filename=\"camera.jpg\"\r\n";
-        file_header += "Content-Type: image/jpeg\r\n";
-        file_header += "\r\n";
-        http->Write(file_header.c_str(), file_header.size());
+        ESP_LOGW(TAG, "Hardware JPEG encoding failed, fallback to software");
     }
+#endif
+    return uploader_.Explain((const uint8_t*)fb_->data, fb_->recv_len, fb_->width, fb_->height, PIXFORMAT_RGB565, question);
+}
 
-    // 第三块：JPEG数据
-    size_t total_sent = 0;
-    while (true) {
-        JpegChunk chunk;
-        if (xQueueReceive(jpeg_queue, &chunk, portMAX_DELAY) != pdPASS) {
-            ESP_LOGE(TAG, "Failed to receive JPEG chunk");
-            break;
-        }
-        if (chunk.data == nullptr) {
-            break; // The last chunk
-        }
-        http->Write((const char*)chunk.data, chunk.len);
-        total_sent += chunk.len;
-        heap_caps_free(chunk.data);
+#if SOC_JPEG_CODEC_SUPPORTED
+/**
+ * @brief 使用 P4 硬件 JPEG 编码器编码整帧后上传
+ *
+ * 先用 PPA 按上行速度缩小并交换为小端 RGB565，再由硬件编码，一帧只需几毫秒，不再需要编码线程；
+ * 编码结果保留在内存中，上传失败时直接重传。没有 PPA 或编码失败时返回 false，调用者回退到软件编码。
+ */
+bool WicCamera::ExplainWithHardwareJpeg(const std::string& question, std::string& result) {
+#if SOC_PPA_SUPPORTED
+    if (ppa_srm_ == nullptr) {
+        return false;
     }
-    // Wait for the encoder thread to finish
-    encoder_thread_.join();
-    // 清理队列
-    vQueueDelete(jpeg_queue);
+    int scale, quality;
+    uploader_.ChooseEncoding(scale, quality);
 
-    {
-        // 第四块：multipart尾部
-        std::string multipart_footer;
-        multipart_footer += "\r\n--" + boundary + "--\r\n";
-        http->Write(multipart_footer.c_str(), multipart_footer.size());
+    int64_t start_time = esp_timer_get_time();
+    int scale_steps = PPA_SCALE_STEP / std::max(scale, 1);
+    int width = fb_->width * scale_steps / PPA_SCALE_STEP;
+    int height = fb_->height * scale_steps / PPA_SCALE_STEP;
+    size_t frame_buffer_size;
+    auto frame = TransformWithPpa(scale_steps, PPA_SRM_ROTATION_ANGLE_0, width, height, frame_buffer_size);
+    if (frame == nullptr) {
+        return false;
     }
-    // 结束块
-    http->Write("", 0);
+    size_t frame_size = (size_t)width * height * 2;
 
-    if (http->GetStatusCode() != 200) {
-        ESP_LOGE(TAG, "Failed to upload photo, status code: %d, jpeg_size: %u", http->GetStatusCode(), total_sent);
-        return "{\"success\": false, \"message\": \"Failed to upload photo\"}";
+    jpeg_encode_memory_alloc_cfg_t mem_cfg = {
+        .buffer_direction = JPEG_ENC_ALLOC_OUTPUT_BUFFER,
+    };
+    size_t jpeg_buffer_size = 0;
+    // RGB565 压缩后通常远小于原图的一半
+    auto jpeg_buffer = (uint8_t*)jpeg_alloc_encoder_mem(frame_size / 2, &mem_cfg, &jpeg_buffer_size);
+    if (jpeg_buffer == nullptr) {
+        ESP_LOGE(TAG, "Failed to allocate JPEG output buffer");
+        heap_caps_free(frame);
+        return false;
     }
 
-    std::string result = http->ReadAll();
-    http->Close();
+    jpeg_encode_cfg_t encode_cfg = {
+        .height = (uint32_t)height,
+        .width = (uint32_t)width,
+        .src_type = JPEG_ENCODE_IN_FORMAT_RGB565,
+        .sub_sample = JPEG_DOWN_SAMPLING_YUV420,
+        .image_quality = (uint32_t)quality,
+    };
+    uint32_t jpeg_size = 0;
+    esp_err_t err = jpeg_encoder_process(jpeg_encoder_, &encode_cfg, (const uint8_t*)frame, frame_size,
+        jpeg_buffer, jpeg_buffer_size, &jpeg_size);
+    heap_caps_free(frame);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Hardware JPEG encode failed: %s", esp_err_to_name(err));
+        heap_caps_free(jpeg_buffer);
+        return false;
+    }
 
-    // Get remain task stack size
-    size_t remain_stack_size = uxTaskGetStackHighWaterMark(nullptr);
-    ESP_LOGI(TAG, "Explain image size=%dx%d, compressed size=%d, remain stack size=%d, question=%s\n%s",
-        WIC_CAM_CSI_HRES, WIC_CAM_CSI_VRES, total_sent, remain_stack_size, question.c_str(), result.c_str());
-    return result;
+    result = uploader_.ExplainJpeg(jpeg_buffer, jpeg_size, width, height, quality,
+        esp_timer_get_time() - start_time, question);
+    heap_caps_free(jpeg_buffer);
+    return true;
+#else
+    // 没有 PPA 时交给软件编码，它会处理缩小和字节序
+    return false;
+#endif
 }
+#endif
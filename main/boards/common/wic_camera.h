@@ -3,30 +3,40 @@
 
 #include <esp_camera.h>
 #include <lvgl.h>
-#include <thread>
 #include <memory>
 
-#include <freertos/FreeRTOS.h>
-#include <freertos/queue.h>
+#include <soc/soc_caps.h>
+#if SOC_JPEG_CODEC_SUPPORTED
+#include <driver/jpeg_encode.h>
+#endif
+#if SOC_PPA_SUPPORTED
+#include <driver/ppa.h>
+#endif
 
 #include "camera.h"
 #include "wic_cam_sensor.h"
-
-struct JpegChunk {
-    uint8_t* data;
-    size_t len;
-};
+#include "explain_uploader.h"
 
 class WicCamera : public Camera {
 private:
     wic_cam_img_buf_t* fb_ = nullptr;
-    lv_img_dsc_t preview_image_;
-    std::string explain_url_;
-    std::string explain_token_;
-    std::thread encoder_thread_;
+    ExplainUploader uploader_;
+    int preview_rotation_;
+#if SOC_PPA_SUPPORTED
+    ppa_client_handle_t ppa_srm_ = nullptr;
+
+    void* TransformWithPpa(int scale_steps, ppa_srm_rotation_angle_t rotation, int width, int height, size_t& buffer_size);
+    lv_img_dsc_t* CreatePreviewImageWithPpa(int max_width, int max_height);
+#endif
+#if SOC_JPEG_CODEC_SUPPORTED
+    jpeg_encoder_handle_t jpeg_encoder_ = nullptr;
+
+    bool ExplainWithHardwareJpeg(const std::string& question, std::string& result);
+#endif
 
 public:
-    WicCamera(i2c_master_bus_handle_t i2c_handle);
+    // preview_rotation: 0, 90, 180 or 270 degrees, only applied when the preview is made by the PPA
+    WicCamera(i2c_master_bus_handle_t i2c_handle, wic_cam_fmt_t format = WIC_CAM_FMT_DEFAULT, int preview_rotation = 0);
     ~WicCamera();
 
     virtual void SetExplainUrl(const std::string& url, const std::string& token);
@@ -2,6 +2,7 @@
 
 #include "display.h"
 #include "application.h"
+#include "system_profiler.h"
 #include "system_info.h"
 #include "font_awesome_symbols.h"
 #include "settings.h"
@@ -56,7 +57,7 @@ void WifiBoard::EnterWifiConfigMode() {
     // 播报配置 WiFi 的提示
     application.Alert(Lang::Strings::WIFI_CONFIG_MODE, hint.c_str(), "", Lang::Sounds::P3_WIFICONFIG);
 
-    #if USE_ACOUSTIC_WIFI_PROVISIONING
+    #if CONFIG_USE_ACOUSTIC_WIFI_PROVISIONING
     audio_wifi_config::ReceiveWifiCredentialsFromAudio(&application, &wifi_ap);
     #endif
     
@@ -89,6 +90,8 @@ void WifiBoard::StartNetwork() {
     wifi_station.OnScanBegin([this]() {
         auto display = Board::GetInstance().GetDisplay();
         display->ShowNotification(Lang::Strings::SCANNING_WIFI, 30000);
+        // A scan also starts after the connection is lost
+        Application::GetInstance().NotifyStatusBarChanged(kStatusBarNetwork);
     });
     wifi_station.OnConnect([this](const std::string& ssid) {
         auto display = Board::GetInstance().GetDisplay();
@@ -102,6 +105,7 @@ void WifiBoard::StartNetwork() {
         std::string notification = Lang::Strings::CONNECTED_TO;
         notification += ssid;
         display->ShowNotification(notification.c_str(), 30000);
+        Application::GetInstance().NotifyStatusBarChanged(kStatusBarNetwork);
     });
     wifi_station.Start();
 
@@ -213,6 +217,11 @@ std::string WifiBoard::GetDeviceStatusJson() {
      *     },
      *     "chip": {
      *         "temperature": 25
+     *     },
+     *     "system": {
+     *         "cpu_load": [35, 12],
+     *         "free_internal_heap": 81920,
+     *         "largest_internal_block": 40960
      *     }
      * }
      */
@@ -281,6 +290,12 @@ std::string WifiBoard::GetDeviceStatusJson() {
         cJSON_AddItemToObject(root, "home_ctrl", home_ctrl_properties);
     }
 
+    // System load, see self.system.get_profile for the details
+    auto system = SystemProfiler::GetInstance().GetSummaryJson();
+    if (system) {
+        cJSON_AddItemToObject(root, "system", system);
+    }
+
     auto json_str = cJSON_PrintUnformatted(root);
     std::string json(json_str);
     cJSON_free(json_str);
@@ -72,6 +72,7 @@ private:
             if (xQueueReceive(controller->action_queue_, &params, pdMS_TO_TICKS(1000)) == pdTRUE) {
                 ESP_LOGI(TAG, "执行动作: %d", params.action_type);
                 controller->is_action_in_progress_ = true;  // 开始执行动作
+                controller->electron_bot_.BeginAction();
 
                 // 执行相应的动作
                 if (params.action_type >= ACTION_HAND_LEFT_UP &&
@@ -96,6 +97,13 @@ private:
                     controller->electron_bot_.Home(true);
                 }
                 controller->is_action_in_progress_ = false;  // 动作执行完毕
+
+                auto stats = controller->electron_bot_.TakeMotionStats();
+                if (stats.ticks > 0) {
+                    ESP_LOGI(TAG, "动作完成: %lu ticks, jitter avg %lld us, max %lld us, tick max %lld us",
+                             stats.ticks, stats.total_jitter_us / stats.ticks, stats.max_jitter_us,
+                             stats.max_run_us);
+                }
             }
             vTaskDelay(pdMS_TO_TICKS(20));
         }
@@ -112,8 +120,8 @@ private:
 
     void StartActionTaskIfNeeded() {
         if (action_task_handle_ == nullptr) {
-            xTaskCreate(ActionTask, "electron_bot_action", 1024 * 4, this, configMAX_PRIORITIES - 1,
-                        &action_task_handle_);
+            // 舵机由 ServoMotion 定时器驱动，动作任务只负责排队和等待，不需要最高优先级
+            xTaskCreate(ActionTask, "electron_bot_action", 1024 * 4, this, 4, &action_task_handle_);
         }
     }
 
@@ -249,9 +257,9 @@ public:
         // 系统工具
         mcp_server.AddTool("self.electron.stop", "立即停止", PropertyList(),
                            [this](const PropertyList& properties) -> ReturnValue {
-                               // 清空队列但保持任务常驻
+                               // 清空队列并取消当前动作，动作任务保持常驻
                                xQueueReset(action_queue_);
-                               is_action_in_progress_ = false;
+                               electron_bot_.Stop();
                                QueueAction(ACTION_HOME, 1, 1000, 0, 0);
                                return true;
                            });
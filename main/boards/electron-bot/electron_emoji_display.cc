@@ -10,40 +10,46 @@
 
 #define TAG "ElectronEmojiDisplay"
 
+#if CONFIG_USE_EMOJI_ANIM
+#define EMOTION_SRC(name) (&name##_anim)
+#else
+#define EMOTION_SRC(name) (&name)
+#endif
+
 // 表情映射表 - 将多种表情映射到现有6个GIF
 const ElectronEmojiDisplay::EmotionMap ElectronEmojiDisplay::emotion_maps_[] = {
     // 中性/平静类表情 -> staticstate
-    {"neutral", &staticstate},
-    {"relaxed", &staticstate},
-    {"sleepy", &staticstate},
+    {"neutral", EMOTION_SRC(staticstate)},
+    {"relaxed", EMOTION_SRC(staticstate)},
+    {"sleepy", EMOTION_SRC(staticstate)},
 
     // 积极/开心类表情 -> happy
-    {"happy", &happy},
-    {"laughing", &happy},
-    {"funny", &happy},
-    {"loving", &happy},
-    {"confident", &happy},
-    {"winking", &happy},
-    {"cool", &happy},
-    {"delicious", &happy},
-    {"kissy", &happy},
-    {"silly", &happy},
+    {"happy", EMOTION_SRC(happy)},
+    {"laughing", EMOTION_SRC(happy)},
+    {"funny", EMOTION_SRC(happy)},
+    {"loving", EMOTION_SRC(happy)},
+    {"confident", EMOTION_SRC(happy)},
+    {"winking", EMOTION_SRC(happy)},
+    {"cool", EMOTION_SRC(happy)},
+    {"delicious", EMOTION_SRC(happy)},
+    {"kissy", EMOTION_SRC(happy)},
+    {"silly", EMOTION_SRC(happy)},
 
     // 悲伤类表情 -> sad
-    {"sad", &sad},
-    {"crying", &sad},
+    {"sad", EMOTION_SRC(sad)},
+    {"crying", EMOTION_SRC(sad)},
 
     // 愤怒类表情 -> anger
-    {"angry", &anger},
+    {"angry", EMOTION_SRC(anger)},
 
     // 惊讶类表情 -> scare
-    {"surprised", &scare},
-    {"shocked", &scare},
+    {"surprised", EMOTION_SRC(scare)},
+    {"shocked", EMOTION_SRC(scare)},
 
     // 思考/困惑类表情 -> buxue
-    {"thinking", &buxue},
-    {"confused", &buxue},
-    {"embarrassed", &buxue},
+    {"thinking", EMOTION_SRC(buxue)},
+    {"confused", EMOTION_SRC(buxue)},
+    {"embarrassed", EMOTION_SRC(buxue)},
 
     {nullptr, nullptr}  // 结束标记
 };
@@ -85,13 +91,18 @@ void ElectronEmojiDisplay::SetupGifContainer() {
     lv_obj_set_style_border_width(emotion_label_, 0, 0);
     lv_obj_add_flag(emotion_label_, LV_OBJ_FLAG_HIDDEN);
 
+#if CONFIG_USE_EMOJI_ANIM
+    emotion_player_ = std::make_unique<EmojiAnimPlayer>(content_);
+    emotion_gif_ = emotion_player_->object();
+#else
     emotion_gif_ = lv_gif_create(content_);
     int gif_size = LV_HOR_RES;
     lv_obj_set_size(emotion_gif_, gif_size, gif_size);
     lv_obj_set_style_border_width(emotion_gif_, 0, 0);
     lv_obj_set_style_bg_opa(emotion_gif_, LV_OPA_TRANSP, 0);
     lv_obj_center(emotion_gif_);
-    lv_gif_set_src(emotion_gif_, &staticstate);
+#endif
+    ShowEmotion(EMOTION_SRC(staticstate));
 
     chat_message_label_ = lv_label_create(content_);
     lv_label_set_text(chat_message_label_, "");
@@ -119,16 +130,24 @@ void ElectronEmojiDisplay::SetEmotion(const char* emotion) {
 
     for (const auto& map : emotion_maps_) {
         if (map.name && strcmp(map.name, emotion) == 0) {
-            lv_gif_set_src(emotion_gif_, map.gif);
+            ShowEmotion(map.gif);
             ESP_LOGI(TAG, "设置表情: %s", emotion);
             return;
         }
     }
 
-    lv_gif_set_src(emotion_gif_, &staticstate);
+    ShowEmotion(EMOTION_SRC(staticstate));
     ESP_LOGI(TAG, "未知表情'%s'，使用默认", emotion);
 }
 
+void ElectronEmojiDisplay::ShowEmotion(const EmotionSource* source) {
+#if CONFIG_USE_EMOJI_ANIM
+    emotion_player_->Play(source);
+#else
+    lv_gif_set_src(emotion_gif_, source);
+#endif
+}
+
 void ElectronEmojiDisplay::SetChatMessage(const char* role, const char* content) {
     DisplayLockGuard lock(this);
     if (chat_message_label_ == nullptr) {
@@ -2,7 +2,10 @@
 
 #include <libs/gif/lv_gif.h>
 
+#include <memory>
+
 #include "display/lcd_display.h"
+#include "display/emoji_anim.h"
 
 // Electron Bot表情GIF声明 - 使用与Otto相同的6个表情
 LV_IMAGE_DECLARE(staticstate);  // 静态状态/中性表情
@@ -12,6 +15,16 @@ LV_IMAGE_DECLARE(scare);        // 惊吓/惊讶
 LV_IMAGE_DECLARE(buxue);        // 不学/困惑
 LV_IMAGE_DECLARE(anger);        // 愤怒
 
+#if CONFIG_USE_EMOJI_ANIM
+// 预转换表情动画，由 scripts/Emoji_Converter/gif_to_anim.py 生成
+EMOJI_ANIM_DECLARE(staticstate_anim);
+EMOJI_ANIM_DECLARE(sad_anim);
+EMOJI_ANIM_DECLARE(happy_anim);
+EMOJI_ANIM_DECLARE(scare_anim);
+EMOJI_ANIM_DECLARE(buxue_anim);
+EMOJI_ANIM_DECLARE(anger_anim);
+#endif
+
 /**
  * @brief Electron Bot GIF表情显示类
  * 继承LcdDisplay，添加GIF表情支持
@@ -39,13 +52,21 @@ public:
 private:
     void SetupGifContainer();
 
+#if CONFIG_USE_EMOJI_ANIM
+    using EmotionSource = emoji_anim_dsc_t;
+    std::unique_ptr<EmojiAnimPlayer> emotion_player_;  ///< 预转换表情动画播放器
+#else
+    using EmotionSource = lv_img_dsc_t;
+#endif
     lv_obj_t* emotion_gif_;  ///< GIF表情组件
 
     // 表情映射
     struct EmotionMap {
         const char* name;
-        const lv_image_dsc_t* gif;
+        const EmotionSource* gif;
     };
 
+    void ShowEmotion(const EmotionSource* source);
+
     static const EmotionMap emotion_maps_[];
 };
\ No newline at end of file
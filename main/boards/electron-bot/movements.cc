@@ -7,7 +7,11 @@
 
 static const char* TAG = "Movements";
 
-Otto::Otto() {
+Otto::Otto() : motion_(SERVO_COUNT, [this](int servo, int position) {
+    if (servo_pins_[servo] != -1) {
+        servo_[servo].SetPosition(position);
+    }
+}) {
     is_otto_resting_ = false;
     for (int i = 0; i < SERVO_COUNT; i++) {
         servo_pins_[i] = -1;
@@ -81,54 +85,16 @@ void Otto::MoveServos(int time, int servo_target[]) {
     if (GetRestState() == true) {
         SetRestState(false);
     }
-
-    final_time_ = millis() + time;
-    if (time > 10) {
-        for (int i = 0; i < SERVO_COUNT; i++) {
-            if (servo_pins_[i] != -1) {
-                increment_[i] = (servo_target[i] - servo_[i].GetPosition()) / (time / 10.0);
-            }
-        }
-
-        for (int iteration = 1; millis() < final_time_; iteration++) {
-            partial_time_ = millis() + 10;
-            for (int i = 0; i < SERVO_COUNT; i++) {
-                if (servo_pins_[i] != -1) {
-                    servo_[i].SetPosition(servo_[i].GetPosition() + increment_[i]);
-                }
-            }
-            vTaskDelay(pdMS_TO_TICKS(10));
-        }
-    } else {
-        for (int i = 0; i < SERVO_COUNT; i++) {
-            if (servo_pins_[i] != -1) {
-                servo_[i].SetPosition(servo_target[i]);
-            }
-        }
-        vTaskDelay(pdMS_TO_TICKS(time));
+    if (motion_.epoch() != action_epoch_) {
+        return;
     }
 
-    // final adjustment to the target.
-    bool f = true;
-    int adjustment_count = 0;
-    while (f && adjustment_count < 10) {
-        f = false;
-        for (int i = 0; i < SERVO_COUNT; i++) {
-            if (servo_pins_[i] != -1 && servo_target[i] != servo_[i].GetPosition()) {
-                f = true;
-                break;
-            }
-        }
-        if (f) {
-            for (int i = 0; i < SERVO_COUNT; i++) {
-                if (servo_pins_[i] != -1) {
-                    servo_[i].SetPosition(servo_target[i]);
-                }
-            }
-            vTaskDelay(pdMS_TO_TICKS(10));
-            adjustment_count++;
-        }
-    };
+    int target[SERVO_COUNT];
+    for (int i = 0; i < SERVO_COUNT; i++) {
+        target[i] = servo_pins_[i] != -1 ? servo_target[i] : -1;
+    }
+    motion_.QueueMove(target, time);
+    WaitMotion();
 }
 
 void Otto::MoveSingle(int position, int servo_number) {
@@ -142,33 +108,24 @@ void Otto::MoveSingle(int position, int servo_number) {
     }
 
     if (servo_number >= 0 && servo_number < SERVO_COUNT && servo_pins_[servo_number] != -1) {
-        servo_[servo_number].SetPosition(position);
+        int target[SERVO_COUNT] = {-1, -1, -1, -1, -1, -1};
+        target[servo_number] = position;
+        motion_.QueueMove(target, 0);
     }
 }
 
 void Otto::OscillateServos(int amplitude[SERVO_COUNT], int offset[SERVO_COUNT], int period,
                            double phase_diff[SERVO_COUNT], float cycle = 1) {
-    for (int i = 0; i < SERVO_COUNT; i++) {
-        if (servo_pins_[i] != -1) {
-            servo_[i].SetO(offset[i]);
-            servo_[i].SetA(amplitude[i]);
-            servo_[i].SetT(period);
-            servo_[i].SetPh(phase_diff[i]);
-        }
+    if (motion_.epoch() != action_epoch_) {
+        return;
     }
 
-    double ref = millis();
-    double end_time = period * cycle + ref;
-
-    while (millis() < end_time) {
-        for (int i = 0; i < SERVO_COUNT; i++) {
-            if (servo_pins_[i] != -1) {
-                servo_[i].Refresh();
-            }
-        }
-        vTaskDelay(5);
+    int center[SERVO_COUNT];
+    for (int i = 0; i < SERVO_COUNT; i++) {
+        center[i] = offset[i] + 90;
     }
-    vTaskDelay(pdMS_TO_TICKS(10));
+    motion_.QueueOscillation(amplitude, center, phase_diff, period, cycle);
+    WaitMotion();
 }
 
 void Otto::Execute(int amplitude[SERVO_COUNT], int offset[SERVO_COUNT], int period,
@@ -177,16 +134,32 @@ void Otto::Execute(int amplitude[SERVO_COUNT], int offset[SERVO_COUNT], int peri
         SetRestState(false);
     }
 
-    int cycles = (int)steps;
+    //-- All the cycles, including the final not complete one, in one oscillation
+    OscillateServos(amplitude, offset, period, phase_diff, steps);
+}
 
-    //-- Execute complete cycles
-    if (cycles >= 1)
-        for (int i = 0; i < cycles; i++)
-            OscillateServos(amplitude, offset, period, phase_diff);
+void Otto::Pause(int time) {
+    if (motion_.epoch() != action_epoch_) {
+        return;
+    }
+    motion_.QueueHold(time);
+    WaitMotion();
+}
+
+bool Otto::WaitMotion() {
+    return motion_.WaitIdle(action_epoch_);
+}
+
+void Otto::BeginAction() {
+    action_epoch_ = motion_.epoch();
+}
+
+void Otto::Stop() {
+    motion_.Cancel();
+}
 
-    //-- Execute the final not complete cycle
-    OscillateServos(amplitude, offset, period, phase_diff, (float)steps - cycles);
-    vTaskDelay(pdMS_TO_TICKS(10));
+ServoMotionStats Otto::TakeMotionStats() {
+    return motion_.TakeStats();
 }
 
 ///////////////////////////////////////////////////////////////////
@@ -195,10 +168,11 @@ void Otto::Execute(int amplitude[SERVO_COUNT], int offset[SERVO_COUNT], int peri
 void Otto::Home(bool hands_down) {
     if (is_otto_resting_ == false) {  // Go to rest position only if necessary
         MoveServos(1000, servo_initial_);
-        is_otto_resting_ = true;
+        // Not at rest if the move was cancelled on the way
+        is_otto_resting_ = motion_.epoch() == action_epoch_;
     }
 
-    vTaskDelay(pdMS_TO_TICKS(1000));
+    Pause(1000);
 }
 
 bool Otto::GetRestState() {
@@ -230,7 +204,7 @@ void Otto::HandAction(int action, int times, int amount, int period) {
 
     int current_positions[SERVO_COUNT];
     for (int i = 0; i < SERVO_COUNT; i++) {
-        current_positions[i] = (servo_pins_[i] != -1) ? servo_[i].GetPosition() : servo_initial_[i];
+        current_positions[i] = (servo_pins_[i] != -1) ? motion_.GetPosition(i) : servo_initial_[i];
     }
 
     switch (action) {
@@ -264,7 +238,7 @@ void Otto::HandAction(int action, int times, int amount, int period) {
             for (int i = 0; i < times; i++) {
                 current_positions[LEFT_PITCH] = 150 + (i % 2 == 0 ? -30 : 30);
                 MoveServos(period / 10, current_positions);
-                vTaskDelay(pdMS_TO_TICKS(period / 10));
+                Pause(period / 10);
             }
             memcpy(current_positions, servo_initial_, sizeof(current_positions));
             MoveServos(period, current_positions);
@@ -276,7 +250,7 @@ void Otto::HandAction(int action, int times, int amount, int period) {
             for (int i = 0; i < times; i++) {
                 current_positions[RIGHT_PITCH] = 30 + (i % 2 == 0 ? 30 : -30);
                 MoveServos(period / 10, current_positions);
-                vTaskDelay(pdMS_TO_TICKS(period / 10));
+                Pause(period / 10);
             }
             memcpy(current_positions, servo_initial_, sizeof(current_positions));
             MoveServos(period, current_positions);
@@ -290,7 +264,7 @@ void Otto::HandAction(int action, int times, int amount, int period) {
                 current_positions[LEFT_PITCH] = 150 + (i % 2 == 0 ? -30 : 30);
                 current_positions[RIGHT_PITCH] = 30 + (i % 2 == 0 ? 30 : -30);
                 MoveServos(period / 10, current_positions);
-                vTaskDelay(pdMS_TO_TICKS(period / 10));
+                Pause(period / 10);
             }
             memcpy(current_positions, servo_initial_, sizeof(current_positions));
             MoveServos(period, current_positions);
@@ -358,7 +332,7 @@ void Otto::BodyAction(int action, int times, int amount, int period) {
     int current_positions[SERVO_COUNT];
     for (int i = 0; i < SERVO_COUNT; i++) {
         if (servo_pins_[i] != -1) {
-            current_positions[i] = servo_[i].GetPosition();
+            current_positions[i] = motion_.GetPosition(i);
         } else {
             current_positions[i] = servo_initial_[i];
         }
@@ -385,7 +359,7 @@ void Otto::BodyAction(int action, int times, int amount, int period) {
 
     current_positions[BODY] = target_angle;
     MoveServos(period, current_positions);
-    vTaskDelay(pdMS_TO_TICKS(100));
+    Pause(100);
 }
 
 //---------------------------------------------------------
@@ -405,7 +379,7 @@ void Otto::HeadAction(int action, int times, int amount, int period) {
     int current_positions[SERVO_COUNT];
     for (int i = 0; i < SERVO_COUNT; i++) {
         if (servo_pins_[i] != -1) {
-            current_positions[i] = servo_[i].GetPosition();
+            current_positions[i] = motion_.GetPosition(i);
         } else {
             current_positions[i] = servo_initial_[i];
         }
@@ -428,12 +402,12 @@ void Otto::HeadAction(int action, int times, int amount, int period) {
             // 先抬头
             current_positions[HEAD] = head_center + amount;
             MoveServos(period / 3, current_positions);
-            vTaskDelay(pdMS_TO_TICKS(period / 6));
+            Pause(period / 6);
 
             // 再低头
             current_positions[HEAD] = head_center - amount;
             MoveServos(period / 3, current_positions);
-            vTaskDelay(pdMS_TO_TICKS(period / 6));
+            Pause(period / 6);
 
             // 回到中心
             current_positions[HEAD] = head_center;
@@ -455,7 +429,7 @@ void Otto::HeadAction(int action, int times, int amount, int period) {
                 current_positions[HEAD] = head_center - amount;
                 MoveServos(period / 2, current_positions);
 
-                vTaskDelay(pdMS_TO_TICKS(50));  // 短暂停顿
+                Pause(50);  // 短暂停顿
             }
 
             // 回到中心
@@ -7,6 +7,7 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "oscillator.h"
+#include "servo_motion.h"
 
 //-- Constants
 #define FORWARD 1
@@ -51,6 +52,13 @@ public:
     void OscillateServos(int amplitude[SERVO_COUNT], int offset[SERVO_COUNT], int period,
                          double phase_diff[SERVO_COUNT], float cycle);
 
+    //-- Motions are played by ServoMotion, the calls below wait for them to finish.
+    //-- BeginAction marks the start of an action, Stop cancels it from any task and
+    //-- makes the remaining calls of the action return at once.
+    void BeginAction();
+    void Stop();
+    ServoMotionStats TakeMotionStats();
+
     //-- HOME = Otto at rest position
     void Home(bool hands_down = true);
     bool GetRestState();
@@ -76,14 +84,15 @@ private:
     int servo_trim_[SERVO_COUNT];
     int servo_initial_[SERVO_COUNT] = {180, 180, 0, 0, 90, 90};
 
-    unsigned long final_time_;
-    unsigned long partial_time_;
-    float increment_[SERVO_COUNT];
+    ServoMotion motion_;
+    uint32_t action_epoch_ = 0;
 
     bool is_otto_resting_;
 
     void Execute(int amplitude[SERVO_COUNT], int offset[SERVO_COUNT], int period,
                  double phase_diff[SERVO_COUNT], float steps);
+    void Pause(int time);
+    bool WaitMotion();
 };
 
 #endif  // __MOVEMENTS_H__
\ No newline at end of file
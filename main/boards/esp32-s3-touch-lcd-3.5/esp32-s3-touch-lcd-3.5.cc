@@ -111,12 +111,30 @@ class CustomBoard : public WifiBoard {
 private:
     Button boot_button_;
     Pmic* pmic_ = nullptr;
+    PowerTelemetry* power_telemetry_ = nullptr;
     i2c_master_bus_handle_t i2c_bus_;
     esp_io_expander_handle_t io_expander = NULL;
     LcdDisplay* display_;
     PowerSaveTimer* power_save_timer_;
     Esp32Camera* camera_;
 
+    void InitializePowerTelemetry() {
+        power_telemetry_ = new PowerTelemetry([this](PowerTelemetry::SampleDone done) {
+            pmic_->ReadTelemetryAsync(done);
+        });
+        power_telemetry_->OnEvent([this](PowerEvent event, const PowerSnapshot& power) {
+            // Every event changes the battery icon
+            Application::GetInstance().NotifyStatusBarChanged(kStatusBarBattery);
+            if (event == kPowerEventDischargingChanged) {
+                bool discharging = power.discharging;
+                Application::GetInstance().Schedule([this, discharging]() {
+                    power_save_timer_->SetEnabled(discharging);
+                });
+            }
+        });
+        power_telemetry_->Start();
+    }
+
     void InitializePowerSaveTimer() {
         power_save_timer_ = new PowerSaveTimer(-1, 60, 300);
         power_save_timer_->OnEnterSleepMode([this]() {
@@ -345,6 +363,7 @@ public:
         InitializeI2c();
         InitializeTca9554();
         InitializeAxp2101();
+        InitializePowerTelemetry();
         InitializeSpi();
         InitializeLcdDisplay();
         // 解决部分开机黑屏的问题
@@ -374,16 +393,19 @@ public:
         static PwmBacklight backlight(DISPLAY_BACKLIGHT_PIN, DISPLAY_BACKLIGHT_OUTPUT_INVERT);
         return &backlight;
     }
+    virtual uint32_t GetStatusBarEvents() override {
+        // PowerTelemetry notifies every battery change
+        return kStatusBarBattery;
+    }
+
     virtual bool GetBatteryLevel(int &level, bool& charging, bool& discharging) override {
-        static bool last_discharging = false;
-        charging = pmic_->IsCharging();
-        discharging = pmic_->IsDischarging();
-        if (discharging != last_discharging) {
-            power_save_timer_->SetEnabled(discharging);
-            last_discharging = discharging;
+        PowerSnapshot power;
+        if (!power_telemetry_->GetSnapshot(power)) {
+            return false;
         }
-
-        level = pmic_->GetBatteryLevel();
+        charging = power.charging;
+        discharging = power.discharging;
+        level = power.level;
         return true;
     }
 
@@ -20,6 +20,7 @@
 #include "power_manager.h"
 #include "power_controller.h"
 #include "gpio_manager.h"
+#include "settings.h"
 #include <driver/rtc_io.h>
 #include <esp_sleep.h>
 
@@ -77,6 +78,7 @@ private:
                 ESP_ERROR_CHECK(esp_sleep_enable_ext0_wakeup(PWR_BUTTON_GPIO, 0));
                 ESP_ERROR_CHECK(rtc_gpio_pullup_en(PWR_BUTTON_GPIO));  // 内部上拉
                 ESP_ERROR_CHECK(rtc_gpio_pulldown_dis(PWR_BUTTON_GPIO));
+                Settings::Flush();  // 深度睡眠会丢掉内存中未写入的设置
                 esp_deep_sleep_start();
             }
         }
@@ -197,6 +199,8 @@ private:
             switch(newState) {
                 case PowerController::PowerState::SHUTDOWN: {
                     ESP_LOGI(TAG, "Entering shutdown sequence");
+                    // 断电或深度睡眠前写入未保存的设置
+                    Settings::Flush();
                     
                     // 统一唤醒触发条件
                     #ifndef __USER_GPIO_PWRDOWN__
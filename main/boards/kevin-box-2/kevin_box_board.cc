@@ -60,11 +60,29 @@ private:
     esp_lcd_panel_handle_t panel_ = nullptr;
     Display* display_ = nullptr;
     Pmic* pmic_ = nullptr;
+    PowerTelemetry* power_telemetry_ = nullptr;
     Button boot_button_;
     Button volume_up_button_;
     Button volume_down_button_;
     PowerSaveTimer* power_save_timer_;
 
+    void InitializePowerTelemetry() {
+        power_telemetry_ = new PowerTelemetry([this](PowerTelemetry::SampleDone done) {
+            pmic_->ReadTelemetryAsync(done);
+        });
+        power_telemetry_->OnEvent([this](PowerEvent event, const PowerSnapshot& power) {
+            // Every event changes the battery icon
+            Application::GetInstance().NotifyStatusBarChanged(kStatusBarBattery);
+            if (event == kPowerEventDischargingChanged) {
+                bool discharging = power.discharging;
+                Application::GetInstance().Schedule([this, discharging]() {
+                    power_save_timer_->SetEnabled(discharging);
+                });
+            }
+        });
+        power_telemetry_->Start();
+    }
+
     void InitializePowerSaveTimer() {
         power_save_timer_ = new PowerSaveTimer(-1, -1, 600);
         power_save_timer_->OnShutdownRequest([this]() {
@@ -250,6 +268,7 @@ public:
 
         InitializeButtons();
         InitializePowerSaveTimer();
+        InitializePowerTelemetry();
         InitializeIot();
     }
 
@@ -269,16 +288,19 @@ public:
         return display_;
     }
 
+    virtual uint32_t GetStatusBarEvents() override {
+        // PowerTelemetry notifies every battery change
+        return kStatusBarBattery;
+    }
+
     virtual bool GetBatteryLevel(int &level, bool& charging, bool& discharging) override {
-        static bool last_discharging = false;
-        charging = pmic_->IsCharging();
-        discharging = pmic_->IsDischarging();
-        if (discharging != last_discharging) {
-            power_save_timer_->SetEnabled(discharging);
-            last_discharging = discharging;
+        PowerSnapshot power;
+        if (!power_telemetry_->GetSnapshot(power)) {
+            return false;
         }
-
-        level = pmic_->GetBatteryLevel();
+        charging = power.charging;
+        discharging = power.discharging;
+        level = power.level;
         return true;
     }
 };
@@ -74,12 +74,30 @@ private:
     i2c_master_bus_handle_t i2c_bus_;
     Cst816x *cst816d_;
     Pmic* pmic_;
+    PowerTelemetry* power_telemetry_ = nullptr;
     LcdDisplay *display_;
     Button boot_button_;
     Button key1_button_;
     PowerSaveTimer* power_save_timer_;
     Esp32Camera* camera_;
 
+    void InitializePowerTelemetry() {
+        power_telemetry_ = new PowerTelemetry([this](PowerTelemetry::SampleDone done) {
+            pmic_->ReadTelemetryAsync(done);
+        });
+        power_telemetry_->OnEvent([this](PowerEvent event, const PowerSnapshot& power) {
+            // Every event changes the battery icon
+            Application::GetInstance().NotifyStatusBarChanged(kStatusBarBattery);
+            if (event == kPowerEventDischargingChanged) {
+                bool discharging = power.discharging;
+                Application::GetInstance().Schedule([this, discharging]() {
+                    power_save_timer_->SetEnabled(discharging);
+                });
+            }
+        });
+        power_telemetry_->Start();
+    }
+
     void InitializePowerSaveTimer() {
         power_save_timer_ = new PowerSaveTimer(-1, 60, -1);
         power_save_timer_->OnEnterSleepMode([this]() {
@@ -282,6 +300,7 @@ public:
         InitializePowerSaveTimer();
         InitI2c();
         InitSy6970();
+        InitializePowerTelemetry();
         InitCst816d();
         I2cDetect();
         InitSpi();
@@ -317,17 +336,19 @@ public:
         return display_;
     }
 
+    virtual uint32_t GetStatusBarEvents() override {
+        // PowerTelemetry notifies every battery change
+        return kStatusBarBattery;
+    }
+
     virtual bool GetBatteryLevel(int &level, bool& charging, bool& discharging) override {
-        static bool last_discharging = false;
-        charging = pmic_->IsCharging();
-        bool is_power_good = pmic_->IsPowerGood();
-        discharging = !charging && is_power_good;
-        if (discharging != last_discharging) {
-            power_save_timer_->SetEnabled(discharging);
-            last_discharging = discharging;
+        PowerSnapshot power;
+        if (!power_telemetry_->GetSnapshot(power)) {
+            return false;
         }
-
-        level = pmic_->GetBatteryLevel();
+        charging = power.charging;
+        discharging = power.discharging;
+        level = power.level;
         return true;
     }
 
@@ -129,6 +129,7 @@ class M5StackCoreS3Board : public WifiBoard {
 private:
     i2c_master_bus_handle_t i2c_bus_;
     Pmic* pmic_;
+    PowerTelemetry* power_telemetry_ = nullptr;
     Aw9523* aw9523_;
     Ft6336* ft6336_;
     LcdDisplay* display_;
@@ -136,6 +137,23 @@ private:
     esp_timer_handle_t touchpad_timer_;
     PowerSaveTimer* power_save_timer_;
 
+    void InitializePowerTelemetry() {
+        power_telemetry_ = new PowerTelemetry([this](PowerTelemetry::SampleDone done) {
+            pmic_->ReadTelemetryAsync(done);
+        });
+        power_telemetry_->OnEvent([this](PowerEvent event, const PowerSnapshot& power) {
+            // Every event changes the battery icon
+            Application::GetInstance().NotifyStatusBarChanged(kStatusBarBattery);
+            if (event == kPowerEventDischargingChanged) {
+                bool discharging = power.discharging;
+                Application::GetInstance().Schedule([this, discharging]() {
+                    power_save_timer_->SetEnabled(discharging);
+                });
+            }
+        });
+        power_telemetry_->Start();
+    }
+
     void InitializePowerSaveTimer() {
         power_save_timer_ = new PowerSaveTimer(-1, 60, 300);
         power_save_timer_->OnEnterSleepMode([this]() {
@@ -355,6 +373,7 @@ public:
         InitializePowerSaveTimer();
         InitializeI2c();
         InitializeAxp2101();
+        InitializePowerTelemetry();
         InitializeAw9523();
         I2cDetect();
         InitializeSpi();
@@ -388,16 +407,19 @@ public:
         return camera_;
     }
 
+    virtual uint32_t GetStatusBarEvents() override {
+        // PowerTelemetry notifies every battery change
+        return kStatusBarBattery;
+    }
+
     virtual bool GetBatteryLevel(int &level, bool& charging, bool& discharging) override {
-        static bool last_discharging = false;
-        charging = pmic_->IsCharging();
-        discharging = pmic_->IsDischarging();
-        if (discharging != last_discharging) {
-            power_save_timer_->SetEnabled(discharging);
-            last_discharging = discharging;
+        PowerSnapshot power;
+        if (!power_telemetry_->GetSnapshot(power)) {
+            return false;
         }
-
-        level = pmic_->GetBatteryLevel();
+        charging = power.charging;
+        discharging = power.discharging;
+        level = power.level;
         return true;
     }
 
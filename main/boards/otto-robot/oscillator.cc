@@ -17,20 +17,7 @@ Oscillator::Oscillator(int trim) {
     diff_limit_ = 0;
     is_attached_ = false;
 
-    sampling_period_ = 30;
-    period_ = 2000;
-    number_samples_ = period_ / sampling_period_;
-    inc_ = 2 * M_PI / number_samples_;
-
-    amplitude_ = 45;
-    phase_ = 0;
-    phase0_ = 0;
-    offset_ = 0;
-    stop_ = false;
-    rev_ = false;
-
     pos_ = 90;
-    previous_millis_ = 0;
 }
 
 Oscillator::~Oscillator() {
@@ -43,24 +30,12 @@ uint32_t Oscillator::AngleToCompare(int angle) {
            SERVO_MIN_PULSEWIDTH_US;
 }
 
-bool Oscillator::NextSample() {
-    current_millis_ = millis();
-
-    if (current_millis_ - previous_millis_ > sampling_period_) {
-        previous_millis_ = current_millis_;
-        return true;
-    }
-
-    return false;
-}
-
-void Oscillator::Attach(int pin, bool rev) {
+void Oscillator::Attach(int pin) {
     if (is_attached_) {
         Detach();
     }
 
     pin_ = pin;
-    rev_ = rev;
 
     ledc_timer_config_t ledc_timer = {.speed_mode = LEDC_LOW_SPEED_MODE,
                                       .duty_resolution = LEDC_TIMER_13_BIT,
@@ -100,30 +75,10 @@ void Oscillator::Detach() {
     is_attached_ = false;
 }
 
-void Oscillator::SetT(unsigned int T) {
-    period_ = T;
-
-    number_samples_ = period_ / sampling_period_;
-    inc_ = 2 * M_PI / number_samples_;
-}
-
 void Oscillator::SetPosition(int position) {
     Write(position);
 }
 
-void Oscillator::Refresh() {
-    if (NextSample()) {
-        if (!stop_) {
-            int pos = std::round(amplitude_ * std::sin(phase_ + phase0_) + offset_);
-            if (rev_)
-                pos = -pos;
-            Write(pos + 90);
-        }
-
-        phase_ = phase_ + inc_;
-    }
-}
-
 void Oscillator::Write(int position) {
     if (!is_attached_)
         return;
@@ -23,55 +23,27 @@ class Oscillator {
 public:
     Oscillator(int trim = 0);
     ~Oscillator();
-    void Attach(int pin, bool rev = false);
+    void Attach(int pin);
     void Detach();
 
-    void SetA(unsigned int amplitude) { amplitude_ = amplitude; };
-    void SetO(int offset) { offset_ = offset; };
-    void SetPh(double Ph) { phase0_ = Ph; };
-    void SetT(unsigned int period);
     void SetTrim(int trim) { trim_ = trim; };
     void SetLimiter(int diff_limit) { diff_limit_ = diff_limit; };
     void DisableLimiter() { diff_limit_ = 0; };
     int GetTrim() { return trim_; };
     void SetPosition(int position);
-    void Stop() { stop_ = true; };
-    void Play() { stop_ = false; };
-    void Reset() { phase_ = 0; };
-    void Refresh();
     int GetPosition() { return pos_; }
 
 private:
-    bool NextSample();
     void Write(int position);
     uint32_t AngleToCompare(int angle);
 
 private:
     bool is_attached_;
 
-    //-- Oscillators parameters
-    unsigned int amplitude_;  //-- Amplitude (degrees)
-    int offset_;              //-- Offset (degrees)
-    unsigned int period_;     //-- Period (miliseconds)
-    double phase0_;           //-- Phase (radians)
-
     //-- Internal variables
     int pos_;                       //-- Current servo pos
     int pin_;                       //-- Pin where the servo is connected
     int trim_;                      //-- Calibration offset
-    double phase_;                  //-- Current phase
-    double inc_;                    //-- Increment of phase
-    double number_samples_;         //-- Number of samples
-    unsigned int sampling_period_;  //-- sampling period (ms)
-
-    long previous_millis_;
-    long current_millis_;
-
-    //-- Oscillation mode. If true, the servo is stopped
-    bool stop_;
-
-    //-- Reverse mode
-    bool rev_;
 
     int diff_limit_;
     long previous_servo_command_millis_;
@@ -62,6 +62,7 @@ private:
             if (xQueueReceive(controller->action_queue_, &params, pdMS_TO_TICKS(1000)) == pdTRUE) {
                 ESP_LOGI(TAG, "执行动作: %d", params.action_type);
                 controller->is_action_in_progress_ = true;
+                controller->otto_.BeginAction();
 
                 switch (params.action_type) {
                     case ACTION_WALK:
@@ -131,6 +132,13 @@ private:
                     controller->otto_.Home(params.action_type < ACTION_HANDS_UP);
                 }
                 controller->is_action_in_progress_ = false;
+
+                auto stats = controller->otto_.TakeMotionStats();
+                if (stats.ticks > 0) {
+                    ESP_LOGI(TAG, "动作完成: %lu ticks, jitter avg %lld us, max %lld us, tick max %lld us",
+                             stats.ticks, stats.total_jitter_us / stats.ticks, stats.max_jitter_us,
+                             stats.max_run_us);
+                }
                 vTaskDelay(pdMS_TO_TICKS(20));
             }
         }
@@ -138,8 +146,8 @@ private:
 
     void StartActionTaskIfNeeded() {
         if (action_task_handle_ == nullptr) {
-            xTaskCreate(ActionTask, "otto_action", 1024 * 3, this, configMAX_PRIORITIES - 1,
-                        &action_task_handle_);
+            // 舵机由 ServoMotion 定时器驱动，动作任务只负责排队和等待，不需要最高优先级
+            xTaskCreate(ActionTask, "otto_action", 1024 * 3, this, 4, &action_task_handle_);
         }
     }
 
@@ -358,12 +366,9 @@ public:
         // 系统工具
         mcp_server.AddTool("self.otto.stop", "立即停止", PropertyList(),
                            [this](const PropertyList& properties) -> ReturnValue {
-                               if (action_task_handle_ != nullptr) {
-                                   vTaskDelete(action_task_handle_);
-                                   action_task_handle_ = nullptr;
-                               }
-                               is_action_in_progress_ = false;
+                               // 清空队列并取消当前动作，动作任务保持常驻
                                xQueueReset(action_queue_);
+                               otto_.Stop();
 
                                QueueAction(ACTION_HOME, 1, 1000, 1, 0);
                                return true;
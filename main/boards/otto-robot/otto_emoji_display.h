@@ -2,9 +2,22 @@
 
 #include <libs/gif/lv_gif.h>
 
+#include <memory>
+
 #include "display/lcd_display.h"
+#include "display/emoji_anim.h"
 #include "otto_emoji_gif.h"
 
+#if CONFIG_USE_EMOJI_ANIM
+// 预转换表情动画，由 scripts/Emoji_Converter/gif_to_anim.py 生成
+EMOJI_ANIM_DECLARE(staticstate_anim);
+EMOJI_ANIM_DECLARE(sad_anim);
+EMOJI_ANIM_DECLARE(happy_anim);
+EMOJI_ANIM_DECLARE(scare_anim);
+EMOJI_ANIM_DECLARE(buxue_anim);
+EMOJI_ANIM_DECLARE(anger_anim);
+#endif
+
 /**
  * @brief Otto机器人GIF表情显示类
  * 继承LcdDisplay，添加GIF表情支持
@@ -32,13 +45,21 @@ public:
 private:
     void SetupGifContainer();
 
+#if CONFIG_USE_EMOJI_ANIM
+    using EmotionSource = emoji_anim_dsc_t;
+    std::unique_ptr<EmojiAnimPlayer> emotion_player_;  ///< 预转换表情动画播放器
+#else
+    using EmotionSource = lv_img_dsc_t;
+#endif
     lv_obj_t* emotion_gif_;  ///< GIF表情组件
 
     // 表情映射
     struct EmotionMap {
         const char* name;
-        const lv_img_dsc_t* gif;
+        const EmotionSource* gif;
     };
 
+    void ShowEmotion(const EmotionSource* source);
+
     static const EmotionMap emotion_maps_[];
 };
\ No newline at end of file
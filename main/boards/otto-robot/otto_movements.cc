@@ -8,7 +8,11 @@ static const char* TAG = "OttoMovements";
 
 #define HAND_HOME_POSITION 45
 
-Otto::Otto() {
+Otto::Otto() : motion_(SERVO_COUNT, [this](int servo, int position) {
+    if (servo_pins_[servo] != -1) {
+        servo_[servo].SetPosition(position);
+    }
+}) {
     is_otto_resting_ = false;
     has_hands_ = false;
     // 初始化所有舵机管脚为-1（未连接）
@@ -90,54 +94,16 @@ void Otto::MoveServos(int time, int servo_target[]) {
     if (GetRestState() == true) {
         SetRestState(false);
     }
-
-    final_time_ = millis() + time;
-    if (time > 10) {
-        for (int i = 0; i < SERVO_COUNT; i++) {
-            if (servo_pins_[i] != -1) {
-                increment_[i] = (servo_target[i] - servo_[i].GetPosition()) / (time / 10.0);
-            }
-        }
-
-        for (int iteration = 1; millis() < final_time_; iteration++) {
-            partial_time_ = millis() + 10;
-            for (int i = 0; i < SERVO_COUNT; i++) {
-                if (servo_pins_[i] != -1) {
-                    servo_[i].SetPosition(servo_[i].GetPosition() + increment_[i]);
-                }
-            }
-            vTaskDelay(pdMS_TO_TICKS(10));
-        }
-    } else {
-        for (int i = 0; i < SERVO_COUNT; i++) {
-            if (servo_pins_[i] != -1) {
-                servo_[i].SetPosition(servo_target[i]);
-            }
-        }
-        vTaskDelay(pdMS_TO_TICKS(time));
+    if (motion_.epoch() != action_epoch_) {
+        return;
     }
 
-    // final adjustment to the target.
-    bool f = true;
-    int adjustment_count = 0;
-    while (f && adjustment_count < 10) {
-        f = false;
-        for (int i = 0; i < SERVO_COUNT; i++) {
-            if (servo_pins_[i] != -1 && servo_target[i] != servo_[i].GetPosition()) {
-                f = true;
-                break;
-            }
-        }
-        if (f) {
-            for (int i = 0; i < SERVO_COUNT; i++) {
-                if (servo_pins_[i] != -1) {
-                    servo_[i].SetPosition(servo_target[i]);
-                }
-            }
-            vTaskDelay(pdMS_TO_TICKS(10));
-            adjustment_count++;
-        }
-    };
+    int target[SERVO_COUNT];
+    for (int i = 0; i < SERVO_COUNT; i++) {
+        target[i] = servo_pins_[i] != -1 ? servo_target[i] : -1;
+    }
+    motion_.QueueMove(target, time);
+    WaitMotion();
 }
 
 void Otto::MoveSingle(int position, int servo_number) {
@@ -151,33 +117,24 @@ void Otto::MoveSingle(int position, int servo_number) {
     }
 
     if (servo_number >= 0 && servo_number < SERVO_COUNT && servo_pins_[servo_number] != -1) {
-        servo_[servo_number].SetPosition(position);
+        int target[SERVO_COUNT] = {-1, -1, -1, -1, -1, -1};
+        target[servo_number] = position;
+        motion_.QueueMove(target, 0);
     }
 }
 
 void Otto::OscillateServos(int amplitude[SERVO_COUNT], int offset[SERVO_COUNT], int period,
                            double phase_diff[SERVO_COUNT], float cycle = 1) {
-    for (int i = 0; i < SERVO_COUNT; i++) {
-        if (servo_pins_[i] != -1) {
-            servo_[i].SetO(offset[i]);
-            servo_[i].SetA(amplitude[i]);
-            servo_[i].SetT(period);
-            servo_[i].SetPh(phase_diff[i]);
-        }
+    if (motion_.epoch() != action_epoch_) {
+        return;
     }
 
-    double ref = millis();
-    double end_time = period * cycle + ref;
-
-    while (millis() < end_time) {
-        for (int i = 0; i < SERVO_COUNT; i++) {
-            if (servo_pins_[i] != -1) {
-                servo_[i].Refresh();
-            }
-        }
-        vTaskDelay(5);
+    int center[SERVO_COUNT];
+    for (int i = 0; i < SERVO_COUNT; i++) {
+        center[i] = offset[i] + 90;
     }
-    vTaskDelay(pdMS_TO_TICKS(10));
+    motion_.QueueOscillation(amplitude, center, phase_diff, period, cycle);
+    WaitMotion();
 }
 
 void Otto::Execute(int amplitude[SERVO_COUNT], int offset[SERVO_COUNT], int period,
@@ -186,16 +143,32 @@ void Otto::Execute(int amplitude[SERVO_COUNT], int offset[SERVO_COUNT], int peri
         SetRestState(false);
     }
 
-    int cycles = (int)steps;
+    //-- All the cycles, including the final not complete one, in one oscillation
+    OscillateServos(amplitude, offset, period, phase_diff, steps);
+}
+
+void Otto::Pause(int time) {
+    if (motion_.epoch() != action_epoch_) {
+        return;
+    }
+    motion_.QueueHold(time);
+    WaitMotion();
+}
 
-    //-- Execute complete cycles
-    if (cycles >= 1)
-        for (int i = 0; i < cycles; i++)
-            OscillateServos(amplitude, offset, period, phase_diff);
+bool Otto::WaitMotion() {
+    return motion_.WaitIdle(action_epoch_);
+}
+
+void Otto::BeginAction() {
+    action_epoch_ = motion_.epoch();
+}
+
+void Otto::Stop() {
+    motion_.Cancel();
+}
 
-    //-- Execute the final not complete cycle
-    OscillateServos(amplitude, offset, period, phase_diff, (float)steps - cycles);
-    vTaskDelay(pdMS_TO_TICKS(10));
+ServoMotionStats Otto::TakeMotionStats() {
+    return motion_.TakeStats();
 }
 
 ///////////////////////////////////////////////////////////////////
@@ -216,7 +189,7 @@ void Otto::Home(bool hands_down) {
                     }
                 } else {
                     // 如果不需要复位手部，保持当前位置
-                    homes[i] = servo_[i].GetPosition();
+                    homes[i] = motion_.GetPosition(i);
                 }
             } else {
                 // 腿部和脚部舵机始终复位
@@ -225,10 +198,11 @@ void Otto::Home(bool hands_down) {
         }
 
         MoveServos(500, homes);
-        is_otto_resting_ = true;
+        // Not at rest if the move was cancelled on the way
+        is_otto_resting_ = motion_.epoch() == action_epoch_;
     }
 
-    vTaskDelay(pdMS_TO_TICKS(200));
+    Pause(200);
 }
 
 bool Otto::GetRestState() {
@@ -366,7 +340,7 @@ void Otto::Bend(int steps, int period, int dir) {
     for (int i = 0; i < steps; i++) {
         MoveServos(T2 / 2, bend1);
         MoveServos(T2 / 2, bend2);
-        vTaskDelay(pdMS_TO_TICKS(period * 0.8));
+        Pause(period * 0.8);
         MoveServos(500, homes);
     }
 }
@@ -417,7 +391,7 @@ void Otto::ShakeLeg(int steps, int period, int dir) {
         MoveServos(500, homes);  // Return to home position
     }
 
-    vTaskDelay(pdMS_TO_TICKS(period));
+    Pause(period);
 }
 
 //---------------------------------------------------------
@@ -607,10 +581,10 @@ void Otto::HandsUp(int period, int dir) {
         target[RIGHT_HAND] = 10;
     } else if (dir == 1) {
         target[LEFT_HAND] = 170;
-        target[RIGHT_HAND] = servo_[RIGHT_HAND].GetPosition();
+        target[RIGHT_HAND] = motion_.GetPosition(RIGHT_HAND);
     } else if (dir == -1) {
         target[RIGHT_HAND] = 10;
-        target[LEFT_HAND] = servo_[LEFT_HAND].GetPosition();
+        target[LEFT_HAND] = motion_.GetPosition(LEFT_HAND);
     }
 
     MoveServos(period, target);
@@ -630,9 +604,9 @@ void Otto::HandsDown(int period, int dir) {
     int target[SERVO_COUNT] = {90, 90, 90, 90, HAND_HOME_POSITION, 180 - HAND_HOME_POSITION};
 
     if (dir == 1) {
-        target[RIGHT_HAND] = servo_[RIGHT_HAND].GetPosition();
+        target[RIGHT_HAND] = motion_.GetPosition(RIGHT_HAND);
     } else if (dir == -1) {
-        target[LEFT_HAND] = servo_[LEFT_HAND].GetPosition();
+        target[LEFT_HAND] = motion_.GetPosition(LEFT_HAND);
     }
 
     MoveServos(period, target);
@@ -659,7 +633,7 @@ void Otto::HandWave(int period, int dir) {
     int current_positions[SERVO_COUNT];
     for (int i = 0; i < SERVO_COUNT; i++) {
         if (servo_pins_[i] != -1) {
-            current_positions[i] = servo_[i].GetPosition();
+            current_positions[i] = motion_.GetPosition(i);
         } else {
             current_positions[i] = 90;
         }
@@ -674,24 +648,24 @@ void Otto::HandWave(int period, int dir) {
 
     current_positions[servo_index] = position;
     MoveServos(300, current_positions);
-    vTaskDelay(pdMS_TO_TICKS(300));
+    Pause(300);
 
     // 左右摆动5次
     for (int i = 0; i < 5; i++) {
         if (servo_index == LEFT_HAND) {
             current_positions[servo_index] = position - 30;
             MoveServos(period / 10, current_positions);
-            vTaskDelay(pdMS_TO_TICKS(period / 10));
+            Pause(period / 10);
             current_positions[servo_index] = position + 30;
             MoveServos(period / 10, current_positions);
         } else {
             current_positions[servo_index] = position + 30;
             MoveServos(period / 10, current_positions);
-            vTaskDelay(pdMS_TO_TICKS(period / 10));
+            Pause(period / 10);
             current_positions[servo_index] = position - 30;
             MoveServos(period / 10, current_positions);
         }
-        vTaskDelay(pdMS_TO_TICKS(period / 10));
+        Pause(period / 10);
     }
 
     if (servo_index == LEFT_HAND) {
@@ -715,7 +689,7 @@ void Otto::HandWaveBoth(int period) {
     int current_positions[SERVO_COUNT];
     for (int i = 0; i < SERVO_COUNT; i++) {
         if (servo_pins_[i] != -1) {
-            current_positions[i] = servo_[i].GetPosition();
+            current_positions[i] = motion_.GetPosition(i);
         } else {
             current_positions[i] = 90;
         }
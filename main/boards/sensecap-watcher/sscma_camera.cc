@@ -7,12 +7,18 @@
 
 #include <esp_log.h>
 #include <esp_heap_caps.h>
+#include <esp_timer.h>
 #include <img_converters.h>
+#include <cJSON.h>
 #include <cstring>
 
 #define TAG "SscmaCamera"
 
 #define IMG_JPEG_BUF_SIZE   48 * 1024
+#define CAPTURE_TIMEOUT_MS  2000
+
+#define CAPTURE_DONE_EVENT      (1 << 0)
+#define CAPTURE_FAILED_EVENT    (1 << 1)
 
 SscmaCamera::SscmaCamera(esp_io_expander_handle_t io_exp_handle) {
     sscma_client_io_spi_config_t spi_io_config = {0};
@@ -43,33 +49,14 @@ SscmaCamera::SscmaCamera(esp_io_expander_handle_t io_exp_handle) {
 
     sscma_client_new(sscma_client_io_handle_, &sscma_client_config, &sscma_client_handle_);
 
-    sscma_data_queue_ = xQueueCreate(1, sizeof(SscmaData));
+    capture_event_group_ = xEventGroupCreate();
 
     sscma_client_callback_t callback = {0};
 
     callback.on_event = [](sscma_client_handle_t client, const sscma_client_reply_t *reply, void *user_ctx) {
         SscmaCamera* self = static_cast<SscmaCamera*>(user_ctx);
         if (!self) return;
-        char *img = NULL;
-        int img_size = 0;
-        if (sscma_utils_fetch_image_from_reply(reply, &img, &img_size) == ESP_OK)
-        {
-            ESP_LOGI(TAG, "image_size: %d\n", img_size);
-            // 将数据通过队列发送出去
-            SscmaData data;
-            data.img = (uint8_t*)img;
-            data.len = img_size;
-
-            // 清空队列，保证只保存最新的数据
-            SscmaData dummy;
-            while (xQueueReceive(self->sscma_data_queue_, &dummy, 0) == pdPASS) {
-                if (dummy.img) {
-                    heap_caps_free(dummy.img);
-                }
-            }
-            xQueueSend(self->sscma_data_queue_, &data, 0);
-            // 注意：img 的释放由接收方负责
-        }
+        self->OnImageReply(reply);
     };
     callback.on_connect = [](sscma_client_handle_t client, const sscma_client_reply_t *reply, void *user_ctx) {
         ESP_LOGI(TAG, "SSCMA client connected");
@@ -157,8 +144,8 @@ SscmaCamera::~SscmaCamera() {
     if (sscma_client_handle_) {
         sscma_client_del(sscma_client_handle_);
     }
-    if (sscma_data_queue_) {
-        vQueueDelete(sscma_data_queue_);
+    if (capture_event_group_) {
+        vEventGroupDelete(capture_event_group_);
     }
     if (jpeg_data_.buf) {
         heap_caps_free(jpeg_data_.buf);
@@ -183,41 +170,72 @@ void SscmaCamera::SetExplainUrl(const std::string& url, const std::string& token
     explain_token_ = token;
 }
 
-bool SscmaCamera::Capture() {
+void SscmaCamera::OnImageReply(const sscma_client_reply_t *reply) {
+    if (capture_frames_.load() <= 0) {
+        return;
+    }
+    cJSON* data = cJSON_GetObjectItem(reply->payload, "data");
+    cJSON* image = data != nullptr ? cJSON_GetObjectItem(data, "image") : nullptr;
+    if (!cJSON_IsString(image)) {
+        return;
+    }
+    // himax 有缓存数据，只解码最后一张，之前的直接丢弃
+    // Capture() may reset the counter meanwhile (timeout), never take it below zero
+    int frames = capture_frames_.load();
+    do {
+        if (frames <= 0) {
+            return;
+        }
+    } while (!capture_frames_.compare_exchange_weak(frames, frames - 1));
+    if (frames > 1) {
+        return;
+    }
+    if (jpeg_data_.buf == nullptr) {
+        xEventGroupSetBits(capture_event_group_, CAPTURE_FAILED_EVENT);
+        return;
+    }
+
+    // 直接从应答中的 base64 字符串解码到 JPEG 缓冲区，不再复制一份 base64 数据
+    size_t image_len = strlen(image->valuestring);
+    int ret = mbedtls_base64_decode(jpeg_data_.buf, IMG_JPEG_BUF_SIZE, &jpeg_data_.len,
+        (const unsigned char*)image->valuestring, image_len);
+    if (ret != 0 || jpeg_data_.len == 0) {
+        ESP_LOGE(TAG, "Failed to decode base64 image data, ret: %d, output_len: %zu", ret, jpeg_data_.len);
+        jpeg_data_.len = 0;
+        xEventGroupSetBits(capture_event_group_, CAPTURE_FAILED_EVENT);
+        return;
+    }
+    xEventGroupSetBits(capture_event_group_, CAPTURE_DONE_EVENT);
+}
 
-    SscmaData data;
+bool SscmaCamera::Capture() {
     int ret = 0;
-    
+
     if (sscma_client_handle_ == nullptr) {
         ESP_LOGE(TAG, "SSCMA client handle is not initialized");
         return false;
     }
 
     ESP_LOGI(TAG, "Capturing image...");
+    int64_t start_time = esp_timer_get_time();
 
     // himax 有缓存数据,需要拍两张照片, 只获取最新的照片即可.
+    xEventGroupClearBits(capture_event_group_, CAPTURE_DONE_EVENT | CAPTURE_FAILED_EVENT);
+    capture_frames_ = 2;
     if (sscma_client_sample(sscma_client_handle_, 2) ) {
+        capture_frames_ = 0;
         ESP_LOGE(TAG, "Failed to capture image from SSCMA client");
         return false;
     }
-    vTaskDelay(pdMS_TO_TICKS(500)); // 等待SSCMA客户端处理数据
-    if (xQueueReceive(sscma_data_queue_, &data, pdMS_TO_TICKS(1000)) != pdPASS) {
+    // 等待回调解码完成，而不是固定延时
+    EventBits_t bits = xEventGroupWaitBits(capture_event_group_, CAPTURE_DONE_EVENT | CAPTURE_FAILED_EVENT,
+        pdTRUE, pdFALSE, pdMS_TO_TICKS(CAPTURE_TIMEOUT_MS));
+    capture_frames_ = 0;
+    if (!(bits & CAPTURE_DONE_EVENT)) {
         ESP_LOGE(TAG, "Failed to receive JPEG data from SSCMA client");
         return false;
     }
-
-    if (jpeg_data_.buf == nullptr) {
-        heap_caps_free(data.img);
-        return false;
-    }
-
-    ret = mbedtls_base64_decode(jpeg_data_.buf, IMG_JPEG_BUF_SIZE, &jpeg_data_.len, data.img, data.len);
-    if (ret != 0 || jpeg_data_.len == 0) {
-        ESP_LOGE(TAG, "Failed to decode base64 image data, ret: %d, output_len: %zu", ret, jpeg_data_.len);
-        heap_caps_free(data.img);
-        return false;
-    }
-    heap_caps_free(data.img);
+    ESP_LOGI(TAG, "Received JPEG %zu bytes in %lld ms", jpeg_data_.len, (esp_timer_get_time() - start_time) / 1000);
 
     //DECODE JPEG
     if (!jpeg_dec_ || !jpeg_io_ || !jpeg_out_ || !preview_image_.data) {
@@ -241,6 +259,8 @@ bool SscmaCamera::Capture() {
         return true;
     }
 
+    ESP_LOGI(TAG, "Preview ready in %lld ms", (esp_timer_get_time() - start_time) / 1000);
+
     // 显示预览图片
     auto display = Board::GetInstance().GetDisplay();
     if (display != nullptr) {
@@ -4,9 +4,10 @@
 #include <lvgl.h>
 #include <thread>
 #include <memory>
+#include <atomic>
 
 #include <freertos/FreeRTOS.h>
-#include <freertos/queue.h>
+#include <freertos/event_groups.h>
 #include <esp_io_expander_tca95xx_16bit.h>
 #include <esp_jpeg_dec.h>
 #include <mbedtls/base64.h>
@@ -14,10 +15,6 @@
 #include "sscma_client.h"
 #include "camera.h"
 
-struct SscmaData {
-    uint8_t* img;
-    size_t len;
-};
 struct JpegData {
     uint8_t* buf;
     size_t len;
@@ -30,11 +27,15 @@ private:
     std::string explain_token_;
     sscma_client_io_handle_t sscma_client_io_handle_;
     sscma_client_handle_t sscma_client_handle_;
-    QueueHandle_t sscma_data_queue_;
+    EventGroupHandle_t capture_event_group_;
+    // Image replies still expected by the pending capture, 0 when no capture is pending
+    std::atomic<int> capture_frames_{0};
     JpegData jpeg_data_;
     jpeg_dec_handle_t *jpeg_dec_;
     jpeg_dec_io_t *jpeg_io_;
     jpeg_dec_header_info_t *jpeg_out_;
+
+    void OnImageReply(const sscma_client_reply_t *reply);
 public:
     SscmaCamera(esp_io_expander_handle_t io_exp_handle);
     ~SscmaCamera();
@@ -0,0 +1,31 @@
+#include "cpu_frequency_lock.h"
+
+#include <esp_log.h>
+
+#define TAG "CpuFrequencyLock"
+
+CpuFrequencyLock::CpuFrequencyLock(const char* name) {
+    auto ret = esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, name, &pm_lock_);
+    if (ret != ESP_OK && ret != ESP_ERR_NOT_SUPPORTED) {
+        ESP_LOGE(TAG, "Failed to create PM lock %s: %s", name, esp_err_to_name(ret));
+    }
+}
+
+CpuFrequencyLock::~CpuFrequencyLock() {
+    if (pm_lock_ != nullptr) {
+        Release();
+        esp_pm_lock_delete(pm_lock_);
+    }
+}
+
+void CpuFrequencyLock::Acquire() {
+    if (pm_lock_ != nullptr && !held_.exchange(true)) {
+        esp_pm_lock_acquire(pm_lock_);
+    }
+}
+
+void CpuFrequencyLock::Release() {
+    if (pm_lock_ != nullptr && held_.exchange(false)) {
+        esp_pm_lock_release(pm_lock_);
+    }
+}
@@ -0,0 +1,25 @@
+#ifndef CPU_FREQUENCY_LOCK_H
+#define CPU_FREQUENCY_LOCK_H
+
+#include <esp_pm.h>
+#include <atomic>
+
+/**
+ * An ESP_PM_CPU_FREQ_MAX lock that is held at most once, so Acquire() and Release() can be
+ * called from start and stop paths that repeat or race each other. PM locks are global: while
+ * held, the whole chip runs at the max frequency, including the tasks that esp-sr creates.
+ */
+class CpuFrequencyLock {
+public:
+    CpuFrequencyLock(const char* name);
+    ~CpuFrequencyLock();
+
+    void Acquire();
+    void Release();
+
+private:
+    esp_pm_lock_handle_t pm_lock_ = nullptr;
+    std::atomic<bool> held_ = false;
+};
+
+#endif // CPU_FREQUENCY_LOCK_H
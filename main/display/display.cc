@@ -10,6 +10,7 @@
 #include "font_awesome_symbols.h"
 #include "audio_codec.h"
 #include "settings.h"
+#include "preview_image.h"
 #include "assets/lang_config.h"
 
 #define TAG "Display"
@@ -61,6 +62,20 @@ Display::~Display() {
     }
 }
 
+void Display::HoldCpuWhileRendering() {
+    // Only sent when something was invalidated, an idle screen does not take the lock
+    auto callback = [](lv_event_t* e) {
+        auto display = static_cast<Display*>(lv_event_get_user_data(e));
+        if (lv_event_get_code(e) == LV_EVENT_RENDER_START) {
+            display->render_cpu_lock_.Acquire();
+        } else {
+            display->render_cpu_lock_.Release();
+        }
+    };
+    lv_display_add_event_cb(display_, callback, LV_EVENT_RENDER_START, this);
+    lv_display_add_event_cb(display_, callback, LV_EVENT_RENDER_READY, this);
+}
+
 void Display::SetStatus(const char* status) {
     DisplayLockGuard lock(this);
     if (status_label_ == nullptr) {
@@ -88,23 +103,19 @@ void Display::ShowNotification(const char* notification, int duration_ms) {
     ESP_ERROR_CHECK(esp_timer_start_once(notification_timer_, duration_ms * 1000));
 }
 
-void Display::UpdateStatusBar(bool update_all) {
+void Display::UpdateStatusBar(uint32_t items) {
     auto& board = Board::GetInstance();
-    auto codec = board.GetAudioCodec();
-
-    {
-        DisplayLockGuard lock(this);
-        if (mute_label_ == nullptr) {
-            return;
-        }
 
-        // 如果静音状态改变，则更新图标
-        if (codec->output_volume() == 0 && !muted_) {
-            muted_ = true;
-            lv_label_set_text(mute_label_, FONT_AWESOME_VOLUME_MUTE);
-        } else if (codec->output_volume() > 0 && muted_) {
-            muted_ = false;
-            lv_label_set_text(mute_label_, "");
+    // 静音状态改变时才更新图标
+    if (items & kStatusBarMute) {
+        bool muted = board.GetAudioCodec()->output_volume() == 0;
+        if (muted != muted_) {
+            DisplayLockGuard lock(this);
+            if (mute_label_ == nullptr) {
+                return;
+            }
+            muted_ = muted;
+            lv_label_set_text(mute_label_, muted_ ? FONT_AWESOME_VOLUME_MUTE : "");
         }
     }
 
@@ -113,7 +124,7 @@ void Display::UpdateStatusBar(bool update_all) {
     int battery_level;
     bool charging, discharging;
     const char* icon = nullptr;
-    if (board.GetBatteryLevel(battery_level, charging, discharging)) {
+    if ((items & kStatusBarBattery) && board.GetBatteryLevel(battery_level, charging, discharging)) {
         if (charging) {
             icon = FONT_AWESOME_BATTERY_CHARGING;
         } else {
@@ -127,31 +138,32 @@ void Display::UpdateStatusBar(bool update_all) {
             };
             icon = levels[battery_level / 20];
         }
-        DisplayLockGuard lock(this);
-        if (battery_label_ != nullptr && battery_icon_ != icon) {
-            battery_icon_ = icon;
-            lv_label_set_text(battery_label_, battery_icon_);
-        }
+        bool low_battery = !charging && battery_level < 20 && discharging;
+        if (icon != battery_icon_ || (low_battery_popup_ != nullptr && low_battery != low_battery_shown_)) {
+            DisplayLockGuard lock(this);
+            if (battery_icon_ != icon) {
+                battery_icon_ = icon;
+                if (battery_label_ != nullptr) {
+                    lv_label_set_text(battery_label_, battery_icon_);
+                }
+            }
 
-        if (low_battery_popup_ != nullptr) {
-            if (strcmp(icon, FONT_AWESOME_BATTERY_EMPTY) == 0 && discharging) {
-                if (lv_obj_has_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN)) { // 如果低电量提示框隐藏，则显示
+            if (low_battery_popup_ != nullptr && low_battery != low_battery_shown_) {
+                low_battery_shown_ = low_battery;
+                if (low_battery) {
+                    // 低电量时显示提示框
                     lv_obj_clear_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN);
                     auto& app = Application::GetInstance();
                     app.PlaySound(Lang::Sounds::P3_LOW_BATTERY);
-                }
-            } else {
-                // Hide the low battery popup when the battery is not empty
-                if (!lv_obj_has_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN)) { // 如果低电量提示框显示，则隐藏
+                } else {
+                    // Hide the low battery popup when the battery is not empty
                     lv_obj_add_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN);
                 }
             }
         }
     }
 
-    // 每 10 秒更新一次网络图标
-    static int seconds_counter = 0;
-    if (update_all || seconds_counter++ % 10 == 0) {
+    if (items & kStatusBarNetwork) {
         // 升级固件时，不读取 4G 网络状态，避免占用 UART 资源
         auto device_state = Application::GetInstance().GetDeviceState();
         static const std::vector<DeviceState> allowed_states = {
@@ -235,6 +247,11 @@ void Display::SetPreviewImage(const lv_img_dsc_t* image) {
     // Do nothing
 }
 
+void Display::TakePreviewImage(lv_img_dsc_t* image) {
+    // Preview is not supported, release the image
+    DeletePreviewImage(image);
+}
+
 void Display::SetChatMessage(const char* role, const char* content) {
     DisplayLockGuard lock(this);
     if (chat_message_label_ == nullptr) {
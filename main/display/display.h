@@ -8,6 +8,16 @@
 
 #include <string>
 
+#include "cpu_frequency_lock.h"
+
+// Status bar items that changed, see Application::NotifyStatusBarChanged()
+enum StatusBarItem : uint32_t {
+    kStatusBarMute = 1 << 0,
+    kStatusBarBattery = 1 << 1,
+    kStatusBarNetwork = 1 << 2,
+    kStatusBarAll = kStatusBarMute | kStatusBarBattery | kStatusBarNetwork,
+};
+
 struct DisplayFonts {
     const lv_font_t* text_font = nullptr;
     const lv_font_t* icon_font = nullptr;
@@ -26,9 +36,14 @@ public:
     virtual void SetChatMessage(const char* role, const char* content);
     virtual void SetIcon(const char* icon);
     virtual void SetPreviewImage(const lv_img_dsc_t* image);
+    // Show an image created by CreatePreviewImage(), the display takes ownership of it
+    virtual void TakePreviewImage(lv_img_dsc_t* image);
     virtual void SetTheme(const std::string& theme_name);
     virtual std::string GetTheme() { return current_theme_name_; }
-    virtual void UpdateStatusBar(bool update_all = false);
+    // Labels are only touched (and the LVGL lock only taken) when a value differs from the one shown
+    virtual void UpdateStatusBar(uint32_t items = kStatusBarAll);
+    // Render fixed chat messages and log the time per sentence, see CONFIG_USE_BOOT_BENCHMARK
+    virtual void RunTextBenchmark() {}
 
     inline int width() const { return width_; }
     inline int height() const { return height_; }
@@ -53,9 +68,15 @@ protected:
     const char* battery_icon_ = nullptr;
     const char* network_icon_ = nullptr;
     bool muted_ = false;
+    bool low_battery_shown_ = false;
     std::string current_theme_name_;
 
     esp_timer_handle_t notification_timer_ = nullptr;
+    // Held by the LVGL task while it renders, so animations do not run at a DFS lowered frequency
+    CpuFrequencyLock render_cpu_lock_{"lvgl_render"};
+
+    // Call once display_ is created
+    void HoldCpuWhileRendering();
 
     friend class DisplayLockGuard;
     virtual bool Lock(int timeout_ms = 0) = 0;
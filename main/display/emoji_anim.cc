@@ -0,0 +1,208 @@
+#include "emoji_anim.h"
+#include "application.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
+#include <cstring>
+#include <algorithm>
+
+#define TAG "EmojiAnim"
+
+// Upper bound of the governor slowdown factor
+#define EMOJI_ANIM_MAX_SLOWDOWN 4
+
+EmojiAnimPlayer::EmojiAnimPlayer(lv_obj_t* parent) {
+    canvas_ = lv_canvas_create(parent);
+    lv_obj_set_style_border_width(canvas_, 0, 0);
+    lv_obj_set_style_bg_opa(canvas_, LV_OPA_TRANSP, 0);
+
+    timer_ = lv_timer_create(OnTimer, 1000, this);
+    lv_timer_pause(timer_);
+}
+
+EmojiAnimPlayer::~EmojiAnimPlayer() {
+    if (timer_ != nullptr) {
+        lv_timer_delete(timer_);
+    }
+    if (canvas_ != nullptr) {
+        lv_obj_del(canvas_);
+    }
+    if (frame_buffer_ != nullptr) {
+        heap_caps_free(frame_buffer_);
+    }
+}
+
+bool EmojiAnimPlayer::DecodeFrame(const uint8_t* src, size_t size, uint16_t* dst, size_t pixels) {
+    const uint8_t* end = src + size;
+    size_t pos = 0;
+    while (src < end) {
+        uint8_t op = *src++;
+        int type = op >> 6;
+        size_t count = (op & 0x3F) + 1;
+        if (type == EMOJI_ANIM_OP_LONG) {
+            if (src >= end) {
+                return false;
+            }
+            type = (op >> 4) & 0x03;
+            count = (((op & 0x0F) << 8) | *src++) + 1;
+        }
+        if (pos + count > pixels) {
+            return false;
+        }
+
+        switch (type) {
+        case EMOJI_ANIM_OP_SKIP:
+            break;
+        case EMOJI_ANIM_OP_RUN: {
+            if (end - src < 2) {
+                return false;
+            }
+            uint16_t color = src[0] | (src[1] << 8);
+            src += 2;
+            std::fill_n(dst + pos, count, color);
+            break;
+        }
+        case EMOJI_ANIM_OP_LITERAL:
+            if ((size_t)(end - src) < count * 2) {
+                return false;
+            }
+            memcpy(dst + pos, src, count * 2);
+            src += count * 2;
+            break;
+        default:
+            return false;
+        }
+        pos += count;
+    }
+    return true;
+}
+
+bool EmojiAnimPlayer::Play(const emoji_anim_dsc_t* anim, bool loop) {
+    // A finished one-shot animation is played again
+    if (anim == anim_ && loop == loop_ && !finished_) {
+        return true;
+    }
+    Stop();
+
+    if (anim == nullptr || anim->data_size < sizeof(emoji_anim_header_t)) {
+        return false;
+    }
+    auto header = reinterpret_cast<const emoji_anim_header_t*>(anim->data);
+    size_t table_end = sizeof(emoji_anim_header_t) + header->frame_count * sizeof(emoji_anim_frame_t);
+    if (header->magic != EMOJI_ANIM_MAGIC || header->frame_count == 0 || table_end > anim->data_size) {
+        ESP_LOGE(TAG, "Invalid animation data");
+        return false;
+    }
+    auto frames = reinterpret_cast<const emoji_anim_frame_t*>(anim->data + sizeof(emoji_anim_header_t));
+    for (int i = 0; i < header->frame_count; i++) {
+        if (frames[i].offset < table_end || frames[i].offset > anim->data_size ||
+            frames[i].size > anim->data_size - frames[i].offset) {
+            ESP_LOGE(TAG, "Invalid frame %d", i);
+            return false;
+        }
+    }
+    if (!(frames[0].flags & EMOJI_ANIM_FRAME_FLAG_KEY)) {
+        ESP_LOGE(TAG, "The first frame must be a key frame");
+        return false;
+    }
+
+    // Only grow the frame buffer, it is shared by all animations
+    size_t pixels = header->width * header->height;
+    if (pixels > frame_buffer_pixels_) {
+        if (frame_buffer_ != nullptr) {
+            heap_caps_free(frame_buffer_);
+        }
+        frame_buffer_ = (uint16_t*)heap_caps_malloc(pixels * 2, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (frame_buffer_ == nullptr) {
+            frame_buffer_ = (uint16_t*)heap_caps_malloc(pixels * 2, MALLOC_CAP_8BIT);
+        }
+        if (frame_buffer_ == nullptr) {
+            ESP_LOGE(TAG, "Failed to allocate frame buffer %dx%d", header->width, header->height);
+            frame_buffer_pixels_ = 0;
+            return false;
+        }
+        frame_buffer_pixels_ = pixels;
+    }
+    // Pixels skipped by the first frame must not show garbage or the previous animation
+    memset(frame_buffer_, 0, pixels * 2);
+    lv_canvas_set_buffer(canvas_, frame_buffer_, header->width, header->height, LV_COLOR_FORMAT_RGB565);
+    lv_obj_center(canvas_);
+
+    anim_ = anim;
+    header_ = header;
+    frames_ = frames;
+    loop_ = loop;
+    finished_ = false;
+    current_frame_ = 0;
+    lv_timer_resume(timer_);
+    ShowNextFrame();
+    return true;
+}
+
+void EmojiAnimPlayer::Stop() {
+    lv_timer_pause(timer_);
+    anim_ = nullptr;
+    header_ = nullptr;
+    frames_ = nullptr;
+}
+
+void EmojiAnimPlayer::OnTimer(lv_timer_t* timer) {
+    auto player = static_cast<EmojiAnimPlayer*>(lv_timer_get_user_data(timer));
+    player->ShowNextFrame();
+}
+
+void EmojiAnimPlayer::ShowNextFrame() {
+    if (header_ == nullptr) {
+        return;
+    }
+
+    auto& frame = frames_[current_frame_];
+    int64_t start_time = esp_timer_get_time();
+    if (!DecodeFrame(anim_->data + frame.offset, frame.size, frame_buffer_, header_->width * header_->height)) {
+        ESP_LOGE(TAG, "Failed to decode frame %d", current_frame_);
+        Stop();
+        return;
+    }
+    UpdateGovernor(esp_timer_get_time() - start_time, frame.delay_ms);
+    lv_obj_invalidate(canvas_);
+
+    if (header_->frame_count == 1) {
+        lv_timer_pause(timer_);
+        return;
+    }
+    lv_timer_set_period(timer_, std::max<int>(frame.delay_ms, 10) * slowdown_);
+
+    current_frame_++;
+    if (current_frame_ >= header_->frame_count) {
+        if (!loop_) {
+            finished_ = true;
+            lv_timer_pause(timer_);
+            return;
+        }
+        current_frame_ = 0;
+    }
+}
+
+// Slow the animation down while the audio pipeline is busy or when decoding takes too
+// much of the frame time, and speed it back up once the pressure is gone.
+void EmojiAnimPlayer::UpdateGovernor(int64_t decode_us, int delay_ms) {
+    average_decode_us_ = (average_decode_us_ * 7 + decode_us) / 8;
+
+    auto& app = Application::GetInstance();
+    auto state = app.GetDeviceState();
+    bool audio_busy = state == kDeviceStateSpeaking || state == kDeviceStateListening;
+    int min_slowdown = audio_busy ? 2 : 1;
+    // Between sentences there is nothing to animate to, idle at the lowest rate
+    if (state == kDeviceStateSpeaking && app.GetOutputLevels().rms == 0) {
+        min_slowdown = EMOJI_ANIM_MAX_SLOWDOWN;
+    }
+
+    int64_t frame_us = std::max(delay_ms, 10) * 1000LL;
+    if (average_decode_us_ > frame_us / 4) {
+        slowdown_ = std::min(slowdown_ * 2, EMOJI_ANIM_MAX_SLOWDOWN);
+    } else if (average_decode_us_ < frame_us / 8) {
+        slowdown_ = slowdown_ / 2;
+    }
+    slowdown_ = std::max(slowdown_, min_slowdown);
+}
@@ -0,0 +1,52 @@
+#ifndef EMOJI_ANIM_H
+#define EMOJI_ANIM_H
+
+#include <lvgl.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "emoji_anim_format.h"
+
+/**
+ * Plays pre-converted emoji animations (see emoji_anim_format.h) on an LVGL canvas.
+ *
+ * Frames are decoded in place into a single RGB565 canvas buffer, so memory use is
+ * one frame of the largest animation played, independent of the frame count.
+ * All methods must be called with the display lock held.
+ */
+class EmojiAnimPlayer {
+public:
+    EmojiAnimPlayer(lv_obj_t* parent);
+    ~EmojiAnimPlayer();
+
+    bool Play(const emoji_anim_dsc_t* anim, bool loop = true);
+    void Stop();
+
+    inline lv_obj_t* object() const { return canvas_; }
+
+    static bool DecodeFrame(const uint8_t* src, size_t size, uint16_t* dst, size_t pixels);
+
+private:
+    lv_obj_t* canvas_ = nullptr;
+    lv_timer_t* timer_ = nullptr;
+    uint16_t* frame_buffer_ = nullptr;
+    size_t frame_buffer_pixels_ = 0;
+
+    const emoji_anim_dsc_t* anim_ = nullptr;
+    const emoji_anim_header_t* header_ = nullptr;
+    const emoji_anim_frame_t* frames_ = nullptr;
+    int current_frame_ = 0;
+    bool loop_ = true;
+    bool finished_ = false;
+
+    // Frame-rate governor, the frame delay is multiplied by slowdown_
+    int slowdown_ = 1;
+    int64_t average_decode_us_ = 0;
+
+    static void OnTimer(lv_timer_t* timer);
+    void ShowNextFrame();
+    void UpdateGovernor(int64_t decode_us, int delay_ms);
+};
+
+#endif // EMOJI_ANIM_H
@@ -0,0 +1,62 @@
+#ifndef EMOJI_ANIM_FORMAT_H
+#define EMOJI_ANIM_FORMAT_H
+
+/*
+ * Pre-converted emoji animation format, produced by scripts/Emoji_Converter/gif_to_anim.py
+ *
+ * Layout (little endian, 4-byte aligned):
+ *   emoji_anim_header_t
+ *   emoji_anim_frame_t[frame_count]
+ *   frame payloads
+ *
+ * Each frame payload is a stream of RGB565 ops covering the frame in raster order:
+ *   00nnnnnn                 SKIP    n+1 pixels (keep previous frame)
+ *   01nnnnnn <pixel>         RUN     n+1 pixels of one color
+ *   10nnnnnn <pixel>*(n+1)   LITERAL n+1 pixels
+ *   11ttnnnn <byte>          long form of op tt, count = (nnnn << 8 | byte) + 1
+ * Key frames never use SKIP, so playback can restart from any key frame.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EMOJI_ANIM_MAGIC 0x314E4145  // "EAN1"
+
+#define EMOJI_ANIM_OP_SKIP      0
+#define EMOJI_ANIM_OP_RUN       1
+#define EMOJI_ANIM_OP_LITERAL   2
+#define EMOJI_ANIM_OP_LONG      3
+
+#define EMOJI_ANIM_FRAME_FLAG_KEY   (1 << 0)
+
+typedef struct {
+    uint32_t magic;
+    uint16_t width;
+    uint16_t height;
+    uint16_t frame_count;
+    uint16_t reserved;
+} emoji_anim_header_t;
+
+typedef struct {
+    uint32_t offset;    // Offset of the payload from the start of the data
+    uint32_t size;      // Payload size in bytes
+    uint16_t delay_ms;
+    uint16_t flags;
+} emoji_anim_frame_t;
+
+typedef struct {
+    const uint8_t* data;
+    uint32_t data_size;
+} emoji_anim_dsc_t;
+
+#ifdef __cplusplus
+}
+#define EMOJI_ANIM_DECLARE(var_name) extern "C" const emoji_anim_dsc_t var_name
+#else
+#define EMOJI_ANIM_DECLARE(var_name) extern const emoji_anim_dsc_t var_name
+#endif
+
+#endif // EMOJI_ANIM_FORMAT_H
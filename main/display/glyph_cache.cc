@@ -0,0 +1,307 @@
+#include "glyph_cache.h"
+
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+
+#include <algorithm>
+#include <cstring>
+
+#define TAG "GlyphCache"
+
+#define NO_ENTRY -1
+
+// Intrusive LRU list and hash chains over a fixed pool, shared by both caches
+template <typename Entry>
+static void Unlink(Entry* pool, int16_t& head, int16_t& tail, int16_t index) {
+    auto& entry = pool[index];
+    if (entry.prev != NO_ENTRY) {
+        pool[entry.prev].next = entry.next;
+    } else {
+        head = entry.next;
+    }
+    if (entry.next != NO_ENTRY) {
+        pool[entry.next].prev = entry.prev;
+    } else {
+        tail = entry.prev;
+    }
+}
+
+template <typename Entry>
+static void PushFront(Entry* pool, int16_t& head, int16_t& tail, int16_t index) {
+    auto& entry = pool[index];
+    entry.prev = NO_ENTRY;
+    entry.next = head;
+    if (head != NO_ENTRY) {
+        pool[head].prev = index;
+    }
+    head = index;
+    if (tail == NO_ENTRY) {
+        tail = index;
+    }
+}
+
+template <typename Entry>
+static void RemoveFromBucket(Entry* pool, int16_t* buckets, int bucket, int16_t index) {
+    int16_t* link = &buckets[bucket];
+    while (*link != NO_ENTRY) {
+        if (*link == index) {
+            *link = pool[index].hash_next;
+            return;
+        }
+        link = &pool[*link].hash_next;
+    }
+}
+
+static inline int Bucket(uint64_t key, int capacity) {
+    uint32_t hash = (uint32_t)(key ^ (key >> 32)) * 2654435761u;
+    return hash % capacity;
+}
+
+static void CopyRows(uint8_t* dst, uint32_t dst_stride, const uint8_t* src, uint32_t src_stride, uint32_t width, uint32_t height) {
+    if (dst_stride == width && src_stride == width) {
+        memcpy(dst, src, width * height);
+        return;
+    }
+    for (uint32_t y = 0; y < height; y++) {
+        memcpy(dst + y * dst_stride, src + y * src_stride, width);
+    }
+}
+
+// Decode one UTF-8 character, invalid bytes are returned as is
+static uint32_t NextUtf8(const char*& p) {
+    uint8_t c = *p++;
+    int extra = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : 0;
+    uint32_t letter = extra == 0 ? c : c & (0x3F >> extra);
+    for (int i = 0; i < extra && (*p & 0xC0) == 0x80; i++) {
+        letter = (letter << 6) | (*p++ & 0x3F);
+    }
+    return letter;
+}
+
+GlyphCache::GlyphCache(const lv_font_t* base, int max_glyphs, size_t bitmap_bytes) : base_(base) {
+    font_ = *base;
+    font_.get_glyph_dsc = GetGlyphDsc;
+    font_.get_glyph_bitmap = GetGlyphBitmap;
+    font_.release_glyph = base->release_glyph != nullptr ? ReleaseGlyph : nullptr;
+    font_.user_data = this;
+
+    // Kerning makes the advance depend on the next letter, only plain fonts without a kerning table can ignore it
+    kerning_ = true;
+    if (base->get_glyph_dsc == lv_font_get_glyph_dsc_fmt_txt) {
+        auto fdsc = (const lv_font_fmt_txt_dsc_t*)base->dsc;
+        kerning_ = fdsc->kern_dsc != nullptr && base->kerning != LV_FONT_KERNING_NONE;
+    }
+
+    glyph_capacity_ = max_glyphs;
+    glyphs_ = (GlyphEntry*)heap_caps_malloc(sizeof(GlyphEntry) * glyph_capacity_, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (glyphs_ == nullptr) {
+        glyphs_ = (GlyphEntry*)heap_caps_malloc(sizeof(GlyphEntry) * glyph_capacity_, MALLOC_CAP_8BIT);
+    }
+    glyph_buckets_ = (int16_t*)heap_caps_malloc(sizeof(int16_t) * glyph_capacity_, MALLOC_CAP_8BIT);
+    if (glyphs_ == nullptr || glyph_buckets_ == nullptr) {
+        ESP_LOGE(TAG, "Failed to allocate glyph cache");
+        glyph_capacity_ = 0;
+    } else {
+        memset(glyph_buckets_, 0xFF, sizeof(int16_t) * glyph_capacity_);
+    }
+
+    // Bitmaps of any size share one pool, so a few large glyphs do not waste it
+    bitmap_pool_size_ = bitmap_bytes;
+    bitmap_capacity_ = std::min<size_t>(bitmap_bytes / GLYPH_CACHE_BITMAP_BYTES_PER_ENTRY, INT16_MAX);
+    if (bitmap_capacity_ > 0) {
+        bitmap_pool_ = (uint8_t*)heap_caps_malloc(bitmap_pool_size_, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (bitmap_pool_ == nullptr) {
+            bitmap_pool_ = (uint8_t*)heap_caps_malloc(bitmap_pool_size_, MALLOC_CAP_8BIT);
+        }
+        bitmaps_ = (BitmapEntry*)heap_caps_malloc(sizeof(BitmapEntry) * bitmap_capacity_, MALLOC_CAP_8BIT);
+        bitmap_buckets_ = (int16_t*)heap_caps_malloc(sizeof(int16_t) * bitmap_capacity_, MALLOC_CAP_8BIT);
+        if (bitmap_pool_ == nullptr || bitmaps_ == nullptr || bitmap_buckets_ == nullptr) {
+            ESP_LOGE(TAG, "Failed to allocate glyph bitmap cache");
+            bitmap_capacity_ = 0;
+        } else {
+            memset(bitmap_buckets_, 0xFF, sizeof(int16_t) * bitmap_capacity_);
+            // Unused entries are chained through next
+            for (int i = 0; i < bitmap_capacity_; i++) {
+                bitmaps_[i].next = i + 1 < bitmap_capacity_ ? i + 1 : NO_ENTRY;
+            }
+            bitmap_free_ = 0;
+        }
+    }
+    ESP_LOGI(TAG, "Caching %d glyphs and up to %d bitmaps in %zu bytes", glyph_capacity_, bitmap_capacity_,
+        bitmap_capacity_ > 0 ? bitmap_pool_size_ : 0);
+}
+
+GlyphCache::~GlyphCache() {
+    heap_caps_free(glyphs_);
+    heap_caps_free(glyph_buckets_);
+    heap_caps_free(bitmaps_);
+    heap_caps_free(bitmap_buckets_);
+    heap_caps_free(bitmap_pool_);
+}
+
+bool GlyphCache::LookupGlyph(lv_font_glyph_dsc_t* dsc, uint32_t letter, uint32_t letter_next) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.glyph_lookups++;
+    if (glyph_capacity_ == 0 || !enabled_) {
+        return base_->get_glyph_dsc(base_, dsc, letter, letter_next);
+    }
+
+    uint64_t key = kerning_ ? ((uint64_t)letter_next << 32) | letter : letter;
+    int bucket = Bucket(key, glyph_capacity_);
+    for (int16_t i = glyph_buckets_[bucket]; i != NO_ENTRY; i = glyphs_[i].hash_next) {
+        if (glyphs_[i].key == key) {
+            stats_.glyph_hits++;
+            Unlink(glyphs_, glyph_head_, glyph_tail_, i);
+            PushFront(glyphs_, glyph_head_, glyph_tail_, i);
+            *dsc = glyphs_[i].dsc;
+            return glyphs_[i].found;
+        }
+    }
+
+    bool found = base_->get_glyph_dsc(base_, dsc, letter, letter_next);
+
+    int16_t index;
+    if (glyph_count_ < glyph_capacity_) {
+        index = glyph_count_++;
+    } else {
+        index = glyph_tail_;
+        Unlink(glyphs_, glyph_head_, glyph_tail_, index);
+        RemoveFromBucket(glyphs_, glyph_buckets_, Bucket(glyphs_[index].key, glyph_capacity_), index);
+    }
+    // Missing glyphs are cached too, the fallback fonts are asked for them every time
+    auto& entry = glyphs_[index];
+    entry.key = key;
+    entry.dsc = *dsc;
+    entry.found = found;
+    entry.hash_next = glyph_buckets_[bucket];
+    glyph_buckets_[bucket] = index;
+    PushFront(glyphs_, glyph_head_, glyph_tail_, index);
+    return found;
+}
+
+const void* GlyphCache::LookupBitmap(lv_font_glyph_dsc_t* dsc, lv_draw_buf_t* draw_buf) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // The base font resolves the glyph, not this wrapper
+    dsc->resolved_font = base_;
+    if (bitmap_capacity_ == 0 || !enabled_ || dsc->req_raw_bitmap || draw_buf == nullptr) {
+        auto bitmap = base_->get_glyph_bitmap(dsc, draw_buf);
+        dsc->resolved_font = &font_;
+        return bitmap;
+    }
+
+    stats_.bitmap_lookups++;
+    uint32_t key = dsc->gid.index;
+    // A8 rows are kept packed, the draw buffer stride depends on the alignment of the draw unit
+    uint32_t size = dsc->box_w * dsc->box_h;
+    int bucket = Bucket(key, bitmap_capacity_);
+    for (int16_t i = bitmap_buckets_[bucket]; i != NO_ENTRY; i = bitmaps_[i].hash_next) {
+        if (bitmaps_[i].key == key && bitmaps_[i].size == size) {
+            stats_.bitmap_hits++;
+            CopyRows(draw_buf->data, draw_buf->header.stride, bitmap_pool_ + bitmaps_[i].offset, dsc->box_w, dsc->box_w, dsc->box_h);
+            dsc->resolved_font = &font_;
+            return bitmap_returns_draw_buf_ ? (const void*)draw_buf : (const void*)draw_buf->data;
+        }
+    }
+
+    auto bitmap = base_->get_glyph_bitmap(dsc, draw_buf);
+    dsc->resolved_font = &font_;
+    // A huge glyph would flush most of the pool, it is rendered every time instead
+    if (bitmap == nullptr || size == 0 || size > bitmap_pool_size_ / 8) {
+        return bitmap;
+    }
+    // Only a bitmap rendered into the draw buffer is worth keeping, a pointer into the font is already free
+    if (bitmap == draw_buf) {
+        bitmap_returns_draw_buf_ = 1;
+    } else if (bitmap == draw_buf->data) {
+        bitmap_returns_draw_buf_ = 0;
+    } else {
+        return bitmap;
+    }
+
+    int16_t index = AllocateBitmap(size);
+    auto& entry = bitmaps_[index];
+    entry.key = key;
+    entry.hash_next = bitmap_buckets_[bucket];
+    bitmap_buckets_[bucket] = index;
+    PushFront(bitmaps_, bitmap_head_, bitmap_tail_, index);
+    CopyRows(bitmap_pool_ + entry.offset, dsc->box_w, draw_buf->data, draw_buf->header.stride, dsc->box_w, dsc->box_h);
+    return bitmap;
+}
+
+void GlyphCache::EvictOldestBitmap() {
+    int16_t index = bitmap_tail_;
+    Unlink(bitmaps_, bitmap_head_, bitmap_tail_, index);
+    RemoveFromBucket(bitmaps_, bitmap_buckets_, Bucket(bitmaps_[index].key, bitmap_capacity_), index);
+    bitmaps_[index].next = bitmap_free_;
+    bitmap_free_ = index;
+}
+
+// Take size bytes at the write position of the ring, the bitmaps stored there are evicted.
+// Bitmaps not yet overwritten lie after the write position, oldest first, so they are always
+// evicted from the tail of the list.
+int16_t GlyphCache::AllocateBitmap(uint32_t size) {
+    if (bitmap_write_ + size > bitmap_pool_size_) {
+        while (bitmap_tail_ != NO_ENTRY && bitmaps_[bitmap_tail_].offset >= bitmap_write_) {
+            EvictOldestBitmap();
+        }
+        bitmap_write_ = 0;
+    }
+    while (bitmap_tail_ != NO_ENTRY && bitmaps_[bitmap_tail_].offset >= bitmap_write_ &&
+           bitmaps_[bitmap_tail_].offset < bitmap_write_ + size) {
+        EvictOldestBitmap();
+    }
+    if (bitmap_free_ == NO_ENTRY) {
+        EvictOldestBitmap();
+    }
+
+    int16_t index = bitmap_free_;
+    bitmap_free_ = bitmaps_[index].next;
+    bitmaps_[index].offset = bitmap_write_;
+    bitmaps_[index].size = size;
+    bitmap_write_ += size;
+    return index;
+}
+
+void GlyphCache::Prepare(const char* text) {
+    if (text == nullptr) {
+        return;
+    }
+    // Only this font is warmed up, LVGL walks the fallback fonts itself and they are not thread safe
+    lv_font_glyph_dsc_t dsc;
+    const char* p = text;
+    uint32_t letter = *p != '\0' ? NextUtf8(p) : 0;
+    while (letter != 0) {
+        uint32_t letter_next = *p != '\0' ? NextUtf8(p) : 0;
+        if (letter != '\n' && letter != '\r') {
+            LookupGlyph(&dsc, letter, letter_next);
+        }
+        letter = letter_next;
+    }
+}
+
+void GlyphCache::SetEnabled(bool enabled) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    enabled_ = enabled;
+}
+
+GlyphCacheStats GlyphCache::TakeStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto stats = stats_;
+    stats_ = GlyphCacheStats();
+    return stats;
+}
+
+bool GlyphCache::GetGlyphDsc(const lv_font_t* font, lv_font_glyph_dsc_t* dsc, uint32_t letter, uint32_t letter_next) {
+    return static_cast<GlyphCache*>(font->user_data)->LookupGlyph(dsc, letter, letter_next);
+}
+
+const void* GlyphCache::GetGlyphBitmap(lv_font_glyph_dsc_t* dsc, lv_draw_buf_t* draw_buf) {
+    return static_cast<GlyphCache*>(dsc->resolved_font->user_data)->LookupBitmap(dsc, draw_buf);
+}
+
+void GlyphCache::ReleaseGlyph(const lv_font_t* font, lv_font_glyph_dsc_t* dsc) {
+    auto self = static_cast<GlyphCache*>(font->user_data);
+    dsc->resolved_font = self->base_;
+    self->base_->release_glyph(self->base_, dsc);
+    dsc->resolved_font = font;
+}
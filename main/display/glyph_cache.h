@@ -0,0 +1,100 @@
+#ifndef GLYPH_CACHE_H
+#define GLYPH_CACHE_H
+
+#include <lvgl.h>
+
+#include <mutex>
+#include <cstdint>
+
+#if CONFIG_SPIRAM
+#define GLYPH_CACHE_MAX_GLYPHS 1024
+#define GLYPH_CACHE_BITMAP_BYTES (96 * 1024)
+#else
+// ~6 KB of internal RAM, bitmaps are not cached: a useful bitmap pool does not fit
+#define GLYPH_CACHE_MAX_GLYPHS 128
+#define GLYPH_CACHE_BITMAP_BYTES 0
+#endif
+// Bitmap entries per byte of pool, the average A8 glyph of a 16 ~ 30 px font is a few hundred bytes
+#define GLYPH_CACHE_BITMAP_BYTES_PER_ENTRY 128
+
+struct GlyphCacheStats {
+    uint32_t glyph_lookups = 0;
+    uint32_t glyph_hits = 0;
+    uint32_t bitmap_lookups = 0;
+    uint32_t bitmap_hits = 0;
+};
+
+/**
+ * A font that forwards to a large bitmap font (typically CJK) and keeps the most recently used
+ * glyph descriptors and rendered A8 bitmaps.
+ *
+ * Descriptor lookups in a big font are a binary search through the cmap on every character
+ * measured or drawn, and compressed glyphs are decompressed on every draw. Descriptors are kept
+ * in a fixed pool with LRU eviction. Bitmaps are packed at their own box size into a ring
+ * buffer, a new bitmap overwrites the oldest ones. Prepare() looks up the glyphs of a text
+ * before the LVGL lock is taken, so the layout under the lock hits the cache.
+ */
+class GlyphCache {
+public:
+    GlyphCache(const lv_font_t* base, int max_glyphs = GLYPH_CACHE_MAX_GLYPHS, size_t bitmap_bytes = GLYPH_CACHE_BITMAP_BYTES);
+    ~GlyphCache();
+
+    // Use this instead of the base font, it keeps the base font's metrics and fallback
+    const lv_font_t* font() const { return &font_; }
+    // Safe to call from any task
+    void Prepare(const char* text);
+    GlyphCacheStats TakeStats();
+    // A disabled cache forwards every lookup to the base font, for benchmarks
+    void SetEnabled(bool enabled);
+
+private:
+    struct GlyphEntry {
+        uint64_t key;
+        lv_font_glyph_dsc_t dsc;
+        bool found;
+        int16_t prev, next, hash_next;
+    };
+    struct BitmapEntry {
+        uint32_t key;
+        uint32_t offset;
+        uint32_t size;
+        int16_t prev, next, hash_next;
+    };
+
+    lv_font_t font_;
+    const lv_font_t* base_;
+    bool kerning_;
+    bool enabled_ = true;
+
+    std::mutex mutex_;
+    GlyphEntry* glyphs_ = nullptr;
+    int16_t* glyph_buckets_ = nullptr;
+    int glyph_capacity_ = 0;
+    int glyph_count_ = 0;
+    int16_t glyph_head_ = -1, glyph_tail_ = -1;
+
+    // Bitmap entries are listed newest first, which is also their order in the pool
+    BitmapEntry* bitmaps_ = nullptr;
+    int16_t* bitmap_buckets_ = nullptr;
+    int16_t bitmap_free_ = -1;
+    uint8_t* bitmap_pool_ = nullptr;
+    size_t bitmap_pool_size_ = 0;
+    size_t bitmap_write_ = 0;
+    int bitmap_capacity_ = 0;
+    int16_t bitmap_head_ = -1, bitmap_tail_ = -1;
+    // Whether the base font returns the draw buffer itself or its data
+    int8_t bitmap_returns_draw_buf_ = -1;
+
+    GlyphCacheStats stats_;
+
+    bool LookupGlyph(lv_font_glyph_dsc_t* dsc, uint32_t letter, uint32_t letter_next);
+    const void* LookupBitmap(lv_font_glyph_dsc_t* dsc, lv_draw_buf_t* draw_buf);
+    void EvictOldestBitmap();
+    int16_t AllocateBitmap(uint32_t size);
+
+    static bool GetGlyphDsc(const lv_font_t* font, lv_font_glyph_dsc_t* dsc, uint32_t letter, uint32_t letter_next);
+    static const void* GetGlyphBitmap(lv_font_glyph_dsc_t* dsc, lv_draw_buf_t* draw_buf);
+    static void ReleaseGlyph(const lv_font_t* font, lv_font_glyph_dsc_t* dsc);
+};
+
+#endif // GLYPH_CACHE_H
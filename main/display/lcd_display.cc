@@ -10,11 +10,17 @@
 #include "assets/lang_config.h"
 #include <cstring>
 #include "settings.h"
+#include "preview_image.h"
+#include "glyph_cache.h"
+#include "asset_pack.h"
 
 #include "board.h"
 
 #define TAG "LcdDisplay"
 
+// Replaces the built-in text font when the asset pack has it
+#define LCD_DISPLAY_TEXT_FONT_ASSET "text_font.bin"
+
 // Color definitions for dark theme
 #define DARK_BACKGROUND_COLOR       lv_color_hex(0x121212)     // Dark background
 #define DARK_TEXT_COLOR             lv_color_white()           // White text
@@ -140,6 +146,7 @@ SpiLcdDisplay::SpiLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_h
         ESP_LOGE(TAG, "Failed to add display");
         return;
     }
+    HoldCpuWhileRendering();
 
     if (offset_x != 0 || offset_y != 0) {
         lv_display_set_offset(display_, offset_x, offset_y);
@@ -203,6 +210,7 @@ RgbLcdDisplay::RgbLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_h
         ESP_LOGE(TAG, "Failed to add RGB display");
         return;
     }
+    HoldCpuWhileRendering();
     
     if (offset_x != 0 || offset_y != 0) {
         lv_display_set_offset(display_, offset_x, offset_y);
@@ -261,6 +269,7 @@ MipiLcdDisplay::MipiLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel
         ESP_LOGE(TAG, "Failed to add display");
         return;
     }
+    HoldCpuWhileRendering();
 
     if (offset_x != 0 || offset_y != 0) {
         lv_display_set_offset(display_, offset_x, offset_y);
@@ -283,6 +292,9 @@ LcdDisplay::~LcdDisplay() {
     if (container_ != nullptr) {
         lv_obj_del(container_);
     }
+    if (owned_preview_image_ != nullptr) {
+        DeletePreviewImage(owned_preview_image_);
+    }
     if (display_ != nullptr) {
         lv_display_delete(display_);
     }
@@ -293,6 +305,94 @@ LcdDisplay::~LcdDisplay() {
     if (panel_io_ != nullptr) {
         esp_lcd_panel_io_del(panel_io_);
     }
+    delete text_glyph_cache_;
+}
+
+void LcdDisplay::SetChatMessage(const char* role, const char* content) {
+    // Look up the glyphs before taking the LVGL lock, so the layout below only hits the cache
+    int64_t start_time = esp_timer_get_time();
+    if (text_glyph_cache_ != nullptr) {
+        text_glyph_cache_->Prepare(content);
+    }
+    int64_t prepare_time = esp_timer_get_time();
+#if CONFIG_USE_WECHAT_MESSAGE_STYLE
+    AddChatMessage(role, content);
+#else
+    Display::SetChatMessage(role, content);
+#endif
+    int64_t layout_time = esp_timer_get_time() - prepare_time;
+    prepare_time -= start_time;
+    ESP_LOGD(TAG, "Chat message prepared in %lld us, laid out in %lld us", prepare_time, layout_time);
+
+    chat_layout_total_us_ += layout_time;
+    chat_layout_max_us_ = std::max(chat_layout_max_us_, layout_time);
+    if (++chat_layout_count_ >= 10 && text_glyph_cache_ != nullptr) {
+        auto stats = text_glyph_cache_->TakeStats();
+        ESP_LOGI(TAG, "Chat layout avg %.1f ms max %.1f ms, glyph hits %lu/%lu, bitmap hits %lu/%lu",
+            chat_layout_total_us_ / 1000.0f / chat_layout_count_, chat_layout_max_us_ / 1000.0f,
+            stats.glyph_hits, stats.glyph_lookups, stats.bitmap_hits, stats.bitmap_lookups);
+        chat_layout_count_ = 0;
+        chat_layout_total_us_ = 0;
+        chat_layout_max_us_ = 0;
+    }
+}
+
+void LcdDisplay::RunTextBenchmark() {
+    // Same sentences on every run, so numbers from different builds can be compared
+    static const char* const kSentences[] = {
+        "你好，我是小智，很高兴认识你！",
+        "今天天气晴，最高气温二十六度，适合出门散步。",
+        "好的，已经帮你把音量调到百分之六十了。",
+        "Sure, here is a short story about a robot who learns to sing.",
+        "这个问题有点复杂，我们一步一步来看：首先，要弄清楚题目的条件。",
+        "明天上午九点提醒你开会，记得带上笔记本电脑。",
+    };
+    const int kRounds = 3;
+
+    for (int pass = 0; pass < 2; pass++) {
+        bool cached = pass == 1;
+        if (text_glyph_cache_ != nullptr) {
+            text_glyph_cache_->SetEnabled(cached);
+            text_glyph_cache_->TakeStats();
+        } else if (cached) {
+            break;
+        }
+
+        int64_t first_round_us = 0, total_us = 0, max_us = 0;
+        int count = 0;
+        for (int round = 0; round < kRounds; round++) {
+            for (auto sentence : kSentences) {
+                int64_t start = esp_timer_get_time();
+                SetChatMessage("assistant", sentence);
+                {
+                    // Draw and flush now, instead of waiting for the LVGL task
+                    DisplayLockGuard lock(this);
+                    lv_refr_now(display_);
+                }
+                int64_t elapsed = esp_timer_get_time() - start;
+                if (round == 0) {
+                    first_round_us += elapsed;
+                } else {
+                    total_us += elapsed;
+                    count++;
+                }
+                max_us = std::max(max_us, elapsed);
+            }
+        }
+
+        int sentences = sizeof(kSentences) / sizeof(kSentences[0]);
+        ESP_LOGI(TAG, "Text benchmark, glyph cache %s: first round %.2f ms, then %.2f ms per sentence, max %.2f ms",
+            cached ? "on" : "off", first_round_us / 1000.0f / sentences, total_us / 1000.0f / count, max_us / 1000.0f);
+        if (text_glyph_cache_ != nullptr) {
+            auto stats = text_glyph_cache_->TakeStats();
+            ESP_LOGI(TAG, "Text benchmark, glyph hits %lu/%lu, bitmap hits %lu/%lu",
+                stats.glyph_hits, stats.glyph_lookups, stats.bitmap_hits, stats.bitmap_lookups);
+        }
+    }
+    if (text_glyph_cache_ != nullptr) {
+        text_glyph_cache_->SetEnabled(true);
+    }
+    SetChatMessage("system", "");
 }
 
 bool LcdDisplay::Lock(int timeout_ms) {
@@ -303,9 +403,29 @@ void LcdDisplay::Unlock() {
     lvgl_port_unlock();
 }
 
+void LcdDisplay::InitializeTextFont() {
+    // 资源分区中的 text_font.bin 替换内置的文字字体，缺少的字形仍从内置字体中查找
+    auto& asset_pack = AssetPack::GetInstance();
+    if (fonts_.text_font != nullptr && asset_pack.Load()) {
+        auto font = asset_pack.GetFont(LCD_DISPLAY_TEXT_FONT_ASSET);
+        if (font != nullptr) {
+            font->fallback = fonts_.text_font;
+            fonts_.text_font = font;
+            ESP_LOGI(TAG, "Text font loaded from the asset pack, line height %d", font->line_height);
+        }
+    }
+
+    // Every label using the text font goes through the cache, it keeps the font's fallback
+    if (fonts_.text_font != nullptr) {
+        text_glyph_cache_ = new GlyphCache(fonts_.text_font);
+        fonts_.text_font = text_glyph_cache_->font();
+    }
+}
+
 #if CONFIG_USE_WECHAT_MESSAGE_STYLE
 void LcdDisplay::SetupUI() {
     DisplayLockGuard lock(this);
+    InitializeTextFont();
 
     auto screen = lv_screen_active();
     lv_obj_set_style_text_font(screen, fonts_.text_font, 0);
@@ -418,7 +538,7 @@ void LcdDisplay::SetupUI() {
 #else
 #define  MAX_MESSAGES 20
 #endif
-void LcdDisplay::SetChatMessage(const char* role, const char* content) {
+void LcdDisplay::AddChatMessage(const char* role, const char* content) {
     DisplayLockGuard lock(this);
     if (content_ == nullptr) {
         return;
@@ -602,109 +722,118 @@ void LcdDisplay::SetChatMessage(const char* role, const char* content) {
 }
 
 void LcdDisplay::SetPreviewImage(const lv_img_dsc_t* img_dsc) {
+    if (img_dsc == nullptr) {
+        return;
+    }
+
+    // Copy the image descriptor and data to avoid source data changes
+    lv_img_dsc_t* copied_img_dsc = (lv_img_dsc_t*)heap_caps_malloc(sizeof(lv_img_dsc_t), MALLOC_CAP_8BIT);
+    if (copied_img_dsc == nullptr) {
+        ESP_LOGE(TAG, "Failed to allocate memory for image descriptor");
+        return;
+    }
+
+    // Copy the header
+    copied_img_dsc->header = img_dsc->header;
+    copied_img_dsc->data_size = img_dsc->data_size;
+
+    // Copy the image data
+    uint8_t* copied_data = (uint8_t*)heap_caps_malloc(img_dsc->data_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (copied_data == nullptr) {
+        // Fallback to internal RAM if SPIRAM allocation fails
+        copied_data = (uint8_t*)heap_caps_malloc(img_dsc->data_size, MALLOC_CAP_8BIT);
+    }
+    if (copied_data == nullptr) {
+        ESP_LOGE(TAG, "Failed to allocate memory for image data (size: %lu bytes)", img_dsc->data_size);
+        heap_caps_free(copied_img_dsc);
+        return;
+    }
+
+    memcpy(copied_data, img_dsc->data, img_dsc->data_size);
+    copied_img_dsc->data = copied_data;
+    ShowPreviewImage(copied_img_dsc);
+}
+
+void LcdDisplay::TakePreviewImage(lv_img_dsc_t* img_dsc) {
+    if (img_dsc == nullptr) {
+        return;
+    }
+    // The image is released together with the bubble, so no copy is needed
+    ShowPreviewImage(img_dsc);
+}
+
+void LcdDisplay::ShowPreviewImage(lv_img_dsc_t* copied_img_dsc) {
     DisplayLockGuard lock(this);
     if (content_ == nullptr) {
+        DeletePreviewImage(copied_img_dsc);
         return;
     }
+
+    // Create a message bubble for image preview
+    lv_obj_t* img_bubble = lv_obj_create(content_);
+    lv_obj_set_style_radius(img_bubble, 8, 0);
+    lv_obj_set_scrollbar_mode(img_bubble, LV_SCROLLBAR_MODE_OFF);
+    lv_obj_set_style_border_width(img_bubble, 1, 0);
+    lv_obj_set_style_border_color(img_bubble, current_theme_.border, 0);
+    lv_obj_set_style_pad_all(img_bubble, 8, 0);
     
-    if (img_dsc != nullptr) {
-        // Create a message bubble for image preview
-        lv_obj_t* img_bubble = lv_obj_create(content_);
-        lv_obj_set_style_radius(img_bubble, 8, 0);
-        lv_obj_set_scrollbar_mode(img_bubble, LV_SCROLLBAR_MODE_OFF);
-        lv_obj_set_style_border_width(img_bubble, 1, 0);
-        lv_obj_set_style_border_color(img_bubble, current_theme_.border, 0);
-        lv_obj_set_style_pad_all(img_bubble, 8, 0);
-        
-        // Set image bubble background color (similar to system message)
-        lv_obj_set_style_bg_color(img_bubble, current_theme_.assistant_bubble, 0);
-        
-        // 设置自定义属性标记气泡类型
-        lv_obj_set_user_data(img_bubble, (void*)"image");
-        
-        // Create the image object inside the bubble
-        lv_obj_t* preview_image = lv_image_create(img_bubble);
-        
-        // Copy the image descriptor and data to avoid source data changes
-        lv_img_dsc_t* copied_img_dsc = (lv_img_dsc_t*)heap_caps_malloc(sizeof(lv_img_dsc_t), MALLOC_CAP_8BIT);
-        if (copied_img_dsc == nullptr) {
-            ESP_LOGE(TAG, "Failed to allocate memory for image descriptor");
-            lv_obj_del(img_bubble);
-            return;
-        }
-        
-        // Copy the header
-        copied_img_dsc->header = img_dsc->header;
-        copied_img_dsc->data_size = img_dsc->data_size;
-        
-        // Copy the image data
-        uint8_t* copied_data = (uint8_t*)heap_caps_malloc(img_dsc->data_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-        if (copied_data == nullptr) {
-            // Fallback to internal RAM if SPIRAM allocation fails
-            copied_data = (uint8_t*)heap_caps_malloc(img_dsc->data_size, MALLOC_CAP_8BIT);
-        }
-        if (copied_data == nullptr) {
-            ESP_LOGE(TAG, "Failed to allocate memory for image data (size: %lu bytes)", img_dsc->data_size);
-            heap_caps_free(copied_img_dsc);
-            lv_obj_del(img_bubble);
-            return;
-        }
-        
-        memcpy(copied_data, img_dsc->data, img_dsc->data_size);
-        copied_img_dsc->data = copied_data;
-        
-        // Calculate appropriate size for the image
-        lv_coord_t max_width = LV_HOR_RES * 70 / 100;  // 70% of screen width
-        lv_coord_t max_height = LV_VER_RES * 50 / 100; // 50% of screen height
-        
-        // Calculate zoom factor to fit within maximum dimensions
-        lv_coord_t img_width = copied_img_dsc->header.w;
-        lv_coord_t img_height = copied_img_dsc->header.h;
-        
-        lv_coord_t zoom_w = (max_width * 256) / img_width;
-        lv_coord_t zoom_h = (max_height * 256) / img_height;
-        lv_coord_t zoom = (zoom_w < zoom_h) ? zoom_w : zoom_h;
-        
-        // Ensure zoom doesn't exceed 256 (100%)
-        if (zoom > 256) zoom = 256;
-        
-        // Set image properties
-        lv_image_set_src(preview_image, copied_img_dsc);
-        lv_image_set_scale(preview_image, zoom);
-        
-        // Add event handler to clean up copied data when image is deleted
-        lv_obj_add_event_cb(preview_image, [](lv_event_t* e) {
-            lv_img_dsc_t* copied_img_dsc = (lv_img_dsc_t*)lv_event_get_user_data(e);
-            if (copied_img_dsc != nullptr) {
-                heap_caps_free((void*)copied_img_dsc->data);
-                heap_caps_free(copied_img_dsc);
-            }
-        }, LV_EVENT_DELETE, (void*)copied_img_dsc);
-        
-        // Calculate actual scaled image dimensions
-        lv_coord_t scaled_width = (img_width * zoom) / 256;
-        lv_coord_t scaled_height = (img_height * zoom) / 256;
-        
-        // Set bubble size to be 16 pixels larger than the image (8 pixels on each side)
-        lv_obj_set_width(img_bubble, scaled_width + 16);
-        lv_obj_set_height(img_bubble, scaled_height + 16);
-        
-        // Don't grow in flex layout
-        lv_obj_set_style_flex_grow(img_bubble, 0, 0);
-        
-        // Center the image within the bubble
-        lv_obj_center(preview_image);
-        
-        // Left align the image bubble like assistant messages
-        lv_obj_align(img_bubble, LV_ALIGN_LEFT_MID, 0, 0);
+    // Set image bubble background color (similar to system message)
+    lv_obj_set_style_bg_color(img_bubble, current_theme_.assistant_bubble, 0);
+    
+    // 设置自定义属性标记气泡类型
+    lv_obj_set_user_data(img_bubble, (void*)"image");
+    
+    // Create the image object inside the bubble
+    lv_obj_t* preview_image = lv_image_create(img_bubble);
+    
+    // Calculate appropriate size for the image
+    lv_coord_t max_width = LV_HOR_RES * 70 / 100;  // 70% of screen width
+    lv_coord_t max_height = LV_VER_RES * 50 / 100; // 50% of screen height
+    
+    // Calculate zoom factor to fit within maximum dimensions
+    lv_coord_t img_width = copied_img_dsc->header.w;
+    lv_coord_t img_height = copied_img_dsc->header.h;
+    
+    lv_coord_t zoom_w = (max_width * 256) / img_width;
+    lv_coord_t zoom_h = (max_height * 256) / img_height;
+    lv_coord_t zoom = (zoom_w < zoom_h) ? zoom_w : zoom_h;
+    
+    // Ensure zoom doesn't exceed 256 (100%)
+    if (zoom > 256) zoom = 256;
+    
+    // Set image properties
+    lv_image_set_src(preview_image, copied_img_dsc);
+    lv_image_set_scale(preview_image, zoom);
+    
+    // Add event handler to clean up copied data when image is deleted
+    lv_obj_add_event_cb(preview_image, [](lv_event_t* e) {
+        DeletePreviewImage((lv_img_dsc_t*)lv_event_get_user_data(e));
+    }, LV_EVENT_DELETE, (void*)copied_img_dsc);
+    
+    // Calculate actual scaled image dimensions
+    lv_coord_t scaled_width = (img_width * zoom) / 256;
+    lv_coord_t scaled_height = (img_height * zoom) / 256;
+    
+    // Set bubble size to be 16 pixels larger than the image (8 pixels on each side)
+    lv_obj_set_width(img_bubble, scaled_width + 16);
+    lv_obj_set_height(img_bubble, scaled_height + 16);
+    
+    // Don't grow in flex layout
+    lv_obj_set_style_flex_grow(img_bubble, 0, 0);
+    
+    // Center the image within the bubble
+    lv_obj_center(preview_image);
+    
+    // Left align the image bubble like assistant messages
+    lv_obj_align(img_bubble, LV_ALIGN_LEFT_MID, 0, 0);
 
-        // Auto-scroll to the image bubble
-        lv_obj_scroll_to_view_recursive(img_bubble, LV_ANIM_ON);
-    }
+    // Auto-scroll to the image bubble
+    lv_obj_scroll_to_view_recursive(img_bubble, LV_ANIM_ON);
 }
 #else
 void LcdDisplay::SetupUI() {
     DisplayLockGuard lock(this);
+    InitializeTextFont();
 
     auto screen = lv_screen_active();
     lv_obj_set_style_text_font(screen, fonts_.text_font, 0);
@@ -823,6 +952,11 @@ void LcdDisplay::SetPreviewImage(const lv_img_dsc_t* img_dsc) {
         if (emotion_label_ != nullptr) {
             lv_obj_add_flag(emotion_label_, LV_OBJ_FLAG_HIDDEN);
         }
+        // 释放不再显示的图片
+        if (owned_preview_image_ != nullptr && owned_preview_image_ != img_dsc) {
+            DeletePreviewImage(owned_preview_image_);
+            owned_preview_image_ = nullptr;
+        }
     } else {
         // 隐藏预览图片并显示emotion_label_
         lv_obj_add_flag(preview_image_, LV_OBJ_FLAG_HIDDEN);
@@ -831,6 +965,22 @@ void LcdDisplay::SetPreviewImage(const lv_img_dsc_t* img_dsc) {
         }
     }
 }
+
+void LcdDisplay::TakePreviewImage(lv_img_dsc_t* img_dsc) {
+    if (img_dsc == nullptr) {
+        return;
+    }
+    DisplayLockGuard lock(this);
+    if (preview_image_ == nullptr) {
+        DeletePreviewImage(img_dsc);
+        return;
+    }
+    // The image is shown without copying and released when it is replaced
+    auto previous = owned_preview_image_;
+    owned_preview_image_ = img_dsc;
+    SetPreviewImage(img_dsc);
+    DeletePreviewImage(previous);
+}
 #endif
 
 void LcdDisplay::SetEmotion(const char* emotion) {
@@ -9,6 +9,8 @@
 
 #include <atomic>
 
+class GlyphCache;
+
 // Theme color structure
 struct ThemeColors {
     lv_color_t background;
@@ -34,11 +36,22 @@ protected:
     lv_obj_t* container_ = nullptr;
     lv_obj_t* side_bar_ = nullptr;
     lv_obj_t* preview_image_ = nullptr;
+    lv_img_dsc_t* owned_preview_image_ = nullptr;
 
     DisplayFonts fonts_;
     ThemeColors current_theme_;
+    GlyphCache* text_glyph_cache_ = nullptr;
+    int chat_layout_count_ = 0;
+    int64_t chat_layout_total_us_ = 0;
+    int64_t chat_layout_max_us_ = 0;
 
     void SetupUI();
+    // Needs LVGL, so it runs from SetupUI() rather than the constructor
+    void InitializeTextFont();
+#if CONFIG_USE_WECHAT_MESSAGE_STYLE
+    void ShowPreviewImage(lv_img_dsc_t* img_dsc);
+    void AddChatMessage(const char* role, const char* content);
+#endif
     virtual bool Lock(int timeout_ms = 0) override;
     virtual void Unlock() override;
 
@@ -51,9 +64,9 @@ public:
     virtual void SetEmotion(const char* emotion) override;
     virtual void SetIcon(const char* icon) override;
     virtual void SetPreviewImage(const lv_img_dsc_t* img_dsc) override;
-#if CONFIG_USE_WECHAT_MESSAGE_STYLE
-    virtual void SetChatMessage(const char* role, const char* content) override; 
-#endif  
+    virtual void TakePreviewImage(lv_img_dsc_t* img_dsc) override;
+    virtual void SetChatMessage(const char* role, const char* content) override;
+    virtual void RunTextBenchmark() override;
 
     // Add theme switching function
     virtual void SetTheme(const std::string& theme_name) override;
@@ -0,0 +1,99 @@
+#include "preview_image.h"
+
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include <cstring>
+#include <algorithm>
+
+#define TAG "PreviewImage"
+
+// Swap the bytes of both 16-bit halves of a word
+static inline uint32_t Swap16x2(uint32_t v) {
+    return ((v & 0x00FF00FF) << 8) | ((v >> 8) & 0x00FF00FF);
+}
+
+void Rgb565ScaleSwap(const uint16_t* src, int src_width, uint16_t* dst, int dst_width, int dst_height, int factor) {
+    if (factor == 1 && src_width == dst_width && ((uintptr_t)src & 3) == 0 && ((uintptr_t)dst & 3) == 0) {
+        // Fast path: no scaling, swap four pixels per iteration
+        size_t words = (size_t)dst_width * dst_height / 2;
+        auto s = (const uint32_t*)src;
+        auto d = (uint32_t*)dst;
+        size_t i = 0;
+        for (; i + 2 <= words; i += 2) {
+            d[i] = Swap16x2(s[i]);
+            d[i + 1] = Swap16x2(s[i + 1]);
+        }
+        for (; i < words; i++) {
+            d[i] = Swap16x2(s[i]);
+        }
+        if ((dst_width * dst_height) & 1) {
+            size_t last = (size_t)dst_width * dst_height - 1;
+            dst[last] = __builtin_bswap16(src[last]);
+        }
+        return;
+    }
+
+    for (int y = 0; y < dst_height; y++) {
+        const uint16_t* row = src + (size_t)y * factor * src_width;
+        uint16_t* out = dst + (size_t)y * dst_width;
+        int x = 0;
+        if (((uintptr_t)out & 3) == 0) {
+            auto out32 = (uint32_t*)out;
+            for (; x + 2 <= dst_width; x += 2) {
+                uint32_t pair = row[x * factor] | ((uint32_t)row[(x + 1) * factor] << 16);
+                out32[x / 2] = Swap16x2(pair);
+            }
+        }
+        for (; x < dst_width; x++) {
+            out[x] = __builtin_bswap16(row[x * factor]);
+        }
+    }
+}
+
+lv_img_dsc_t* CreatePreviewImage(const uint16_t* frame, int frame_width, int frame_height, int max_width, int max_height) {
+    if (frame == nullptr || frame_width <= 0 || frame_height <= 0 || max_width <= 0 || max_height <= 0) {
+        return nullptr;
+    }
+
+    int factor = std::max((frame_width + max_width - 1) / max_width, (frame_height + max_height - 1) / max_height);
+    factor = std::max(factor, 1);
+    int width = frame_width / factor;
+    int height = frame_height / factor;
+
+    auto image = (lv_img_dsc_t*)heap_caps_malloc(sizeof(lv_img_dsc_t), MALLOC_CAP_8BIT);
+    if (image == nullptr) {
+        ESP_LOGE(TAG, "Failed to allocate memory for image descriptor");
+        return nullptr;
+    }
+    memset(image, 0, sizeof(lv_img_dsc_t));
+    image->header.magic = LV_IMAGE_HEADER_MAGIC;
+    image->header.cf = LV_COLOR_FORMAT_RGB565;
+    image->header.flags = LV_IMAGE_FLAGS_ALLOCATED | LV_IMAGE_FLAGS_MODIFIABLE;
+    image->header.w = width;
+    image->header.h = height;
+    image->header.stride = width * 2;
+    image->data_size = width * height * 2;
+
+    auto data = (uint16_t*)heap_caps_malloc(image->data_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (data == nullptr) {
+        // Fallback to internal RAM if SPIRAM allocation fails
+        data = (uint16_t*)heap_caps_malloc(image->data_size, MALLOC_CAP_8BIT);
+    }
+    if (data == nullptr) {
+        ESP_LOGE(TAG, "Failed to allocate memory for image data (size: %lu bytes)", (unsigned long)image->data_size);
+        heap_caps_free(image);
+        return nullptr;
+    }
+
+    Rgb565ScaleSwap(frame, frame_width, data, width, height, factor);
+    image->data = (const uint8_t*)data;
+    return image;
+}
+
+void DeletePreviewImage(lv_img_dsc_t* image) {
+    if (image == nullptr) {
+        return;
+    }
+    heap_caps_free((void*)image->data);
+    heap_caps_free(image);
+}
@@ -0,0 +1,22 @@
+#ifndef PREVIEW_IMAGE_H
+#define PREVIEW_IMAGE_H
+
+#include <lvgl.h>
+
+#include <cstdint>
+
+/**
+ * Create an RGB565 preview image from a camera frame.
+ *
+ * The frame is byte-swapped from the camera's big-endian RGB565 into LVGL's native order
+ * and downscaled by an integer factor in the same pass, so the result fits within
+ * max_width x max_height. The descriptor and pixel buffer are allocated with heap_caps_malloc
+ * and must be released with DeletePreviewImage(), or handed to Display::TakePreviewImage().
+ */
+lv_img_dsc_t* CreatePreviewImage(const uint16_t* frame, int frame_width, int frame_height, int max_width, int max_height);
+void DeletePreviewImage(lv_img_dsc_t* image);
+
+// Byte-swap and decimate RGB565 pixels, two pixels per 32-bit word
+void Rgb565ScaleSwap(const uint16_t* src, int src_width, uint16_t* dst, int dst_width, int dst_height, int factor);
+
+#endif // PREVIEW_IMAGE_H
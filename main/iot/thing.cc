@@ -44,10 +44,14 @@ std::string Thing::GetDescriptorJson() {
     return json_str;
 }
 
-std::string Thing::GetStateJson() {
+std::string Thing::GetStateJson(bool delta) {
+    uint32_t dirty = properties_.Poll();
+    if (delta && dirty == 0) {
+        return "";
+    }
     std::string json_str = "{";
     json_str += "\"name\":\"" + name_ + "\",";
-    json_str += "\"state\":" + properties_.GetStateJson();
+    json_str += "\"state\":" + properties_.GetStateJson(delta ? dirty : UINT32_MAX);
     json_str += "}";
     return json_str;
 }
@@ -79,8 +83,10 @@ void Thing::Invoke(const cJSON* command) {
             }
         }
 
-        Application::GetInstance().Schedule([&method]() {
+        auto& app = Application::GetInstance();
+        app.Schedule([&method, &app]() {
             method.Invoke();
+            app.NotifyStateChanged();
         });
     } catch (const std::runtime_error& e) {
         ESP_LOGE(TAG, "Method not found: %s", method_name->valuestring);
@@ -6,6 +6,8 @@
 #include <functional>
 #include <vector>
 #include <stdexcept>
+#include <variant>
+#include <cstdint>
 #include <cJSON.h>
 
 namespace iot {
@@ -24,6 +26,8 @@ private:
     std::function<bool()> boolean_getter_;
     std::function<int()> number_getter_;
     std::function<std::string()> string_getter_;
+    // 上次上报的值，用于检测变化
+    std::variant<std::monostate, bool, int, std::string> last_value_;
 
 public:
     Property(const std::string& name, const std::string& description, std::function<bool()> getter) :
@@ -55,13 +59,31 @@ public:
         return json_str;
     }
 
-    std::string GetStateJson() {
+    // Read the getter once and keep the typed value, returns true if it changed since the last poll
+    bool Poll() {
+        decltype(last_value_) value;
         if (type_ == kValueTypeBoolean) {
-            return boolean_getter_() ? "true" : "false";
+            value = boolean_getter_();
         } else if (type_ == kValueTypeNumber) {
-            return std::to_string(number_getter_());
+            value = number_getter_();
         } else if (type_ == kValueTypeString) {
-            return "\"" + string_getter_() + "\"";
+            value = string_getter_();
+        }
+        if (value == last_value_) {
+            return false;
+        }
+        last_value_ = std::move(value);
+        return true;
+    }
+
+    // Serialize the value read by the last Poll()
+    std::string GetStateJson() const {
+        if (std::holds_alternative<bool>(last_value_)) {
+            return std::get<bool>(last_value_) ? "true" : "false";
+        } else if (std::holds_alternative<int>(last_value_)) {
+            return std::to_string(std::get<int>(last_value_));
+        } else if (std::holds_alternative<std::string>(last_value_)) {
+            return "\"" + std::get<std::string>(last_value_) + "\"";
         }
         return "null";
     }
@@ -106,9 +128,25 @@ public:
         return json_str;
     }
 
-    std::string GetStateJson() {
+    // Poll every property, bit i is set if properties_[i] changed (only the first 32 are tracked)
+    uint32_t Poll() {
+        uint32_t dirty = 0;
+        for (size_t i = 0; i < properties_.size(); i++) {
+            if (properties_[i].Poll() && i < 32) {
+                dirty |= 1u << i;
+            }
+        }
+        return dirty;
+    }
+
+    // Serialize the polled values of the properties selected by mask
+    std::string GetStateJson(uint32_t mask = UINT32_MAX) {
         std::string json_str = "{";
-        for (auto& property : properties_) {
+        for (size_t i = 0; i < properties_.size(); i++) {
+            if (i < 32 && !(mask & (1u << i))) {
+                continue;
+            }
+            auto& property = properties_[i];
             json_str += "\"" + property.name() + "\":" + property.GetStateJson() + ",";
         }
         if (json_str.back() == ',') {
@@ -267,7 +305,8 @@ public:
     virtual ~Thing() = default;
 
     virtual std::string GetDescriptorJson();
-    virtual std::string GetStateJson();
+    // delta 为 true 时只包含变化的属性，没有变化时返回空字符串
+    virtual std::string GetStateJson(bool delta = false);
     virtual void Invoke(const cJSON* command);
 
     const std::string& name() const { return name_; }
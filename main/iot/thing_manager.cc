@@ -23,24 +23,15 @@ std::string ThingManager::GetDescriptorsJson() {
 }
 
 bool ThingManager::GetStatesJson(std::string& json, bool delta) {
-    if (!delta) {
-        last_states_.clear();
-    }
     bool changed = false;
     json = "[";
-    // 枚举thing，获取每个thing的state，如果发生变化，则更新，保存到last_states_
-    // 如果delta为true，则只返回变化的部分
+    // 每个属性保存上次上报的值，delta为true时只返回变化的属性
     for (auto& thing : things_) {
-        std::string state = thing->GetStateJson();
-        if (delta) {
-            // 如果delta为true，则只返回变化的部分
-            auto it = last_states_.find(thing->name());
-            if (it != last_states_.end() && it->second == state) {
-                continue;
-            }
-            changed = true;
-            last_states_[thing->name()] = state;
+        std::string state = thing->GetStateJson(delta);
+        if (state.empty()) {
+            continue;
         }
+        changed = true;
         json += state + ",";
     }
     if (json.back() == ',') {
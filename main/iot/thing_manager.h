@@ -33,7 +33,6 @@ private:
     ~ThingManager() = default;
 
     std::vector<Thing*> things_;
-    std::map<std::string, std::string> last_states_;
 };
 
 
@@ -1,16 +1,17 @@
 #include "circular_strip.h"
 #include "application.h"
 #include <esp_log.h>
+#include <algorithm>
+#include <cstdlib>
 
 #define TAG "CircularStrip"
 
-#define BLINK_INFINITE -1
-
 CircularStrip::CircularStrip(gpio_num_t gpio, uint8_t max_leds) : max_leds_(max_leds) {
     // If the gpio is not connected, you should use NoLed class
     assert(gpio != GPIO_NUM_NC);
 
     colors_.resize(max_leds_);
+    frame_.resize(max_leds_);
 
     led_strip_config_t strip_config = {};
     strip_config.strip_gpio_num = gpio;
@@ -24,156 +25,154 @@ CircularStrip::CircularStrip(gpio_num_t gpio, uint8_t max_leds) : max_leds_(max_
     ESP_ERROR_CHECK(led_strip_new_rmt_device(&strip_config, &rmt_config, &led_strip_));
     led_strip_clear(led_strip_);
 
-    esp_timer_create_args_t strip_timer_args = {
-        .callback = [](void *arg) {
-            auto strip = static_cast<CircularStrip*>(arg);
-            std::lock_guard<std::mutex> lock(strip->mutex_);
-            if (strip->strip_callback_ != nullptr) {
-                strip->strip_callback_();
-            }
-        },
-        .arg = this,
-        .dispatch_method = ESP_TIMER_TASK,
-        .name = "strip_timer",
-        .skip_unhandled_events = false,
-    };
-    ESP_ERROR_CHECK(esp_timer_create(&strip_timer_args, &strip_timer_));
+    LedAnimator::GetInstance().Register(this);
 }
 
 CircularStrip::~CircularStrip() {
-    esp_timer_stop(strip_timer_);
+    LedAnimator::GetInstance().Unregister(this);
     if (led_strip_ != nullptr) {
         led_strip_del(led_strip_);
     }
 }
 
+static inline uint8_t MixChannel(uint8_t low, uint8_t high, uint8_t level) {
+    return low + ((int)high - low) * level / 255;
+}
 
-void CircularStrip::SetAllColor(StripColor color) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    esp_timer_stop(strip_timer_);
+bool CircularStrip::Render(uint32_t now_ms) {
+    uint32_t elapsed = now_ms - animation_start_ms_;
+    uint8_t scale = animation_.AudioScale();
+    bool changed = false;
     for (int i = 0; i < max_leds_; i++) {
-        colors_[i] = color;
-        led_strip_set_pixel(led_strip_, i, color.red, color.green, color.blue);
+        uint8_t level = LedGamma(animation_.Evaluate(elapsed, i) * scale / 255);
+        StripColor color = {
+            MixChannel(low_color_.red, colors_[i].red, level),
+            MixChannel(low_color_.green, colors_[i].green, level),
+            MixChannel(low_color_.blue, colors_[i].blue, level),
+        };
+        if (color != frame_[i]) {
+            frame_[i] = color;
+            led_strip_set_pixel(led_strip_, i, color.red, color.green, color.blue);
+            changed = true;
+        }
+    }
+    // Only send the strip over RMT when at least one pixel changed
+    if (changed) {
+        led_strip_refresh(led_strip_);
     }
-    led_strip_refresh(led_strip_);
+    return !animation_.Finished(elapsed, max_leds_ - 1);
 }
 
-void CircularStrip::SetSingleColor(uint8_t index, StripColor color) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    esp_timer_stop(strip_timer_);
-    colors_[index] = color;
-    led_strip_set_pixel(led_strip_, index, color.red, color.green, color.blue);
-    led_strip_refresh(led_strip_);
+void CircularStrip::Play(const LedAnimation& animation) {
+    if (led_strip_ == nullptr) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint32_t now = LedAnimator::now_ms();
+        // Keep the phase when the same animation is requested again (e.g. on VAD changes)
+        if (!animating_ || !(animation == animation_)) {
+            animation_ = animation;
+            animation_start_ms_ = now;
+        }
+        animating_ = Render(now);
+        if (!animating_) {
+            return;
+        }
+    }
+    LedAnimator::GetInstance().Wake();
 }
 
-void CircularStrip::Blink(StripColor color, int interval_ms) {
-    for (int i = 0; i < max_leds_; i++) {
-        colors_[i] = color;
+bool CircularStrip::OnAnimationTick(uint32_t now_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!animating_) {
+        return false;
     }
-    StartStripTask(interval_ms, [this]() {
-        static bool on = true;
-        if (on) {
-            for (int i = 0; i < max_leds_; i++) {
-                led_strip_set_pixel(led_strip_, i, colors_[i].red, colors_[i].green, colors_[i].blue);
-            }
-            led_strip_refresh(led_strip_);
-        } else {
-            led_strip_clear(led_strip_);
-        }
-        on = !on;
-    });
+    animating_ = Render(now_ms);
+    return animating_;
 }
 
-void CircularStrip::FadeOut(int interval_ms) {
-    StartStripTask(interval_ms, [this]() {
-        bool all_off = true;
+// Stop the animation and continue from whatever is currently shown
+void CircularStrip::Freeze() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    animating_ = false;
+    colors_ = frame_;
+    low_color_ = {};
+}
+
+void CircularStrip::SetAllColor(StripColor color) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
         for (int i = 0; i < max_leds_; i++) {
-            colors_[i].red /= 2;
-            colors_[i].green /= 2;
-            colors_[i].blue /= 2;
-            if (colors_[i].red != 0 || colors_[i].green != 0 || colors_[i].blue != 0) {
-                all_off = false;
-            }
-            led_strip_set_pixel(led_strip_, i, colors_[i].red, colors_[i].green, colors_[i].blue);
+            colors_[i] = color;
         }
-        if (all_off) {
-            led_strip_clear(led_strip_);
-            esp_timer_stop(strip_timer_);
-        } else {
-            led_strip_refresh(led_strip_);
+    }
+    Play(LedAnimation::Solid(255));
+}
+
+void CircularStrip::SetSingleColor(uint8_t index, StripColor color) {
+    if (index >= max_leds_) {
+        return;
+    }
+    Freeze();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        colors_[index] = color;
+    }
+    Play(LedAnimation::Solid(255));
+}
+
+void CircularStrip::Blink(StripColor color, int interval_ms) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (int i = 0; i < max_leds_; i++) {
+            colors_[i] = color;
         }
-    });
+        low_color_ = {};
+    }
+    Play(LedAnimation::Blink(interval_ms));
+}
+
+void CircularStrip::FadeOut(int interval_ms) {
+    Freeze();
+    // Roughly the time the old halving fade took from full brightness
+    Play(LedAnimation::FadeOut(interval_ms * 8));
 }
 
 void CircularStrip::Breathe(StripColor low, StripColor high, int interval_ms) {
-    StartStripTask(interval_ms, [this, low, high]() {
-        static bool increase = true;
-        static StripColor color = low;
-        if (increase) {
-            if (color.red < high.red) {
-                color.red++;
-            }
-            if (color.green < high.green) {
-                color.green++;
-            }
-            if (color.blue < high.blue) {
-                color.blue++;
-            }
-            if (color.red == high.red && color.green == high.green && color.blue == high.blue) {
-                increase = false;
-            }
-        } else {
-            if (color.red > low.red) {
-                color.red--;
-            }
-            if (color.green > low.green) {
-                color.green--;
-            }
-            if (color.blue > low.blue) {
-                color.blue--;
-            }
-            if (color.red == low.red && color.green == low.green && color.blue == low.blue) {
-                increase = true;
-            }
-        }
+    // One brightness step per interval, as before
+    int steps = std::max({ std::abs(high.red - low.red), std::abs(high.green - low.green), std::abs(high.blue - low.blue), 1 });
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
         for (int i = 0; i < max_leds_; i++) {
-            led_strip_set_pixel(led_strip_, i, color.red, color.green, color.blue);
+            colors_[i] = high;
         }
-        led_strip_refresh(led_strip_);
-    });
+        low_color_ = low;
+    }
+    Play(LedAnimation::Breathe(steps * interval_ms));
 }
 
 void CircularStrip::Scroll(StripColor low, StripColor high, int length, int interval_ms) {
-    for (int i = 0; i < max_leds_; i++) {
-        colors_[i] = low;
-    }
-    StartStripTask(interval_ms, [this, low, high, length]() {
-        static int offset = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
         for (int i = 0; i < max_leds_; i++) {
-            colors_[i] = low;
-        }
-        for (int j = 0; j < length; j++) {
-            int i = (offset + j) % max_leds_;
             colors_[i] = high;
         }
-        for (int i = 0; i < max_leds_; i++) {
-            led_strip_set_pixel(led_strip_, i, colors_[i].red, colors_[i].green, colors_[i].blue);
-        }
-        led_strip_refresh(led_strip_);
-        offset = (offset + 1) % max_leds_;
-    });
+        low_color_ = low;
+    }
+    Play(LedAnimation::Scroll(max_leds_, length, interval_ms));
 }
 
-void CircularStrip::StartStripTask(int interval_ms, std::function<void()> cb) {
-    if (led_strip_ == nullptr) {
-        return;
+void CircularStrip::AudioReactive(StripColor color, bool output) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (int i = 0; i < max_leds_; i++) {
+            colors_[i] = color;
+        }
+        low_color_ = {};
     }
-
-    std::lock_guard<std::mutex> lock(mutex_);
-    esp_timer_stop(strip_timer_);
-    
-    strip_callback_ = cb;
-    esp_timer_start_periodic(strip_timer_, interval_ms * 1000);
+    Play(LedAnimation::AudioLevel(output ? kLedAudioOutput : kLedAudioInput));
 }
 
 void CircularStrip::SetBrightness(uint8_t default_brightness, uint8_t low_brightness) {
@@ -208,12 +207,12 @@ void CircularStrip::OnStateChanged() {
         case kDeviceStateListening:
         case kDeviceStateAudioTesting: {
             StripColor color = { default_brightness_, low_brightness_, low_brightness_ };
-            SetAllColor(color);
+            AudioReactive(color, false);
             break;
         }
         case kDeviceStateSpeaking: {
             StripColor color = { low_brightness_, default_brightness_, low_brightness_ };
-            SetAllColor(color);
+            AudioReactive(color, true);
             break;
         }
         case kDeviceStateUpgrading: {
@@ -2,6 +2,7 @@
 #define _CIRCULAR_STRIP_H_
 
 #include "led.h"
+#include "led_animator.h"
 #include <driver/gpio.h>
 #include <led_strip.h>
 #include <esp_timer.h>
@@ -14,9 +15,11 @@
 
 struct StripColor {
     uint8_t red = 0, green = 0, blue = 0;
+
+    bool operator==(const StripColor&) const = default;
 };
 
-class CircularStrip : public Led {
+class CircularStrip : public Led, public LedAnimationTarget {
 public:
     CircularStrip(gpio_num_t gpio, uint8_t max_leds);
     virtual ~CircularStrip();
@@ -28,22 +31,30 @@ public:
     void Blink(StripColor color, int interval_ms);
     void Breathe(StripColor low, StripColor high, int interval_ms);
     void Scroll(StripColor low, StripColor high, int length, int interval_ms);
+    // Brightness follows the microphone or the playback loudness
+    void AudioReactive(StripColor color, bool output);
+
+    bool OnAnimationTick(uint32_t now_ms) override;
 
 private:
     std::mutex mutex_;
-    TaskHandle_t blink_task_ = nullptr;
     led_strip_handle_t led_strip_ = nullptr;
     int max_leds_ = 0;
+    // Each LED is rendered between low_color_ (level 0) and colors_[i] (level 255)
     std::vector<StripColor> colors_;
-    int blink_counter_ = 0;
-    int blink_interval_ms_ = 0;
-    esp_timer_handle_t strip_timer_ = nullptr;
-    std::function<void()> strip_callback_ = nullptr;
+    StripColor low_color_;
+    // Colors currently pushed to the strip
+    std::vector<StripColor> frame_;
+    LedAnimation animation_;
+    uint32_t animation_start_ms_ = 0;
+    bool animating_ = false;
 
     uint8_t default_brightness_ = DEFAULT_BRIGHTNESS;
     uint8_t low_brightness_ = LOW_BRIGHTNESS;
 
-    void StartStripTask(int interval_ms, std::function<void()> cb);
+    void Play(const LedAnimation& animation);
+    void Freeze();
+    bool Render(uint32_t now_ms);
     void Rainbow(StripColor low, StripColor high, int interval_ms);
     void FadeOut(int interval_ms);
 };
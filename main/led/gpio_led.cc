@@ -60,35 +60,14 @@ GpioLed::GpioLed(gpio_num_t gpio, int output_invert, ledc_timer_t timer_num, led
     // Set LED Controller with previously prepared configuration
     ledc_channel_config(&ledc_channel_);
 
-    // Initialize fade service.
-    ledc_fade_func_install(0);
-
-    // When the callback registered by ledc_cb_degister is called, run led ->OnFadeEnd()
-    ledc_cbs_t ledc_callbacks = {
-        .fade_cb = FadeCallback
-    };
-    ledc_cb_register(ledc_channel_.speed_mode, ledc_channel_.channel, &ledc_callbacks, this);
-
-    esp_timer_create_args_t blink_timer_args = {
-        .callback = [](void *arg) {
-            auto led = static_cast<GpioLed*>(arg);
-            led->OnBlinkTimer();
-        },
-        .arg = this,
-        .dispatch_method = ESP_TIMER_TASK,
-        .name = "Blink Timer",
-        .skip_unhandled_events = false,
-    };
-    ESP_ERROR_CHECK(esp_timer_create(&blink_timer_args, &blink_timer_));
-
     ledc_initialized_ = true;
+    LedAnimator::GetInstance().Register(this);
 }
 
 GpioLed::~GpioLed() {
-    esp_timer_stop(blink_timer_);
+    LedAnimator::GetInstance().Unregister(this);
     if (ledc_initialized_) {
-        ledc_fade_stop(ledc_channel_.speed_mode, ledc_channel_.channel);
-        ledc_fade_func_uninstall();
+        ledc_stop(ledc_channel_.speed_mode, ledc_channel_.channel, 0);
     }
 }
 
@@ -101,28 +80,53 @@ void GpioLed::SetBrightness(uint8_t brightness) {
     }
 }
 
-void GpioLed::TurnOn() {
-    if (!ledc_initialized_) {
-        return;
+bool GpioLed::Render(uint32_t now_ms) {
+    uint32_t elapsed = now_ms - animation_start_ms_;
+    uint32_t duty = duty_ * LedGamma(animation_.Evaluate(elapsed, 0) * animation_.AudioScale() / 255) / 255;
+    if (duty != current_duty_) {
+        current_duty_ = duty;
+        ledc_set_duty(ledc_channel_.speed_mode, ledc_channel_.channel, duty);
+        ledc_update_duty(ledc_channel_.speed_mode, ledc_channel_.channel);
     }
-
-    std::lock_guard<std::mutex> lock(mutex_);
-    esp_timer_stop(blink_timer_);
-    ledc_fade_stop(ledc_channel_.speed_mode, ledc_channel_.channel);
-    ledc_set_duty(ledc_channel_.speed_mode, ledc_channel_.channel, duty_);
-    ledc_update_duty(ledc_channel_.speed_mode, ledc_channel_.channel);
+    return !animation_.Finished(elapsed, 0);
 }
 
-void GpioLed::TurnOff() {
+void GpioLed::Play(const LedAnimation& animation) {
     if (!ledc_initialized_) {
         return;
     }
 
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint32_t now = LedAnimator::now_ms();
+        // Keep the phase when the same animation is requested again (e.g. on VAD changes)
+        if (!animating_ || !(animation == animation_)) {
+            animation_ = animation;
+            animation_start_ms_ = now;
+        }
+        animating_ = Render(now);
+        if (!animating_) {
+            return;
+        }
+    }
+    LedAnimator::GetInstance().Wake();
+}
+
+bool GpioLed::OnAnimationTick(uint32_t now_ms) {
     std::lock_guard<std::mutex> lock(mutex_);
-    esp_timer_stop(blink_timer_);
-    ledc_fade_stop(ledc_channel_.speed_mode, ledc_channel_.channel);
-    ledc_set_duty(ledc_channel_.speed_mode, ledc_channel_.channel, 0);
-    ledc_update_duty(ledc_channel_.speed_mode, ledc_channel_.channel);
+    if (!animating_) {
+        return false;
+    }
+    animating_ = Render(now_ms);
+    return animating_;
+}
+
+void GpioLed::TurnOn() {
+    Play(LedAnimation::Solid(255));
+}
+
+void GpioLed::TurnOff() {
+    Play(LedAnimation::Solid(0));
 }
 
 void GpioLed::BlinkOnce() {
@@ -138,64 +142,11 @@ void GpioLed::StartContinuousBlink(int interval_ms) {
 }
 
 void GpioLed::StartBlinkTask(int times, int interval_ms) {
-    if (!ledc_initialized_) {
-        return;
-    }
-
-    std::lock_guard<std::mutex> lock(mutex_);
-    esp_timer_stop(blink_timer_);
-    ledc_fade_stop(ledc_channel_.speed_mode, ledc_channel_.channel);
-
-    blink_counter_ = times * 2;
-    blink_interval_ms_ = interval_ms;
-    esp_timer_start_periodic(blink_timer_, interval_ms * 1000);
-}
-
-void GpioLed::OnBlinkTimer() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    blink_counter_--;
-    if (blink_counter_ & 1) {
-        ledc_set_duty(ledc_channel_.speed_mode, ledc_channel_.channel, duty_);
-    } else {
-        ledc_set_duty(ledc_channel_.speed_mode, ledc_channel_.channel, 0);
-
-        if (blink_counter_ == 0) {
-            esp_timer_stop(blink_timer_);
-        }
-    }
-    ledc_update_duty(ledc_channel_.speed_mode, ledc_channel_.channel);
+    Play(LedAnimation::Blink(interval_ms, times == BLINK_INFINITE ? 0 : times));
 }
 
 void GpioLed::StartFadeTask() {
-    if (!ledc_initialized_) {
-        return;
-    }
-
-    std::lock_guard<std::mutex> lock(mutex_);
-    esp_timer_stop(blink_timer_);
-    ledc_fade_stop(ledc_channel_.speed_mode, ledc_channel_.channel);
-    fade_up_ = true;
-    ledc_set_fade_with_time(ledc_channel_.speed_mode,
-                            ledc_channel_.channel, LEDC_DUTY, LEDC_FADE_TIME);
-    ledc_fade_start(ledc_channel_.speed_mode,
-                    ledc_channel_.channel, LEDC_FADE_NO_WAIT);
-}
-
-void GpioLed::OnFadeEnd() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    fade_up_ = !fade_up_;
-    ledc_set_fade_with_time(ledc_channel_.speed_mode,
-                            ledc_channel_.channel, fade_up_ ? LEDC_DUTY : 0, LEDC_FADE_TIME);
-    ledc_fade_start(ledc_channel_.speed_mode,
-                    ledc_channel_.channel, LEDC_FADE_NO_WAIT);
-}
-
-bool IRAM_ATTR GpioLed::FadeCallback(const ledc_cb_param_t *param, void *user_arg) {
-    if (param->event == LEDC_FADE_END_EVT) {
-        auto led = static_cast<GpioLed*>(user_arg);
-        led->OnFadeEnd();
-    }
-    return true;
+    Play(LedAnimation::Breathe(LEDC_FADE_TIME));
 }
 
 void GpioLed::OnStateChanged() {
@@ -226,12 +177,12 @@ void GpioLed::OnStateChanged() {
             } else {
                 SetBrightness(LOW_BRIGHTNESS);
             }
-            // TurnOn();
-            StartFadeTask();
+            // Follow the microphone level
+            Play(LedAnimation::AudioLevel(kLedAudioInput));
             break;
         case kDeviceStateSpeaking:
             SetBrightness(SPEAKING_BRIGHTNESS);
-            TurnOn();
+            Play(LedAnimation::AudioLevel(kLedAudioOutput));
             break;
         case kDeviceStateUpgrading:
             SetBrightness(UPGRADING_BRIGHTNESS);
@@ -4,13 +4,14 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include "led.h"
+#include "led_animator.h"
 #include <driver/gpio.h>
 #include <driver/ledc.h>
 #include <esp_timer.h>
 #include <atomic>
 #include <mutex>
 
-class GpioLed : public Led {
+class GpioLed : public Led, public LedAnimationTarget {
  public:
     GpioLed(gpio_num_t gpio);
     GpioLed(gpio_num_t gpio, int output_invert);
@@ -22,26 +23,27 @@ class GpioLed : public Led {
     void TurnOff();
     void SetBrightness(uint8_t brightness);
 
+    bool OnAnimationTick(uint32_t now_ms) override;
+
  private:
     std::mutex mutex_;
-    TaskHandle_t blink_task_ = nullptr;
     ledc_channel_config_t ledc_channel_ = {0};
     bool ledc_initialized_ = false;
+    // Duty at animation level 255
     uint32_t duty_ = 0;
-    int blink_counter_ = 0;
-    int blink_interval_ms_ = 0;
-    esp_timer_handle_t blink_timer_ = nullptr;
-    bool fade_up_ = true;
+    uint32_t current_duty_ = 0;
+    LedAnimation animation_;
+    uint32_t animation_start_ms_ = 0;
+    bool animating_ = false;
 
-    void StartBlinkTask(int times, int interval_ms);
-    void OnBlinkTimer();
+    void Play(const LedAnimation& animation);
+    bool Render(uint32_t now_ms);
 
+    void StartBlinkTask(int times, int interval_ms);
     void BlinkOnce();
     void Blink(int times, int interval_ms);
     void StartContinuousBlink(int interval_ms);
     void StartFadeTask();
-    void OnFadeEnd();
-    static bool IRAM_ATTR FadeCallback(const ledc_cb_param_t *param, void *user_arg);
 };
 
 #endif  // _GPIO_LED_H_
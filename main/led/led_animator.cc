@@ -0,0 +1,230 @@
+#include "led_animator.h"
+#include "application.h"
+
+#include <esp_log.h>
+#include <algorithm>
+#include <array>
+
+#define TAG "LedAnimator"
+
+static const uint8_t kGammaTable[256] = {
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,
+      3,   3,   3,   3,   3,   4,   4,   4,   4,   5,   5,   5,   5,   6,   6,   6,
+      6,   7,   7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  11,  11,  11,  12,
+     12,  13,  13,  13,  14,  14,  15,  15,  16,  16,  17,  17,  18,  18,  19,  19,
+     20,  20,  21,  22,  22,  23,  23,  24,  25,  25,  26,  26,  27,  28,  28,  29,
+     30,  30,  31,  32,  33,  33,  34,  35,  35,  36,  37,  38,  39,  39,  40,  41,
+     42,  43,  43,  44,  45,  46,  47,  48,  49,  49,  50,  51,  52,  53,  54,  55,
+     56,  57,  58,  59,  60,  61,  62,  63,  64,  65,  66,  67,  68,  69,  70,  71,
+     73,  74,  75,  76,  77,  78,  79,  81,  82,  83,  84,  85,  87,  88,  89,  90,
+     91,  93,  94,  95,  97,  98,  99, 100, 102, 103, 105, 106, 107, 109, 110, 111,
+    113, 114, 116, 117, 119, 120, 121, 123, 124, 126, 127, 129, 130, 132, 133, 135,
+    137, 138, 140, 141, 143, 145, 146, 148, 149, 151, 153, 154, 156, 158, 159, 161,
+    163, 165, 166, 168, 170, 172, 173, 175, 177, 179, 181, 182, 184, 186, 188, 190,
+    192, 194, 196, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221,
+    223, 225, 227, 229, 231, 234, 236, 238, 240, 242, 244, 246, 248, 251, 253, 255,
+};
+
+template <typename F>
+static constexpr std::array<uint8_t, 256> MakeEasingTable(F curve) {
+    std::array<uint8_t, 256> table = {};
+    for (int x = 0; x < 256; x++) {
+        table[x] = curve(x);
+    }
+    return table;
+}
+
+// Keep some light on when the stream is quiet
+#define LED_AUDIO_MIN_SCALE 48
+
+// Quadratic ease-in / ease-out and smoothstep, computed at compile time
+static constexpr auto kEaseInTable = MakeEasingTable([](int x) { return x * x / 255; });
+static constexpr auto kEaseOutTable = MakeEasingTable([](int x) { return 255 - (255 - x) * (255 - x) / 255; });
+static constexpr auto kEaseInOutTable = MakeEasingTable([](int x) { return x * x * (765 - 2 * x) / 65025; });
+
+uint8_t LedGamma(uint8_t level) {
+    return kGammaTable[level];
+}
+
+static uint8_t Ease(LedEasing easing, uint8_t x) {
+    switch (easing) {
+        case kLedEasingIn:
+            return kEaseInTable[x];
+        case kLedEasingOut:
+            return kEaseOutTable[x];
+        case kLedEasingInOut:
+            return kEaseInOutTable[x];
+        case kLedEasingStep:
+            return 0;
+        default:
+            return x;
+    }
+}
+
+static uint16_t ClampTime(int time_ms) {
+    return std::clamp(time_ms, 0, 0xFFFF);
+}
+
+uint8_t LedAnimation::Evaluate(uint32_t elapsed_ms, int index) const {
+    if (count == 0) {
+        return 0;
+    }
+    const LedKeyframe& last = keyframes[count - 1];
+    int32_t duration = last.time_ms;
+    if (count == 1 || duration == 0) {
+        return last.level;
+    }
+
+    int32_t t = (int32_t)elapsed_ms - index * phase_ms;
+    if (repeat == 0) {
+        t %= duration;
+        if (t < 0) {
+            t += duration;
+        }
+    } else if (t < 0) {
+        return keyframes[0].level;
+    } else if (t >= duration * repeat) {
+        return last.level;
+    } else {
+        t %= duration;
+    }
+
+    int i = count - 2;
+    while (i > 0 && keyframes[i].time_ms > t) {
+        i--;
+    }
+    const LedKeyframe& from = keyframes[i];
+    const LedKeyframe& to = keyframes[i + 1];
+    int32_t span = to.time_ms - from.time_ms;
+    if (span <= 0) {
+        return to.level;
+    }
+    uint8_t x = (t - from.time_ms) * 255 / span;
+    return from.level + ((int)to.level - from.level) * Ease(from.easing, x) / 255;
+}
+
+bool LedAnimation::Finished(uint32_t elapsed_ms, int last_index) const {
+    if (repeat == 0) {
+        return false;
+    }
+    uint32_t duration = count > 0 ? keyframes[count - 1].time_ms : 0;
+    return elapsed_ms >= duration * repeat + last_index * phase_ms;
+}
+
+LedAnimation LedAnimation::Solid(uint8_t level) {
+    LedAnimation animation;
+    animation.keyframes[0] = { 0, level, kLedEasingStep };
+    animation.count = 1;
+    animation.repeat = 1;
+    return animation;
+}
+
+LedAnimation LedAnimation::Blink(int interval_ms, int times) {
+    LedAnimation animation;
+    animation.keyframes[0] = { 0, 255, kLedEasingStep };
+    animation.keyframes[1] = { ClampTime(interval_ms), 0, kLedEasingStep };
+    animation.keyframes[2] = { ClampTime(interval_ms * 2), 0, kLedEasingStep };
+    animation.count = 3;
+    animation.repeat = std::clamp(times, 0, 255);
+    return animation;
+}
+
+LedAnimation LedAnimation::Breathe(int half_period_ms) {
+    LedAnimation animation;
+    animation.keyframes[0] = { 0, 0, kLedEasingInOut };
+    animation.keyframes[1] = { ClampTime(half_period_ms), 255, kLedEasingInOut };
+    animation.keyframes[2] = { ClampTime(half_period_ms * 2), 0, kLedEasingStep };
+    animation.count = 3;
+    return animation;
+}
+
+LedAnimation LedAnimation::FadeOut(int duration_ms) {
+    LedAnimation animation;
+    animation.keyframes[0] = { 0, 255, kLedEasingOut };
+    animation.keyframes[1] = { ClampTime(duration_ms), 0, kLedEasingStep };
+    animation.count = 2;
+    animation.repeat = 1;
+    return animation;
+}
+
+LedAnimation LedAnimation::Scroll(int leds, int length, int interval_ms) {
+    // Every LED plays the same on/off pulse, delayed by one interval per LED
+    LedAnimation animation;
+    animation.keyframes[0] = { 0, 255, kLedEasingStep };
+    animation.keyframes[1] = { ClampTime(std::min(length, leds) * interval_ms), 0, kLedEasingStep };
+    animation.keyframes[2] = { ClampTime(leds * interval_ms), 0, kLedEasingStep };
+    animation.count = 3;
+    animation.phase_ms = ClampTime(interval_ms);
+    return animation;
+}
+
+LedAnimation LedAnimation::AudioLevel(LedAudioSource source) {
+    LedAnimation animation = Solid(255);
+    animation.repeat = 0;
+    animation.audio_source = source;
+    return animation;
+}
+
+uint8_t LedAnimation::AudioScale() const {
+    if (audio_source == kLedAudioNone) {
+        return 255;
+    }
+    auto& app = Application::GetInstance();
+    auto levels = audio_source == kLedAudioInput ? app.GetInputLevels() : app.GetOutputLevels();
+    return LED_AUDIO_MIN_SCALE + levels.rms * (255 - LED_AUDIO_MIN_SCALE) / 255;
+}
+
+LedAnimator::LedAnimator() {
+    esp_timer_create_args_t timer_args = {
+        .callback = [](void *arg) {
+            auto animator = static_cast<LedAnimator*>(arg);
+            animator->OnTick();
+        },
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "led_animator",
+        .skip_unhandled_events = true,
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &timer_));
+}
+
+LedAnimator::~LedAnimator() {
+    if (timer_ != nullptr) {
+        esp_timer_stop(timer_);
+        esp_timer_delete(timer_);
+    }
+}
+
+void LedAnimator::Register(LedAnimationTarget* target) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    targets_.push_back(target);
+}
+
+void LedAnimator::Unregister(LedAnimationTarget* target) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    targets_.erase(std::remove(targets_.begin(), targets_.end(), target), targets_.end());
+}
+
+void LedAnimator::Wake() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_) {
+        running_ = true;
+        esp_timer_start_periodic(timer_, LED_ANIMATION_TICK_MS * 1000);
+    }
+}
+
+void LedAnimator::OnTick() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint32_t now = now_ms();
+    bool active = false;
+    for (auto target : targets_) {
+        if (target->OnAnimationTick(now)) {
+            active = true;
+        }
+    }
+    if (!active && running_) {
+        esp_timer_stop(timer_);
+        running_ = false;
+    }
+}
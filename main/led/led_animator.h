@@ -0,0 +1,107 @@
+#ifndef _LED_ANIMATOR_H_
+#define _LED_ANIMATOR_H_
+
+#include <esp_timer.h>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#define LED_ANIMATION_TICK_MS 20
+#define LED_ANIMATION_MAX_KEYFRAMES 6
+
+enum LedEasing : uint8_t {
+    kLedEasingLinear,
+    kLedEasingIn,
+    kLedEasingOut,
+    kLedEasingInOut,
+    kLedEasingStep,
+};
+
+// Scale an animation by the loudness of an audio stream
+enum LedAudioSource : uint8_t {
+    kLedAudioNone,
+    kLedAudioInput,
+    kLedAudioOutput,
+};
+
+struct LedKeyframe {
+    uint16_t time_ms;   // Time from the start of the animation
+    uint8_t level;      // 0 ~ 255, interpolated between the target's low and high output
+    LedEasing easing;   // Curve used from this keyframe to the next one
+
+    bool operator==(const LedKeyframe&) const = default;
+};
+
+/**
+ * Declarative keyframe animation. Keyframes are evaluated against precomputed easing
+ * tables, so rendering a tick costs a table lookup and a multiply per LED.
+ */
+struct LedAnimation {
+    LedKeyframe keyframes[LED_ANIMATION_MAX_KEYFRAMES] = {};
+    uint8_t count = 0;
+    uint8_t repeat = 0;     // Number of plays, 0 means forever
+    uint16_t phase_ms = 0;  // Delay of each LED relative to the previous one
+    LedAudioSource audio_source = kLedAudioNone;
+
+    bool operator==(const LedAnimation&) const = default;
+
+    uint8_t Evaluate(uint32_t elapsed_ms, int index) const;
+    bool Finished(uint32_t elapsed_ms, int last_index) const;
+    // Current audio scale factor (0 ~ 255), sampled once per tick
+    uint8_t AudioScale() const;
+
+    static LedAnimation Solid(uint8_t level);
+    static LedAnimation Blink(int interval_ms, int times = 0);
+    static LedAnimation Breathe(int half_period_ms);
+    static LedAnimation FadeOut(int duration_ms);
+    static LedAnimation Scroll(int leds, int length, int interval_ms);
+    static LedAnimation AudioLevel(LedAudioSource source);
+};
+
+// Perceptual brightness correction (gamma 2.2)
+uint8_t LedGamma(uint8_t level);
+
+class LedAnimationTarget {
+public:
+    virtual ~LedAnimationTarget() = default;
+    // Called from the shared scheduler tick, return false when the animation has finished
+    virtual bool OnAnimationTick(uint32_t now_ms) = 0;
+};
+
+/**
+ * One esp_timer drives every animated LED. The timer only runs while at least one
+ * target has an animation in progress, static colors cost nothing.
+ *
+ * Targets must not hold their own lock while calling Wake(), the tick locks the
+ * scheduler first and then each target.
+ */
+class LedAnimator {
+public:
+    static LedAnimator& GetInstance() {
+        static LedAnimator instance;
+        return instance;
+    }
+    // Delete copy constructor and assignment operator
+    LedAnimator(const LedAnimator&) = delete;
+    LedAnimator& operator=(const LedAnimator&) = delete;
+
+    void Register(LedAnimationTarget* target);
+    void Unregister(LedAnimationTarget* target);
+    // Start the tick after a target begins a new animation
+    void Wake();
+
+    static uint32_t now_ms() { return esp_timer_get_time() / 1000; }
+
+private:
+    LedAnimator();
+    ~LedAnimator();
+
+    std::mutex mutex_;
+    std::vector<LedAnimationTarget*> targets_;
+    esp_timer_handle_t timer_ = nullptr;
+    bool running_ = false;
+
+    void OnTick();
+};
+
+#endif // _LED_ANIMATOR_H_
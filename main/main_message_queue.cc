@@ -0,0 +1,180 @@
+#include "main_message_queue.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <cstring>
+#include <algorithm>
+
+#define TAG "MainMessageQueue"
+
+static const char* const CHAT_ROLES[] = { "user", "assistant", "system" };
+
+MainMessageQueue::MainMessageQueue() {
+    rings_[kMessagePriorityHigh].slots.resize(MAIN_MESSAGE_HIGH_CAPACITY);
+    rings_[kMessagePriorityNormal].slots.resize(MAIN_MESSAGE_NORMAL_CAPACITY);
+    for (auto& slot : chat_slots_) {
+        slot.text.reserve(MAIN_MESSAGE_TEXT_RESERVE);
+    }
+    emotion_slot_.text.reserve(32);
+}
+
+void MainMessageQueue::PushToRing(Ring& ring, MainMessage&& message) {
+    // Once spilled, keep appending to the overflow list to preserve the order
+    if (ring.count == ring.slots.size() || !ring.overflow.empty()) {
+        if (stats_.overflowed++ == 0) {
+            ESP_LOGW(TAG, "Ring of %u messages is full, the main loop is falling behind", (unsigned)ring.slots.size());
+        }
+        ring.overflow.push_back(std::move(message));
+        return;
+    }
+    ring.slots[(ring.head + ring.count) % ring.slots.size()] = std::move(message);
+    ring.count++;
+}
+
+void MainMessageQueue::PopFromRing(Ring& ring, MainMessage& message) {
+    if (ring.count > 0) {
+        message = std::move(ring.slots[ring.head]);
+        ring.slots[ring.head].callback = nullptr;
+        ring.head = (ring.head + 1) % ring.slots.size();
+        ring.count--;
+        // Refill the ring from the overflow list
+        if (!ring.overflow.empty()) {
+            ring.slots[(ring.head + ring.count) % ring.slots.size()] = std::move(ring.overflow.front());
+            ring.overflow.pop_front();
+            ring.count++;
+        }
+    } else {
+        message = std::move(ring.overflow.front());
+        ring.overflow.pop_front();
+    }
+}
+
+void MainMessageQueue::Push(std::function<void()>&& callback, MessagePriority priority) {
+    MainMessage message;
+    message.type = kMainMessageCallback;
+    message.callback = std::move(callback);
+    message.queued_us = esp_timer_get_time();
+    std::lock_guard<std::mutex> lock(mutex_);
+    message.seq = next_seq_++;
+    PushToRing(rings_[priority], std::move(message));
+}
+
+void MainMessageQueue::PushUi(UiSlot& slot, const char* text) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (slot.pending) {
+        stats_.coalesced++;
+    }
+    slot.pending = true;
+    slot.seq = next_seq_++;
+    slot.queued_us = esp_timer_get_time();
+    slot.text.assign(text);
+}
+
+void MainMessageQueue::PushChatMessage(const char* role, const char* content) {
+    for (int i = 0; i < 3; i++) {
+        if (strcmp(role, CHAT_ROLES[i]) == 0) {
+            PushUi(chat_slots_[i], content);
+            return;
+        }
+    }
+    ESP_LOGW(TAG, "Unknown chat role: %s", role);
+}
+
+void MainMessageQueue::PushEmotion(const char* emotion) {
+    PushUi(emotion_slot_, emotion);
+}
+
+void MainMessageQueue::DiscardEmotion() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (emotion_slot_.pending) {
+        emotion_slot_.pending = false;
+        emotion_slot_.text.clear();
+        stats_.coalesced++;
+    }
+}
+
+static inline bool SeqBefore(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) < 0;
+}
+
+bool MainMessageQueue::Pop(MainMessage& message, uint32_t end_seq) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // State changes go before the pending UI updates, callbacks keep their arrival order
+    auto& high = rings_[kMessagePriorityHigh];
+    auto& normal = rings_[kMessagePriorityNormal];
+    UiSlot* ui = nullptr;
+    int chat_index = -1;
+    for (int i = 0; i < 3; i++) {
+        if (chat_slots_[i].pending && (ui == nullptr || SeqBefore(chat_slots_[i].seq, ui->seq))) {
+            ui = &chat_slots_[i];
+            chat_index = i;
+        }
+    }
+    if (emotion_slot_.pending && (ui == nullptr || SeqBefore(emotion_slot_.seq, ui->seq))) {
+        ui = &emotion_slot_;
+        chat_index = -1;
+    }
+
+    if (ui != nullptr && !SeqBefore(ui->seq, end_seq)) {
+        ui = nullptr;
+    }
+    bool has_normal = !normal.empty() && SeqBefore(normal.front().seq, end_seq);
+    // While a state change is pending, it and the callbacks queued before it go first.
+    // High priority messages pushed during this dispatch run in it too
+    if (!high.empty()) {
+        if (has_normal && SeqBefore(normal.front().seq, high.front().seq)) {
+            PopFromRing(normal, message);
+        } else {
+            PopFromRing(high, message);
+        }
+        return true;
+    }
+    if (ui != nullptr && (!has_normal || SeqBefore(ui->seq, normal.front().seq))) {
+        message.type = chat_index >= 0 ? kMainMessageChat : kMainMessageEmotion;
+        message.callback = nullptr;
+        message.role = chat_index >= 0 ? CHAT_ROLES[chat_index] : nullptr;
+        message.seq = ui->seq;
+        message.queued_us = ui->queued_us;
+        // Swap, so both buffers keep their capacity
+        message.text.swap(ui->text);
+        ui->text.clear();
+        ui->pending = false;
+        return true;
+    }
+    if (has_normal) {
+        PopFromRing(normal, message);
+        return true;
+    }
+    return false;
+}
+
+void MainMessageQueue::DispatchAll(const std::function<void(MainMessage&)>& handler) {
+    MainMessage message;
+    message.text.reserve(MAIN_MESSAGE_TEXT_RESERVE);
+    uint32_t end_seq;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        end_seq = next_seq_;
+    }
+    while (Pop(message, end_seq)) {
+        int64_t start_us = esp_timer_get_time();
+        handler(message);
+        // Release the captures now rather than at the next message
+        message.callback = nullptr;
+        int64_t end_us = esp_timer_get_time();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        int64_t wait_us = start_us - message.queued_us;
+        stats_.dispatched++;
+        stats_.total_wait_us += wait_us;
+        stats_.max_wait_us = std::max(stats_.max_wait_us, wait_us);
+        stats_.max_run_us = std::max(stats_.max_run_us, end_us - start_us);
+    }
+}
+
+MainMessageStats MainMessageQueue::TakeStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto stats = stats_;
+    stats_ = MainMessageStats();
+    return stats;
+}
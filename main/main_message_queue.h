@@ -0,0 +1,99 @@
+#ifndef MAIN_MESSAGE_QUEUE_H
+#define MAIN_MESSAGE_QUEUE_H
+
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define MAIN_MESSAGE_HIGH_CAPACITY 8
+#define MAIN_MESSAGE_NORMAL_CAPACITY 32
+#define MAIN_MESSAGE_TEXT_RESERVE 256
+
+enum MessagePriority {
+    kMessagePriorityHigh,       // State changes, run ahead of pending UI updates and also when pushed during a dispatch
+    kMessagePriorityNormal,
+};
+
+enum MainMessageType {
+    kMainMessageCallback,
+    kMainMessageChat,
+    kMainMessageEmotion,
+};
+
+struct MainMessage {
+    MainMessageType type = kMainMessageCallback;
+    std::function<void()> callback;
+    const char* role = nullptr;
+    std::string text;
+    int64_t queued_us = 0;
+    uint32_t seq = 0;
+};
+
+struct MainMessageStats {
+    uint32_t dispatched = 0;
+    uint32_t coalesced = 0;
+    uint32_t overflowed = 0;
+    int64_t total_wait_us = 0;
+    int64_t max_wait_us = 0;
+    int64_t max_run_us = 0;
+};
+
+/**
+ * Message queue of the main event loop.
+ *
+ * Callbacks go into preallocated rings, one per priority; a full ring spills into a list so
+ * nothing is ever dropped. Chat messages and emotions are not queued one by one: each role and
+ * the emotion own a slot with a reserved text buffer, a newer update replaces the pending one,
+ * so only the latest text is drawn. High priority callbacks run ahead of the pending UI updates
+ * and are not held back until the next dispatch when pushed during one; callbacks of both
+ * priorities stay in arrival order among themselves, since both may change the device state.
+ */
+class MainMessageQueue {
+public:
+    MainMessageQueue();
+
+    void Push(std::function<void()>&& callback, MessagePriority priority);
+    void PushChatMessage(const char* role, const char* content);
+    void PushEmotion(const char* emotion);
+    // Drop the pending emotion, called by a state change that sets its own
+    void DiscardEmotion();
+
+    // Run the messages pushed before the call, messages pushed meanwhile wait for the next call
+    void DispatchAll(const std::function<void(MainMessage&)>& handler);
+    // Stats since the last call
+    MainMessageStats TakeStats();
+
+private:
+    struct Ring {
+        std::vector<MainMessage> slots;
+        size_t head = 0;
+        size_t count = 0;
+        std::list<MainMessage> overflow;
+
+        bool empty() const { return count == 0 && overflow.empty(); }
+        const MainMessage& front() const { return count > 0 ? slots[head] : overflow.front(); }
+    };
+
+    struct UiSlot {
+        bool pending = false;
+        uint32_t seq = 0;
+        int64_t queued_us = 0;
+        std::string text;
+    };
+
+    std::mutex mutex_;
+    Ring rings_[2];
+    UiSlot chat_slots_[3];      // user, assistant, system
+    UiSlot emotion_slot_;
+    uint32_t next_seq_ = 0;
+    MainMessageStats stats_;
+
+    void PushToRing(Ring& ring, MainMessage&& message);
+    void PopFromRing(Ring& ring, MainMessage& message);
+    void PushUi(UiSlot& slot, const char* text);
+    bool Pop(MainMessage& message, uint32_t end_seq);
+};
+
+#endif // MAIN_MESSAGE_QUEUE_H
@@ -8,17 +8,20 @@
 #include <esp_app_desc.h>
 #include <algorithm>
 #include <cstring>
-#include <esp_pthread.h>
+#include <esp_timer.h>
 
 #include "application.h"
 #include "display.h"
 #include "board.h"
+#include "system_profiler.h"
 
 #define TAG "MCP"
 
-#define DEFAULT_TOOLCALL_STACK_SIZE 6144
+#define DEFAULT_TOOLCALL_STACK_SIZE MCP_TOOL_SMALL_STACK_SIZE
 
-McpServer::McpServer() {
+McpServer::McpServer()
+    : executor_([this](int id, const std::string& result) { ReplyResult(id, result); },
+                [this](int id, const std::string& message) { ReplyError(id, message); }) {
 }
 
 McpServer::~McpServer() {
@@ -26,6 +29,7 @@ McpServer::~McpServer() {
         delete tool;
     }
     tools_.clear();
+    cJSON_Delete(last_device_status_);
 }
 
 void McpServer::AddCommonTools() {
@@ -45,6 +49,18 @@ void McpServer::AddCommonTools() {
             return board.GetDeviceStatusJson();
         });
 
+    AddTool("self.system.get_profile",
+        "Provides the recent CPU load per core and per task, task stack headroom, heap usage, main loop latency and power level residency of the device.\n"
+        "Use this tool only for diagnosing the device itself (e.g. why the audio is stuttering).\n"
+        "Args:\n"
+        "  `samples`: How many of the most recent samples to return, one sample every 2 seconds.",
+        PropertyList({
+            Property("samples", kPropertyTypeInteger, 10, 0, SYSTEM_PROFILER_HISTORY)
+        }),
+        [](const PropertyList& properties) -> ReturnValue {
+            return SystemProfiler::GetInstance().GetProfileJson(properties["samples"].value<int>());
+        });
+
     AddTool("self.audio_speaker.set_volume", 
         "Set the volume of the audio speaker. If the current volume is unknown, you must call `self.get_device_status` tool first and then call this tool.",
         PropertyList({
@@ -119,17 +135,26 @@ void McpServer::AddCommonTools() {
 
     // Restore the original tools list to the end of the tools list
     tools_.insert(tools_.end(), original_tools.begin(), original_tools.end());
+
+    // Board tools are registered in the board constructor, so the registry is complete here
+    BuildToolsListCache();
 }
 
 void McpServer::AddTool(McpTool* tool) {
     // Prevent adding duplicate tools
-    if (std::find_if(tools_.begin(), tools_.end(), [tool](const McpTool* t) { return t->name() == tool->name(); }) != tools_.end()) {
+    if (!tool_index_.emplace(tool->name(), tool).second) {
         ESP_LOGW(TAG, "Tool %s already added", tool->name().c_str());
         return;
     }
 
     ESP_LOGI(TAG, "Add tool: %s", tool->name().c_str());
     tools_.push_back(tool);
+
+    if (tools_list_cached_) {
+        ESP_LOGW(TAG, "Tool %s added after the tools list was built, rebuilding on next request", tool->name().c_str());
+        tools_list_pages_.clear();
+        tools_list_cached_ = false;
+    }
 }
 
 void McpServer::AddTool(const std::string& name, const std::string& description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback) {
@@ -244,7 +269,21 @@ void McpServer::ParseMessage(const cJSON* json) {
             ReplyError(id_int, "Invalid stackSize");
             return;
         }
-        DoToolCall(id_int, std::string(tool_name->valuestring), tool_arguments, stack_size ? stack_size->valueint : DEFAULT_TOOLCALL_STACK_SIZE);
+        if (stack_size != nullptr && stack_size->valueint > MCP_TOOL_LARGE_STACK_SIZE) {
+            // The workers have fixed stacks, a larger request would overflow the biggest one
+            ESP_LOGE(TAG, "tools/call: stackSize %d exceeds %d", stack_size->valueint, MCP_TOOL_LARGE_STACK_SIZE);
+            ReplyError(id_int, "stackSize exceeds " + std::to_string(MCP_TOOL_LARGE_STACK_SIZE));
+            return;
+        }
+        auto timeout = cJSON_GetObjectItem(params, "timeoutMs");
+        if (timeout != nullptr && (!cJSON_IsNumber(timeout) || timeout->valueint <= 0)) {
+            ESP_LOGE(TAG, "tools/call: Invalid timeoutMs");
+            ReplyError(id_int, "Invalid timeoutMs");
+            return;
+        }
+        DoToolCall(id_int, std::string(tool_name->valuestring), tool_arguments,
+            stack_size ? stack_size->valueint : DEFAULT_TOOLCALL_STACK_SIZE,
+            timeout ? timeout->valueint : MCP_TOOL_CALL_TIMEOUT_MS);
     } else {
         ESP_LOGE(TAG, "Method not implemented: %s", method_str.c_str());
         ReplyError(id_int, "Method not implemented: " + method_str);
@@ -268,70 +307,106 @@ void McpServer::ReplyError(int id, const std::string& message) {
     Application::GetInstance().SendMcpMessage(payload);
 }
 
-void McpServer::GetToolsList(int id, const std::string& cursor) {
+// Serialize tools_[start...] into one page, `next` is the index of the first tool left out
+bool McpServer::BuildToolsPage(size_t start, std::string& json, size_t& next) {
     const int max_payload_size = 8000;
-    std::string json = "{\"tools\":[";
-    
-    bool found_cursor = cursor.empty();
-    auto it = tools_.begin();
-    std::string next_cursor = "";
-    
-    while (it != tools_.end()) {
-        // 如果我们还没有找到起始位置，继续搜索
-        if (!found_cursor) {
-            if ((*it)->name() == cursor) {
-                found_cursor = true;
-            } else {
-                ++it;
-                continue;
-            }
-        }
-        
+    json = "{\"tools\":[";
+
+    size_t i = start;
+    for (; i < tools_.size(); ++i) {
         // 添加tool前检查大小
-        std::string tool_json = (*it)->to_json() + ",";
+        std::string tool_json = tools_[i]->to_json() + ",";
         if (json.length() + tool_json.length() + 30 > max_payload_size) {
             // 如果添加这个tool会超出大小限制，设置next_cursor并退出循环
-            next_cursor = (*it)->name();
             break;
         }
-        
         json += tool_json;
-        ++it;
     }
-    
+    next = i;
+
     if (json.back() == ',') {
         json.pop_back();
     }
-    
-    if (json.back() == '[' && !tools_.empty()) {
+
+    if (i == start && i < tools_.size()) {
         // 如果没有添加任何tool，返回错误
-        ESP_LOGE(TAG, "tools/list: Failed to add tool %s because of payload size limit", next_cursor.c_str());
-        ReplyError(id, "Failed to add tool " + next_cursor + " because of payload size limit");
-        return;
+        return false;
     }
 
-    if (next_cursor.empty()) {
+    if (i == tools_.size()) {
         json += "]}";
     } else {
-        json += "],\"nextCursor\":\"" + next_cursor + "\"}";
+        json += "],\"nextCursor\":\"" + tools_[i]->name() + "\"}";
+    }
+    return true;
+}
+
+void McpServer::BuildToolsListCache() {
+    int64_t start_time = esp_timer_get_time();
+    tools_list_pages_.clear();
+
+    size_t start = 0;
+    size_t total_size = 0;
+    do {
+        std::string json;
+        size_t next;
+        if (!BuildToolsPage(start, json, next)) {
+            // Leave the oversized tool to the uncached path, which reports the error
+            break;
+        }
+        total_size += json.size();
+        tools_list_pages_.emplace_back(start == 0 ? "" : tools_[start]->name(), std::move(json));
+        start = next;
+    } while (start < tools_.size());
+    tools_list_cached_ = true;
+
+    ESP_LOGI(TAG, "Tools list cached: %u tools, %u pages, %u bytes in %lld us",
+        (unsigned)tools_.size(), (unsigned)tools_list_pages_.size(), (unsigned)total_size, (long long)(esp_timer_get_time() - start_time));
+}
+
+void McpServer::GetToolsList(int id, const std::string& cursor) {
+    int64_t start_time = esp_timer_get_time();
+    if (!tools_list_cached_) {
+        BuildToolsListCache();
+    }
+
+    for (const auto& [page_cursor, json] : tools_list_pages_) {
+        if (page_cursor == cursor) {
+            ReplyResult(id, json);
+            ESP_LOGD(TAG, "tools/list: cursor \"%s\" served from cache in %lld us", cursor.c_str(), (long long)(esp_timer_get_time() - start_time));
+            return;
+        }
+    }
+
+    // Not a page boundary, serialize from the requested tool
+    size_t start = 0;
+    if (!cursor.empty()) {
+        auto tool_iter = std::find_if(tools_.begin(), tools_.end(), [&cursor](const McpTool* tool) { return tool->name() == cursor; });
+        start = tool_iter - tools_.begin();
+    }
+
+    std::string json;
+    size_t next;
+    if (!BuildToolsPage(start, json, next)) {
+        std::string next_cursor = next < tools_.size() ? tools_[next]->name() : "";
+        ESP_LOGE(TAG, "tools/list: Failed to add tool %s because of payload size limit", next_cursor.c_str());
+        ReplyError(id, "Failed to add tool " + next_cursor + " because of payload size limit");
+        return;
     }
-    
     ReplyResult(id, json);
 }
 
-void McpServer::DoToolCall(int id, const std::string& tool_name, const cJSON* tool_arguments, int stack_size) {
-    auto tool_iter = std::find_if(tools_.begin(), tools_.end(), 
-                                 [&tool_name](const McpTool* tool) { 
-                                     return tool->name() == tool_name; 
-                                 });
-    
-    if (tool_iter == tools_.end()) {
+void McpServer::DoToolCall(int id, const std::string& tool_name, const cJSON* tool_arguments, int stack_size, int timeout_ms) {
+    int64_t start_time = esp_timer_get_time();
+    auto tool_iter = tool_index_.find(tool_name);
+    if (tool_iter == tool_index_.end()) {
         ESP_LOGE(TAG, "tools/call: Unknown tool: %s", tool_name.c_str());
         ReplyError(id, "Unknown tool: " + tool_name);
         return;
     }
+    McpTool* tool = tool_iter->second;
 
-    PropertyList arguments = (*tool_iter)->properties();
+    PropertyList arguments = tool->properties();
     try {
         for (auto& argument : arguments) {
             bool found = false;
@@ -365,21 +440,143 @@ void McpServer::DoToolCall(int id, const std::string& tool_name, const cJSON* to
         return;
     }
 
-    // Start a task to receive data with stack size
-    esp_pthread_cfg_t cfg = esp_pthread_get_default_config();
-    cfg.thread_name = "tool_call";
-    cfg.stack_size = stack_size;
-    cfg.prio = 1;
-    esp_pthread_set_cfg(&cfg);
-
-    // Use a thread to call the tool to avoid blocking the main thread
-    tool_call_thread_ = std::thread([this, id, tool_iter, arguments = std::move(arguments)]() {
-        try {
-            ReplyResult(id, (*tool_iter)->Call(arguments));
-        } catch (const std::exception& e) {
-            ESP_LOGE(TAG, "tools/call: %s", e.what());
-            ReplyError(id, e.what());
-        }
+    // Run the tool on a pooled worker to avoid blocking the main thread
+    bool queued = executor_.Submit(id, tool_name, stack_size, timeout_ms, [tool, arguments = std::move(arguments)]() {
+        return tool->Call(arguments);
     });
-    tool_call_thread_.detach();
-}
\ No newline at end of file
+    if (!queued) {
+        ReplyError(id, "Too many tool calls in progress");
+        return;
+    }
+    ESP_LOGD(TAG, "tools/call: %s dispatched in %lld us", tool_name.c_str(), (long long)(esp_timer_get_time() - start_time));
+}
+
+#if CONFIG_USE_BOOT_BENCHMARK
+void McpServer::RunBenchmark() {
+    // Fixed round counts, so numbers from different builds can be compared
+    const int kListRounds = 20;
+    const int kCallRounds = 100;
+    if (!tools_list_cached_) {
+        BuildToolsListCache();
+    }
+
+    // tools/list: every page serialized per request, as before the cache, against the cached pages
+    size_t bytes = 0;
+    int requests = 0;
+    int64_t start = esp_timer_get_time();
+    for (int round = 0; round < kListRounds; round++) {
+        size_t page = 0;
+        do {
+            std::string json;
+            size_t next;
+            if (!BuildToolsPage(page, json, next)) {
+                break;
+            }
+            bytes += json.size();
+            requests++;
+            page = next;
+        } while (page < tools_.size());
+    }
+    int64_t uncached_us = esp_timer_get_time() - start;
+
+    start = esp_timer_get_time();
+    for (int round = 0; round < kListRounds; round++) {
+        for (const auto& [cursor, json] : tools_list_pages_) {
+            // Same lookup as GetToolsList, and the copy ReplyResult makes
+            for (const auto& [page_cursor, page_json] : tools_list_pages_) {
+                if (page_cursor == cursor) {
+                    std::string payload = page_json;
+                    bytes += payload.size();
+                    break;
+                }
+            }
+        }
+    }
+    int64_t cached_us = esp_timer_get_time() - start;
+    requests = std::max(requests, 1);
+    ESP_LOGI(TAG, "Benchmark tools/list, %u tools in %u pages: uncached %.1f us, cached %.1f us per page",
+        (unsigned)tools_.size(), (unsigned)tools_list_pages_.size(),
+        (float)uncached_us / requests, (float)cached_us / requests);
+
+    // tools/call: the name lookup of every tool, by linear search as before the index and by the index
+    std::vector<std::string> names;
+    for (auto tool : tools_) {
+        names.push_back(tool->name());
+    }
+    int found = 0;
+    start = esp_timer_get_time();
+    for (int round = 0; round < kCallRounds; round++) {
+        for (const auto& name : names) {
+            auto it = std::find_if(tools_.begin(), tools_.end(), [&name](const McpTool* tool) { return tool->name() == name; });
+            found += it != tools_.end();
+        }
+    }
+    int64_t linear_us = esp_timer_get_time() - start;
+
+    start = esp_timer_get_time();
+    for (int round = 0; round < kCallRounds; round++) {
+        for (const auto& name : names) {
+            found += tool_index_.find(name) != tool_index_.end();
+        }
+    }
+    int64_t indexed_us = esp_timer_get_time() - start;
+    int calls = std::max<int>(kCallRounds * names.size(), 1);
+    ESP_LOGI(TAG, "Benchmark tools/call lookup: linear %.2f us, indexed %.2f us per call (%d found, %u bytes listed)",
+        (float)linear_us / calls, (float)indexed_us / calls, found, (unsigned)bytes);
+}
+#endif
+
+void McpServer::CancelToolCalls() {
+    executor_.CancelAll();
+}
+
+// Collect the members of `current` that differ from `last`, nested objects are compared per field
+static cJSON* DiffObject(const cJSON* last, const cJSON* current) {
+    cJSON* delta = cJSON_CreateObject();
+    const cJSON* item = nullptr;
+    cJSON_ArrayForEach(item, current) {
+        const cJSON* previous = cJSON_GetObjectItem(last, item->string);
+        if (cJSON_IsObject(item) && cJSON_IsObject(previous)) {
+            cJSON* child = DiffObject(previous, item);
+            if (child->child != nullptr) {
+                cJSON_AddItemToObject(delta, item->string, child);
+            } else {
+                cJSON_Delete(child);
+            }
+        } else if (previous == nullptr || !cJSON_Compare(previous, item, true)) {
+            cJSON_AddItemToObject(delta, item->string, cJSON_Duplicate(item, true));
+        }
+    }
+    return delta;
+}
+
+void McpServer::NotifyDeviceStatus() {
+    cJSON* status = cJSON_Parse(Board::GetInstance().GetDeviceStatusJson().c_str());
+    if (status == nullptr) {
+        return;
+    }
+    cJSON* delta;
+    {
+        std::lock_guard<std::mutex> lock(device_status_mutex_);
+        // The first notification of a session carries the full status
+        delta = last_device_status_ ? DiffObject(last_device_status_, status) : cJSON_Duplicate(status, true);
+        cJSON_Delete(last_device_status_);
+        last_device_status_ = status;
+    }
+
+    if (delta->child != nullptr) {
+        char* params = cJSON_PrintUnformatted(delta);
+        std::string payload = "{\"jsonrpc\":\"2.0\",\"method\":\"notifications/device_status\",\"params\":";
+        payload += params;
+        payload += "}";
+        cJSON_free(params);
+        Application::GetInstance().SendMcpMessage(payload);
+    }
+    cJSON_Delete(delta);
+}
+
+void McpServer::ResetDeviceStatus() {
+    std::lock_guard<std::mutex> lock(device_status_mutex_);
+    cJSON_Delete(last_device_status_);
+    last_device_status_ = nullptr;
+}
@@ -4,13 +4,17 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <functional>
 #include <variant>
 #include <optional>
 #include <stdexcept>
-#include <thread>
+#include <mutex>
 
 #include <cJSON.h>
+#include <sdkconfig.h>
+
+#include "mcp_tool_executor.h"
 
 // 添加类型别名
 using ReturnValue = std::variant<bool, int, std::string>;
@@ -86,7 +90,7 @@ public:
         value_ = value;
     }
 
-    std::string to_json() const {
+    cJSON* to_cjson() const {
         cJSON *json = cJSON_CreateObject();
         
         if (type_ == kPropertyTypeBoolean) {
@@ -111,7 +115,11 @@ public:
                 cJSON_AddStringToObject(json, "default", value<std::string>().c_str());
             }
         }
-        
+        return json;
+    }
+
+    std::string to_json() const {
+        cJSON *json = to_cjson();
         char *json_str = cJSON_PrintUnformatted(json);
         std::string result(json_str);
         cJSON_free(json_str);
@@ -154,14 +162,17 @@ public:
         return required;
     }
 
-    std::string to_json() const {
+    // Build the schema tree directly, without printing and re-parsing each property
+    cJSON* to_cjson() const {
         cJSON *json = cJSON_CreateObject();
-        
         for (const auto& property : properties_) {
-            cJSON *prop_json = cJSON_Parse(property.to_json().c_str());
-            cJSON_AddItemToObject(json, property.name().c_str(), prop_json);
+            cJSON_AddItemToObject(json, property.name().c_str(), property.to_cjson());
         }
-        
+        return json;
+    }
+
+    std::string to_json() const {
+        cJSON *json = to_cjson();
         char *json_str = cJSON_PrintUnformatted(json);
         std::string result(json_str);
         cJSON_free(json_str);
@@ -202,8 +213,7 @@ public:
         cJSON *input_schema = cJSON_CreateObject();
         cJSON_AddStringToObject(input_schema, "type", "object");
         
-        cJSON *properties = cJSON_Parse(properties_.to_json().c_str());
-        cJSON_AddItemToObject(input_schema, "properties", properties);
+        cJSON_AddItemToObject(input_schema, "properties", properties_.to_cjson());
         
         if (!required.empty()) {
             cJSON *required_array = cJSON_CreateArray();
@@ -261,6 +271,15 @@ public:
     void AddTool(const std::string& name, const std::string& description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback);
     void ParseMessage(const cJSON* json);
     void ParseMessage(const std::string& message);
+    // Drop pending tool calls when the session ends, their replies would have nowhere to go
+    void CancelToolCalls();
+    // Send the device status fields that changed since the last notification
+    void NotifyDeviceStatus();
+    void ResetDeviceStatus();
+#if CONFIG_USE_BOOT_BENCHMARK
+    // Time the tools/list and tools/call dispatch paths on the registered tools, before and after caching
+    void RunBenchmark();
+#endif
 
 private:
     McpServer();
@@ -272,10 +291,19 @@ private:
     void ReplyError(int id, const std::string& message);
 
     void GetToolsList(int id, const std::string& cursor);
-    void DoToolCall(int id, const std::string& tool_name, const cJSON* tool_arguments, int stack_size);
+    bool BuildToolsPage(size_t start, std::string& json, size_t& next);
+    void BuildToolsListCache();
+    void DoToolCall(int id, const std::string& tool_name, const cJSON* tool_arguments, int stack_size, int timeout_ms);
 
     std::vector<McpTool*> tools_;
-    std::thread tool_call_thread_;
+    std::unordered_map<std::string, McpTool*> tool_index_;
+    // tools/list 响应在工具注册完成后只序列化一次，按 cursor（每页第一个工具名）缓存
+    std::vector<std::pair<std::string, std::string>> tools_list_pages_;
+    bool tools_list_cached_ = false;
+    McpToolExecutor executor_;
+    // Reset from the protocol task when the channel closes, compared on the main loop
+    std::mutex device_status_mutex_;
+    cJSON* last_device_status_ = nullptr;
 };
 
 #endif // MCP_SERVER_H
@@ -0,0 +1,257 @@
+#include "mcp_tool_executor.h"
+
+#include <esp_log.h>
+#include <algorithm>
+
+#define TAG "McpToolExecutor"
+
+// Interval of the deadline check, the timeout resolution
+#define MCP_TOOL_TIMEOUT_CHECK_MS 500
+
+struct WorkerArgs {
+    McpToolExecutor* executor;
+    int stack_class;
+};
+
+McpToolExecutor::McpToolExecutor(ReplyResult reply_result, ReplyError reply_error)
+    : reply_result_(reply_result), reply_error_(reply_error) {
+    esp_timer_create_args_t timer_args = {
+        .callback = [](void *arg) {
+            auto executor = static_cast<McpToolExecutor*>(arg);
+            executor->CheckTimeouts();
+        },
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "mcp_tool_timeout",
+        .skip_unhandled_events = true,
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &timeout_timer_));
+}
+
+McpToolExecutor::~McpToolExecutor() {
+    if (timeout_timer_ != nullptr) {
+        esp_timer_stop(timeout_timer_);
+        esp_timer_delete(timeout_timer_);
+    }
+    for (auto handle : workers_) {
+        vTaskDelete(handle);
+    }
+}
+
+void McpToolExecutor::StartWorkers(StackClass stack_class, uint32_t stack_size, int count) {
+    for (int i = 0; i < count; i++) {
+        char name[24];
+        snprintf(name, sizeof(name), "tool_call_%c%d", stack_class == kStackSmall ? 's' : 'l', i);
+        auto args = new WorkerArgs{ this, stack_class };
+        TaskHandle_t handle = nullptr;
+        if (xTaskCreate([](void* arg) {
+            auto args = (WorkerArgs*)arg;
+            auto executor = args->executor;
+            auto stack_class = (StackClass)args->stack_class;
+            delete args;
+            executor->WorkerLoop(stack_class);
+        }, name, stack_size, args, 1, &handle) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create worker %s", name);
+            delete args;
+            continue;
+        }
+        workers_.push_back(handle);
+    }
+}
+
+bool McpToolExecutor::Submit(int id, const std::string& name, uint32_t stack_size, uint32_t timeout_ms, Work work) {
+    if (stack_size > MCP_TOOL_LARGE_STACK_SIZE) {
+        ESP_LOGE(TAG, "tools/call %s rejected: stack size %lu exceeds %d",
+            name.c_str(), (unsigned long)stack_size, MCP_TOOL_LARGE_STACK_SIZE);
+        std::lock_guard<std::mutex> lock(mutex_);
+        metrics_.rejected++;
+        return false;
+    }
+    StackClass stack_class = stack_size <= MCP_TOOL_SMALL_STACK_SIZE ? kStackSmall : kStackLarge;
+
+    auto job = std::make_shared<Job>();
+    job->id = id;
+    job->name = name;
+    job->work = std::move(work);
+    job->queued_us = esp_timer_get_time();
+    job->deadline_us = job->queued_us + (int64_t)timeout_ms * 1000;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t depth = queues_[kStackSmall].size() + queues_[kStackLarge].size();
+    if (depth >= MCP_TOOL_MAX_QUEUED) {
+        metrics_.rejected++;
+        ESP_LOGW(TAG, "tools/call %s rejected: %u calls queued, %u running",
+            name.c_str(), (unsigned)depth, (unsigned)running_.size());
+        return false;
+    }
+    if (!workers_started_[stack_class]) {
+        workers_started_[stack_class] = true;
+        if (stack_class == kStackSmall) {
+            StartWorkers(kStackSmall, MCP_TOOL_SMALL_STACK_SIZE, MCP_TOOL_SMALL_WORKERS);
+        } else {
+            StartWorkers(kStackLarge, MCP_TOOL_LARGE_STACK_SIZE, MCP_TOOL_LARGE_WORKERS);
+        }
+    }
+
+    job->seq = next_seq_++;
+    queues_[stack_class].push_back(job);
+    metrics_.submitted++;
+    metrics_.max_queue_depth = std::max<uint32_t>(metrics_.max_queue_depth, depth + 1);
+    if (!timeout_timer_running_) {
+        timeout_timer_running_ = true;
+        esp_timer_start_periodic(timeout_timer_, MCP_TOOL_TIMEOUT_CHECK_MS * 1000);
+    }
+    condition_variable_.notify_all();
+    return true;
+}
+
+// A job may start once no call with the same id is running or was queued before it
+bool McpToolExecutor::IsBlocked(const Job& job) {
+    for (auto& running : running_) {
+        if (running->id == job.id) {
+            return true;
+        }
+    }
+    for (auto& queue : queues_) {
+        for (auto& queued : queue) {
+            if (queued->id == job.id && queued->seq < job.seq) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+std::shared_ptr<McpToolExecutor::Job> McpToolExecutor::TakeJob(StackClass stack_class) {
+    // Large workers help with small calls when they have nothing else to do
+    for (int c = stack_class; c >= kStackSmall; c--) {
+        auto& queue = queues_[c];
+        for (auto it = queue.begin(); it != queue.end(); ++it) {
+            if (IsBlocked(**it)) {
+                continue;
+            }
+            auto job = *it;
+            queue.erase(it);
+            job->state = kJobRunning;
+            running_.push_back(job);
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+void McpToolExecutor::WorkerLoop(StackClass stack_class) {
+    while (true) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        std::shared_ptr<Job> job;
+        condition_variable_.wait(lock, [this, stack_class, &job]() {
+            job = TakeJob(stack_class);
+            return job != nullptr;
+        });
+        int64_t start_us = esp_timer_get_time();
+        int64_t wait_us = start_us - job->queued_us;
+        metrics_.total_wait_us += wait_us;
+        metrics_.max_wait_us = std::max(metrics_.max_wait_us, wait_us);
+        lock.unlock();
+
+        bool success = true;
+        std::string output;
+        try {
+            output = job->work();
+        } catch (const std::exception& e) {
+            ESP_LOGE(TAG, "tools/call %s: %s", job->name.c_str(), e.what());
+            success = false;
+            output = e.what();
+        }
+        int64_t run_us = esp_timer_get_time() - start_us;
+
+        // Only one of the worker, the timeout check and CancelAll gets to reply
+        int expected = kJobRunning;
+        bool reply = job->state.compare_exchange_strong(expected, kJobReplied);
+
+        lock.lock();
+        running_.remove(job);
+        metrics_.completed++;
+        metrics_.max_run_us = std::max(metrics_.max_run_us, run_us);
+        lock.unlock();
+        // Calls waiting on this id may start now
+        condition_variable_.notify_all();
+
+        ESP_LOGD(TAG, "tools/call %s: waited %lld us, ran %lld us", job->name.c_str(), (long long)wait_us, (long long)run_us);
+        if (!reply) {
+            ESP_LOGW(TAG, "tools/call %s finished after timeout or cancellation, result dropped", job->name.c_str());
+        } else if (success) {
+            reply_result_(job->id, output);
+        } else {
+            reply_error_(job->id, output);
+        }
+    }
+}
+
+void McpToolExecutor::CheckTimeouts() {
+    std::vector<std::pair<int, std::string>> expired;
+    int64_t now = esp_timer_get_time();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& queue : queues_) {
+            for (auto it = queue.begin(); it != queue.end();) {
+                if (now >= (*it)->deadline_us) {
+                    (*it)->state = kJobReplied;
+                    expired.emplace_back((*it)->id, (*it)->name);
+                    it = queue.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+        for (auto& job : running_) {
+            int expected = kJobRunning;
+            if (now >= job->deadline_us && job->state.compare_exchange_strong(expected, kJobReplied)) {
+                expired.emplace_back(job->id, job->name);
+            }
+        }
+        metrics_.timed_out += expired.size();
+
+        bool pending = !running_.empty() || !queues_[kStackSmall].empty() || !queues_[kStackLarge].empty();
+        if (!pending && timeout_timer_running_) {
+            esp_timer_stop(timeout_timer_);
+            timeout_timer_running_ = false;
+        }
+    }
+    if (!expired.empty()) {
+        // Removed queued calls may unblock calls with the same id
+        condition_variable_.notify_all();
+    }
+
+    for (auto& [id, name] : expired) {
+        ESP_LOGW(TAG, "tools/call %s (id %d) timed out", name.c_str(), id);
+        reply_error_(id, "Tool call timed out: " + name);
+    }
+}
+
+void McpToolExecutor::CancelAll() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint32_t cancelled = 0;
+    for (auto& queue : queues_) {
+        for (auto& job : queue) {
+            job->state = kJobReplied;
+            cancelled++;
+        }
+        queue.clear();
+    }
+    for (auto& job : running_) {
+        int expected = kJobRunning;
+        if (job->state.compare_exchange_strong(expected, kJobReplied)) {
+            cancelled++;
+        }
+    }
+    if (cancelled > 0) {
+        metrics_.cancelled += cancelled;
+        ESP_LOGI(TAG, "Cancelled %lu tool calls", (unsigned long)cancelled);
+    }
+}
+
+McpToolCallMetrics McpToolExecutor::GetMetrics() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return metrics_;
+}
@@ -0,0 +1,105 @@
+#ifndef MCP_TOOL_EXECUTOR_H
+#define MCP_TOOL_EXECUTOR_H
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define MCP_TOOL_SMALL_STACK_SIZE 6144
+#define MCP_TOOL_SMALL_WORKERS 2
+#define MCP_TOOL_LARGE_STACK_SIZE (8192 * 2)
+#define MCP_TOOL_LARGE_WORKERS 1
+#define MCP_TOOL_MAX_QUEUED 8
+#define MCP_TOOL_CALL_TIMEOUT_MS 60000
+
+struct McpToolCallMetrics {
+    uint32_t submitted = 0;
+    uint32_t completed = 0;
+    uint32_t rejected = 0;
+    uint32_t timed_out = 0;
+    uint32_t cancelled = 0;
+    uint32_t max_queue_depth = 0;
+    int64_t total_wait_us = 0;
+    int64_t max_wait_us = 0;
+    int64_t max_run_us = 0;
+};
+
+/**
+ * Bounded executor for MCP tool calls.
+ *
+ * Workers are created once per stack size class, lazily on the first call of the class, instead
+ * of spawning a detached thread with a caller sized stack for every call. A device that never
+ * receives a tool call does not pay for any worker stack. Each call
+ * gets exactly one reply: the result, an error, or a timeout error, whichever comes first.
+ * A tool callback cannot be interrupted, so a timed out or cancelled call keeps its worker
+ * until it returns and its result is dropped. Calls sharing a JSON-RPC id run in order.
+ */
+class McpToolExecutor {
+public:
+    using Work = std::function<std::string()>;
+    using ReplyResult = std::function<void(int id, const std::string& result)>;
+    using ReplyError = std::function<void(int id, const std::string& message)>;
+
+    McpToolExecutor(ReplyResult reply_result, ReplyError reply_error);
+    ~McpToolExecutor();
+
+    // Returns false if the queue is full or stack_size is above MCP_TOOL_LARGE_STACK_SIZE,
+    // the caller is expected to reply with an error
+    bool Submit(int id, const std::string& name, uint32_t stack_size, uint32_t timeout_ms, Work work);
+    // Drop queued calls and suppress the replies of running ones, used when the session closes
+    void CancelAll();
+    McpToolCallMetrics GetMetrics();
+
+private:
+    enum JobState {
+        kJobQueued,
+        kJobRunning,
+        kJobReplied,
+    };
+
+    struct Job {
+        int id;
+        uint32_t seq;
+        std::string name;
+        Work work;
+        int64_t queued_us;
+        int64_t deadline_us;
+        std::atomic<int> state = kJobQueued;
+    };
+
+    enum StackClass {
+        kStackSmall,
+        kStackLarge,
+        kStackClassCount,
+    };
+
+    ReplyResult reply_result_;
+    ReplyError reply_error_;
+    std::mutex mutex_;
+    std::condition_variable condition_variable_;
+    std::list<std::shared_ptr<Job>> queues_[kStackClassCount];
+    std::list<std::shared_ptr<Job>> running_;
+    std::vector<TaskHandle_t> workers_;
+    bool workers_started_[kStackClassCount] = {};
+    esp_timer_handle_t timeout_timer_ = nullptr;
+    bool timeout_timer_running_ = false;
+    uint32_t next_seq_ = 0;
+    McpToolCallMetrics metrics_;
+
+    void StartWorkers(StackClass stack_class, uint32_t stack_size, int count);
+    void WorkerLoop(StackClass stack_class);
+    std::shared_ptr<Job> TakeJob(StackClass stack_class);
+    bool IsBlocked(const Job& job);
+    void CheckTimeouts();
+};
+
+#endif // MCP_TOOL_EXECUTOR_H
@@ -261,6 +261,8 @@ void Ota::MarkCurrentVersionValid() {
 
 void Ota::Upgrade(const std::string& firmware_url) {
     ESP_LOGI(TAG, "Upgrading firmware from %s", firmware_url.c_str());
+    // Don't leave settings in RAM during a long flash operation
+    Settings::Flush();
     esp_ota_handle_t update_handle = 0;
     auto update_partition = esp_ota_get_next_update_partition(NULL);
     if (update_partition == NULL) {
@@ -12,6 +12,7 @@ struct AudioStreamPacket {
     int frame_duration = 0;
     uint32_t timestamp = 0;
     std::vector<uint8_t> payload;
+    uint32_t frame_id = 0;  // Local id for latency tracing, not sent
 };
 
 struct BinaryProtocol2 {
@@ -1,58 +1,335 @@
 #include "settings.h"
 
 #include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_system.h>
 #include <nvs_flash.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+
+#include <map>
+#include <mutex>
+#include <vector>
+#include <variant>
+#include <algorithm>
 
 #define TAG "Settings"
 
-Settings::Settings(const std::string& ns, bool read_write) : ns_(ns), read_write_(read_write) {
-    nvs_open(ns.c_str(), read_write_ ? NVS_READWRITE : NVS_READONLY, &nvs_handle_);
+// Commit this long after the last write
+#define SETTINGS_COMMIT_DELAY_MS 1000
+// Upper bound for a write to stay in RAM while writes keep coming
+#define SETTINGS_COMMIT_MAX_DELAY_MS 5000
+// Flash writes can stall for tens of milliseconds, keep them off the esp_timer task
+#define SETTINGS_COMMIT_TASK_PRIORITY 1
+#define SETTINGS_COMMIT_TASK_STACK_SIZE 4096
+
+namespace {
+
+struct Entry {
+    std::variant<int32_t, std::string> value;
+    bool erased = false;
+    bool dirty = false;
+};
+
+struct Namespace {
+    std::map<std::string, Entry> entries;
+    bool erase_all = false;
+    bool dirty = false;
+};
+
+class SettingsCache {
+public:
+    static SettingsCache& GetInstance() {
+        static SettingsCache instance;
+        return instance;
+    }
+    // Delete copy constructor and assignment operator
+    SettingsCache(const SettingsCache&) = delete;
+    SettingsCache& operator=(const SettingsCache&) = delete;
+
+    template<typename T>
+    bool Get(const std::string& ns, const std::string& key, T& value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto space = Load(ns);
+        if (space == nullptr) {
+            return false;
+        }
+        auto it = space->entries.find(key);
+        if (it == space->entries.end() || it->second.erased || !std::holds_alternative<T>(it->second.value)) {
+            return false;
+        }
+        value = std::get<T>(it->second.value);
+        return true;
+    }
+
+    template<typename T>
+    void Set(const std::string& ns, const std::string& key, const T& value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto space = Load(ns);
+        if (space == nullptr) {
+            // NVS is not available, keep the value for this session anyway
+            space = &namespaces_[ns];
+        }
+        auto it = space->entries.find(key);
+        if (it != space->entries.end() && !it->second.erased && std::holds_alternative<T>(it->second.value)
+            && std::get<T>(it->second.value) == value) {
+            // Unchanged, nothing to write
+            return;
+        }
+        auto& entry = space->entries[key];
+        entry.value = value;
+        entry.erased = false;
+        entry.dirty = true;
+        space->dirty = true;
+        ScheduleCommit();
+    }
+
+    void Erase(const std::string& ns, const std::string& key) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto space = Load(ns);
+        if (space == nullptr) {
+            space = &namespaces_[ns];
+        }
+        auto& entry = space->entries[key];
+        entry.erased = true;
+        entry.dirty = true;
+        space->dirty = true;
+        ScheduleCommit();
+    }
+
+    void EraseAll(const std::string& ns) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& space = namespaces_[ns];
+        space.entries.clear();
+        space.erase_all = true;
+        space.dirty = true;
+        loaded_[ns] = true;
+        ScheduleCommit();
+    }
+
+    void Commit();
+
+private:
+    std::mutex mutex_;
+    // Serializes commits, so an older snapshot never lands in flash after a newer one
+    std::mutex commit_mutex_;
+    std::map<std::string, Namespace> namespaces_;
+    std::map<std::string, bool> loaded_;
+    esp_timer_handle_t commit_timer_ = nullptr;
+    SemaphoreHandle_t commit_request_ = nullptr;
+    int64_t first_pending_us_ = 0;
+
+    SettingsCache() {
+        // The timer only wakes up the commit task
+        commit_request_ = xSemaphoreCreateBinary();
+        xTaskCreate([](void* arg) {
+            auto cache = static_cast<SettingsCache*>(arg);
+            while (true) {
+                xSemaphoreTake(cache->commit_request_, portMAX_DELAY);
+                cache->Commit();
+            }
+        }, "settings_commit", SETTINGS_COMMIT_TASK_STACK_SIZE, this, SETTINGS_COMMIT_TASK_PRIORITY, nullptr);
+
+        esp_timer_create_args_t timer_args = {
+            .callback = [](void* arg) {
+                xSemaphoreGive(static_cast<SettingsCache*>(arg)->commit_request_);
+            },
+            .arg = this,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "settings_commit",
+            .skip_unhandled_events = true,
+        };
+        ESP_ERROR_CHECK(esp_timer_create(&timer_args, &commit_timer_));
+        // Pending writes must reach flash before any restart
+        esp_register_shutdown_handler([]() {
+            SettingsCache::GetInstance().Commit();
+        });
+    }
+
+    Namespace* Load(const std::string& ns);
+    void ScheduleCommit();
+    void Requeue(const std::string& ns, const Namespace& changes);
+};
+
+Namespace* SettingsCache::Load(const std::string& ns) {
+    if (loaded_[ns]) {
+        return &namespaces_[ns];
+    }
+
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(ns.c_str(), NVS_READONLY, &handle);
+    if (ret == ESP_ERR_NVS_NOT_FOUND) {
+        // The namespace has never been written
+        loaded_[ns] = true;
+        return &namespaces_[ns];
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to open namespace %s: %s", ns.c_str(), esp_err_to_name(ret));
+        return nullptr;
+    }
+
+    auto& space = namespaces_[ns];
+    nvs_iterator_t it = nullptr;
+    ret = nvs_entry_find(NVS_DEFAULT_PART_NAME, ns.c_str(), NVS_TYPE_ANY, &it);
+    while (ret == ESP_OK) {
+        nvs_entry_info_t info;
+        nvs_entry_info(it, &info);
+        // Keys written since the process started are newer than flash
+        if (space.entries.find(info.key) == space.entries.end()) {
+            if (info.type == NVS_TYPE_I32) {
+                int32_t value;
+                if (nvs_get_i32(handle, info.key, &value) == ESP_OK) {
+                    space.entries[info.key].value = value;
+                }
+            } else if (info.type == NVS_TYPE_STR) {
+                size_t length = 0;
+                if (nvs_get_str(handle, info.key, nullptr, &length) == ESP_OK) {
+                    std::string value;
+                    value.resize(length);
+                    nvs_get_str(handle, info.key, value.data(), &length);
+                    while (!value.empty() && value.back() == '\0') {
+                        value.pop_back();
+                    }
+                    space.entries[info.key].value = std::move(value);
+                }
+            }
+        }
+        ret = nvs_entry_next(&it);
+    }
+    nvs_release_iterator(it);
+    nvs_close(handle);
+
+    loaded_[ns] = true;
+    return &space;
 }
 
-Settings::~Settings() {
-    if (nvs_handle_ != 0) {
-        if (read_write_ && dirty_) {
-            ESP_ERROR_CHECK(nvs_commit(nvs_handle_));
+void SettingsCache::ScheduleCommit() {
+    int64_t now = esp_timer_get_time();
+    if (first_pending_us_ == 0) {
+        first_pending_us_ = now;
+    }
+    int64_t deadline = first_pending_us_ + SETTINGS_COMMIT_MAX_DELAY_MS * 1000;
+    int64_t delay = std::min<int64_t>(SETTINGS_COMMIT_DELAY_MS * 1000, deadline - now);
+    esp_timer_stop(commit_timer_);
+    esp_timer_start_once(commit_timer_, std::max<int64_t>(delay, 0));
+}
+
+// Marks the changes of a failed commit dirty again, unless they were superseded in the meantime
+void SettingsCache::Requeue(const std::string& ns, const Namespace& changes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& space = namespaces_[ns];
+    space.dirty = true;
+    if (space.erase_all) {
+        // EraseAll() was called since, older changes are gone anyway
+        return;
+    }
+    space.erase_all = changes.erase_all;
+    for (auto& [key, entry] : changes.entries) {
+        auto it = space.entries.find(key);
+        if (it == space.entries.end()) {
+            // Erased placeholders are dropped after the snapshot
+            space.entries[key] = entry;
+        } else {
+            // A newer value is already dirty and wins
+            it->second.dirty = true;
         }
-        nvs_close(nvs_handle_);
     }
 }
 
-std::string Settings::GetString(const std::string& key, const std::string& default_value) {
-    if (nvs_handle_ == 0) {
-        return default_value;
+void SettingsCache::Commit() {
+    std::lock_guard<std::mutex> commit_lock(commit_mutex_);
+    // Take a snapshot of the pending writes, so the flash writes run without holding the lock
+    std::vector<std::pair<std::string, Namespace>> pending;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        esp_timer_stop(commit_timer_);
+        first_pending_us_ = 0;
+        for (auto& [name, space] : namespaces_) {
+            if (!space.dirty) {
+                continue;
+            }
+            Namespace changes;
+            changes.erase_all = space.erase_all;
+            for (auto& [key, entry] : space.entries) {
+                if (entry.dirty) {
+                    changes.entries[key] = entry;
+                    entry.dirty = false;
+                }
+            }
+            pending.emplace_back(name, std::move(changes));
+            space.erase_all = false;
+            space.dirty = false;
+        }
+        // Erased keys no longer need a placeholder
+        for (auto& [name, space] : namespaces_) {
+            for (auto it = space.entries.begin(); it != space.entries.end();) {
+                if (it->second.erased && !it->second.dirty) {
+                    it = space.entries.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
     }
 
-    size_t length = 0;
-    if (nvs_get_str(nvs_handle_, key.c_str(), nullptr, &length) != ESP_OK) {
-        return default_value;
+    for (auto& [name, changes] : pending) {
+        nvs_handle_t handle;
+        esp_err_t ret = nvs_open(name.c_str(), NVS_READWRITE, &handle);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to open namespace %s for writing: %s", name.c_str(), esp_err_to_name(ret));
+            // Retried with the next write, Flush() or restart
+            Requeue(name, changes);
+            continue;
+        }
+        if (changes.erase_all) {
+            ESP_ERROR_CHECK(nvs_erase_all(handle));
+        }
+        for (auto& [key, entry] : changes.entries) {
+            if (entry.erased) {
+                ret = nvs_erase_key(handle, key.c_str());
+                if (ret != ESP_ERR_NVS_NOT_FOUND) {
+                    ESP_ERROR_CHECK(ret);
+                }
+            } else if (std::holds_alternative<int32_t>(entry.value)) {
+                ESP_ERROR_CHECK(nvs_set_i32(handle, key.c_str(), std::get<int32_t>(entry.value)));
+            } else {
+                ESP_ERROR_CHECK(nvs_set_str(handle, key.c_str(), std::get<std::string>(entry.value).c_str()));
+            }
+        }
+        ESP_ERROR_CHECK(nvs_commit(handle));
+        nvs_close(handle);
+        ESP_LOGI(TAG, "Committed %u changes to namespace %s", (unsigned)changes.entries.size(), name.c_str());
     }
+}
+
+} // namespace
+
+Settings::Settings(const std::string& ns, bool read_write) : ns_(ns), read_write_(read_write) {
+}
+
+Settings::~Settings() {
+}
 
+std::string Settings::GetString(const std::string& key, const std::string& default_value) {
     std::string value;
-    value.resize(length);
-    ESP_ERROR_CHECK(nvs_get_str(nvs_handle_, key.c_str(), value.data(), &length));
-    while (!value.empty() && value.back() == '\0') {
-        value.pop_back();
+    if (!SettingsCache::GetInstance().Get(ns_, key, value)) {
+        return default_value;
     }
     return value;
 }
 
 void Settings::SetString(const std::string& key, const std::string& value) {
     if (read_write_) {
-        ESP_ERROR_CHECK(nvs_set_str(nvs_handle_, key.c_str(), value.c_str()));
-        dirty_ = true;
+        SettingsCache::GetInstance().Set(ns_, key, value);
     } else {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
     }
 }
 
 int32_t Settings::GetInt(const std::string& key, int32_t default_value) {
-    if (nvs_handle_ == 0) {
-        return default_value;
-    }
-
     int32_t value;
-    if (nvs_get_i32(nvs_handle_, key.c_str(), &value) != ESP_OK) {
+    if (!SettingsCache::GetInstance().Get(ns_, key, value)) {
         return default_value;
     }
     return value;
@@ -60,8 +337,7 @@ int32_t Settings::GetInt(const std::string& key, int32_t default_value) {
 
 void Settings::SetInt(const std::string& key, int32_t value) {
     if (read_write_) {
-        ESP_ERROR_CHECK(nvs_set_i32(nvs_handle_, key.c_str(), value));
-        dirty_ = true;
+        SettingsCache::GetInstance().Set(ns_, key, value);
     } else {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
     }
@@ -69,10 +345,7 @@ void Settings::SetInt(const std::string& key, int32_t value) {
 
 void Settings::EraseKey(const std::string& key) {
     if (read_write_) {
-        auto ret = nvs_erase_key(nvs_handle_, key.c_str());
-        if (ret != ESP_ERR_NVS_NOT_FOUND) {
-            ESP_ERROR_CHECK(ret);
-        }
+        SettingsCache::GetInstance().Erase(ns_, key);
     } else {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
     }
@@ -80,8 +353,12 @@ void Settings::EraseKey(const std::string& key) {
 
 void Settings::EraseAll() {
     if (read_write_) {
-        ESP_ERROR_CHECK(nvs_erase_all(nvs_handle_));
+        SettingsCache::GetInstance().EraseAll(ns_);
     } else {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
     }
 }
+
+void Settings::Flush() {
+    SettingsCache::GetInstance().Commit();
+}
@@ -4,6 +4,13 @@
 #include <string>
 #include <nvs_flash.h>
 
+/**
+ * Settings are served from a process-wide RAM cache. A namespace is loaded from NVS on its
+ * first use, writes only touch the cache and are committed to flash by a debounced background
+ * commit, so repeated changes (e.g. turning a volume knob) cost a single flash write.
+ * Pending writes are flushed on esp_restart() and before PowerSaveTimer shutdown requests;
+ * call Flush() before anything else that may lose power, such as esp_deep_sleep_start().
+ */
 class Settings {
 public:
     Settings(const std::string& ns, bool read_write = false);
@@ -16,11 +23,12 @@ public:
     void EraseKey(const std::string& key);
     void EraseAll();
 
+    // Commit all pending writes to NVS now
+    static void Flush();
+
 private:
     std::string ns_;
-    nvs_handle_t nvs_handle_ = 0;
     bool read_write_ = false;
-    bool dirty_ = false;
 };
 
 #endif
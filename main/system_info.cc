@@ -94,9 +94,9 @@ esp_err_t SystemInfo::PrintTaskCpuUsage(TickType_t xTicksToWait) {
 
     printf("| Task | Run Time | Percentage\n");
     //Match each task in start_array to those in the end_array
-    for (int i = 0; i < start_array_size; i++) {
+    for (UBaseType_t i = 0; i < start_array_size; i++) {
         int k = -1;
-        for (int j = 0; j < end_array_size; j++) {
+        for (UBaseType_t j = 0; j < end_array_size; j++) {
             if (start_array[i].xHandle == end_array[j].xHandle) {
                 k = j;
                 //Mark that task have been matched by overwriting their handles
@@ -109,17 +109,17 @@ esp_err_t SystemInfo::PrintTaskCpuUsage(TickType_t xTicksToWait) {
         if (k >= 0) {
             uint32_t task_elapsed_time = end_array[k].ulRunTimeCounter - start_array[i].ulRunTimeCounter;
             uint32_t percentage_time = (task_elapsed_time * 100UL) / (total_elapsed_time * CONFIG_FREERTOS_NUMBER_OF_CORES);
-            printf("| %-16s | %8lu | %4lu%%\n", start_array[i].pcTaskName, task_elapsed_time, percentage_time);
+            printf("| %-16s | %8lu | %4lu%%\n", start_array[i].pcTaskName, (unsigned long)task_elapsed_time, (unsigned long)percentage_time);
         }
     }
 
     //Print unmatched tasks
-    for (int i = 0; i < start_array_size; i++) {
+    for (UBaseType_t i = 0; i < start_array_size; i++) {
         if (start_array[i].xHandle != NULL) {
             printf("| %s | Deleted\n", start_array[i].pcTaskName);
         }
     }
-    for (int i = 0; i < end_array_size; i++) {
+    for (UBaseType_t i = 0; i < end_array_size; i++) {
         if (end_array[i].xHandle != NULL) {
             printf("| %s | Created\n", end_array[i].pcTaskName);
         }
@@ -141,5 +141,10 @@ void SystemInfo::PrintTaskList() {
 void SystemInfo::PrintHeapStats() {
     int free_sram = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
     int min_free_sram = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
-    ESP_LOGI(TAG, "free sram: %u minimal sram: %u", free_sram, min_free_sram);
+    int largest_sram = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
+    ESP_LOGI(TAG, "free sram: %u minimal sram: %u largest block: %u", free_sram, min_free_sram, largest_sram);
+    int free_psram = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    if (free_psram > 0) {
+        ESP_LOGI(TAG, "free psram: %u minimal psram: %u", free_psram, (unsigned)heap_caps_get_minimum_free_size(MALLOC_CAP_SPIRAM));
+    }
 }
@@ -0,0 +1,284 @@
+#include "system_profiler.h"
+
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include <cstring>
+#include <algorithm>
+
+#define TAG "SystemProfiler"
+
+static void ReadHeapStats(uint32_t caps, HeapStats& stats) {
+    stats.free_size = heap_caps_get_free_size(caps);
+    stats.minimum_free_size = heap_caps_get_minimum_free_size(caps);
+    stats.largest_free_block = heap_caps_get_largest_free_block(caps);
+}
+
+static cJSON* HeapStatsToJson(const HeapStats& stats) {
+    // [free, minimum free, largest free block]
+    cJSON* json = cJSON_CreateArray();
+    cJSON_AddItemToArray(json, cJSON_CreateNumber(stats.free_size));
+    cJSON_AddItemToArray(json, cJSON_CreateNumber(stats.minimum_free_size));
+    cJSON_AddItemToArray(json, cJSON_CreateNumber(stats.largest_free_block));
+    return json;
+}
+
+SystemProfiler::SystemProfiler() {
+    esp_timer_create_args_t timer_args = {
+        .callback = [](void* arg) {
+            static_cast<SystemProfiler*>(arg)->Sample();
+        },
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "system_profiler",
+        .skip_unhandled_events = true,
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &sample_timer_));
+}
+
+SystemProfiler::~SystemProfiler() {
+    if (sample_timer_ != nullptr) {
+        esp_timer_stop(sample_timer_);
+        esp_timer_delete(sample_timer_);
+    }
+    heap_caps_free(snapshot_);
+    heap_caps_free(tasks_);
+    heap_caps_free(previous_tasks_);
+    heap_caps_free(history_);
+}
+
+void SystemProfiler::Start(uint32_t interval_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (history_ == nullptr) {
+        snapshot_ = (TaskStatus_t*)heap_caps_malloc(sizeof(TaskStatus_t) * SYSTEM_PROFILER_MAX_TASKS, MALLOC_CAP_8BIT);
+        tasks_ = (TaskStats*)heap_caps_malloc(sizeof(TaskStats) * SYSTEM_PROFILER_MAX_TASKS, MALLOC_CAP_8BIT);
+        previous_tasks_ = (TaskStats*)heap_caps_malloc(sizeof(TaskStats) * SYSTEM_PROFILER_MAX_TASKS, MALLOC_CAP_8BIT);
+        // The history is only read on request, PSRAM is fine for it
+        history_ = (ProfilerSample*)heap_caps_calloc(SYSTEM_PROFILER_HISTORY, sizeof(ProfilerSample), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (history_ == nullptr) {
+            history_ = (ProfilerSample*)heap_caps_calloc(SYSTEM_PROFILER_HISTORY, sizeof(ProfilerSample), MALLOC_CAP_8BIT);
+        }
+        if (snapshot_ == nullptr || tasks_ == nullptr || previous_tasks_ == nullptr || history_ == nullptr) {
+            ESP_LOGE(TAG, "Failed to allocate profiler buffers");
+            return;
+        }
+    }
+    interval_ms_ = interval_ms;
+    esp_timer_stop(sample_timer_);
+    esp_timer_start_periodic(sample_timer_, (uint64_t)interval_ms * 1000);
+    ESP_LOGI(TAG, "Sampling every %lu ms, %d samples of history", (unsigned long)interval_ms, SYSTEM_PROFILER_HISTORY);
+}
+
+void SystemProfiler::Stop() {
+    esp_timer_stop(sample_timer_);
+}
+
+void SystemProfiler::SetMainLoopStatsSource(std::function<MainMessageStats()> source) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    main_loop_stats_source_ = std::move(source);
+}
+
+void SystemProfiler::SetPowerSource(std::function<cJSON*()> source) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    power_source_ = std::move(source);
+}
+
+void SystemProfiler::Sample() {
+    ProfilerSample sample = {};
+    sample.time_us = esp_timer_get_time();
+    // Heap walks take the heap locks, keep them outside of our own lock
+    ReadHeapStats(MALLOC_CAP_INTERNAL, sample.internal);
+    ReadHeapStats(MALLOC_CAP_SPIRAM, sample.spiram);
+    ReadHeapStats(MALLOC_CAP_DMA, sample.dma);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (main_loop_stats_source_) {
+        auto stats = main_loop_stats_source_();
+        sample.main_loop.dispatched = stats.dispatched;
+        sample.main_loop.coalesced = stats.coalesced;
+        sample.main_loop.avg_wait_us = stats.dispatched > 0 ? stats.total_wait_us / stats.dispatched : 0;
+        sample.main_loop.max_wait_us = stats.max_wait_us;
+        sample.main_loop.max_run_us = stats.max_run_us;
+    }
+    configRUN_TIME_COUNTER_TYPE total_run_time;
+    UBaseType_t count = uxTaskGetSystemState(snapshot_, SYSTEM_PROFILER_MAX_TASKS, &total_run_time);
+    if (count == 0) {
+        // More tasks than SYSTEM_PROFILER_MAX_TASKS
+        if (skipped_samples_++ == 0) {
+            ESP_LOGW(TAG, "Too many tasks (%u), increase SYSTEM_PROFILER_MAX_TASKS", (unsigned)uxTaskGetNumberOfTasks());
+        }
+        return;
+    }
+    std::sort(snapshot_, snapshot_ + count, [](const TaskStatus_t& a, const TaskStatus_t& b) {
+        return a.xTaskNumber < b.xTaskNumber;
+    });
+
+    std::swap(tasks_, previous_tasks_);
+    size_t previous_count = task_count_;
+    configRUN_TIME_COUNTER_TYPE elapsed = total_run_time - last_total_run_time_;
+    bool has_baseline = last_total_run_time_ != 0;
+    last_total_run_time_ = total_run_time;
+
+    TaskHandle_t idle_tasks[CONFIG_FREERTOS_NUMBER_OF_CORES];
+    for (int core = 0; core < CONFIG_FREERTOS_NUMBER_OF_CORES; core++) {
+        idle_tasks[core] = xTaskGetIdleTaskHandleForCore(core);
+        sample.core_load[core] = 0;
+    }
+
+    // Both lists are sorted by task number, tasks created since the last sample have no baseline
+    size_t p = 0;
+    for (size_t i = 0; i < count; i++) {
+        const TaskStatus_t& status = snapshot_[i];
+        TaskStats& task = tasks_[i];
+        while (p < previous_count && previous_tasks_[p].number < status.xTaskNumber) {
+            p++;
+        }
+        const TaskStats* previous = (p < previous_count && previous_tasks_[p].number == status.xTaskNumber) ? &previous_tasks_[p] : nullptr;
+
+        task.number = status.xTaskNumber;
+        strncpy(task.name, status.pcTaskName, sizeof(task.name) - 1);
+        task.name[sizeof(task.name) - 1] = '\0';
+        task.run_time = status.ulRunTimeCounter;
+        task.stack_high_water_mark = status.usStackHighWaterMark;
+        task.cpu = 0;
+        if (previous != nullptr && has_baseline && elapsed > 0) {
+            uint64_t delta = (configRUN_TIME_COUNTER_TYPE)(status.ulRunTimeCounter - previous->run_time);
+            task.cpu = std::min<uint64_t>(delta * 100 / elapsed, 100);
+        }
+        task.peak_cpu = std::max(task.cpu, previous != nullptr ? previous->peak_cpu : (uint8_t)0);
+
+        for (int core = 0; core < CONFIG_FREERTOS_NUMBER_OF_CORES; core++) {
+            if (status.xHandle == idle_tasks[core] && has_baseline) {
+                sample.core_load[core] = 100 - task.cpu;
+            }
+        }
+    }
+    task_count_ = count;
+    if (!has_baseline) {
+        return;
+    }
+
+    // Idle tasks are already accounted for in the core load
+    for (size_t i = 0; i < task_count_; i++) {
+        const TaskStats& task = tasks_[i];
+        if (task.cpu == 0 || strncmp(task.name, "IDLE", 4) == 0) {
+            continue;
+        }
+        for (int k = 0; k < SYSTEM_PROFILER_TOP_TASKS; k++) {
+            auto& top = sample.top_tasks[k];
+            if (top.name[0] == '\0' || task.cpu > top.cpu) {
+                for (int m = SYSTEM_PROFILER_TOP_TASKS - 1; m > k; m--) {
+                    sample.top_tasks[m] = sample.top_tasks[m - 1];
+                }
+                memcpy(top.name, task.name, sizeof(top.name));
+                top.cpu = task.cpu;
+                break;
+            }
+        }
+    }
+
+    history_[history_head_] = sample;
+    history_head_ = (history_head_ + 1) % SYSTEM_PROFILER_HISTORY;
+    history_count_ = std::min<size_t>(history_count_ + 1, SYSTEM_PROFILER_HISTORY);
+}
+
+const ProfilerSample* SystemProfiler::Latest() const {
+    if (history_count_ == 0) {
+        return nullptr;
+    }
+    return &history_[(history_head_ + SYSTEM_PROFILER_HISTORY - 1) % SYSTEM_PROFILER_HISTORY];
+}
+
+cJSON* SystemProfiler::GetSummaryJson() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto latest = Latest();
+    if (latest == nullptr) {
+        return nullptr;
+    }
+    auto json = cJSON_CreateObject();
+    auto load = cJSON_CreateArray();
+    for (int core = 0; core < CONFIG_FREERTOS_NUMBER_OF_CORES; core++) {
+        cJSON_AddItemToArray(load, cJSON_CreateNumber(latest->core_load[core]));
+    }
+    cJSON_AddItemToObject(json, "cpu_load", load);
+    cJSON_AddNumberToObject(json, "free_internal_heap", latest->internal.free_size);
+    cJSON_AddNumberToObject(json, "largest_internal_block", latest->internal.largest_free_block);
+    if (latest->spiram.free_size > 0) {
+        cJSON_AddNumberToObject(json, "free_spiram", latest->spiram.free_size);
+    }
+    cJSON_AddNumberToObject(json, "main_loop_max_wait_us", latest->main_loop.max_wait_us);
+    return json;
+}
+
+std::string SystemProfiler::GetProfileJson(int max_samples) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "interval_ms", interval_ms_);
+    cJSON_AddNumberToObject(root, "skipped_samples", skipped_samples_);
+
+    auto tasks = cJSON_CreateArray();
+    for (size_t i = 0; i < task_count_; i++) {
+        auto& stats = tasks_[i];
+        auto task = cJSON_CreateObject();
+        cJSON_AddStringToObject(task, "name", stats.name);
+        cJSON_AddNumberToObject(task, "cpu", stats.cpu);
+        cJSON_AddNumberToObject(task, "peak_cpu", stats.peak_cpu);
+        cJSON_AddNumberToObject(task, "stack_free", stats.stack_high_water_mark);
+        cJSON_AddItemToArray(tasks, task);
+    }
+    cJSON_AddItemToObject(root, "tasks", tasks);
+
+    // Heap arrays are [free, minimum free, largest free block]
+    auto history = cJSON_CreateArray();
+    size_t count = std::min<size_t>(std::max(max_samples, 0), history_count_);
+    int64_t now = esp_timer_get_time();
+    for (size_t i = 0; i < count; i++) {
+        auto& sample = history_[(history_head_ + SYSTEM_PROFILER_HISTORY - count + i) % SYSTEM_PROFILER_HISTORY];
+        auto item = cJSON_CreateObject();
+        cJSON_AddNumberToObject(item, "age_ms", (now - sample.time_us) / 1000);
+        auto load = cJSON_CreateArray();
+        for (int core = 0; core < CONFIG_FREERTOS_NUMBER_OF_CORES; core++) {
+            cJSON_AddItemToArray(load, cJSON_CreateNumber(sample.core_load[core]));
+        }
+        cJSON_AddItemToObject(item, "cpu_load", load);
+        cJSON_AddItemToObject(item, "internal", HeapStatsToJson(sample.internal));
+        if (sample.spiram.free_size > 0) {
+            cJSON_AddItemToObject(item, "spiram", HeapStatsToJson(sample.spiram));
+        }
+        cJSON_AddItemToObject(item, "dma", HeapStatsToJson(sample.dma));
+        auto top = cJSON_CreateObject();
+        for (auto& task : sample.top_tasks) {
+            if (task.name[0] != '\0') {
+                cJSON_AddNumberToObject(top, task.name, task.cpu);
+            }
+        }
+        cJSON_AddItemToObject(item, "top_tasks", top);
+        // [messages, coalesced, average wait, max wait, max run], times in us
+        auto main_loop = cJSON_CreateArray();
+        cJSON_AddItemToArray(main_loop, cJSON_CreateNumber(sample.main_loop.dispatched));
+        cJSON_AddItemToArray(main_loop, cJSON_CreateNumber(sample.main_loop.coalesced));
+        cJSON_AddItemToArray(main_loop, cJSON_CreateNumber(sample.main_loop.avg_wait_us));
+        cJSON_AddItemToArray(main_loop, cJSON_CreateNumber(sample.main_loop.max_wait_us));
+        cJSON_AddItemToArray(main_loop, cJSON_CreateNumber(sample.main_loop.max_run_us));
+        cJSON_AddItemToObject(item, "main_loop", main_loop);
+        cJSON_AddItemToArray(history, item);
+    }
+    cJSON_AddItemToObject(root, "history", history);
+    if (power_source_) {
+        cJSON_AddItemToObject(root, "power", power_source_());
+    }
+
+    auto json_str = cJSON_PrintUnformatted(root);
+    std::string json(json_str);
+    cJSON_free(json_str);
+    cJSON_Delete(root);
+    return json;
+}
+
+void SystemProfiler::PrintTasks() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ESP_LOGI(TAG, "| Task             | CPU  | Peak | Stack free");
+    for (size_t i = 0; i < task_count_; i++) {
+        auto& task = tasks_[i];
+        ESP_LOGI(TAG, "| %-16s | %3u%% | %3u%% | %6lu", task.name, task.cpu, task.peak_cpu, (unsigned long)task.stack_high_water_mark);
+    }
+}
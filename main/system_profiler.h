@@ -0,0 +1,108 @@
+#ifndef SYSTEM_PROFILER_H
+#define SYSTEM_PROFILER_H
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+#include <cJSON.h>
+
+#include <mutex>
+#include <string>
+#include <functional>
+
+#include "main_message_queue.h"
+
+#define SYSTEM_PROFILER_INTERVAL_MS 2000
+#define SYSTEM_PROFILER_HISTORY 30
+#define SYSTEM_PROFILER_MAX_TASKS 40
+#define SYSTEM_PROFILER_TOP_TASKS 3
+
+struct HeapStats {
+    uint32_t free_size;
+    uint32_t minimum_free_size;
+    uint32_t largest_free_block;    // Much smaller than free_size means the heap is fragmented
+};
+
+struct ProfilerSample {
+    int64_t time_us;
+    uint8_t core_load[CONFIG_FREERTOS_NUMBER_OF_CORES];    // Percent, derived from the idle tasks
+    HeapStats internal;
+    HeapStats spiram;
+    HeapStats dma;
+    struct {
+        char name[configMAX_TASK_NAME_LEN];
+        uint8_t cpu;    // Percent of one core
+    } top_tasks[SYSTEM_PROFILER_TOP_TASKS];
+    struct {
+        uint32_t dispatched;
+        uint32_t coalesced;
+        uint32_t avg_wait_us;
+        uint32_t max_wait_us;
+        uint32_t max_run_us;
+    } main_loop;    // Over the interval
+};
+
+/**
+ * Background sampler of per task CPU usage, stack high water marks and heap statistics.
+ *
+ * Every interval it takes one uxTaskGetSystemState() snapshot into a preallocated buffer and
+ * diffs the run time counters against the previous snapshot (both sorted by task number, so the
+ * match is a merge), then appends a compact sample to a ring buffer. Nothing is allocated after
+ * Start(), and the caller never blocks for the measurement window.
+ */
+class SystemProfiler {
+public:
+    static SystemProfiler& GetInstance() {
+        static SystemProfiler instance;
+        return instance;
+    }
+    // Delete copy constructor and assignment operator
+    SystemProfiler(const SystemProfiler&) = delete;
+    SystemProfiler& operator=(const SystemProfiler&) = delete;
+
+    void Start(uint32_t interval_ms = SYSTEM_PROFILER_INTERVAL_MS);
+    void Stop();
+    // Called once per sample from the esp_timer task, returns the stats since the previous call
+    void SetMainLoopStatsSource(std::function<MainMessageStats()> source);
+    // Power level residency, added to the profile as "power"
+    void SetPowerSource(std::function<cJSON*()> source);
+
+    // Latest values only, small enough for the device status
+    cJSON* GetSummaryJson();
+    // Per task table and up to max_samples of history, newest last
+    std::string GetProfileJson(int max_samples = SYSTEM_PROFILER_HISTORY);
+    void PrintTasks();
+
+private:
+    struct TaskStats {
+        UBaseType_t number;
+        char name[configMAX_TASK_NAME_LEN];
+        configRUN_TIME_COUNTER_TYPE run_time;
+        uint32_t stack_high_water_mark;     // Bytes
+        uint8_t cpu;
+        uint8_t peak_cpu;
+    };
+
+    std::mutex mutex_;
+    esp_timer_handle_t sample_timer_ = nullptr;
+    uint32_t interval_ms_ = 0;
+    TaskStatus_t* snapshot_ = nullptr;
+    TaskStats* tasks_ = nullptr;
+    TaskStats* previous_tasks_ = nullptr;
+    size_t task_count_ = 0;
+    configRUN_TIME_COUNTER_TYPE last_total_run_time_ = 0;
+    ProfilerSample* history_ = nullptr;
+    size_t history_head_ = 0;
+    size_t history_count_ = 0;
+    uint32_t skipped_samples_ = 0;
+    std::function<MainMessageStats()> main_loop_stats_source_;
+    std::function<cJSON*()> power_source_;
+
+    SystemProfiler();
+    ~SystemProfiler();
+
+    void Sample();
+    const ProfilerSample* Latest() const;
+};
+
+#endif // SYSTEM_PROFILER_H
@@ -0,0 +1,163 @@
+# convert GIF files to pre-decoded RLE/delta RGB565 emoji animations (see main/display/emoji_anim_format.h)
+import argparse
+import os
+import struct
+import sys
+
+from PIL import Image, ImageSequence
+
+MAGIC = 0x314E4145  # "EAN1"
+HEADER_FORMAT = '<IHHHH'
+FRAME_FORMAT = '<IIHH'
+FRAME_FLAG_KEY = 1
+
+OP_SKIP = 0
+OP_RUN = 1
+OP_LITERAL = 2
+MAX_SHORT_COUNT = 64
+MAX_LONG_COUNT = 4096
+MIN_RUN = 3
+
+
+def to_rgb565(image, background):
+    canvas = Image.new('RGBA', image.size, background + (255,))
+    canvas.alpha_composite(image.convert('RGBA'))
+    pixels = []
+    for r, g, b, _ in canvas.getdata():
+        pixels.append(((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3))
+    return pixels
+
+
+def emit_op(out, op, count, payload=b''):
+    while count > 0:
+        n = min(count, MAX_LONG_COUNT)
+        if n <= MAX_SHORT_COUNT:
+            out.append((op << 6) | (n - 1))
+        else:
+            out.append(0xC0 | (op << 4) | ((n - 1) >> 8))
+            out.append((n - 1) & 0xFF)
+        if op == OP_RUN:
+            out += payload
+        elif op == OP_LITERAL:
+            out += payload[:n * 2]
+            payload = payload[n * 2:]
+        count -= n
+
+
+def encode_frame(pixels, previous):
+    out = bytearray()
+    literal = []
+
+    def flush_literal():
+        if literal:
+            emit_op(out, OP_LITERAL, len(literal), b''.join(struct.pack('<H', p) for p in literal))
+            literal.clear()
+
+    i = 0
+    total = len(pixels)
+    while i < total:
+        if previous is not None and pixels[i] == previous[i]:
+            j = i
+            while j < total and pixels[j] == previous[j]:
+                j += 1
+            flush_literal()
+            emit_op(out, OP_SKIP, j - i)
+            i = j
+            continue
+
+        j = i
+        while j < total and pixels[j] == pixels[i] and (previous is None or pixels[j] != previous[j]):
+            j += 1
+        if j - i >= MIN_RUN:
+            flush_literal()
+            emit_op(out, OP_RUN, j - i, struct.pack('<H', pixels[i]))
+            i = j
+        else:
+            literal.append(pixels[i])
+            i += 1
+    flush_literal()
+    return bytes(out)
+
+
+def convert(input_file, size, background, keyframe_interval):
+    gif = Image.open(input_file)
+    width, height = size if size else gif.size
+    frames = []
+    previous = None
+    for index, frame in enumerate(ImageSequence.Iterator(gif)):
+        delay = frame.info.get('duration', gif.info.get('duration', 100)) or 100
+        image = frame.convert('RGBA')
+        if image.size != (width, height):
+            image = image.resize((width, height), Image.LANCZOS)
+        pixels = to_rgb565(image, background)
+        key = previous is None or (keyframe_interval > 0 and index % keyframe_interval == 0)
+        payload = encode_frame(pixels, None if key else previous)
+        frames.append((payload, delay, FRAME_FLAG_KEY if key else 0))
+        previous = pixels
+
+    data = bytearray(struct.pack(HEADER_FORMAT, MAGIC, width, height, len(frames), 0))
+    offset = len(data) + len(frames) * struct.calcsize(FRAME_FORMAT)
+    table = bytearray()
+    payloads = bytearray()
+    for payload, delay, flags in frames:
+        table += struct.pack(FRAME_FORMAT, offset + len(payloads), len(payload), min(delay, 0xFFFF), flags)
+        payloads += payload
+        # Keep every payload 4-byte aligned
+        payloads += b'\0' * (-len(payload) % 4)
+    data += table + payloads
+
+    raw_size = width * height * 2 * len(frames)
+    print(f'{input_file}: {width}x{height}, {len(frames)} frames, '
+          f'{len(data)} bytes ({len(data) * 100 / raw_size:.1f}% of raw RGB565)')
+    return bytes(data)
+
+
+def write_c_source(data, name, output_file):
+    with open(output_file, 'w') as f:
+        f.write('// Generated by scripts/Emoji_Converter/gif_to_anim.py, do not edit\n')
+        f.write('#include "emoji_anim_format.h"\n\n')
+        f.write(f'static const uint8_t {name}_data[] __attribute__((aligned(4))) = {{\n')
+        for i in range(0, len(data), 16):
+            f.write('    ' + ', '.join(f'0x{b:02x}' for b in data[i:i + 16]) + ',\n')
+        f.write('};\n\n')
+        f.write(f'const emoji_anim_dsc_t {name} = {{\n')
+        f.write(f'    .data = {name}_data,\n')
+        f.write(f'    .data_size = sizeof({name}_data),\n')
+        f.write('};\n')
+
+
+def parse_size(value):
+    width, height = value.lower().split('x')
+    return int(width), int(height)
+
+
+def parse_color(value):
+    value = value.lstrip('#')
+    return tuple(int(value[i:i + 2], 16) for i in (0, 2, 4))
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='Convert GIF files to emoji animations (RLE/delta RGB565)')
+    parser.add_argument('input_files', nargs='+', help='Input GIF files')
+    parser.add_argument('-o', '--output-dir', default='.', help='Output directory')
+    parser.add_argument('-s', '--size', type=parse_size, help='Output size, e.g. 240x240 (default: GIF size)')
+    parser.add_argument('-f', '--format', choices=['c', 'bin'], default='c',
+                        help='Output a C source file or a raw binary (default: c)')
+    parser.add_argument('-b', '--background', type=parse_color, default=(0, 0, 0),
+                        help='Background color for transparent pixels (default: 000000)')
+    parser.add_argument('-k', '--keyframe-interval', type=int, default=0,
+                        help='Insert a key frame every N frames (default: only the first frame)')
+    parser.add_argument('--suffix', default='_anim', help='Suffix of the C symbol name (default: _anim)')
+    args = parser.parse_args()
+
+    os.makedirs(args.output_dir, exist_ok=True)
+    for input_file in args.input_files:
+        base = os.path.splitext(os.path.basename(input_file))[0]
+        data = convert(input_file, args.size, args.background, args.keyframe_interval)
+        if args.format == 'c':
+            name = base.replace('-', '_') + args.suffix
+            write_c_source(data, name, os.path.join(args.output_dir, name + '.c'))
+        else:
+            with open(os.path.join(args.output_dir, base + '.anim'), 'wb') as f:
+                f.write(data)
+    sys.exit(0)
@@ -0,0 +1,80 @@
+import sys
+import math
+import wave
+import struct
+import argparse
+
+
+'''
+  Generate the sound of the acoustic WiFi provisioning (CONFIG_USE_ACOUSTIC_WIFI_PROVISIONING),
+  for the modulation selected in menuconfig, and write it to a WAV file.
+
+    python scripts/acoustic_wifi_send.py "my ssid" "my password" --mode mfsk400 -o wifi.wav
+
+  Play the file near the device while it is in WiFi configuration mode.
+
+  Frame: preamble, \x01\x02, "ssid\npassword", 8-bit sum of the text, \x03\x04, bits MSB first.
+  Must match main/boards/common/afsk_demod.h
+'''
+
+MODES = {
+    # name: (baud, tones), tones[i] is sent for symbol value i
+    "fsk100": (100, [1500, 1800]),
+    "mfsk400": (200, [1400, 1600, 1800, 2000]),
+}
+
+START = b"\x01\x02"
+END = b"\x03\x04"
+# 00110011 changes the tone on every symbol of both modes, the receiver locks its timing on it
+PREAMBLE = b"\x33" * 4
+
+
+def frame_bits(ssid, password):
+    text = f"{ssid}\n{password}".encode("utf-8")
+    checksum = sum(text) & 0xFF
+    data = PREAMBLE + START + text + bytes([checksum]) + END
+    return [(byte >> (7 - i)) & 1 for byte in data for i in range(8)]
+
+
+def modulate(bits, baud, tones, sample_rate, amplitude):
+    bits_per_symbol = int(math.log2(len(tones)))
+    samples_per_symbol = sample_rate / baud
+    samples = []
+    phase = 0.0
+    position = 0.0
+    for i in range(0, len(bits), bits_per_symbol):
+        symbol = 0
+        for bit in bits[i:i + bits_per_symbol]:
+            symbol = (symbol << 1) | bit
+        step = 2 * math.pi * tones[symbol] / sample_rate
+        position += samples_per_symbol
+        # Continuous phase, no click between symbols
+        while len(samples) < round(position):
+            samples.append(int(amplitude * math.sin(phase)))
+            phase += step
+    return samples
+
+
+def main(ssid, password, mode, output_file, sample_rate, volume):
+    baud, tones = MODES[mode]
+    silence = [0] * (sample_rate // 5)
+    samples = silence + modulate(frame_bits(ssid, password), baud, tones, sample_rate, 32767 * volume) + silence
+    with wave.open(output_file, "wb") as f:
+        f.setnchannels(1)
+        f.setsampwidth(2)
+        f.setframerate(sample_rate)
+        f.writeframes(struct.pack(f"<{len(samples)}h", *samples))
+    print(f"{len(samples) / sample_rate:.2f} s of {mode} written to {output_file}")
+    return 0
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Acoustic WiFi provisioning sender")
+    parser.add_argument("ssid", help="WiFi SSID")
+    parser.add_argument("password", help="WiFi password")
+    parser.add_argument("--mode", choices=MODES.keys(), default="fsk100", help="must match the menuconfig choice")
+    parser.add_argument("-o", "--output", default="acoustic_wifi.wav", help="output WAV file")
+    parser.add_argument("--sample-rate", type=int, default=48000, help="sample rate of the WAV file")
+    parser.add_argument("--volume", type=float, default=0.5, help="amplitude, 0 to 1")
+    args = parser.parse_args()
+    sys.exit(main(args.ssid, args.password, args.mode, args.output, args.sample_rate, args.volume))
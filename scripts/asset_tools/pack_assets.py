@@ -0,0 +1,154 @@
+#!/usr/bin/env python3
+# Pack sounds, fonts and images into an asset partition image (see main/asset_pack.h)
+import argparse
+import os
+import struct
+import sys
+import zlib
+
+MAGIC = 0x50415a58  # "XZAP"
+VERSION = 1
+NAME_LEN = 32
+HEADER_FORMAT = "<IHHIII12x"
+ENTRY_FORMAT = "<32sIIBBHHH"
+HEADER_SIZE = struct.calcsize(HEADER_FORMAT)
+ENTRY_SIZE = struct.calcsize(ENTRY_FORMAT)
+
+TYPE_BLOB = 0
+TYPE_SOUND = 1
+TYPE_FONT = 2
+TYPE_IMAGE = 3
+TYPE_NAMES = {TYPE_BLOB: "blob", TYPE_SOUND: "sound", TYPE_FONT: "font", TYPE_IMAGE: "image"}
+
+# lv_color_format_t
+LV_COLOR_FORMAT_RAW = 0x01
+
+
+def image_size(data):
+    """Return (width, height) of a PNG, GIF or JPEG file, (0, 0) if unknown"""
+    if data[:8] == b"\x89PNG\r\n\x1a\n":
+        return struct.unpack(">II", data[16:24])
+    if data[:6] in (b"GIF87a", b"GIF89a"):
+        return struct.unpack("<HH", data[6:10])
+    if data[:2] == b"\xff\xd8":
+        i = 2
+        while i + 9 < len(data):
+            if data[i] != 0xFF:
+                break
+            marker = data[i + 1]
+            length = struct.unpack(">H", data[i + 2:i + 4])[0]
+            if marker in (0xC0, 0xC1, 0xC2):
+                height, width = struct.unpack(">HH", data[i + 5:i + 9])
+                return width, height
+            i += 2 + length
+    return 0, 0
+
+
+def classify(name, data):
+    ext = os.path.splitext(name)[1].lower()
+    if ext == ".p3":
+        return TYPE_SOUND, 0, 0, 0
+    if ext == ".bin":
+        return TYPE_FONT, 0, 0, 0
+    if ext in (".png", ".gif", ".jpg", ".jpeg"):
+        width, height = image_size(data)
+        return TYPE_IMAGE, LV_COLOR_FORMAT_RAW, width, height
+    return TYPE_BLOB, 0, 0, 0
+
+
+def collect(inputs):
+    assets = {}
+    for path in inputs:
+        files = []
+        if os.path.isdir(path):
+            for file in sorted(os.listdir(path)):
+                full_path = os.path.join(path, file)
+                if os.path.isfile(full_path) and not file.startswith("."):
+                    files.append(full_path)
+        else:
+            files.append(path)
+        # A later input overrides an asset with the same name, e.g. common/ then zh-CN/
+        for file in files:
+            name = os.path.basename(file)
+            if len(name.encode("utf-8")) >= NAME_LEN:
+                raise ValueError(f"Asset name too long (max {NAME_LEN - 1} bytes): {name}")
+            with open(file, "rb") as f:
+                assets[name] = f.read()
+    return assets
+
+
+def align_up(value, align):
+    return (value + align - 1) // align * align
+
+
+def pack(assets, align):
+    names = sorted(assets.keys(), key=lambda n: n.encode("utf-8"))
+    index_end = HEADER_SIZE + ENTRY_SIZE * len(names)
+    offset = align_up(index_end, align)
+
+    entries = b""
+    body = bytearray(offset - index_end)
+    for name in names:
+        data = assets[name]
+        asset_type, color_format, width, height = classify(name, data)
+        entries += struct.pack(ENTRY_FORMAT, name.encode("utf-8"), offset, len(data),
+                               asset_type, color_format, 0, width, height)
+        body += data
+        padded = align_up(len(data), align)
+        body += bytes(padded - len(data))
+        offset += padded
+
+    total_size = index_end + len(body)
+    header = struct.pack(HEADER_FORMAT, MAGIC, VERSION, len(names), total_size,
+                         zlib.crc32(entries), zlib.crc32(body))
+    return header + entries + bytes(body)
+
+
+def dump(path):
+    with open(path, "rb") as f:
+        image = f.read()
+    magic, version, count, total_size, index_crc, data_crc = struct.unpack_from(HEADER_FORMAT, image)
+    if magic != MAGIC:
+        raise ValueError("Not an asset pack")
+    index_end = HEADER_SIZE + ENTRY_SIZE * count
+    entries = image[HEADER_SIZE:index_end]
+    print(f"version {version}, {count} assets, {total_size} bytes")
+    print(f"index crc {'ok' if zlib.crc32(entries) == index_crc else 'BAD'}, "
+          f"data crc {'ok' if zlib.crc32(image[index_end:total_size]) == data_crc else 'BAD'}")
+    for i in range(count):
+        name, offset, size, asset_type, color_format, _, width, height = \
+            struct.unpack_from(ENTRY_FORMAT, entries, i * ENTRY_SIZE)
+        name = name.rstrip(b"\0").decode("utf-8")
+        extra = f" {width}x{height}" if asset_type == TYPE_IMAGE else ""
+        print(f"  {name:<32} {TYPE_NAMES.get(asset_type, asset_type):<6} {offset:>8} {size:>8}{extra}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="打包音效、字体和图片到资源分区镜像")
+    parser.add_argument("inputs", nargs="*", help="资源目录或文件，同名资源以后面的为准")
+    parser.add_argument("-o", "--output", default="assets.bin", help="输出的分区镜像")
+    parser.add_argument("-a", "--align", type=int, default=16, help="每个资源的对齐字节数")
+    parser.add_argument("-s", "--partition-size", type=lambda x: int(x, 0), help="分区大小，超出时报错")
+    parser.add_argument("-l", "--list", metavar="IMAGE", help="列出已有镜像的内容并校验")
+    args = parser.parse_args()
+
+    if args.list:
+        dump(args.list)
+        return
+    if not args.inputs:
+        parser.error("no inputs")
+    if args.align < 4 or args.align & (args.align - 1):
+        parser.error("align must be a power of two and at least 4")
+
+    assets = collect(args.inputs)
+    image = pack(assets, args.align)
+    if args.partition_size is not None and len(image) > args.partition_size:
+        print(f"Pack is {len(image)} bytes, larger than the partition ({args.partition_size} bytes)", file=sys.stderr)
+        sys.exit(1)
+    with open(args.output, "wb") as f:
+        f.write(image)
+    print(f"Packed {len(assets)} assets into {args.output}, {len(image)} bytes")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,125 @@
+import re
+import sys
+import json
+import argparse
+
+
+'''
+  Convert the audio pipeline trace printed by a CONFIG_USE_AUDIO_TRACE build
+  into a Chrome / Perfetto trace, and print the latency percentiles of each stage.
+
+  Capture the serial log (e.g. `idf.py monitor | tee trace.log`), have a conversation,
+  wait for the device to return to idle, then run:
+
+    python scripts/audio_trace.py trace.log -o trace.json
+
+  Open trace.json in https://ui.perfetto.dev or chrome://tracing
+'''
+
+# Must match AudioTraceStage in main/audio_processing/audio_trace.h
+STAGES = [
+    "mic_read",
+    "processor_output",
+    "encode_start",
+    "encode_end",
+    "send",
+    "receive",
+    "decode_start",
+    "decode_end",
+    "output",
+]
+
+# (name, from stage, to stage) of each span of a frame
+SPANS = [
+    ("uplink", "process", "mic_read", "processor_output"),
+    ("uplink", "encode_wait", "processor_output", "encode_start"),
+    ("uplink", "encode", "encode_start", "encode_end"),
+    ("uplink", "send_wait", "encode_end", "send"),
+    ("uplink", "uplink_total", "mic_read", "send"),
+    ("downlink", "decode_wait", "receive", "decode_start"),
+    ("downlink", "decode", "decode_start", "decode_end"),
+    ("downlink", "output", "decode_end", "output"),
+    ("downlink", "downlink_total", "receive", "output"),
+]
+
+LINE_PATTERN = re.compile(r"AudioTrace: (\d+) (\d+) (\d+) (-?\d+)")
+
+
+def parse(lines):
+    events = []
+    for line in lines:
+        match = LINE_PATTERN.search(line)
+        if match:
+            core, stage, frame, time_us = (int(x) for x in match.groups())
+            if stage < len(STAGES):
+                events.append((time_us, core, STAGES[stage], frame))
+    events.sort()
+    return events
+
+
+def percentile(values, p):
+    values = sorted(values)
+    index = min(len(values) - 1, int(round(p / 100 * (len(values) - 1))))
+    return values[index]
+
+
+def main(input_file, output_file):
+    with open(input_file, "r", errors="ignore") as f:
+        events = parse(f)
+    if not events:
+        print("No trace events found, is CONFIG_USE_AUDIO_TRACE enabled?")
+        return 1
+
+    frames = {}
+    for time_us, core, stage, frame in events:
+        # Keep the first occurrence, an encode may complete more than one packet
+        frames.setdefault(frame, {}).setdefault(stage, time_us)
+
+    base = events[0][0]
+    trace_events = []
+    tids = {}
+
+    def tid(name):
+        if name not in tids:
+            tids[name] = len(tids) + 1
+            trace_events.append({"name": "thread_name", "ph": "M", "pid": 1, "tid": tids[name], "args": {"name": name}})
+        return tids[name]
+
+    for time_us, core, stage, frame in events:
+        trace_events.append({"name": stage, "ph": "i", "s": "t", "ts": time_us - base,
+                             "pid": 1, "tid": tid(f"core {core}"), "args": {"frame": frame}})
+
+    durations = {}
+    for frame, stages in sorted(frames.items()):
+        for track, name, start, end in SPANS:
+            if start in stages and end in stages and stages[end] >= stages[start]:
+                duration = stages[end] - stages[start]
+                durations.setdefault(name, []).append(duration)
+                trace_events.append({"name": name, "ph": "X", "ts": stages[start] - base, "dur": duration,
+                                     "pid": 1, "tid": tid(f"{track} {name}"), "args": {"frame": frame}})
+
+    reads = [time_us for time_us, core, stage, frame in events if stage == "mic_read"]
+    if len(reads) > 1:
+        durations["mic_read_interval"] = [b - a for a, b in zip(reads, reads[1:])]
+
+    with open(output_file, "w") as f:
+        json.dump({"traceEvents": trace_events, "displayTimeUnit": "ms"}, f)
+    print(f"{len(events)} events of {len(frames)} frames written to {output_file}\n")
+
+    print(f"{'stage (ms)':<20}{'count':>8}{'p50':>10}{'p90':>10}{'p99':>10}{'max':>10}")
+    names = [span[1] for span in SPANS] + ["mic_read_interval"]
+    for name in names:
+        values = durations.get(name)
+        if not values:
+            continue
+        row = [percentile(values, p) / 1000 for p in (50, 90, 99)] + [max(values) / 1000]
+        print(f"{name:<20}{len(values):>8}" + "".join(f"{v:>10.2f}" for v in row))
+    return 0
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Audio pipeline trace to Chrome / Perfetto trace")
+    parser.add_argument("input", help="serial log containing the AudioTrace dump")
+    parser.add_argument("-o", "--output", default="audio_trace.json", help="output trace file")
+    args = parser.parse_args()
+    sys.exit(main(args.input, args.output))
@@ -24,6 +24,15 @@ namespace Lang {{
     // 音效资源
     namespace Sounds {{
 {sounds}
+
+        // 按文件名索引，资源分区中的同名音效会覆盖内置音效
+        struct NamedSound {{
+            const char* name;
+            std::string_view sound;
+        }};
+        static const NamedSound ALL[] = {{
+{named_sounds}
+        }};
     }}
 }}
 """
@@ -41,6 +50,7 @@ def generate_header(input_path, output_path):
     # 生成字符串常量
     strings = []
     sounds = []
+    named_sounds = []
     for key, value in data['strings'].items():
         value = value.replace('"', '\\"')
         strings.append(f'        constexpr const char* {key.upper()} = "{value}";')
@@ -49,6 +59,7 @@ def generate_header(input_path, output_path):
     for file in os.listdir(os.path.dirname(input_path)):
         if file.endswith('.p3'):
             base_name = os.path.splitext(file)[0]
+            named_sounds.append(f'            {{"{file}", P3_{base_name.upper()}}},')
             sounds.append(f'''
         extern const char p3_{base_name}_start[] asm("_binary_{base_name}_p3_start");
         extern const char p3_{base_name}_end[] asm("_binary_{base_name}_p3_end");
@@ -57,10 +68,12 @@ def generate_header(input_path, output_path):
         static_cast<size_t>(p3_{base_name}_end - p3_{base_name}_start)
         }};''')
     
-    # 生成公共音效
-    for file in os.listdir(os.path.join(os.path.dirname(output_path), 'common')):
+    # 生成公共音效，common 目录与语言目录同级，输出路径可以在构建目录中
+    common_dir = os.path.join(os.path.dirname(os.path.dirname(os.path.abspath(input_path))), 'common')
+    for file in os.listdir(common_dir):
         if file.endswith('.p3'):
             base_name = os.path.splitext(file)[0]
+            named_sounds.append(f'            {{"{file}", P3_{base_name.upper()}}},')
             sounds.append(f'''
         extern const char p3_{base_name}_start[] asm("_binary_{base_name}_p3_start");
         extern const char p3_{base_name}_end[] asm("_binary_{base_name}_p3_end");
@@ -74,7 +87,8 @@ def generate_header(input_path, output_path):
         lang_code=lang_code,
         lang_code_for_font=lang_code.replace('-', '_').lower(),
         strings="\n".join(sorted(strings)),
-        sounds="\n".join(sorted(sounds))
+        sounds="\n".join(sorted(sounds)),
+        named_sounds="\n".join(sorted(named_sounds))
     )
 
     # 写入文件
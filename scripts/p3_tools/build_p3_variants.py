@@ -0,0 +1,95 @@
+# 为指定开发板生成采样率匹配的 P3 音效，播放时不再需要重采样
+import argparse
+import os
+import re
+import struct
+import sys
+
+import numpy as np
+import opuslib
+
+from convert_audio_to_p3 import SUPPORTED_SAMPLE_RATES, FRAME_DURATION_MS, encode_pcm_to_p3, encode_audio_to_opus
+from convert_p3_to_audio import read_p3_sample_rate
+
+BOARDS_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..", "main", "boards")
+AUDIO_EXTENSIONS = (".wav", ".mp3", ".flac", ".ogg", ".m4a")
+
+
+def board_output_sample_rate(board):
+    """Read AUDIO_OUTPUT_SAMPLE_RATE from main/boards/<board>/config.h"""
+    config_path = os.path.join(BOARDS_DIR, board, "config.h")
+    with open(config_path, "r", encoding="utf-8") as f:
+        match = re.search(r"^\s*#define\s+AUDIO_OUTPUT_SAMPLE_RATE\s+(\d+)", f.read(), re.MULTILINE)
+    if match is None:
+        raise ValueError(f"AUDIO_OUTPUT_SAMPLE_RATE not found in {config_path}")
+    return int(match.group(1))
+
+
+def decode_p3(input_file, sample_rate):
+    """Decode a P3 file to int16 PCM, Opus decodes straight to any of its supported rates"""
+    decoder = opuslib.Decoder(sample_rate, 1)
+    frame_size = int(sample_rate * FRAME_DURATION_MS / 1000)
+    frames = []
+    with open(input_file, "rb") as f:
+        while True:
+            header = f.read(4)
+            if len(header) < 4:
+                break
+            _, _, opus_len = struct.unpack(">BBH", header)
+            opus_data = f.read(opus_len)
+            if len(opus_data) != opus_len:
+                break
+            frames.append(np.frombuffer(decoder.decode(opus_data, frame_size), dtype=np.int16))
+    if not frames:
+        raise ValueError(f"No valid audio data in {input_file}")
+    return np.concatenate(frames)
+
+
+def build_variant(input_file, output_file, sample_rate, target_lufs):
+    if input_file.lower().endswith(".p3"):
+        if read_p3_sample_rate(input_file) == sample_rate:
+            with open(input_file, "rb") as src, open(output_file, "wb") as dst:
+                dst.write(src.read())
+            return
+        # P3 音效已经做过响度标准化，只转换采样率
+        encode_pcm_to_p3(decode_p3(input_file, sample_rate), sample_rate, output_file)
+    else:
+        encode_audio_to_opus(input_file, output_file, target_lufs, sample_rate)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="为开发板生成采样率匹配的 P3 音效")
+    parser.add_argument("inputs", nargs="+", help="P3 或音频文件，或者包含它们的目录")
+    parser.add_argument("-o", "--output-dir", required=True, help="输出目录")
+    group = parser.add_mutually_exclusive_group(required=True)
+    group.add_argument("-b", "--board", help="开发板目录名，从 config.h 读取 AUDIO_OUTPUT_SAMPLE_RATE")
+    group.add_argument("-r", "--sample-rate", type=int, choices=SUPPORTED_SAMPLE_RATES, help="输出采样率")
+    parser.add_argument("-l", "--lufs", type=float, default=-16.0, help="音频文件的目标响度 (默认: -16)")
+    parser.add_argument("-d", "--disable-loudnorm", action="store_true", help="音频文件不做响度标准化")
+    args = parser.parse_args()
+
+    sample_rate = args.sample_rate or board_output_sample_rate(args.board)
+    if sample_rate not in SUPPORTED_SAMPLE_RATES:
+        # 例如 44100Hz，编码为最接近的 Opus 采样率，设备上仍需重采样
+        fallback = min(SUPPORTED_SAMPLE_RATES, key=lambda rate: abs(rate - sample_rate))
+        print(f"Opus does not support {sample_rate}Hz, using {fallback}Hz", file=sys.stderr)
+        sample_rate = fallback
+    target_lufs = None if args.disable_loudnorm else args.lufs
+
+    files = []
+    for path in args.inputs:
+        if os.path.isdir(path):
+            files += [os.path.join(path, file) for file in sorted(os.listdir(path))
+                      if file.lower().endswith((".p3",) + AUDIO_EXTENSIONS)]
+        else:
+            files.append(path)
+
+    os.makedirs(args.output_dir, exist_ok=True)
+    for file in files:
+        output_file = os.path.join(args.output_dir, os.path.splitext(os.path.basename(file))[0] + ".p3")
+        print(f"{file} -> {output_file} ({sample_rate}Hz)")
+        build_variant(file, output_file, sample_rate, target_lufs)
+
+
+if __name__ == "__main__":
+    main()
@@ -8,7 +8,25 @@ import numpy as np
 import argparse
 import pyloudnorm as pyln
 
-def encode_audio_to_opus(input_file, output_file, target_lufs=None):
+# Sample rates supported by Opus. The reserved byte of each P3 header carries the rate in kHz,
+# 0 in older files means 16000Hz
+SUPPORTED_SAMPLE_RATES = (8000, 12000, 16000, 24000, 48000)
+FRAME_DURATION_MS = 60
+
+
+def encode_pcm_to_p3(audio, sample_rate, output_file):
+    """Encode int16 mono PCM into 60ms P3 frames, sample_rate must be one of SUPPORTED_SAMPLE_RATES"""
+    encoder = opuslib.Encoder(sample_rate, 1, opuslib.APPLICATION_AUDIO)
+    with open(output_file, 'wb') as f:
+        frame_size = int(sample_rate * FRAME_DURATION_MS / 1000)
+        for i in tqdm.tqdm(range(0, len(audio) - frame_size, frame_size)):
+            frame = audio[i:i + frame_size]
+            opus_data = encoder.encode(frame.tobytes(), frame_size=frame_size)
+            packet = struct.pack('>BBH', 0, sample_rate // 1000, len(opus_data)) + opus_data
+            f.write(packet)
+
+
+def encode_audio_to_opus(input_file, output_file, target_lufs=None, target_sample_rate=16000):
     # Load audio file using librosa
     audio, sample_rate = librosa.load(input_file, sr=None, mono=False, dtype=np.float32)
     
@@ -26,8 +44,7 @@ def encode_audio_to_opus(input_file, output_file, target_lufs=None):
         audio = pyln.normalize.loudness(audio, current_loudness, target_lufs)
         print(f"Adjusted loudness: {current_loudness:.1f} LUFS -> {target_lufs} LUFS")
 
-    # Convert sample rate to 16000Hz if necessary
-    target_sample_rate = 16000
+    # Convert sample rate to the target rate if necessary
     if sample_rate != target_sample_rate:
         audio = librosa.resample(audio, orig_sr=sample_rate, target_sr=target_sample_rate)
         sample_rate = target_sample_rate
@@ -35,18 +52,7 @@ def encode_audio_to_opus(input_file, output_file, target_lufs=None):
     # Convert audio data back to int16 after processing
     audio = (audio * 32767).astype(np.int16)
     
-    # Initialize Opus encoder
-    encoder = opuslib.Encoder(sample_rate, 1, opuslib.APPLICATION_AUDIO)
-
-    # Encode and save
-    with open(output_file, 'wb') as f:
-        duration = 60  # 60ms per frame
-        frame_size = int(sample_rate * duration / 1000)
-        for i in tqdm.tqdm(range(0, len(audio) - frame_size, frame_size)):
-            frame = audio[i:i + frame_size]
-            opus_data = encoder.encode(frame.tobytes(), frame_size=frame_size)
-            packet = struct.pack('>BBH', 0, 0, len(opus_data)) + opus_data
-            f.write(packet)
+    encode_pcm_to_p3(audio, sample_rate, output_file)
 
 if __name__ == "__main__":
     parser = argparse.ArgumentParser(description='Convert audio to Opus with loudness normalization')
@@ -56,7 +62,9 @@ if __name__ == "__main__":
                        help='Target loudness in LUFS (default: -16)')
     parser.add_argument('-d', '--disable-loudnorm', action='store_true',
                        help='Disable loudness normalization')
+    parser.add_argument('-r', '--sample-rate', type=int, default=16000, choices=SUPPORTED_SAMPLE_RATES,
+                       help='Output sample rate, match the board output_sample_rate to skip resampling (default: 16000)')
     args = parser.parse_args()
 
     target_lufs = None if args.disable_loudnorm else args.lufs
-    encode_audio_to_opus(args.input_file, args.output_file, target_lufs)
\ No newline at end of file
+    encode_audio_to_opus(args.input_file, args.output_file, target_lufs, args.sample_rate)
\ No newline at end of file
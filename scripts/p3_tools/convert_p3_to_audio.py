@@ -6,8 +6,18 @@ from tqdm import tqdm
 import soundfile as sf
 
 
+def read_p3_sample_rate(input_file):
+    """The sample rate recorded in the first P3 header, 16000 for files without one"""
+    with open(input_file, "rb") as f:
+        header = f.read(4)
+    if len(header) < 4:
+        return 16000
+    _, reserved, _ = struct.unpack(">BBH", header)
+    return reserved * 1000 if reserved else 16000
+
+
 def decode_p3_to_audio(input_file, output_file):
-    sample_rate = 16000
+    sample_rate = read_p3_sample_rate(input_file)
     channels = 1
     decoder = opuslib.Decoder(sample_rate, channels)
 
@@ -5,6 +5,7 @@ import time
 import opuslib
 import struct
 import numpy as np
+from convert_p3_to_audio import read_p3_sample_rate
 import sounddevice as sd
 import os
 
@@ -15,7 +16,7 @@ def play_p3_file(input_file, stop_event=None, pause_event=None):
     p3格式: [1字节类型, 1字节保留, 2字节长度, Opus数据]
     """
     # 初始化Opus解码器
-    sample_rate = 16000  # 采样率固定为16000Hz
+    sample_rate = read_p3_sample_rate(input_file)  # 采样率记录在头部的保留字节
     channels = 1  # 单声道
     decoder = opuslib.Decoder(sample_rate, channels)
     